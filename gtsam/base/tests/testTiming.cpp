@@ -0,0 +1,101 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    testTiming.cpp
+ * @brief   Unit tests for the timing outline and trace recording
+ */
+
+#include <gtsam/base/timing.h>
+
+#include <CppUnitLite/TestHarness.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace gtsam;
+
+namespace {
+void timedWork() {
+  gttic_(testTiming_outer);
+  {
+    gttic_(testTiming_inner);
+  }
+}
+
+size_t count(const string& s, const string& pattern) {
+  size_t n = 0;
+  for (size_t pos = s.find(pattern); pos != string::npos; pos = s.find(pattern, pos + 1))
+    ++n;
+  return n;
+}
+}  // namespace
+
+/* ************************************************************************* */
+TEST(Timing, trace) {
+  tictoc_clearTrace_();
+  tictoc_setTracing_(true);
+  timedWork();
+  thread worker(timedWork);
+  worker.join();
+  tictoc_setTracing_(false);
+  timedWork();  // not recorded
+
+  ostringstream os;
+  tictoc_writeTrace_(os);
+  const string json = os.str();
+  EXPECT(json.find("{\"traceEvents\":[") == 0);
+  EXPECT_LONGS_EQUAL(2, count(json, "\"name\":\"testTiming_outer\""));
+  EXPECT_LONGS_EQUAL(2, count(json, "\"name\":\"testTiming_inner\""));
+  EXPECT_LONGS_EQUAL(2, count(json, "\"name\":\"thread_name\""));
+  EXPECT(json.find("\"args\":{\"name\":\"main\"}") != string::npos);
+
+  tictoc_clearTrace_();
+  ostringstream cleared;
+  tictoc_writeTrace_(cleared);
+  EXPECT_LONGS_EQUAL(0, count(cleared.str(), "testTiming_outer"));
+
+  // Recording goes on after clearing
+  tictoc_setTracing_(true);
+  timedWork();
+  tictoc_setTracing_(false);
+  ostringstream after;
+  tictoc_writeTrace_(after);
+  EXPECT_LONGS_EQUAL(1, count(after.str(), "testTiming_outer"));
+  tictoc_clearTrace_();
+}
+
+/* ************************************************************************* */
+TEST(Timing, outlinePerThread) {
+  tictoc_reset_();
+  timedWork();
+  thread worker([] { timedWork(); timedWork(); });
+  worker.join();
+
+  // The merged outline counts the calls of both threads
+  ostringstream os;
+  streambuf* coutBuffer = cout.rdbuf(os.rdbuf());
+  tictoc_print_();
+  cout.rdbuf(coutBuffer);
+  EXPECT(os.str().find("-testTiming outer: ") != string::npos);
+  EXPECT(os.str().find("(3 times") != string::npos);
+  tictoc_reset_();
+}
+
+/* ************************************************************************* */
+int main() {
+  TestResult tr;
+  return TestRegistry::runAllTests(tr);
+}
+/* ************************************************************************* */
@@ -22,21 +22,123 @@
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/format.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
 #include <cassert>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 #include <utility>
+#include <vector>
 
 namespace gtsam {
 namespace internal {
 
 GTSAM_EXPORT boost::shared_ptr<TimingOutline> gTimingRoot(
     new TimingOutline("Total", getTicTocID("Total")));
-GTSAM_EXPORT boost::weak_ptr<TimingOutline> gCurrentTimer(gTimingRoot);
+GTSAM_EXPORT std::atomic<bool> gTracing(false);
+
+namespace {
+// The thread that initialized the library, which records into gTimingRoot
+const std::thread::id gMainThread = std::this_thread::get_id();
+
+// Outlines of the other threads, merged into gTimingRoot for printing
+std::mutex gThreadRootsMutex;
+std::vector<boost::shared_ptr<TimingOutline> > gThreadRoots;
+
+// Labels by tic/toc ID, guarded by the mutex of getTicTocID
+std::vector<std::string>& ticTocLabels() {
+  static std::vector<std::string> labels;
+  return labels;
+}
+
+std::mutex& ticTocMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+/// A span recorded by gttic/gttoc
+struct TraceEvent {
+  size_t id;
+  uint64_t start, end;
+};
+
+/**
+ * Trace events of a single thread.  Only the owning thread writes, publishing
+ * every event by incrementing count with release semantics, so recording takes
+ * no locks.  When full, the oldest events are overwritten.  Clearing from
+ * another thread only moves begin up to count, so count keeps a single writer.
+ */
+struct TraceBuffer {
+  static const size_t kCapacity = size_t(1) << 16;
+  size_t tid;
+  bool isMain;
+  std::vector<TraceEvent> events;
+  std::atomic<size_t> count;  ///< events recorded, written by the owner only
+  std::atomic<size_t> begin;  ///< first event not cleared, written by tictoc_clearTrace_
+  TraceBuffer(size_t tid, bool isMain)
+      : tid(tid), isMain(isMain), events(kCapacity), count(0), begin(0) {}
+};
+
+// Buffers of all threads that ever traced, kept after the threads exit
+std::mutex gTraceBuffersMutex;
+std::vector<boost::shared_ptr<TraceBuffer> > gTraceBuffers;
+
+TraceBuffer& threadTraceBuffer() {
+  static thread_local boost::shared_ptr<TraceBuffer> buffer;
+  if (!buffer) {
+    std::lock_guard<std::mutex> lock(gTraceBuffersMutex);
+    buffer.reset(new TraceBuffer(gTraceBuffers.size(),
+                                 std::this_thread::get_id() == gMainThread));
+    gTraceBuffers.push_back(buffer);
+  }
+  return *buffer;
+}
+
+/// All outlines, starting with gTimingRoot
+std::vector<boost::shared_ptr<TimingOutline> > allRoots() {
+  std::lock_guard<std::mutex> lock(gThreadRootsMutex);
+  std::vector<boost::shared_ptr<TimingOutline> > roots(1, gTimingRoot);
+  roots.insert(roots.end(), gThreadRoots.begin(), gThreadRoots.end());
+  return roots;
+}
+
+/// The outlines of all threads, merged by label
+boost::shared_ptr<TimingOutline> mergedRoot() {
+  const std::vector<boost::shared_ptr<TimingOutline> > roots = allRoots();
+  if (roots.size() == 1)
+    return gTimingRoot;
+  boost::shared_ptr<TimingOutline> merged(
+      new TimingOutline("Total", getTicTocID("Total")));
+  for (const boost::shared_ptr<TimingOutline>& root : roots)
+    merged->accumulate(*root, merged);
+  return merged;
+}
+} // namespace
+
+/* ************************************************************************* */
+boost::weak_ptr<TimingOutline>& currentTimer() {
+  static thread_local boost::weak_ptr<TimingOutline> current;
+  // Start at the root when called first, or after tictoc_reset_
+  if (current.expired()) {
+    if (std::this_thread::get_id() == gMainThread) {
+      current = gTimingRoot;
+    } else {
+      boost::shared_ptr<TimingOutline> root(
+          new TimingOutline("Total", getTicTocID("Total")));
+      std::lock_guard<std::mutex> lock(gThreadRootsMutex);
+      gThreadRoots.push_back(root);
+      current = root;
+    }
+  }
+  return current;
+}
 
 /* ************************************************************************* */
 // Implementation of TimingOutline
@@ -214,6 +316,30 @@ void TimingOutline::finishedIteration() {
   }
 }
 
+/* ************************************************************************* */
+void TimingOutline::accumulate(const TimingOutline& other,
+    const boost::weak_ptr<TimingOutline>& thisPtr) {
+  assert(thisPtr.lock().get() == this);
+  t_ += other.t_;
+  tWall_ += other.tWall_;
+  t2_ += other.t2_;
+  tIt_ += other.tIt_;
+  tMax_ = std::max(tMax_, other.tMax_);
+  if (tMin_ == 0 || (other.tMin_ != 0 && other.tMin_ < tMin_))
+    tMin_ = other.tMin_;
+  n_ += other.n_;
+  // Children in the order they were first seen
+  std::map<size_t, boost::shared_ptr<TimingOutline> > childOrder;
+  for(const ChildMap::value_type& child: other.children_)
+    childOrder[child.second->myOrder_] = child.second;
+  for(const auto& order_child: childOrder) {
+    const TimingOutline& otherChild = *order_child.second;
+    const boost::shared_ptr<TimingOutline>& ourChild =
+        child(otherChild.id_, otherChild.label_, thisPtr);
+    ourChild->accumulate(otherChild, ourChild);
+  }
+}
+
 /* ************************************************************************* */
 size_t getTicTocID(const char *descriptionC) {
   const std::string description(descriptionC);
@@ -221,11 +347,13 @@ size_t getTicTocID(const char *descriptionC) {
   static size_t nextId = 0;
   static gtsam::FastMap<std::string, size_t> idMap;
 
-  // Retrieve or add this string
+  // Retrieve or add this string, from any thread
+  std::lock_guard<std::mutex> lock(ticTocMutex());
   gtsam::FastMap<std::string, size_t>::const_iterator it = idMap.find(
       description);
   if (it == idMap.end()) {
     it = idMap.insert(std::make_pair(description, nextId)).first;
+    ticTocLabels().push_back(description);
     ++nextId;
   }
 
@@ -236,15 +364,17 @@ size_t getTicTocID(const char *descriptionC) {
 /* ************************************************************************* */
 void tic(size_t id, const char *labelC) {
   const std::string label(labelC);
+  boost::weak_ptr<TimingOutline>& current = currentTimer();
   boost::shared_ptr<TimingOutline> node = //
-      gCurrentTimer.lock()->child(id, label, gCurrentTimer);
-  gCurrentTimer = node;
+      current.lock()->child(id, label, current);
+  current = node;
   node->tic();
 }
 
 /* ************************************************************************* */
 void toc(size_t id, const char *label) {
-  boost::shared_ptr<TimingOutline> current(gCurrentTimer.lock());
+  boost::weak_ptr<TimingOutline>& currentPtr = currentTimer();
+  boost::shared_ptr<TimingOutline> current(currentPtr.lock());
   if (id != current->id_) {
     gTimingRoot->print();
     throw std::invalid_argument(
@@ -260,8 +390,112 @@ void toc(size_t id, const char *label) {
             % label).str());
   }
   current->toc();
-  gCurrentTimer = current->parent_;
+  currentPtr = current->parent_;
+}
+
+/* ************************************************************************* */
+uint64_t traceClock() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* ************************************************************************* */
+void traceSpan(size_t id, uint64_t start, uint64_t end) {
+  TraceBuffer& buffer = threadTraceBuffer();
+  const size_t n = buffer.count.load(std::memory_order_relaxed);
+  TraceEvent& event = buffer.events[n % TraceBuffer::kCapacity];
+  event.id = id;
+  event.start = start;
+  event.end = end;
+  buffer.count.store(n + 1, std::memory_order_release);
 }
 
 } // namespace internal
+
+/* ************************************************************************* */
+void tictoc_finishedIteration_() {
+  for (const auto& root : internal::allRoots())
+    root->finishedIteration();
+}
+
+/* ************************************************************************* */
+void tictoc_print_() {
+  internal::mergedRoot()->print();
+}
+
+/* ************************************************************************* */
+void tictoc_print2_() {
+  internal::mergedRoot()->print2();
+}
+
+/* ************************************************************************* */
+void tictoc_reset_() {
+  internal::gTimingRoot.reset(new internal::TimingOutline("Total", internal::getTicTocID("Total")));
+  std::lock_guard<std::mutex> lock(internal::gThreadRootsMutex);
+  internal::gThreadRoots.clear();
+}
+
+/* ************************************************************************* */
+void tictoc_writeTrace_(std::ostream& os) {
+  std::vector<boost::shared_ptr<internal::TraceBuffer> > buffers;
+  {
+    std::lock_guard<std::mutex> lock(internal::gTraceBuffersMutex);
+    buffers = internal::gTraceBuffers;
+  }
+  std::vector<std::string> labels;
+  {
+    std::lock_guard<std::mutex> lock(internal::ticTocMutex());
+    labels = internal::ticTocLabels();
+  }
+
+  // The recorded events of every buffer, oldest first
+  std::vector<std::pair<size_t, size_t> > ranges; // first, end
+  uint64_t origin = std::numeric_limits<uint64_t>::max();
+  for (const auto& buffer : buffers) {
+    const size_t end = buffer->count.load(std::memory_order_acquire);
+    const size_t first = std::max(buffer->begin.load(std::memory_order_relaxed),
+        end > internal::TraceBuffer::kCapacity
+            ? end - internal::TraceBuffer::kCapacity : 0);
+    ranges.push_back(std::make_pair(first, end));
+    for (size_t i = first; i < end; ++i)
+      origin = std::min(origin,
+          buffer->events[i % internal::TraceBuffer::kCapacity].start);
+  }
+
+  // Labels are C++ identifiers, so need no escaping
+  os << "{\"traceEvents\":[";
+  bool first = true;
+  const std::ios::fmtflags flags = os.flags();
+  const std::streamsize precision = os.precision();
+  os << std::fixed << std::setprecision(3);
+  for (size_t b = 0; b < buffers.size(); ++b) {
+    const internal::TraceBuffer& buffer = *buffers[b];
+    os << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+       << buffer.tid << ",\"args\":{\"name\":\""
+       << (buffer.isMain ? std::string("main") : "thread " + std::to_string(buffer.tid))
+       << "\"}}";
+    first = false;
+    for (size_t i = ranges[b].first; i < ranges[b].second; ++i) {
+      const internal::TraceEvent& event =
+          buffer.events[i % internal::TraceBuffer::kCapacity];
+      os << ",\n{\"name\":\"" << labels.at(event.id)
+         << "\",\"cat\":\"gtsam\",\"ph\":\"X\",\"ts\":"
+         << double(event.start - origin) / 1000.0
+         << ",\"dur\":" << double(event.end - event.start) / 1000.0
+         << ",\"pid\":1,\"tid\":" << buffer.tid << "}";
+    }
+  }
+  os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  os.flags(flags);
+  os.precision(precision);
+}
+
+/* ************************************************************************* */
+void tictoc_clearTrace_() {
+  std::lock_guard<std::mutex> lock(internal::gTraceBuffersMutex);
+  for (const auto& buffer : internal::gTraceBuffers)
+    buffer->begin.store(buffer->count.load(std::memory_order_acquire),
+                        std::memory_order_relaxed);
+}
+
 } // namespace gtsam
@@ -25,7 +25,10 @@
 #include <boost/smart_ptr/weak_ptr.hpp>
 #include <boost/version.hpp>
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <iosfwd>
 #include <string>
 
 // This file contains the GTSAM timing instrumentation library, a low-overhead method for
@@ -105,6 +108,29 @@
 //   too scope.  Note that if you use these, it may become difficult to ensure that you
 //   have matching gttic/gttoc statments.  You may want to consider reorganizing your timing
 //   outline to match the scope of your code.
+//
+// Threads:
+//
+// - Every thread records into its own timing outline, so no locks are taken by gttic and
+//   gttoc.  Threads other than the one that started the program get their own tree when
+//   they first call gttic, and tictoc_print_() merges the trees of all threads by label.
+//   Print and reset while the other threads are idle.  CMake still rejects the Timing build
+//   type together with TBB, whose worker threads nest tic/toc pairs across tasks.
+//
+// Tracing:
+//
+// - In addition to the outline, every gttic_/gttoc_ pair can be recorded as a span with its
+//   start time and thread, for viewing parallel runs on a timeline, and gttrace_ records a
+//   span only.  gttic and gttoc record spans in the Timing build, and are no-ops otherwise.
+//   Spans are recorded only after tracing was enabled at runtime with
+//   tictoc_setTracing_(true); while it is off they cost a flag check.  Spans are
+//   kept in a fixed-size ring buffer per thread, so the oldest are overwritten in long runs.
+//   tictoc_writeTrace_() writes all of them in the Chrome trace-event JSON format, which can
+//   be opened in chrome://tracing or Perfetto.  For example, in the Timing build:
+//     tictoc_setTracing_(true);
+//     isam.update(newFactors, newValues);
+//     std::ofstream os("isam2.json");
+//     tictoc_writeTrace_(os);
 
 // Automatically use the new Boost timers if version is recent enough.
 #if BOOST_VERSION >= 104800
@@ -139,6 +165,15 @@ namespace gtsam {
     // Call toc on gCurrentTimer and then set gCurrentTimer to the parent of gCurrentTimer
     GTSAM_EXPORT void toc(size_t id, const char *label);
 
+    // Whether spans are recorded, see tictoc_setTracing_
+    GTSAM_EXTERN_EXPORT std::atomic<bool> gTracing;
+
+    // Nanoseconds since the program started, on a monotonic clock
+    GTSAM_EXPORT uint64_t traceClock();
+
+    // Record a span in the trace buffer of the calling thread
+    GTSAM_EXPORT void traceSpan(size_t id, uint64_t start, uint64_t end);
+
     /**
      * Timing Entry, arranged in a tree
      */
@@ -190,24 +225,48 @@ namespace gtsam {
       void toc();
       void finishedIteration();
 
+      /// Add the statistics of another outline, and of its children to ours by label
+      void accumulate(const TimingOutline& other, const boost::weak_ptr<TimingOutline>& thisPtr);
+
       GTSAM_EXPORT friend void toc(size_t id, const char *label);
     }; // \TimingOutline
 
+    /**
+     * Small class that records a trace span from construction until it is stopped or
+     * destroyed, if tracing is enabled at construction
+     */
+    class AutoTrace {
+     protected:
+      size_t id_;
+      uint64_t start_; ///< start time, 0 when not tracing
+
+     public:
+      explicit AutoTrace(size_t id)
+          : id_(id), start_(gTracing.load(std::memory_order_relaxed) ? traceClock() : 0) {}
+      void stop() {
+        if (start_) traceSpan(id_, start_, traceClock());
+        start_ = 0;
+      }
+      ~AutoTrace() {
+        stop();
+      }
+    };
+
     /**
      * Small class that calls internal::tic at construction, and internol::toc when destroyed
      */
-    class AutoTicToc {
+    class AutoTicToc : public AutoTrace {
      private:
-      size_t id_;
       const char* label_;
       bool isSet_;
 
      public:
       AutoTicToc(size_t id, const char* label)
-          : id_(id), label_(label), isSet_(true) {
+          : AutoTrace(id), label_(label), isSet_(true) {
         tic(id_, label_);
       }
       void stop() {
+        AutoTrace::stop();
         toc(id_, label_);
         isSet_ = false;
       }
@@ -217,7 +276,9 @@ namespace gtsam {
     };
 
     GTSAM_EXTERN_EXPORT boost::shared_ptr<TimingOutline> gTimingRoot;
-    GTSAM_EXTERN_EXPORT boost::weak_ptr<TimingOutline> gCurrentTimer;
+
+    // The innermost open outline node of the calling thread
+    GTSAM_EXPORT boost::weak_ptr<TimingOutline>& currentTimer();
   }
 
 // Tic and toc functions that are always active (whether or not ENABLE_TIMING is defined)
@@ -245,28 +306,38 @@ namespace gtsam {
   static const size_t label##_id_toc = ::gtsam::internal::getTicTocID(#label); \
   ::gtsam::internal::tocInternal(label##_id_toc, #label)
 
-// indicate iteration is finished
-inline void tictoc_finishedIteration_() {
-  ::gtsam::internal::gTimingRoot->finishedIteration(); }
+// record a trace span only, in every build type
+#define gttrace_(label) \
+  static const size_t label##_id_tic = ::gtsam::internal::getTicTocID(#label); \
+  ::gtsam::internal::AutoTrace label##_obj(label##_id_tic)
+
+// indicate iteration is finished, in all threads
+GTSAM_EXPORT void tictoc_finishedIteration_();
 
-// print
-inline void tictoc_print_() {
-  ::gtsam::internal::gTimingRoot->print(); }
+// print, merging the outlines of all threads
+GTSAM_EXPORT void tictoc_print_();
 
-// print mean and standard deviation
-inline void tictoc_print2_() {
-  ::gtsam::internal::gTimingRoot->print2(); }
+// print mean and standard deviation, merging the outlines of all threads
+GTSAM_EXPORT void tictoc_print2_();
 
 // get a node by label and assign it to variable
 #define tictoc_getNode(variable, label) \
   static const size_t label##_id_getnode = ::gtsam::internal::getTicTocID(#label); \
   const boost::shared_ptr<const ::gtsam::internal::TimingOutline> variable = \
-  ::gtsam::internal::gCurrentTimer.lock()->child(label##_id_getnode, #label, ::gtsam::internal::gCurrentTimer);
+  ::gtsam::internal::currentTimer().lock()->child(label##_id_getnode, #label, ::gtsam::internal::currentTimer());
+
+// reset the outlines of all threads
+GTSAM_EXPORT void tictoc_reset_();
+
+// enable or disable recording trace spans, cheap enough to leave enabled
+inline void tictoc_setTracing_(bool enabled) {
+  ::gtsam::internal::gTracing.store(enabled, std::memory_order_relaxed); }
+
+// write the recorded spans of all threads in the Chrome trace-event JSON format
+GTSAM_EXPORT void tictoc_writeTrace_(std::ostream& os);
 
-// reset
-inline void tictoc_reset_() {
-  ::gtsam::internal::gTimingRoot.reset(new ::gtsam::internal::TimingOutline("Total", ::gtsam::internal::getTicTocID("Total")));
-  ::gtsam::internal::gCurrentTimer = ::gtsam::internal::gTimingRoot; }
+// discard the recorded spans of all threads
+GTSAM_EXPORT void tictoc_clearTrace_();
 
 #ifdef ENABLE_TIMING
 #define gttic(label) gttic_(label)
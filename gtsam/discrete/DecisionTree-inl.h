@@ -29,14 +29,78 @@
 using boost::assign::operator+=;
 #include <boost/unordered_set.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/weak_ptr.hpp>
 
 #include <list>
 #include <cmath>
 #include <fstream>
 #include <sstream>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 
 namespace gtsam {
 
+  namespace internal {
+    /**
+     * Hash consing table of the live nodes of one type, holding weak pointers
+     * so that it does not keep nodes alive.  Expired entries are swept when
+     * the table has doubled in size since the last sweep.
+     */
+    template<typename NODE>
+    class UniqueTable {
+      typedef boost::shared_ptr<const NODE> NodePtr;
+      typedef std::unordered_multimap<size_t, boost::weak_ptr<const NODE> > Nodes;
+      Nodes nodes_;
+      size_t sweepSize_;
+
+    public:
+      UniqueTable() : sweepSize_(1024) {}
+
+      /// The node that was inserted with the given hash and is the same as node, if any
+      template<typename SAME>
+      NodePtr find(size_t hash, SAME same) const {
+        std::pair<typename Nodes::const_iterator, typename Nodes::const_iterator> range =
+            nodes_.equal_range(hash);
+        for (typename Nodes::const_iterator it = range.first; it != range.second; ++it) {
+          NodePtr node = it->second.lock();
+          if (node && same(*node)) return node;
+        }
+        return NodePtr();
+      }
+
+      void insert(size_t hash, const NodePtr& node) {
+        if (nodes_.size() >= sweepSize_) {
+          for (typename Nodes::iterator it = nodes_.begin(); it != nodes_.end();)
+            it = it->second.expired() ? nodes_.erase(it) : ++it;
+          sweepSize_ = std::max<size_t>(1024, 2 * nodes_.size());
+        }
+        nodes_.insert(std::make_pair(hash, boost::weak_ptr<const NODE>(node)));
+      }
+    };
+
+    namespace hash_detail {
+      using boost::hash_value;
+
+      /// Whether boost::hash<T> can hash T, through boost or a hash_value found by ADL
+      template<typename T, typename = void>
+      struct IsHashable : std::false_type {};
+      template<typename T>
+      struct IsHashable<T, decltype(void(hash_value(std::declval<const T&>())))>
+          : std::true_type {};
+    }
+
+    /// Hash of t, or 0 for types that cannot be hashed
+    template<typename T>
+    size_t HashIfHashable(const T& t, std::true_type) { return boost::hash<T>()(t); }
+    template<typename T>
+    size_t HashIfHashable(const T&, std::false_type) { return 0; }
+    template<typename T>
+    size_t HashIfHashable(const T& t) {
+      return HashIfHashable(t, hash_detail::IsHashable<T>());
+    }
+  }
+
   /*********************************************************************************/
   // Node
   /*********************************************************************************/
@@ -60,6 +124,33 @@ namespace gtsam {
     Leaf(const Y& constant) :
       constant_(constant) {}
 
+    /**
+     * The unique leaf with a constant, created if it does not exist yet.
+     * Constants that boost::hash cannot hash get a new leaf every time.
+     */
+    static NodePtr Unique(const Y& constant) {
+      return Unique(constant, internal::hash_detail::IsHashable<Y>());
+    }
+
+  private:
+    static NodePtr Unique(const Y& constant, std::true_type) {
+      static thread_local internal::UniqueTable<Leaf> table;
+      const size_t hash = boost::hash<Y>()(constant);
+      boost::shared_ptr<const Leaf> leaf = table.find(hash,
+          [&constant](const Leaf& q) { return q.constant_ == constant; });
+      if (!leaf) {
+        leaf.reset(new Leaf(constant));
+        table.insert(hash, leaf);
+      }
+      return leaf;
+    }
+
+    static NodePtr Unique(const Y& constant, std::false_type) {
+      return NodePtr(new Leaf(constant));
+    }
+
+  public:
+
     /** return the constant */
     const Y& constant() const {
       return constant_;
@@ -101,9 +192,8 @@ namespace gtsam {
     }
 
     /** apply unary operator */
-    NodePtr apply(const Unary& op) const {
-      NodePtr f(new Leaf(op(constant_)));
-      return f;
+    NodePtr apply(const Unary& op, Cache& cache) const {
+      return Unique(op(constant_));
     }
 
     // Apply binary operator "h = f op g" on Leaf node
@@ -111,28 +201,29 @@ namespace gtsam {
     // Simply calls apply on argument to call correct virtual method:
     // fL.apply_f_op_g(gL) -> gL.apply_g_op_fL(fL) (below)
     // fL.apply_f_op_g(gC) -> gC.apply_g_op_fL(fL) (Choice)
-    NodePtr apply_f_op_g(const Node& g, const Binary& op) const {
-      return g.apply_g_op_fL(*this, op);
+    NodePtr apply_f_op_g(const Node& g, const Binary& op, Cache& cache) const {
+      return g.apply_g_op_fL(*this, op, cache);
     }
 
     // Applying binary operator to two leaves results in a leaf
-    NodePtr apply_g_op_fL(const Leaf& fL, const Binary& op) const {
-      NodePtr h(new Leaf(op(fL.constant_, constant_))); // fL op gL
-      return h;
+    NodePtr apply_g_op_fL(const Leaf& fL, const Binary& op, Cache& cache) const {
+      return Unique(op(fL.constant_, constant_)); // fL op gL
     }
 
     // If second argument is a Choice node, call it's apply with leaf as second
-    NodePtr apply_g_op_fC(const Choice& fC, const Binary& op) const {
-      return fC.apply_fC_op_gL(*this, op); // operand order back to normal
+    NodePtr apply_g_op_fC(const Choice& fC, const Binary& op, Cache& cache) const {
+      return fC.apply_fC_op_gL(*this, op, cache); // operand order back to normal
     }
 
-    /** choose a branch, create new memory ! */
-    NodePtr choose(const L& label, size_t index) const {
-      return NodePtr(new Leaf(constant()));
+    /** choose a branch: a leaf does not depend on any label */
+    NodePtr choose(const L& label, size_t index, Cache& cache) const {
+      return Unique(constant_);
     }
 
     bool isLeaf() const { return true; }
 
+    size_t nrLeaves() const { return 1; }
+
   }; // Leaf
 
   /*********************************************************************************/
@@ -151,6 +242,9 @@ namespace gtsam {
     /** incremental allSame */
     size_t allSame_;
 
+    /** incremental nrLeaves, as branches never change once added */
+    size_t nrLeaves_;
+
     typedef boost::shared_ptr<const Choice> ChoicePtr;
 
   public:
@@ -161,33 +255,45 @@ namespace gtsam {
 #endif
     }
 
-    /** If all branches of a choice node f are the same, just return a branch */
+    /**
+     * The unique node for a choice whose branches are unique nodes: if all
+     * branches are the same, just return a branch, and otherwise the existing
+     * choice with the same label and branches, or f itself if there is none.
+     */
     static NodePtr Unique(const ChoicePtr& f) {
 #ifndef DT_NO_PRUNING
       if (f->allSame_) {
         assert(f->branches().size() > 0);
-        NodePtr f0 = f->branches_[0];
-        assert(f0->isLeaf());
-        NodePtr newLeaf(new Leaf(boost::dynamic_pointer_cast<const Leaf>(f0)->constant()));
-        return newLeaf;
-      } else
+        return f->branches_[0];
+      }
 #endif
-        return f;
+      static thread_local internal::UniqueTable<Choice> table;
+      size_t hash = internal::HashIfHashable(f->label_);
+      for(const NodePtr& branch: f->branches_)
+        boost::hash_combine(hash, branch.get());
+      ChoicePtr existing = table.find(hash, [&f](const Choice& q) {
+        return q.label_ == f->label_ && q.branches_ == f->branches_;
+      });
+      if (existing) return existing;
+      table.insert(hash, f);
+      return f;
     }
 
     bool isLeaf() const { return false; }
 
+    size_t nrLeaves() const { return nrLeaves_; }
+
     /** Constructor, given choice label and mandatory expected branch count */
     Choice(const L& label, size_t count) :
-      label_(label), allSame_(true) {
+      label_(label), allSame_(true), nrLeaves_(0) {
       branches_.reserve(count);
     }
 
     /**
      * Construct from applying binary op to two Choice nodes
      */
-    Choice(const Choice& f, const Choice& g, const Binary& op) :
-      allSame_(true) {
+    Choice(const Choice& f, const Choice& g, const Binary& op, Cache& cache) :
+      allSame_(true), nrLeaves_(0) {
 
       // Choose what to do based on label
       if (f.label() > g.label()) {
@@ -196,21 +302,21 @@ namespace gtsam {
         size_t count = f.nrChoices();
         branches_.reserve(count);
         for (size_t i = 0; i < count; i++)
-          push_back(f.branches_[i]->apply_f_op_g(g, op));
+          push_back(Apply(*f.branches_[i], g, op, cache));
       } else if (g.label() > f.label()) {
         // f lower than g
         label_ = g.label();
         size_t count = g.nrChoices();
         branches_.reserve(count);
         for (size_t i = 0; i < count; i++)
-          push_back(g.branches_[i]->apply_g_op_fC(f, op));
+          push_back(Apply(f, *g.branches_[i], op, cache));
       } else {
         // f same level as g
         label_ = f.label();
         size_t count = f.nrChoices();
         branches_.reserve(count);
         for (size_t i = 0; i < count; i++)
-          push_back(f.branches_[i]->apply_f_op_g(*g.branches_[i], op));
+          push_back(Apply(*f.branches_[i], *g.branches_[i], op, cache));
       }
     }
 
@@ -228,11 +334,13 @@ namespace gtsam {
 
     /** add a branch: TODO merge into constructor */
     void push_back(const NodePtr& node) {
-      // allSame_ is restricted to leaf nodes in a decision tree
+      // Equal branches are usually the same unique node, but leaves made on
+      // other threads or of unhashable constants are only equal in value
       if (allSame_ && !branches_.empty()) {
-        allSame_ = node->sameLeaf(*branches_.back());
+        allSame_ = (node == branches_.back()) || node->sameLeaf(*branches_.back());
       }
       branches_.push_back(node);
+      nrLeaves_ += node->nrLeaves();
     }
 
     /** print (as a tree) */
@@ -277,6 +385,7 @@ namespace gtsam {
 
     /** equality up to tolerance */
     bool equals(const Node& q, double tol) const {
+      if (this == &q) return true;
       const Choice* other = dynamic_cast<const Choice*> (&q);
       if (!other) return false;
       if (this->label_ != other->label_) return false;
@@ -305,17 +414,17 @@ namespace gtsam {
     /**
      * Construct from applying unary op to a Choice node
      */
-    Choice(const L& label, const Choice& f, const Unary& op) :
-      label_(label), allSame_(true) {
+    Choice(const L& label, const Choice& f, const Unary& op, Cache& cache) :
+      label_(label), allSame_(true), nrLeaves_(0) {
 
       branches_.reserve(f.branches_.size()); // reserve space
       for (const NodePtr& branch: f.branches_)
-              push_back(branch->apply(op));
+              push_back(Apply(*branch, op, cache));
     }
 
     /** apply unary operator */
-    NodePtr apply(const Unary& op) const {
-      boost::shared_ptr<Choice> r(new Choice(label_, *this, op));
+    NodePtr apply(const Unary& op, Cache& cache) const {
+      boost::shared_ptr<Choice> r(new Choice(label_, *this, op, cache));
       return Unique(r);
     }
 
@@ -324,42 +433,42 @@ namespace gtsam {
     // Simply calls apply on argument to call correct virtual method:
     // fC.apply_f_op_g(gL) -> gL.apply_g_op_fC(fC) -> (Leaf)
     // fC.apply_f_op_g(gC) -> gC.apply_g_op_fC(fC) -> (below)
-    NodePtr apply_f_op_g(const Node& g, const Binary& op) const {
-      return g.apply_g_op_fC(*this, op);
+    NodePtr apply_f_op_g(const Node& g, const Binary& op, Cache& cache) const {
+      return g.apply_g_op_fC(*this, op, cache);
     }
 
     // If second argument of binary op is Leaf node, recurse on branches
-    NodePtr apply_g_op_fL(const Leaf& fL, const Binary& op) const {
+    NodePtr apply_g_op_fL(const Leaf& fL, const Binary& op, Cache& cache) const {
       boost::shared_ptr<Choice> h(new Choice(label(), nrChoices()));
-      for(NodePtr branch: branches_)
-              h->push_back(fL.apply_f_op_g(*branch, op));
+      for(const NodePtr& branch: branches_)
+              h->push_back(Apply(fL, *branch, op, cache));
       return Unique(h);
     }
 
     // If second argument of binary op is Choice, call constructor
-    NodePtr apply_g_op_fC(const Choice& fC, const Binary& op) const {
-      boost::shared_ptr<Choice> h(new Choice(fC, *this, op));
+    NodePtr apply_g_op_fC(const Choice& fC, const Binary& op, Cache& cache) const {
+      boost::shared_ptr<Choice> h(new Choice(fC, *this, op, cache));
       return Unique(h);
     }
 
     // If second argument of binary op is Leaf
     template<typename OP>
-    NodePtr apply_fC_op_gL(const Leaf& gL, OP op) const {
+    NodePtr apply_fC_op_gL(const Leaf& gL, OP op, Cache& cache) const {
       boost::shared_ptr<Choice> h(new Choice(label(), nrChoices()));
       for(const NodePtr& branch: branches_)
-              h->push_back(branch->apply_f_op_g(gL, op));
+              h->push_back(Apply(*branch, gL, op, cache));
       return Unique(h);
     }
 
     /** choose a branch, recursively */
-    NodePtr choose(const L& label, size_t index) const {
+    NodePtr choose(const L& label, size_t index, Cache& cache) const {
       if (label_ == label)
         return branches_[index]; // choose branch
 
       // second case, not label of interest, just recurse
       boost::shared_ptr<Choice> r(new Choice(label_, branches_.size()));
       for(const NodePtr& branch: branches_)
-              r->push_back(branch->choose(label, index));
+              r->push_back(Choose(*branch, label, index, cache));
       return Unique(r);
     }
 
@@ -380,7 +489,7 @@ namespace gtsam {
   /*********************************************************************************/
   template<typename L, typename Y>
   DecisionTree<L, Y>::DecisionTree(const Y& y)  {
-    root_ = NodePtr(new Leaf(y));
+    root_ = Leaf::Unique(y);
   }
 
   /*********************************************************************************/
@@ -388,7 +497,7 @@ namespace gtsam {
   DecisionTree<L, Y>::DecisionTree(//
       const L& label, const Y& y1, const Y& y2)  {
     boost::shared_ptr<Choice> a(new Choice(label, 2));
-    NodePtr l1(new Leaf(y1)), l2(new Leaf(y2));
+    NodePtr l1(Leaf::Unique(y1)), l2(Leaf::Unique(y2));
     a->push_back(l1);
     a->push_back(l2);
     root_ = Choice::Unique(a);
@@ -401,7 +510,7 @@ namespace gtsam {
     if (labelC.second != 2) throw std::invalid_argument(
         "DecisionTree: binary constructor called with non-binary label");
     boost::shared_ptr<Choice> a(new Choice(labelC.first, 2));
-    NodePtr l1(new Leaf(y1)), l2(new Leaf(y2));
+    NodePtr l1(Leaf::Unique(y1)), l2(Leaf::Unique(y2));
     a->push_back(l1);
     a->push_back(l2);
     root_ = Choice::Unique(a);
@@ -547,7 +656,7 @@ namespace gtsam {
       }
       boost::shared_ptr<Choice> choice(new Choice(begin->first, endY - beginY));
       for (ValueIt y = beginY; y != endY; y++)
-        choice->push_back(NodePtr(new Leaf(*y)));
+        choice->push_back(Leaf::Unique(*y));
       return Choice::Unique(choice);
     }
 
@@ -579,7 +688,7 @@ namespace gtsam {
     // ugliness below because apparently we can't have templated virtual functions
     // If leaf, apply unary conversion "op" and create a unique leaf
     const MXLeaf* leaf = dynamic_cast<const MXLeaf*> (f.get());
-    if (leaf) return NodePtr(new Leaf(op(leaf->constant())));
+    if (leaf) return Leaf::Unique(op(leaf->constant()));
 
     // Check if Choice
     boost::shared_ptr<const MXChoice> choice = boost::dynamic_pointer_cast<const MXChoice> (f);
@@ -622,7 +731,8 @@ namespace gtsam {
 
   template<typename L, typename Y>
   DecisionTree<L, Y> DecisionTree<L, Y>::apply(const Unary& op) const {
-    return DecisionTree(root_->apply(op));
+    Cache cache;
+    return DecisionTree(Apply(*root_, op, cache));
   }
 
   /*********************************************************************************/
@@ -630,12 +740,49 @@ namespace gtsam {
   DecisionTree<L, Y> DecisionTree<L, Y>::apply(const DecisionTree& g,
       const Binary& op) const {
     // apply the operaton on the root of both diagrams
-    NodePtr h = root_->apply_f_op_g(*g.root_, op);
+    Cache cache;
+    NodePtr h = Apply(*root_, *g.root_, op, cache);
     // create a new class with the resulting root "h"
     DecisionTree result(h);
     return result;
   }
 
+  /*********************************************************************************/
+  // The operand nodes are owned by the operands for the whole operation, so
+  // their addresses identify them in the cache.
+  template<typename L, typename Y>
+  typename DecisionTree<L, Y>::NodePtr DecisionTree<L, Y>::Apply(const Node& f,
+      const Node& g, const Binary& op, Cache& cache) {
+    const NodePair key(&f, &g);
+    typename Cache::const_iterator it = cache.find(key);
+    if (it != cache.end()) return it->second;
+    NodePtr h = f.apply_f_op_g(g, op, cache);
+    cache.insert(std::make_pair(key, h));
+    return h;
+  }
+
+  template<typename L, typename Y>
+  typename DecisionTree<L, Y>::NodePtr DecisionTree<L, Y>::Apply(const Node& f,
+      const Unary& op, Cache& cache) {
+    const NodePair key(&f, (const Node*)0);
+    typename Cache::const_iterator it = cache.find(key);
+    if (it != cache.end()) return it->second;
+    NodePtr h = f.apply(op, cache);
+    cache.insert(std::make_pair(key, h));
+    return h;
+  }
+
+  template<typename L, typename Y>
+  typename DecisionTree<L, Y>::NodePtr DecisionTree<L, Y>::Choose(const Node& f,
+      const L& label, size_t index, Cache& cache) {
+    const NodePair key(&f, (const Node*)0);
+    typename Cache::const_iterator it = cache.find(key);
+    if (it != cache.end()) return it->second;
+    NodePtr h = f.choose(label, index, cache);
+    cache.insert(std::make_pair(key, h));
+    return h;
+  }
+
   /*********************************************************************************/
   // The way this works:
   // We have an ADT, picture it as a tree.
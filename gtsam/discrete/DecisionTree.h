@@ -21,9 +21,12 @@
 
 #include <gtsam/discrete/Assignment.h>
 #include <boost/function.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/shared_ptr.hpp>
 #include <iostream>
 #include <vector>
 #include <map>
+#include <unordered_map>
 
 namespace gtsam {
 
@@ -31,6 +34,15 @@ namespace gtsam {
    * Decision Tree
    * L = label for variables
    * Y = function range (any algebra), e.g., bool, int, double
+   *
+   * Nodes are hash-consed as in BDD packages: structurally equal nodes are
+   * created only once (per thread), so equal subtrees are shared within and
+   * between trees, and choices whose branches are all the same are removed.
+   * Operations memoize their results per node, so they visit every shared
+   * subtree once.  Leaves are only shared if Y can be hashed with
+   * boost::hash, and labels L that cannot be hashed make the lookup of choices
+   * slower, but neither is required.  Choices with equal leaves collapse
+   * either way, as leaves are compared by value.
    */
   template<typename L, typename Y>
   class DecisionTree {
@@ -45,9 +57,19 @@ namespace gtsam {
     typedef std::pair<L,size_t> LabelC;
 
     /** DTs consist of Leaf and Choice nodes, both subclasses of Node */
+    class Node;
     class Leaf;
     class Choice;
 
+    /**
+     * Results of one operation for the nodes (or pairs of nodes) it was
+     * applied to.  Nodes are unique (see Choice::Unique), so subtrees shared
+     * between or within trees are only visited once per operation.
+     */
+    typedef std::pair<const Node*, const Node*> NodePair;
+    typedef std::unordered_map<NodePair, boost::shared_ptr<const Node>,
+        boost::hash<NodePair> > Cache;
+
     /** ------------------------ Node base class --------------------------- */
     class Node {
     public:
@@ -81,12 +103,13 @@ namespace gtsam {
       virtual bool sameLeaf(const Node& q) const = 0;
       virtual bool equals(const Node& other, double tol = 1e-9) const = 0;
       virtual const Y& operator()(const Assignment<L>& x) const = 0;
-      virtual Ptr apply(const Unary& op) const = 0;
-      virtual Ptr apply_f_op_g(const Node&, const Binary&) const = 0;
-      virtual Ptr apply_g_op_fL(const Leaf&, const Binary&) const = 0;
-      virtual Ptr apply_g_op_fC(const Choice&, const Binary&) const = 0;
-      virtual Ptr choose(const L& label, size_t index) const = 0;
+      virtual Ptr apply(const Unary& op, Cache& cache) const = 0;
+      virtual Ptr apply_f_op_g(const Node&, const Binary&, Cache& cache) const = 0;
+      virtual Ptr apply_g_op_fL(const Leaf&, const Binary&, Cache& cache) const = 0;
+      virtual Ptr apply_g_op_fC(const Choice&, const Binary&, Cache& cache) const = 0;
+      virtual Ptr choose(const L& label, size_t index, Cache& cache) const = 0;
       virtual bool isLeaf() const = 0;
+      virtual size_t nrLeaves() const = 0;
     };
     /** ------------------------ Node base class --------------------------- */
 
@@ -104,6 +127,15 @@ namespace gtsam {
     template<typename It, typename ValueIt>
     NodePtr create(It begin, It end, ValueIt beginY, ValueIt endY) const;
 
+    /** Apply op to the nodes f and g, unless it was already applied to them */
+    static NodePtr Apply(const Node& f, const Node& g, const Binary& op, Cache& cache);
+
+    /** Apply op to the node f, unless it was already applied to it */
+    static NodePtr Apply(const Node& f, const Unary& op, Cache& cache);
+
+    /** Choose a branch of node f, unless it was already chosen for f */
+    static NodePtr Choose(const Node& f, const L& label, size_t index, Cache& cache);
+
     /** Convert to a different type */
     template<typename M, typename X> NodePtr
     convert(const typename DecisionTree<M, X>::NodePtr& f, const std::map<M,
@@ -169,6 +201,11 @@ namespace gtsam {
     /** evaluate */
     const Y& operator()(const Assignment<L>& x) const;
 
+    /** number of leaves, i.e. of distinct paths from the root */
+    size_t nrLeaves() const {
+      return root_->nrLeaves();
+    }
+
     /** apply Unary operation "op" to f */
     DecisionTree apply(const Unary& op) const;
 
@@ -178,7 +215,8 @@ namespace gtsam {
     /** create a new function where value(label)==index
      * It's like "restrict" in Darwiche09book pg329, 330? */
     DecisionTree choose(const L& label, size_t index) const {
-      NodePtr newRoot = root_->choose(label, index);
+      Cache cache;
+      NodePtr newRoot = Choose(*root_, label, index, cache);
       return DecisionTree(newRoot);
     }
 
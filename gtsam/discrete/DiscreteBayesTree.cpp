@@ -22,6 +22,14 @@
 #include <gtsam/inference/BayesTreeCliqueBase-inst.h>
 #include <gtsam/discrete/DiscreteBayesTree.h>
 #include <gtsam/discrete/DiscreteBayesNet.h>
+#include <gtsam/discrete/DiscreteConditional.h>
+#include <gtsam/inference/DenseKeyMap.h>
+#include <gtsam/base/timing.h>
+
+#include <boost/make_shared.hpp>
+
+#include <algorithm>
+#include <vector>
 
 namespace gtsam {
 
@@ -36,6 +44,118 @@ namespace gtsam {
     return Base::equals(other, tol);
   }
 
+  /* ************************************************************************* */
+  namespace {
+    struct OptimizeData {};
+
+    /// Pre-order visitor that solves a clique given the solution of its parents.
+    /// Every variable is written by a single clique before its descendants read
+    /// it, so the cliques of different subtrees can be solved in parallel.
+    struct OptimizeClique {
+      const DenseKeyMap& keyMap;
+      std::vector<size_t>& solution;
+
+      OptimizeClique(const DenseKeyMap& keyMap, std::vector<size_t>& solution) :
+        keyMap(keyMap), solution(solution) {}
+
+      OptimizeData operator()(const DiscreteBayesTreeClique::shared_ptr& clique,
+          OptimizeData& parentData) {
+        const DiscreteConditional& c = *clique->conditional();
+        DiscreteFactor::Values values;
+        for(Key parent: c.parents())
+          values[parent] = solution[keyMap.find(parent)];
+        c.solveInPlace(values);
+        for(Key frontal: c.frontals())
+          solution[keyMap.find(frontal)] = values.at(frontal);
+        return OptimizeData();
+      }
+    };
+
+    /// Pre-order visitor that computes the marginal on the variables of a clique
+    /// from the marginal of its parent, and the marginals of its frontals
+    struct MarginalClique {
+      const DenseKeyMap& keyMap;
+      std::vector<DecisionTreeFactor::shared_ptr>& marginals;
+
+      MarginalClique(const DenseKeyMap& keyMap,
+          std::vector<DecisionTreeFactor::shared_ptr>& marginals) :
+        keyMap(keyMap), marginals(marginals) {}
+
+      DecisionTreeFactor::shared_ptr operator()(
+          const DiscreteBayesTreeClique::shared_ptr& clique,
+          DecisionTreeFactor::shared_ptr& parentMarginal) {
+        const DiscreteConditional& c = *clique->conditional();
+
+        // P(F,S) = P(F|S) P(S), a root has no separator
+        DecisionTreeFactor::shared_ptr joint;
+        if (c.nrParents() == 0)
+          joint = boost::make_shared<DecisionTreeFactor>(c);
+        else {
+          const KeyVector separator(c.beginParents(), c.endParents());
+          joint = boost::make_shared<DecisionTreeFactor>(c * *marginalOn(*parentMarginal, separator));
+        }
+
+        for(Key frontal: c.frontals())
+          marginals[keyMap.find(frontal)] = marginalOn(*joint, KeyVector(1, frontal));
+        return joint;
+      }
+
+      /// Sum out all keys of f but the given ones
+      static DecisionTreeFactor::shared_ptr marginalOn(const DecisionTreeFactor& f,
+          const KeyVector& keys) {
+        Ordering others;
+        for(Key j: f.keys())
+          if (std::find(keys.begin(), keys.end(), j) == keys.end())
+            others.push_back(j);
+        return f.sum(others);
+      }
+    };
+
+    /// Index of the frontal variables of all cliques
+    DenseKeyMap frontalKeyMap(const DiscreteBayesTree& bayesTree) {
+      KeyVector keys;
+      keys.reserve(bayesTree.nodes().size());
+      for(const auto& node: bayesTree.nodes())
+        keys.push_back(node.first);
+      return DenseKeyMap(keys);
+    }
+  }
+
+  /* ************************************************************************* */
+  DiscreteFactor::sharedValues DiscreteBayesTree::optimize() const {
+    gttic(DiscreteBayesTree_optimize);
+    const DenseKeyMap keyMap = frontalKeyMap(*this);
+    std::vector<size_t> solution(keyMap.size());
+
+    OptimizeData rootData;
+    OptimizeClique visitorPre(keyMap, solution);
+    treeTraversal::no_op visitorPost;
+    treeTraversal::DepthFirstForestParallel(*this, rootData, visitorPre, visitorPost);
+
+    // Keys are in sorted order, so every insertion is at the end
+    DiscreteFactor::sharedValues result(new DiscreteFactor::Values());
+    for(size_t i = 0; i < keyMap.size(); ++i)
+      result->insert(result->end(), std::make_pair(keyMap.key(i), solution[i]));
+    return result;
+  }
+
+  /* ************************************************************************* */
+  std::map<Key, DecisionTreeFactor::shared_ptr> DiscreteBayesTree::marginals() const {
+    gttic(DiscreteBayesTree_marginals);
+    const DenseKeyMap keyMap = frontalKeyMap(*this);
+    std::vector<DecisionTreeFactor::shared_ptr> marginals(keyMap.size());
+
+    DecisionTreeFactor::shared_ptr rootData;
+    MarginalClique visitorPre(keyMap, marginals);
+    treeTraversal::no_op visitorPost;
+    treeTraversal::DepthFirstForestParallel(*this, rootData, visitorPre, visitorPost);
+
+    std::map<Key, DecisionTreeFactor::shared_ptr> result;
+    for(size_t i = 0; i < keyMap.size(); ++i)
+      result.insert(result.end(), std::make_pair(keyMap.key(i), marginals[i]));
+    return result;
+  }
+
 } // \namespace gtsam
 
 
@@ -24,6 +24,8 @@
 #include <gtsam/inference/BayesTree.h>
 #include <gtsam/inference/BayesTreeCliqueBase.h>
 
+#include <map>
+
 namespace gtsam {
 
   // Forward declarations
@@ -61,6 +63,22 @@ namespace gtsam {
 
     /** Check equality */
     bool equals(const This& other, double tol = 1e-9) const;
+
+    /**
+     * Solve for the most probable values of all variables by back-substitution,
+     * each clique given the solution of its parents.  The cliques of different
+     * subtrees are solved in parallel when GTSAM is built with TBB.
+     */
+    DiscreteFactor::sharedValues optimize() const;
+
+    /**
+     * The marginals of all variables, computed in one pass from the roots down.
+     * The marginal on the variables of each clique is the product of its
+     * conditional with the marginal on its separator, which is summed from the
+     * marginal of the parent clique, so that no clique is eliminated twice as
+     * when asking for the marginals one variable at a time.
+     */
+    std::map<Key, DecisionTreeFactor::shared_ptr> marginals() const;
   };
 
 }
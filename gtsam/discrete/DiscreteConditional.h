@@ -58,6 +58,12 @@ public:
   /** Construct from signature */
   DiscreteConditional(const Signature& signature);
 
+  /** Construct from the table of a normalized conditional over keys, frontals first */
+  DiscreteConditional(size_t nFrontals, const DiscreteKeys& keys,
+      const std::vector<double>& table) :
+      BaseFactor(keys, table), BaseConditional(nFrontals) {
+  }
+
   /** construct P(X|Y)=P(X,Y)/P(Y) from P(X,Y) and P(Y) */
   DiscreteConditional(const DecisionTreeFactor& joint,
       const DecisionTreeFactor& marginal, const boost::optional<Ordering>& orderedKeys = boost::none);
@@ -26,6 +26,10 @@
 #include <gtsam/inference/EliminateableFactorGraph-inst.h>
 #include <boost/make_shared.hpp>
 
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
 namespace gtsam {
 
   // Instantiate base classes
@@ -97,7 +101,7 @@ namespace gtsam {
   DiscreteFactor::sharedValues DiscreteFactorGraph::optimize() const
   {
     gttic(DiscreteFactorGraph_optimize);
-    return BaseEliminateable::eliminateSequential()->optimize();
+    return BaseEliminateable::eliminateMultifrontal()->optimize();
   }
 
   /* ************************************************************************* */
@@ -129,6 +133,111 @@ namespace gtsam {
     return std::make_pair(cond, sum);
   }
 
+  /* ************************************************************************* */
+  namespace {
+    // Products with more entries than this are eliminated as decision trees
+    const double kMaxTableSize = double(1 << 22);
+
+    // Decision trees with fewer leaves per table entry than this are sparse
+    const double kMinDensity = 0.5;
+
+    // Collect the cardinalities of all keys, false as soon as a factor is sparse
+    bool denseCardinalities(const DiscreteFactorGraph& factors,
+        std::map<Key, size_t>& cardinalities) {
+      for(const DiscreteFactor::shared_ptr& factor: factors) {
+        if (!factor) continue;
+        if (const TableFactor* table = dynamic_cast<const TableFactor*>(factor.get())) {
+          for(const DiscreteKey& key: table->discreteKeys())
+            cardinalities.insert(key);
+          continue;
+        }
+        const DecisionTreeFactor* tree = dynamic_cast<const DecisionTreeFactor*>(factor.get());
+        if (!tree) return false;
+        double size = 1.0;
+        for(Key j: tree->keys()) {
+          cardinalities[j] = tree->cardinality(j);
+          size *= tree->cardinality(j);
+        }
+        if (tree->nrLeaves() < kMinDensity * size) return false;
+      }
+      return true;
+    }
+  }
+
+  /* ************************************************************************* */
+  std::pair<DiscreteConditional::shared_ptr, DiscreteFactor::shared_ptr>  //
+  EliminateDiscreteTable(const DiscreteFactorGraph& factors, const Ordering& frontalKeys) {
+
+    // Convert all factors to tables
+    gttic(convert);
+    std::map<Key, size_t> cardinalities;
+    std::vector<TableFactor::shared_ptr> tables;
+    for(const DiscreteFactor::shared_ptr& factor: factors) {
+      if (!factor) continue;
+      TableFactor::shared_ptr table = boost::dynamic_pointer_cast<TableFactor>(factor);
+      if (!table) {
+        const DecisionTreeFactor* tree = dynamic_cast<const DecisionTreeFactor*>(factor.get());
+        table = boost::make_shared<TableFactor>(tree ? *tree : factor->toDecisionTreeFactor());
+      }
+      for(const DiscreteKey& key: table->discreteKeys())
+        cardinalities.insert(key);
+      tables.push_back(table);
+    }
+    gttoc(convert);
+
+    // The product has the frontals first, so that every column of the table
+    // viewed as a matrix corresponds to one assignment of the separator
+    DiscreteKeys keys;
+    for(Key j: frontalKeys) {
+      const auto it = cardinalities.find(j);
+      if (it == cardinalities.end())
+        throw std::invalid_argument("EliminateDiscreteTable: frontal key " +
+            DefaultKeyFormatter(j) + " does not appear in any factor");
+      keys.push_back(*it);
+    }
+    for(const auto& key: cardinalities)
+      if (std::find(frontalKeys.begin(), frontalKeys.end(), key.first) == frontalKeys.end())
+        keys.push_back(DiscreteKey(key.first, key.second));
+
+    // PRODUCT: multiply all factors
+    gttic(product);
+    const TableFactor product = TableFactor::Product(keys, tables);
+    gttoc(product);
+
+    // sum out frontals, this is the factor on the separator
+    gttic(sum);
+    const TableFactor::shared_ptr sum = product.sum(frontalKeys.size());
+    gttoc(sum);
+
+    // now divide product/sum to get conditional, with 0 where the sum is 0
+    gttic(divide);
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMajorMatrix;
+    const size_t nrSeparator = sum->table().size();
+    const Eigen::Map<const RowMajorMatrix> joint(product.table().data(),
+        product.table().size() / nrSeparator, nrSeparator);
+    const Vector inverse = sum->table().unaryExpr([](double s) { return s == 0 ? 0.0 : 1.0 / s; });
+    const RowMajorMatrix conditional = joint * inverse.asDiagonal();
+    DiscreteConditional::shared_ptr cond(new DiscreteConditional(frontalKeys.size(), keys,
+        std::vector<double>(conditional.data(), conditional.data() + conditional.size())));
+    gttoc(divide);
+
+    return std::make_pair(cond, sum);
+  }
+
+  /* ************************************************************************* */
+  std::pair<DiscreteConditional::shared_ptr, DiscreteFactor::shared_ptr>  //
+  EliminatePreferTable(const DiscreteFactorGraph& factors, const Ordering& frontalKeys) {
+    std::map<Key, size_t> cardinalities;
+    if (denseCardinalities(factors, cardinalities)) {
+      double size = 1.0;
+      for(const auto& key: cardinalities)
+        size *= key.second;
+      if (size <= kMaxTableSize)
+        return EliminateDiscreteTable(factors, frontalKeys);
+    }
+    return EliminateDiscrete(factors, frontalKeys);
+  }
+
 /* ************************************************************************* */
 } // namespace
 
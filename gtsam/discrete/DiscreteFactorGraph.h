@@ -22,6 +22,7 @@
 #include <gtsam/inference/EliminateableFactorGraph.h>
 #include <gtsam/inference/Ordering.h>
 #include <gtsam/discrete/DecisionTreeFactor.h>
+#include <gtsam/discrete/TableFactor.h>
 #include <gtsam/discrete/DiscreteBayesNet.h>
 #include <gtsam/base/FastSet.h>
 #include <boost/make_shared.hpp>
@@ -41,6 +42,22 @@ class DiscreteJunctionTree;
 GTSAM_EXPORT std::pair<boost::shared_ptr<DiscreteConditional>, DecisionTreeFactor::shared_ptr>
 EliminateDiscrete(const DiscreteFactorGraph& factors, const Ordering& keys);
 
+/** Eliminate by multiplying all factors into one dense table, see TableFactor */
+GTSAM_EXPORT std::pair<boost::shared_ptr<DiscreteConditional>, DiscreteFactor::shared_ptr>
+EliminateDiscreteTable(const DiscreteFactorGraph& factors, const Ordering& keys);
+
+/**
+ * Eliminate with dense tables (EliminateDiscreteTable) when all factors are
+ * dense, and with decision trees (EliminateDiscrete) when some factor is sparse,
+ * i.e. its decision tree has far fewer leaves than its table has entries, or
+ * when the product would be too large to store as a table.  Factors other
+ * than DecisionTreeFactor and TableFactor, such as constraints, always use
+ * decision trees.  Opt in by passing it as the elimination function, e.g.
+ * graph.eliminateSequential(ordering, EliminatePreferTable).
+ */
+GTSAM_EXPORT std::pair<boost::shared_ptr<DiscreteConditional>, DiscreteFactor::shared_ptr>
+EliminatePreferTable(const DiscreteFactorGraph& factors, const Ordering& keys);
+
 /* ************************************************************************* */
 template<> struct EliminationTraits<DiscreteFactorGraph>
 {
@@ -132,10 +149,10 @@ public:
   void print(const std::string& s = "DiscreteFactorGraph",
       const KeyFormatter& formatter =DefaultKeyFormatter) const;
 
-  /** Solve the factor graph by performing variable elimination in COLAMD order using
-   *  the dense elimination function specified in \c function,
-   *  followed by back-substitution resulting from elimination.  Is equivalent
-   *  to calling graph.eliminateSequential()->optimize(). */
+  /** Solve the factor graph by performing multifrontal elimination in COLAMD order,
+   *  followed by back-substitution in the resulting Bayes tree.  Both traverse the
+   *  tree in parallel when GTSAM is built with TBB.  Is equivalent to calling
+   *  graph.eliminateMultifrontal()->optimize(). */
   DiscreteFactor::sharedValues optimize() const;
 
 
@@ -0,0 +1,49 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file DiscreteISAM.cpp
+ * @brief Incremental inference in a DiscreteBayesTree
+ */
+
+#include <gtsam/discrete/DiscreteISAM.h>
+#include <gtsam/inference/ISAM-inst.h>
+
+namespace gtsam {
+
+  /* ************************************************************************* */
+  template<>
+  ISAM<DiscreteBayesTree>::Eliminate ISAM<DiscreteBayesTree>::EliminateWithOrphans(
+      const Eliminate& function) {
+    typedef BayesTreeOrphanWrapper<DiscreteBayesTreeClique> OrphanWrapper;
+    return [function](const DiscreteFactorGraph& factors, const Ordering& keys) {
+      // An orphan subtree sums to one over its own variables, so leaving it
+      // out does not change the product
+      DiscreteFactorGraph withoutOrphans;
+      withoutOrphans.reserve(factors.size());
+      for (const DiscreteFactor::shared_ptr& factor: factors)
+        if (!dynamic_cast<const OrphanWrapper*>(factor.get()))
+          withoutOrphans.push_back(factor);
+      return function(withoutOrphans, keys);
+    };
+  }
+
+  // Instantiate base class
+  template class ISAM<DiscreteBayesTree>;
+
+  /* ************************************************************************* */
+  DiscreteISAM::DiscreteISAM() {}
+
+  /* ************************************************************************* */
+  DiscreteISAM::DiscreteISAM(const DiscreteBayesTree& bayesTree) :
+    Base(bayesTree) {}
+
+}
@@ -0,0 +1,59 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file DiscreteISAM.h
+ * @brief Incremental inference in a DiscreteBayesTree
+ */
+
+#pragma once
+
+#include <gtsam/discrete/DiscreteBayesTree.h>
+#include <gtsam/inference/ISAM.h>
+
+namespace gtsam {
+
+  /**
+   * A DiscreteBayesTree that is updated incrementally: new factors only
+   * re-eliminate the cliques on the paths from their keys to the root, and the
+   * subtrees below those are kept as they are.
+   */
+  class GTSAM_EXPORT DiscreteISAM : public ISAM<DiscreteBayesTree>
+  {
+  public:
+    typedef ISAM<DiscreteBayesTree> Base;
+    typedef DiscreteISAM This;
+    typedef boost::shared_ptr<This> shared_ptr;
+
+    /// @name Standard Constructors
+    /// @{
+
+    /** Create an empty Bayes Tree */
+    DiscreteISAM();
+
+    /** Copy constructor */
+    DiscreteISAM(const DiscreteBayesTree& bayesTree);
+
+    /// @}
+
+  };
+
+  /**
+   * The orphaned subtrees take part in the re-elimination as placeholder
+   * factors on their separators, which hold no values, so they are left out of
+   * the factors passed to the discrete elimination function.  As a
+   * specialization of the base hook, this applies to every update of a
+   * DiscreteISAM, also through ISAM<DiscreteBayesTree>.
+   */
+  template<> GTSAM_EXPORT ISAM<DiscreteBayesTree>::Eliminate
+  ISAM<DiscreteBayesTree>::EliminateWithOrphans(const Eliminate& function);
+
+}
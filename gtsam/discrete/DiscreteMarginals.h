@@ -24,6 +24,8 @@
 #include <gtsam/discrete/DiscreteBayesTree.h>
 #include <gtsam/base/Vector.h>
 
+#include <map>
+
 namespace gtsam {
 
   /**
@@ -71,6 +73,27 @@ namespace gtsam {
     return vResult;
   }
 
+  /** Compute the marginals of all variables at once, in a single pass down the
+   *  Bayes tree instead of one elimination per variable
+   *   @return map from every variable to the Vector of its marginal
+   *   probabilities, indexed by state
+   */
+  std::map<Key, Vector> marginalProbabilities() const {
+    std::map<Key, Vector> result;
+    for (const auto& key_marginal : bayesTree_->marginals()) {
+      const Key j = key_marginal.first;
+      const DecisionTreeFactor& marginal = *key_marginal.second;
+      Vector vResult(marginal.cardinality(j));
+      for (size_t state = 0; state < marginal.cardinality(j); ++state) {
+        DiscreteFactor::Values values;
+        values[j] = state;
+        vResult(state) = marginal(values);
+      }
+      result.insert(result.end(), std::make_pair(j, vResult));
+    }
+    return result;
+  }
+
   };
 
 } /* namespace gtsam */
@@ -0,0 +1,321 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file TableFactor.cpp
+ * @brief discrete factor stored as a dense table
+ */
+
+#include <gtsam/discrete/TableFactor.h>
+#include <gtsam/discrete/DecisionTreeFactor.h>
+
+#include <boost/format.hpp>
+#include <boost/make_shared.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace gtsam {
+
+  namespace {
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMajorMatrix;
+    typedef Eigen::Map<const Vector, 0, Eigen::InnerStride<> > StridedVector;
+
+    // Number of entries in a table with the given cardinalities
+    size_t tableSize(const vector<size_t>& cardinalities) {
+      size_t size = 1;
+      for(size_t c: cardinalities)
+        size *= c;
+      return size;
+    }
+
+    // Stride of every key of layout in the table of factor keys, 0 for keys the factor does not involve
+    vector<size_t> strides(const KeyVector& layout, const KeyVector& keys,
+        const vector<size_t>& cardinalities) {
+      vector<size_t> result(layout.size(), 0);
+      size_t stride = 1;
+      for (size_t i = keys.size(); i-- > 0;) {
+        const KeyVector::const_iterator it = std::find(layout.begin(), layout.end(), keys[i]);
+        if (it == layout.end())
+          throw invalid_argument("TableFactor: the keys of the table do not include all keys of the factor");
+        result[it - layout.begin()] = stride;
+        stride *= cardinalities[i];
+      }
+      return result;
+    }
+
+    // Visit a table with the given cardinalities in runs along its last key:
+    // entries i..i+n-1 correspond to entries offset + k * stride of another table
+    template<class OP>
+    void forEachRun(const vector<size_t>& cardinalities, const vector<size_t>& strides, OP op) {
+      const size_t d = cardinalities.size();
+      if (d == 0) {
+        op(0, 0, 1, 0);
+        return;
+      }
+      const size_t n = cardinalities[d - 1], stride = strides[d - 1];
+      const size_t size = tableSize(cardinalities);
+      vector<size_t> digits(d - 1, 0);
+      size_t offset = 0;
+      for (size_t i = 0; i < size; i += n) {
+        op(i, offset, n, stride);
+        for (size_t k = d - 1; k-- > 0;) {
+          offset += strides[k];
+          if (++digits[k] < cardinalities[k]) break;
+          offset -= strides[k] * cardinalities[k];
+          digits[k] = 0;
+        }
+      }
+    }
+
+    // Copy the entries of a table into the layout given by strides
+    void gather(Vector& result, const vector<size_t>& cardinalities,
+        const vector<size_t>& strides, const Vector& table) {
+      result.resize(tableSize(cardinalities));
+      forEachRun(cardinalities, strides, [&](size_t i, size_t offset, size_t n, size_t stride) {
+        if (stride == 0)
+          result.segment(i, n).setConstant(table(offset));
+        else
+          result.segment(i, n) = StridedVector(table.data() + offset, n, Eigen::InnerStride<>(stride));
+      });
+    }
+
+    // Multiply the entries of a table into result, in the layout given by strides
+    void multiply(Vector& result, const vector<size_t>& cardinalities,
+        const vector<size_t>& strides, const Vector& table) {
+      forEachRun(cardinalities, strides, [&](size_t i, size_t offset, size_t n, size_t stride) {
+        if (stride == 0)
+          result.segment(i, n) *= table(offset);
+        else if (stride == 1)
+          result.segment(i, n).array() *= table.segment(offset, n).array();
+        else
+          result.segment(i, n).array() *=
+              StridedVector(table.data() + offset, n, Eigen::InnerStride<>(stride)).array();
+      });
+    }
+
+    vector<size_t> cardinalitiesOf(const DiscreteKeys& keys) {
+      vector<size_t> cardinalities;
+      cardinalities.reserve(keys.size());
+      for(const DiscreteKey& key: keys)
+        cardinalities.push_back(key.second);
+      return cardinalities;
+    }
+
+    // View a table as a matrix with one row per assignment of the frontal keys
+    // that come before the separator keys
+    Eigen::Map<const RowMajorMatrix> frontalRows(const Vector& table, const DiscreteKeys& separator) {
+      const size_t cols = tableSize(cardinalitiesOf(separator));
+      return Eigen::Map<const RowMajorMatrix>(table.data(), table.size() / cols, cols);
+    }
+
+    vector<double> parse(const string& table) {
+      vector<double> values;
+      istringstream iss(table);
+      copy(istream_iterator<double>(iss), istream_iterator<double>(), back_inserter(values));
+      return values;
+    }
+
+    DiscreteKeys keysOf(const DecisionTreeFactor& f) {
+      DiscreteKeys keys;
+      for(Key j: f.keys())
+        keys.push_back(DiscreteKey(j, f.cardinality(j)));
+      return keys;
+    }
+  }
+
+  /* ************************************************************************* */
+  TableFactor::TableFactor() : table_(Vector::Ones(1)) {
+  }
+
+  /* ************************************************************************* */
+  TableFactor::TableFactor(const DiscreteKeys& keys, const Vector& table) :
+      DiscreteFactor(keys.indices()), cardinalities_(cardinalitiesOf(keys)), table_(table) {
+    if (size_t(table_.size()) != tableSize(cardinalities_))
+      throw invalid_argument((boost::format(
+          "TableFactor: expected %d values but got %d instead")
+          % tableSize(cardinalities_) % table_.size()).str());
+  }
+
+  /* ************************************************************************* */
+  TableFactor::TableFactor(const DiscreteKeys& keys, const vector<double>& table) :
+      TableFactor(keys, Vector(Eigen::Map<const Vector>(table.data(), table.size()))) {
+  }
+
+  /* ************************************************************************* */
+  TableFactor::TableFactor(const DiscreteKeys& keys, const string& table) :
+      TableFactor(keys, parse(table)) {
+  }
+
+  /* ************************************************************************* */
+  TableFactor::TableFactor(const DiscreteKeys& keys, const DiscreteFactor& f) :
+      DiscreteFactor(keys.indices()), cardinalities_(cardinalitiesOf(keys)) {
+    if (const TableFactor* table = dynamic_cast<const TableFactor*>(&f)) {
+      gather(table_, cardinalities_, strides(keys_, table->keys(), table->cardinalities_),
+          table->table_);
+      return;
+    }
+
+    // Evaluate f for every assignment, in table order
+    table_.resize(tableSize(cardinalities_));
+    Values values;
+    for (size_t k = 0; k < keys_.size(); ++k)
+      values[keys_[k]] = 0;
+    for (size_t i = 0; i < size_t(table_.size()); ++i) {
+      table_(i) = f(values);
+      for (size_t k = keys_.size(); k-- > 0;) {
+        size_t& digit = values[keys_[k]];
+        if (++digit < cardinalities_[k]) break;
+        digit = 0;
+      }
+    }
+  }
+
+  /* ************************************************************************* */
+  TableFactor::TableFactor(const DecisionTreeFactor& f) :
+      TableFactor(keysOf(f), f) {
+  }
+
+  /* ************************************************************************* */
+  TableFactor TableFactor::Product(const DiscreteKeys& keys,
+      const vector<shared_ptr>& factors) {
+    TableFactor result;
+    result.keys_ = keys.indices();
+    result.cardinalities_ = cardinalitiesOf(keys);
+    result.table_ = Vector::Ones(tableSize(result.cardinalities_));
+    for(const shared_ptr& factor: factors)
+      if (factor)
+        multiply(result.table_, result.cardinalities_,
+            strides(result.keys_, factor->keys_, factor->cardinalities_), factor->table_);
+    return result;
+  }
+
+  /* ************************************************************************* */
+  bool TableFactor::equals(const DiscreteFactor& other, double tol) const {
+    const TableFactor* f = dynamic_cast<const TableFactor*>(&other);
+    return f && keys_ == f->keys_ && cardinalities_ == f->cardinalities_
+        && equal_with_abs_tol(table_, f->table_, tol);
+  }
+
+  /* ************************************************************************* */
+  void TableFactor::print(const string& s, const KeyFormatter& formatter) const {
+    cout << s << "  Cardinalities: ";
+    for (size_t k = 0; k < keys_.size(); ++k)
+      cout << formatter(keys_[k]) << "=" << cardinalities_[k] << " ";
+    cout << "\n  Table: " << table_.transpose() << endl;
+  }
+
+  /* ************************************************************************* */
+  double TableFactor::operator()(const Values& values) const {
+    size_t index = 0;
+    for (size_t k = 0; k < keys_.size(); ++k)
+      index = index * cardinalities_[k] + values.at(keys_[k]);
+    return table_(index);
+  }
+
+  /* ************************************************************************* */
+  DecisionTreeFactor TableFactor::operator*(const DecisionTreeFactor& f) const {
+    return toDecisionTreeFactor() * f;
+  }
+
+  /* ************************************************************************* */
+  TableFactor TableFactor::operator*(const TableFactor& f) const {
+    DiscreteKeys keys = discreteKeys();
+    for (size_t k = 0; k < f.keys_.size(); ++k)
+      if (std::find(keys_.begin(), keys_.end(), f.keys_[k]) == keys_.end())
+        keys.push_back(DiscreteKey(f.keys_[k], f.cardinalities_[k]));
+    TableFactor result(keys, *this);
+    multiply(result.table_, result.cardinalities_,
+        strides(result.keys_, f.keys_, f.cardinalities_), f.table_);
+    return result;
+  }
+
+  /* ************************************************************************* */
+  DecisionTreeFactor TableFactor::toDecisionTreeFactor() const {
+    if (keys_.empty())
+      return DecisionTreeFactor(DiscreteKeys(), Potentials::ADT(DecisionTree<Key, double>(table_(0))));
+    return DecisionTreeFactor(discreteKeys(),
+        vector<double>(table_.data(), table_.data() + table_.size()));
+  }
+
+  /* ************************************************************************* */
+  size_t TableFactor::cardinality(Key j) const {
+    const KeyVector::const_iterator it = std::find(keys_.begin(), keys_.end(), j);
+    if (it == keys_.end())
+      throw invalid_argument("TableFactor::cardinality: key is not in the factor");
+    return cardinalities_[it - keys_.begin()];
+  }
+
+  /* ************************************************************************* */
+  DiscreteKeys TableFactor::discreteKeys() const {
+    DiscreteKeys keys;
+    for (size_t k = 0; k < keys_.size(); ++k)
+      keys.push_back(DiscreteKey(keys_[k], cardinalities_[k]));
+    return keys;
+  }
+
+  /* ************************************************************************* */
+  DiscreteKeys TableFactor::separatorKeys(size_t nrFrontals) const {
+    DiscreteKeys keys;
+    for (size_t k = nrFrontals; k < keys_.size(); ++k)
+      keys.push_back(DiscreteKey(keys_[k], cardinalities_[k]));
+    return keys;
+  }
+
+  /* ************************************************************************* */
+  TableFactor TableFactor::moveToFront(const Ordering& frontalKeys) const {
+    DiscreteKeys keys;
+    for(Key j: frontalKeys)
+      keys.push_back(DiscreteKey(j, cardinality(j)));
+    for (size_t k = 0; k < keys_.size(); ++k)
+      if (std::find(frontalKeys.begin(), frontalKeys.end(), keys_[k]) == frontalKeys.end())
+        keys.push_back(DiscreteKey(keys_[k], cardinalities_[k]));
+    return TableFactor(keys, *this);
+  }
+
+  /* ************************************************************************* */
+  TableFactor::shared_ptr TableFactor::sum(size_t nrFrontals) const {
+    if (nrFrontals > size()) throw invalid_argument(
+        (boost::format(
+            "TableFactor::sum: invalid number of frontal keys %d, nr.keys=%d")
+            % nrFrontals % size()).str());
+    const DiscreteKeys keys = separatorKeys(nrFrontals);
+    const Eigen::Map<const RowMajorMatrix> joint = frontalRows(table_, keys);
+    return boost::make_shared<TableFactor>(keys, Vector(joint.colwise().sum().transpose()));
+  }
+
+  /* ************************************************************************* */
+  TableFactor::shared_ptr TableFactor::sum(const Ordering& keys) const {
+    return moveToFront(keys).sum(keys.size());
+  }
+
+  /* ************************************************************************* */
+  TableFactor::shared_ptr TableFactor::max(size_t nrFrontals) const {
+    if (nrFrontals > size()) throw invalid_argument(
+        (boost::format(
+            "TableFactor::max: invalid number of frontal keys %d, nr.keys=%d")
+            % nrFrontals % size()).str());
+    const DiscreteKeys keys = separatorKeys(nrFrontals);
+    const Eigen::Map<const RowMajorMatrix> joint = frontalRows(table_, keys);
+    return boost::make_shared<TableFactor>(keys, Vector(joint.colwise().maxCoeff().transpose()));
+  }
+
+  /* ************************************************************************* */
+  TableFactor::shared_ptr TableFactor::max(const Ordering& keys) const {
+    return moveToFront(keys).max(keys.size());
+  }
+
+/* ************************************************************************* */
+} // namespace gtsam
@@ -0,0 +1,151 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file TableFactor.h
+ * @brief discrete factor stored as a dense table
+ */
+
+#pragma once
+
+#include <gtsam/discrete/DiscreteFactor.h>
+#include <gtsam/discrete/DiscreteKey.h>
+#include <gtsam/inference/Ordering.h>
+#include <gtsam/base/Vector.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace gtsam {
+
+  class DecisionTreeFactor;
+
+  /**
+   * A discrete factor stored as a dense table of values, one for every
+   * assignment of its keys, with the last key varying fastest.  This is the
+   * layout in which a DecisionTreeFactor is specified from a table.
+   *
+   * Products, sums and maximization run as flat loops over the table, without
+   * the node allocations of decision trees, which makes TableFactor the better
+   * choice for dense factors over variables of small cardinality.  Factors
+   * with many equal values, such as constraints, are smaller and faster as a
+   * DecisionTreeFactor.
+   */
+  class GTSAM_EXPORT TableFactor: public DiscreteFactor {
+
+  public:
+
+    // typedefs needed to play nice with gtsam
+    typedef TableFactor This;
+    typedef DiscreteFactor Base; ///< Typedef to base class
+    typedef boost::shared_ptr<TableFactor> shared_ptr;
+
+  private:
+
+    std::vector<size_t> cardinalities_; ///< Cardinality of every key
+    Vector table_; ///< Values in row-major order of the keys
+
+  public:
+
+    /// @name Standard Constructors
+    /// @{
+
+    /** Default constructor creates the constant factor 1 */
+    TableFactor();
+
+    /** Constructor from keys and a table with the last key varying fastest */
+    TableFactor(const DiscreteKeys& keys, const Vector& table);
+
+    /** Constructor from keys and a table with the last key varying fastest */
+    TableFactor(const DiscreteKeys& keys, const std::vector<double>& table);
+
+    /** Constructor from keys and a string of values, as for DecisionTreeFactor */
+    TableFactor(const DiscreteKeys& keys, const std::string& table);
+
+    /** Convert a factor into a table over the given keys, in that order */
+    TableFactor(const DiscreteKeys& keys, const DiscreteFactor& f);
+
+    /** Convert a DecisionTreeFactor, keeping its keys in the same order */
+    explicit TableFactor(const DecisionTreeFactor& f);
+
+    /**
+     * Product of factors as a table over the given keys, which have to
+     * include the keys of all factors.  This is faster than multiplying the
+     * factors one by one, as it creates no intermediate tables.
+     */
+    static TableFactor Product(const DiscreteKeys& keys,
+        const std::vector<shared_ptr>& factors);
+
+    /// @}
+    /// @name Testable
+    /// @{
+
+    /// equality
+    bool equals(const DiscreteFactor& other, double tol = 1e-9) const;
+
+    // print
+    virtual void print(const std::string& s = "TableFactor:\n",
+        const KeyFormatter& formatter = DefaultKeyFormatter) const;
+
+    /// @}
+    /// @name Standard Interface
+    /// @{
+
+    /// Value for an assignment of values to (at least) the keys of the factor
+    virtual double operator()(const Values& values) const;
+
+    /// Multiply with a DecisionTreeFactor, the result is a DecisionTreeFactor
+    virtual DecisionTreeFactor operator*(const DecisionTreeFactor& f) const;
+
+    /// multiply two factors, the result has the keys of this factor followed by new keys of f
+    TableFactor operator*(const TableFactor& f) const;
+
+    /// Convert into a decisiontree
+    virtual DecisionTreeFactor toDecisionTreeFactor() const;
+
+    /// Cardinality of a key of the factor
+    size_t cardinality(Key j) const;
+
+    /// The keys with their cardinalities, in table order
+    DiscreteKeys discreteKeys() const;
+
+    /// The values, with the last key varying fastest
+    const Vector& table() const { return table_; }
+
+    /// Create new factor by summing out the first nrFrontals keys
+    shared_ptr sum(size_t nrFrontals) const;
+
+    /// Create new factor by summing out keys
+    shared_ptr sum(const Ordering& keys) const;
+
+    /// Create new factor by maximizing over the first nrFrontals keys
+    shared_ptr max(size_t nrFrontals) const;
+
+    /// Create new factor by maximizing over keys
+    shared_ptr max(const Ordering& keys) const;
+
+    /// @}
+
+  private:
+    /// The keys after the first nrFrontals, with their cardinalities
+    DiscreteKeys separatorKeys(size_t nrFrontals) const;
+
+    /// The same factor with the given keys first, followed by the others in their current order
+    TableFactor moveToFront(const Ordering& keys) const;
+  };
+// TableFactor
+
+// traits
+template<> struct traits<TableFactor> : public Testable<TableFactor> {};
+
+}// namespace gtsam
@@ -29,6 +29,8 @@ using namespace boost::assign;
 //#define DT_NO_PRUNING
 #define DISABLE_DOT
 #include <gtsam/discrete/DecisionTree-inl.h>
+
+#include <thread>
 using namespace std;
 using namespace gtsam;
 
@@ -242,6 +244,49 @@ TEST(DT, Compose)
   DOT(f5);
 }
 
+/* ******************************************************************************** */
+// test that equal trees share their nodes
+TEST(DT, sharing)
+{
+  string A("A"), B("B");
+  vector<DT::LabelC> keys;
+  keys += DT::LabelC(A,2), DT::LabelC(B,2);
+
+  // Trees built separately are the same node
+  DT f1(keys, "0 2 1 3"), f2(B, DT(A, 0, 1), DT(A, 2, 3));
+  EXPECT(f1.root_ == f2.root_);
+
+  // Branches that are the same collapse into one
+  DT f3(A, DT(B, 5, 6), DT(B, 5, 6));
+  EXPECT(f3.root_ == DT(B, 5, 6).root_);
+
+  // Results of apply are shared as well
+  DT g = f1.apply(f2, &Ring::add);
+  EXPECT(g.root_ == DT(keys, "0 4 2 6").root_);
+}
+
+/* ******************************************************************************** */
+// test that equal leaves collapse even when they are not the same node
+TEST(DT, sameLeafOtherThread)
+{
+  string A("A");
+
+  // Unique tables are per thread, so this leaf is another node than DT(5)
+  DT other(0);
+  std::thread([&other]() { other = DT(5); }).join();
+  EXPECT(other.root_ != DT(5).root_);
+
+  DT f(A, other, DT(5));
+  EXPECT(f.root_->isLeaf());
+  EXPECT(f == DT(5));
+
+  // Only hashable types are hash-consed
+  struct Unhashable {};
+  EXPECT(internal::hash_detail::IsHashable<int>::value);
+  EXPECT(internal::hash_detail::IsHashable<string>::value);
+  EXPECT(!internal::hash_detail::IsHashable<Unhashable>::value);
+}
+
 /* ************************************************************************* */
 int main() {
   TestResult tr;
@@ -0,0 +1,125 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/*
+ * testDiscreteISAM.cpp
+ * @brief unit tests for DiscreteISAM
+ */
+
+#include <gtsam/discrete/DiscreteISAM.h>
+#include <gtsam/base/Testable.h>
+#include <CppUnitLite/TestHarness.h>
+
+using namespace std;
+using namespace gtsam;
+
+/* ************************************************************************* */
+namespace {
+  // A chain x0 - x1 - x2 - x3 - x4 with mixed cardinalities
+  DiscreteKeys chainKeys() {
+    DiscreteKeys keys;
+    for (size_t j = 0; j < 5; j++)
+      keys.push_back(DiscreteKey(j, 2 + j % 2));
+    return keys;
+  }
+
+  DiscreteFactorGraph chain(const DiscreteKeys& keys) {
+    DiscreteFactorGraph graph;
+    graph.add(keys[0], "0.4 0.6");
+    graph.add(keys[0] & keys[1], "1 2 3  4 5 6");
+    graph.add(keys[1] & keys[2], "3 1  2 2  1 4");
+    graph.add(keys[2] & keys[3], "1 1 3  2 5 1");
+    graph.add(keys[3] & keys[4], "2 1  1 3  4 4");
+    return graph;
+  }
+
+  // The marginals and the MPE of two Bayes trees agree
+  bool sameDensity(const DiscreteBayesTree& expected, const DiscreteBayesTree& actual) {
+    bool same = assert_equal(*expected.optimize(), *actual.optimize());
+    const map<Key, DecisionTreeFactor::shared_ptr> expectedMarginals = expected.marginals();
+    const map<Key, DecisionTreeFactor::shared_ptr> actualMarginals = actual.marginals();
+    same = same && expectedMarginals.size() == actualMarginals.size();
+    for (const auto& key_marginal : expectedMarginals)
+      same = same && actualMarginals.count(key_marginal.first) &&
+          assert_equal(*key_marginal.second, *actualMarginals.at(key_marginal.first), 1e-9);
+    return same;
+  }
+}
+
+/* ************************************************************************* */
+TEST( DiscreteISAM, update )
+{
+  const DiscreteKeys keys = chainKeys();
+  const DiscreteFactorGraph graph = chain(keys);
+  const Ordering ordering = Ordering::Natural(graph);
+  DiscreteISAM isam(*graph.eliminateMultifrontal(ordering));
+  const DiscreteBayesTreeClique::shared_ptr leaf = isam[0];
+
+  // New evidence on the last variable only re-eliminates the top of the tree
+  DiscreteFactorGraph newFactors;
+  newFactors.add(keys[4], "0.9 0.1");
+  isam.update(newFactors);
+
+  DiscreteFactorGraph fullGraph = graph;
+  fullGraph.push_back(newFactors);
+  EXPECT(sameDensity(*fullGraph.eliminateMultifrontal(), isam));
+  EXPECT(leaf == isam[0]);
+
+  // A factor closing a loop re-eliminates the whole chain
+  DiscreteFactorGraph loop;
+  loop.add(keys[0] & keys[4], "1 5  5 1");
+  isam.update(loop);
+  fullGraph.push_back(loop);
+  EXPECT(sameDensity(*fullGraph.eliminateMultifrontal(), isam));
+}
+
+/* ************************************************************************* */
+TEST( DiscreteISAM, fromEmpty )
+{
+  // Adding the factors one at a time gives the same density as batch
+  const DiscreteKeys keys = chainKeys();
+  const DiscreteFactorGraph graph = chain(keys);
+  DiscreteISAM isam;
+  for (const DiscreteFactor::shared_ptr& factor : graph) {
+    DiscreteFactorGraph newFactors;
+    newFactors.push_back(factor);
+    isam.update(newFactors);
+  }
+  EXPECT(sameDensity(*graph.eliminateMultifrontal(), isam));
+}
+
+/* ************************************************************************* */
+TEST( DiscreteISAM, throughBase )
+{
+  // Updating through the ISAM base class leaves the orphans out as well
+  const DiscreteKeys keys = chainKeys();
+  const DiscreteFactorGraph graph = chain(keys);
+  const Ordering ordering = Ordering::Natural(graph);
+  DiscreteISAM isam(*graph.eliminateMultifrontal(ordering));
+  ISAM<DiscreteBayesTree>& base = isam;
+
+  DiscreteFactorGraph newFactors;
+  newFactors.add(keys[4], "0.9 0.1");
+  DiscreteBayesTree::Cliques orphans;
+  base.updateInternal(newFactors, &orphans);
+  EXPECT(!orphans.empty());
+
+  DiscreteFactorGraph fullGraph = graph;
+  fullGraph.push_back(newFactors);
+  EXPECT(sameDensity(*fullGraph.eliminateMultifrontal(), isam));
+}
+
+/* ************************************************************************* */
+int main() {
+  TestResult tr;
+  return TestRegistry::runAllTests(tr);
+}
+/* ************************************************************************* */
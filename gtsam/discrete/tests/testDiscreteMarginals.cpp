@@ -179,6 +179,8 @@ TEST_UNSAFE( DiscreteMarginals, truss2 ) {
   // Check all marginals given by a sequential solver and Marginals
 //  DiscreteSequentialSolver solver(graph);
   DiscreteMarginals marginals(graph);
+  const map<Key, Vector> allMarginals = marginals.marginalProbabilities();
+  LONGS_EQUAL(5, allMarginals.size());
   for (size_t j=0;j<5;j++) {
     double sum = T[j]+F[j];
     T[j]/=sum;
@@ -194,9 +196,37 @@ TEST_UNSAFE( DiscreteMarginals, truss2 ) {
     DecisionTreeFactor expectedM(key[j],table);
     DiscreteFactor::shared_ptr actualM = marginals(j);
     EXPECT(assert_equal(expectedM, *boost::dynamic_pointer_cast<DecisionTreeFactor>(actualM)));
+
+    // All marginals at once
+    EXPECT(assert_equal(Vector2(F[j], T[j]), allMarginals.at(j)));
   }
 }
 
+/* ************************************************************************* */
+// All marginals at once agree with the marginals one at a time
+TEST_UNSAFE( DiscreteMarginals, allMarginals ) {
+
+  // A tree with branches, so that the Bayes tree has several cliques
+  DiscreteKeys keys;
+  for (size_t j = 0; j < 8; j++)
+    keys.push_back(DiscreteKey(j, 2 + j % 2));
+  DiscreteFactorGraph graph;
+  graph.add(keys[0], "0.3 0.7");
+  graph.add(keys[0] & keys[1], "1 2 3 4 5 6");
+  graph.add(keys[1] & keys[2], "2 7 1 8 2 8");
+  graph.add(keys[1] & keys[3], "1 9 3 2 2 2 4 1 1");
+  graph.add(keys[3] & keys[4], "6 1 3 2 5 4");
+  graph.add(keys[0] & keys[5], "1 4 6 2 3 5");
+  graph.add(keys[5] & keys[6], "9 1 1 9 5 5");
+  graph.add(keys[5] & keys[7], "1 2 3 4 5 6 7 8 9");
+
+  DiscreteMarginals marginals(graph);
+  const map<Key, Vector> allMarginals = marginals.marginalProbabilities();
+  LONGS_EQUAL(8, allMarginals.size());
+  for (const DiscreteKey& key : keys)
+    EXPECT(assert_equal(marginals.marginalProbabilities(key), allMarginals.at(key.first), 1e-9));
+}
+
 /* ************************************************************************* */
 int main() {
   TestResult tr;
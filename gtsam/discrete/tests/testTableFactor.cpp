@@ -0,0 +1,171 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/*
+ * testTableFactor.cpp
+ * @brief unit tests for TableFactor
+ */
+
+#include <gtsam/discrete/TableFactor.h>
+#include <gtsam/discrete/DecisionTreeFactor.h>
+#include <gtsam/discrete/DiscreteConditional.h>
+#include <gtsam/discrete/DiscreteFactorGraph.h>
+#include <gtsam/base/Testable.h>
+#include <CppUnitLite/TestHarness.h>
+#include <boost/assign/std/vector.hpp>
+using namespace boost::assign;
+
+using namespace std;
+using namespace gtsam;
+
+/* ************************************************************************* */
+TEST( TableFactor, constructors)
+{
+  DiscreteKey X(0,2), Y(1,3), Z(2,2);
+
+  TableFactor f1(X, "2 8");
+  TableFactor f2(X & Y, "2 5 3 6 4 7");
+  TableFactor f3(X & Y & Z, "2 5 3 6 4 7 25 55 35 65 45 75");
+  EXPECT_LONGS_EQUAL(1,f1.size());
+  EXPECT_LONGS_EQUAL(2,f2.size());
+  EXPECT_LONGS_EQUAL(3,f3.size());
+  EXPECT_LONGS_EQUAL(3,f3.cardinality(1));
+
+  TableFactor::Values values;
+  values[0] = 1; // x
+  values[1] = 2; // y
+  values[2] = 1; // z
+  EXPECT_DOUBLES_EQUAL(8, f1(values), 1e-9);
+  EXPECT_DOUBLES_EQUAL(7, f2(values), 1e-9);
+  EXPECT_DOUBLES_EQUAL(75, f3(values), 1e-9);
+
+  CHECK_EXCEPTION(TableFactor(X & Y, "1 2 3"), std::invalid_argument);
+}
+
+/* ************************************************************************* */
+TEST( TableFactor, conversion)
+{
+  DiscreteKey X(0,2), Y(1,3), Z(2,2);
+  const DecisionTreeFactor tree(X & Y & Z, "2 5 3 6 4 7 25 55 35 65 45 75");
+
+  const TableFactor table(tree);
+  EXPECT(assert_equal(TableFactor(X & Y & Z, "2 5 3 6 4 7 25 55 35 65 45 75"), table));
+  EXPECT(assert_equal(tree, table.toDecisionTreeFactor()));
+
+  // Same factor with the keys in a different order
+  const TableFactor reordered(Z & X & Y, table);
+  EXPECT(assert_equal(TableFactor(Z & X & Y, "2 3 4 25 35 45 5 6 7 55 65 75"), reordered));
+  EXPECT(assert_equal(table, TableFactor(X & Y & Z, reordered)));
+  EXPECT(assert_equal(reordered, TableFactor(Z & X & Y, tree)));
+}
+
+/* ************************************************************************* */
+TEST( TableFactor, multiplication)
+{
+  DiscreteKey v0(0,2), v1(1,2), v2(2,2);
+
+  TableFactor f1(v0 & v1, "1 2 3 4");
+  TableFactor f2(v1 & v2, "5 6 7 8");
+  TableFactor expected(v0 & v1 & v2, "5 6 14 16 15 18 28 32");
+  EXPECT(assert_equal(expected, f1 * f2));
+
+  vector<TableFactor::shared_ptr> factors;
+  factors += boost::make_shared<TableFactor>(f1), boost::make_shared<TableFactor>(f2);
+  EXPECT(assert_equal(expected, TableFactor::Product(v0 & v1 & v2, factors)));
+
+  // Multiplying with a DecisionTreeFactor gives the same values
+  const DecisionTreeFactor product = f1 * f2.toDecisionTreeFactor();
+  EXPECT(assert_equal(expected.toDecisionTreeFactor(), product));
+}
+
+/* ************************************************************************* */
+TEST( TableFactor, sum_max)
+{
+  DiscreteKey v0(0,3), v1(1,2);
+  TableFactor f1(v0 & v1, "1 2  3 4  5 6");
+
+  TableFactor expected(v1, "9 12");
+  TableFactor::shared_ptr actual = f1.sum(1);
+  CHECK(assert_equal(expected, *actual, 1e-5));
+
+  TableFactor expected2(v1, "5 6");
+  TableFactor::shared_ptr actual2 = f1.max(1);
+  CHECK(assert_equal(expected2, *actual2));
+
+  Ordering frontals;
+  frontals += Key(1);
+  TableFactor expected3(v0, "3 7 11");
+  CHECK(assert_equal(expected3, *f1.sum(frontals)));
+  TableFactor expected4(v0, "2 4 6");
+  CHECK(assert_equal(expected4, *f1.max(frontals)));
+
+  // Agrees with DecisionTreeFactor
+  const DecisionTreeFactor tree = f1.toDecisionTreeFactor();
+  CHECK(assert_equal(*tree.sum(frontals), f1.sum(frontals)->toDecisionTreeFactor()));
+}
+
+/* ************************************************************************* */
+TEST( TableFactor, eliminate)
+{
+  DiscreteKey A(0,2), B(1,3), C(2,2);
+  DiscreteFactorGraph graph;
+  graph.add(A & B, "0.1 0.5 0.4 0.2 0.3 0.5");
+  graph.add(B & C, "0.3 0.7 0.6 0.4 0.9 0.1");
+  graph.push_back(boost::make_shared<TableFactor>(A, "0.8 0.2"));
+
+  Ordering frontals;
+  frontals += Key(1), Key(0);
+  const auto expected = EliminateDiscrete(graph, frontals);
+  const auto actual = EliminateDiscreteTable(graph, frontals);
+  EXPECT(assert_equal(*expected.first, *actual.first));
+  EXPECT(expected.first->keys() == actual.first->keys());
+  EXPECT(assert_equal<DiscreteFactor>(TableFactor(*expected.second), *actual.second));
+
+  // Dense graphs are eliminated with tables, sparse ones with decision trees
+  EXPECT(boost::dynamic_pointer_cast<TableFactor>(EliminatePreferTable(graph, frontals).second));
+  graph.add(A & B & C, "1 1 1 1 1 1  1 1 1 1 1 0");
+  EXPECT(boost::dynamic_pointer_cast<DecisionTreeFactor>(EliminatePreferTable(graph, frontals).second));
+
+  // A frontal that no factor involves has no known cardinality
+  Ordering missing;
+  missing += Key(1), Key(7);
+  CHECK_EXCEPTION(EliminateDiscreteTable(graph, missing), std::invalid_argument);
+}
+
+/* ************************************************************************* */
+TEST( TableFactor, optimize)
+{
+  // Chain of dense factors, solved with tables when asked to
+  DiscreteFactorGraph graph;
+  DiscreteKeys keys;
+  for (size_t i = 0; i < 6; i++)
+    keys.push_back(DiscreteKey(i, 3));
+  graph.add(keys[0], "0.2 0.5 0.3");
+  for (size_t i = 0; i + 1 < keys.size(); i++)
+    graph.push_back(boost::make_shared<TableFactor>(keys[i] & keys[i + 1],
+        "0.1 0.6 0.3  0.7 0.2 0.1  0.3 0.3 0.4"));
+
+  DiscreteFactorGraph trees;
+  for (const DiscreteFactor::shared_ptr& factor : graph)
+    trees.push_back(boost::make_shared<DecisionTreeFactor>(factor->toDecisionTreeFactor()));
+
+  const Ordering ordering = Ordering::Natural(graph);
+  EXPECT(assert_equal(*trees.eliminateSequential(ordering),
+      *graph.eliminateSequential(ordering, EliminatePreferTable)));
+  EXPECT(assert_equal(*trees.optimize(), *graph.optimize()));
+}
+
+/* ************************************************************************* */
+int main() {
+  TestResult tr;
+  return TestRegistry::runAllTests(tr);
+}
+/* ************************************************************************* */
@@ -0,0 +1,58 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    LieBatch.cpp
+ * @brief   Vectorized kernels for batch Lie group operations
+ */
+
+#include <gtsam/geometry/LieBatch.h>
+
+#include <limits>
+
+namespace gtsam {
+
+namespace so3 {
+
+/* ************************************************************************* */
+void ExpmapBatch(const Eigen::Matrix<double, 3, Eigen::Dynamic>& omegas,
+    SO3* R, Matrix3* H) {
+  // Same quantities as in ExpmapFunctor and DexpFunctor, for all columns
+  const Eigen::ArrayXd theta2 = omegas.colwise().squaredNorm().transpose();
+  const Eigen::ArrayXd theta = theta2.sqrt();
+  const Eigen::ArrayXd sin_theta = theta.sin();
+  const Eigen::ArrayXd s2 = (0.5 * theta).sin();
+  const Eigen::ArrayXd one_minus_cos = 2.0 * s2 * s2;
+
+  const double eps = std::numeric_limits<double>::epsilon();
+  for (Eigen::Index i = 0; i < omegas.cols(); i++) {
+    const double wx = omegas(0, i), wy = omegas(1, i), wz = omegas(2, i);
+    Matrix3 W;
+    W << 0.0, -wz, +wy, +wz, 0.0, -wx, -wy, +wx, 0.0;
+    if (theta2(i) <= eps) {
+      R[i] = I_3x3 + W;
+      if (H) H[i] = I_3x3 - 0.5 * W;
+    } else {
+      const Matrix3 K = W / theta(i);
+      const Matrix3 KK = K * K;
+      R[i] = I_3x3 + sin_theta(i) * K + one_minus_cos(i) * KK;
+      if (H) {
+        const double a = one_minus_cos(i) / theta(i);
+        const double b = 1.0 - sin_theta(i) / theta(i);
+        H[i] = I_3x3 - a * K + b * KK;
+      }
+    }
+  }
+}
+
+}  // namespace so3
+
+}  // namespace gtsam
@@ -0,0 +1,163 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    LieBatch.h
+ * @brief   Lie group operations applied to arrays of elements at once
+ */
+
+#pragma once
+
+#include <gtsam/geometry/Pose2.h>
+#include <gtsam/geometry/Pose3.h>
+#include <gtsam/geometry/Rot2.h>
+#include <gtsam/geometry/Rot3.h>
+#include <gtsam/geometry/SO3.h>
+
+#include <stdexcept>
+#include <vector>
+
+namespace gtsam {
+
+namespace so3 {
+
+/**
+ * Exponential map of all columns of omegas, with optional derivatives.
+ * The rotation angles and Rodrigues coefficients are computed for the whole
+ * batch with Eigen array expressions, which vectorize, after which every
+ * rotation is assembled with fixed-size 3x3 code.
+ * Matches SO3::Expmap column by column.
+ * @param omegas 3*n matrix of tangent vectors
+ * @param R output array of n rotations
+ * @param H optional output array of n derivatives
+ */
+GTSAM_EXPORT void ExpmapBatch(const Eigen::Matrix<double, 3, Eigen::Dynamic>& omegas,
+    SO3* R, Matrix3* H = nullptr);
+
+}  // namespace so3
+
+/**
+ * Compose, inverse, between, Expmap and Logmap on arrays of Lie group
+ * elements, with optional arrays of derivatives. Works through traits<T>,
+ * so it is agnostic of the rotation representation chosen at compile time,
+ * and is specialized where a type admits a vectorized kernel.
+ * Tangent vectors are passed as the columns of a dimension*n matrix.
+ */
+template <class T>
+struct LieBatch {
+  typedef traits<T> Traits;
+  enum { N = Traits::dimension };
+  typedef Eigen::Matrix<double, N, N> Jacobian;
+  typedef Eigen::Matrix<double, N, Eigen::Dynamic> Tangents;
+  typedef std::vector<T, Eigen::aligned_allocator<T> > Elements;
+  typedef std::vector<Jacobian, Eigen::aligned_allocator<Jacobian> > Jacobians;
+
+  /// Elementwise g[i] * h[i]
+  static Elements Compose(const Elements& g, const Elements& h,
+      Jacobians* H1 = nullptr, Jacobians* H2 = nullptr) {
+    CheckSizes(g.size(), h.size());
+    const size_t n = g.size();
+    Elements result;
+    result.reserve(n);
+    Resize(H1, n);
+    Resize(H2, n);
+    for (size_t i = 0; i < n; i++)
+      result.push_back(Traits::Compose(g[i], h[i], Jac(H1, i), Jac(H2, i)));
+    return result;
+  }
+
+  /// Elementwise g[i]^-1 * h[i]
+  static Elements Between(const Elements& g, const Elements& h,
+      Jacobians* H1 = nullptr, Jacobians* H2 = nullptr) {
+    CheckSizes(g.size(), h.size());
+    const size_t n = g.size();
+    Elements result;
+    result.reserve(n);
+    Resize(H1, n);
+    Resize(H2, n);
+    for (size_t i = 0; i < n; i++)
+      result.push_back(Traits::Between(g[i], h[i], Jac(H1, i), Jac(H2, i)));
+    return result;
+  }
+
+  /// Elementwise g[i]^-1
+  static Elements Inverse(const Elements& g, Jacobians* H = nullptr) {
+    const size_t n = g.size();
+    Elements result;
+    result.reserve(n);
+    Resize(H, n);
+    for (size_t i = 0; i < n; i++)
+      result.push_back(Traits::Inverse(g[i], Jac(H, i)));
+    return result;
+  }
+
+  /// Exponential map of every column of xi
+  static Elements Expmap(const Tangents& xi, Jacobians* H = nullptr) {
+    const size_t n = xi.cols();
+    Elements result;
+    result.reserve(n);
+    Resize(H, n);
+    for (size_t i = 0; i < n; i++)
+      result.push_back(Traits::Expmap(xi.col(i), Jac(H, i)));
+    return result;
+  }
+
+  /// Logarithm map of every element, one column per element
+  static Tangents Logmap(const Elements& g, Jacobians* H = nullptr) {
+    const size_t n = g.size();
+    Tangents result(int(N), n);
+    Resize(H, n);
+    for (size_t i = 0; i < n; i++)
+      result.col(i) = Traits::Logmap(g[i], Jac(H, i));
+    return result;
+  }
+
+ private:
+  static void CheckSizes(size_t n1, size_t n2) {
+    if (n1 != n2)
+      throw std::invalid_argument("LieBatch: arrays have different sizes");
+  }
+
+  static void Resize(Jacobians* H, size_t n) {
+    if (H) H->resize(n);
+  }
+
+  static OptionalJacobian<N, N> Jac(Jacobians* H, size_t i) {
+    if (H) return OptionalJacobian<N, N>((*H)[i]);
+    return OptionalJacobian<N, N>();
+  }
+};
+
+/// Vectorized exponential map for SO3
+template <>
+inline LieBatch<SO3>::Elements LieBatch<SO3>::Expmap(const Tangents& xi,
+    Jacobians* H) {
+  Elements result(xi.cols());
+  Resize(H, xi.cols());
+  so3::ExpmapBatch(xi, result.data(), H ? H->data() : nullptr);
+  return result;
+}
+
+#ifndef GTSAM_USE_QUATERNIONS
+/// Vectorized exponential map for Rot3, when stored as a rotation matrix
+template <>
+inline LieBatch<Rot3>::Elements LieBatch<Rot3>::Expmap(const Tangents& xi,
+    Jacobians* H) {
+  const LieBatch<SO3>::Elements R = LieBatch<SO3>::Expmap(xi, H);
+  Elements result;
+  result.reserve(R.size());
+  for (const SO3& Ri : R)
+    result.push_back(Rot3(Ri));
+  return result;
+}
+#endif
+
+}  // namespace gtsam
@@ -21,7 +21,6 @@
 
 #include <gtsam/geometry/Unit3.h>
 #include <gtsam/geometry/Point2.h>
-#include <gtsam/config.h>  // for GTSAM_USE_TBB
 
 #ifdef __clang__
 #  pragma clang diagnostic push
@@ -48,6 +47,7 @@ Unit3 Unit3::FromPoint3(const Point3& point, OptionalJacobian<2, 3> H) {
   Matrix3 D_p_point;
   Unit3 direction;
   direction.p_ = normalize(point, H ? &D_p_point : 0);
+  direction.B_ = CalculateBasis(direction.p_);
   if (H)
     *H << direction.basis().transpose() * D_p_point;
   return direction;
@@ -79,63 +79,40 @@ static Point3 CalculateBestAxis(const Point3& n) {
 }
 
 /* ************************************************************************* */
-const Matrix32& Unit3::basis(OptionalJacobian<6, 2> H) const {
-#ifdef GTSAM_USE_TBB
-  // NOTE(hayk): At some point it seemed like this reproducably resulted in
-  // deadlock. However, I don't know why and I can no longer reproduce it.
-  // It either was a red herring or there is still a latent bug left to debug.
-  tbb::mutex::scoped_lock lock(B_mutex_);
-#endif
-
-  const bool cachedBasis = static_cast<bool>(B_);
-  const bool cachedJacobian = static_cast<bool>(H_B_);
+Matrix32 Unit3::CalculateBasis(const Vector3& p) {
+  Matrix32 B;
+  const Point3 n(p), axis = CalculateBestAxis(n);
+  const Point3 B1 = gtsam::cross(n, axis);
+  B.col(0) = normalize(B1);
+  B.col(1) = gtsam::cross(n, B.col(0));
+  return B;
+}
 
+/* ************************************************************************* */
+const Matrix32& Unit3::basis(OptionalJacobian<6, 2> H) const {
   if (H) {
-    if (!cachedJacobian) {
-      // Compute Jacobian. Recomputes B_
-      Matrix32 B;
-      Matrix62 jacobian;
-      Matrix33 H_B1_n, H_b1_B1, H_b2_n, H_b2_b1;
-
-      // Choose the direction of the first basis vector b1 in the tangent plane
-      // by crossing n with the chosen axis.
-      const Point3 n(p_), axis = CalculateBestAxis(n);
-      const Point3 B1 = gtsam::cross(n, axis, &H_B1_n);
-
-      // Normalize result to get a unit vector: b1 = B1 / |B1|.
-      B.col(0) = normalize(B1, &H_b1_B1);
-
-      // Get the second basis vector b2, which is orthogonal to n and b1.
-      B.col(1) = gtsam::cross(n, B.col(0), &H_b2_n, &H_b2_b1);
-
-      // Chain rule tomfoolery to compute the jacobian.
-      const Matrix32& H_n_p = B;
-      jacobian.block<3, 2>(0, 0) = H_b1_B1 * H_B1_n * H_n_p;
-      auto H_b1_p = jacobian.block<3, 2>(0, 0);
-      jacobian.block<3, 2>(3, 0) = H_b2_n * H_n_p + H_b2_b1 * H_b1_p;
-
-      // Cache the result and jacobian
-      H_B_.reset(jacobian);
-      B_.reset(B);
-    }
+    // Recompute the basis, this time with the intermediate derivatives
+    Matrix33 H_B1_n, H_b1_B1, H_b2_n, H_b2_b1;
 
-    // Return cached jacobian, possibly computed just above
-    *H = *H_B_;
-  }
+    // Choose the direction of the first basis vector b1 in the tangent plane
+    // by crossing n with the chosen axis.
+    const Point3 n(p_), axis = CalculateBestAxis(n);
+    const Point3 B1 = gtsam::cross(n, axis, &H_B1_n);
 
-  if (!cachedBasis) {
-    // Same calculation as above, without derivatives.
-    // Done after H block, as that possibly computes B_ for the first time
-    Matrix32 B;
+    // Normalize result to get a unit vector: b1 = B1 / |B1|.
+    const Point3 b1 = normalize(B1, &H_b1_B1);
 
-    const Point3 n(p_), axis = CalculateBestAxis(n);
-    const Point3 B1 = gtsam::cross(n, axis);
-    B.col(0) = normalize(B1);
-    B.col(1) = gtsam::cross(n, B.col(0));
-    B_.reset(B);
+    // Get the second basis vector b2, which is orthogonal to n and b1.
+    gtsam::cross(n, b1, &H_b2_n, &H_b2_b1);
+
+    // Chain rule tomfoolery to compute the jacobian.
+    const Matrix32& H_n_p = B_;
+    H->block<3, 2>(0, 0) = H_b1_B1 * H_B1_n * H_n_p;
+    const Matrix32 H_b1_p = H->block<3, 2>(0, 0);
+    H->block<3, 2>(3, 0) = H_b2_n * H_n_p + H_b2_b1 * H_b1_p;
   }
 
-  return *B_;
+  return B_;
 }
 
 /* ************************************************************************* */
@@ -32,10 +32,6 @@
 
 #include <string>
 
-#ifdef GTSAM_USE_TBB
-#include <tbb/mutex.h>
-#endif
-
 namespace gtsam {
 
 /// Represents a 3D point on a unit sphere.
@@ -44,12 +40,10 @@ class GTSAM_EXPORT Unit3 {
 private:
 
   Vector3 p_; ///< The location of the point on the unit sphere
-  mutable boost::optional<Matrix32> B_; ///< Cached basis
-  mutable boost::optional<Matrix62> H_B_; ///< Cached basis derivative
+  Matrix32 B_; ///< Tangent basis, kept in sync with p_ (no lazy cache, no lock)
 
-#ifdef GTSAM_USE_TBB
-  mutable tbb::mutex B_mutex_; ///< Mutex to protect the cached basis.
-#endif
+  /// Calculate the tangent basis at a point on the unit sphere
+  static Matrix32 CalculateBasis(const Vector3& p);
 
 public:
 
@@ -62,35 +56,23 @@ public:
 
   /// Default constructor
   Unit3() :
-      p_(1.0, 0.0, 0.0) {
+      p_(1.0, 0.0, 0.0), B_(CalculateBasis(p_)) {
   }
 
   /// Construct from point
   explicit Unit3(const Vector3& p) :
-      p_(p.normalized()) {
+      p_(p.normalized()), B_(CalculateBasis(p_)) {
   }
 
   /// Construct from x,y,z
   Unit3(double x, double y, double z) :
-      p_(x, y, z) {
-    p_.normalize();
+      p_(Vector3(x, y, z).normalized()), B_(CalculateBasis(p_)) {
   }
 
   /// Construct from 2D point in plane at focal length f
   /// Unit3(p,1) can be viewed as normalized homogeneous coordinates of 2D point
-  explicit Unit3(const Point2& p, double f) : p_(p.x(), p.y(), f) {
-    p_.normalize();
-  }
-
-  /// Copy constructor
-  Unit3(const Unit3& u) {
-    p_ = u.p_;
-  }
-
-  /// Copy assignment
-  Unit3& operator=(const Unit3 & u) {
-    p_ = u.p_;
-    return *this;
+  explicit Unit3(const Point2& p, double f) :
+      p_(Vector3(p.x(), p.y(), f).normalized()), B_(CalculateBasis(p_)) {
   }
 
   /// Named constructor from Point3 with optional Jacobian
@@ -124,6 +106,7 @@ public:
    * It is a 3*2 matrix [b1 b2] composed of two orthogonal directions
    * tangent to the sphere at the current direction.
    * Provides derivatives of the basis with the two basis vectors stacked up as a 6x1.
+   * The basis itself is computed on construction, the derivatives on demand.
    */
   const Matrix32& basis(OptionalJacobian<6, 2> H = boost::none) const;
 
@@ -204,6 +187,8 @@ private:
   template<class ARCHIVE>
   void serialize(ARCHIVE & ar, const unsigned int /*version*/) {
     ar & BOOST_SERIALIZATION_NVP(p_);
+    if (ARCHIVE::is_loading::value)
+      B_ = CalculateBasis(p_);
   }
 
   /// @}
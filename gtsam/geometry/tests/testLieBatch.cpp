@@ -0,0 +1,109 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file   testLieBatch.cpp
+ * @brief  Unit tests for batch Lie group operations
+ **/
+
+#include <gtsam/geometry/LieBatch.h>
+#include <gtsam/base/Testable.h>
+#include <gtsam/base/TestableAssertions.h>
+#include <CppUnitLite/TestHarness.h>
+
+using namespace std;
+using namespace gtsam;
+
+namespace {
+// Tangent vectors, including one near zero to exercise the small-angle branch
+template <int N>
+Eigen::Matrix<double, N, Eigen::Dynamic> someTangents() {
+  Eigen::Matrix<double, N, Eigen::Dynamic> xi(N, 5);
+  for (int i = 0; i < 5; i++)
+    for (int j = 0; j < N; j++)
+      xi(j, i) = 0.1 * (i + 1) * std::cos(1.0 + i + 3.0 * j);
+  xi.col(2).setConstant(1e-10);
+  return xi;
+}
+
+// Check all batch operations against the corresponding single-element ones
+template <class T>
+bool checkBatch() {
+  bool ok = true;
+  typedef LieBatch<T> Batch;
+  typedef traits<T> Traits;
+  const auto xi = someTangents<Batch::N>();
+  const auto xi2 = (0.5 * xi.reverse()).eval();
+
+  typename Batch::Jacobians H, H1, H2;
+  const typename Batch::Elements g = Batch::Expmap(xi, &H);
+  const typename Batch::Elements h = Batch::Expmap(xi2);
+  for (size_t i = 0; i < g.size(); i++) {
+    typename Batch::Jacobian expectedH;
+    ok &= assert_equal<T>(Traits::Expmap(xi.col(i), expectedH), g[i], 1e-9);
+    ok &= assert_equal(Matrix(expectedH), Matrix(H[i]), 1e-9);
+  }
+
+  const typename Batch::Tangents logs = Batch::Logmap(g, &H);
+  for (size_t i = 0; i < g.size(); i++) {
+    typename Batch::Jacobian expectedH;
+    ok &= assert_equal(Vector(Traits::Logmap(g[i], expectedH)),
+                       Vector(logs.col(i)), 1e-9);
+    ok &= assert_equal(Matrix(expectedH), Matrix(H[i]), 1e-9);
+  }
+
+  const typename Batch::Elements composed = Batch::Compose(g, h, &H1, &H2);
+  for (size_t i = 0; i < g.size(); i++) {
+    typename Batch::Jacobian expectedH1, expectedH2;
+    ok &= assert_equal<T>(Traits::Compose(g[i], h[i], expectedH1, expectedH2),
+                          composed[i]);
+    ok &= assert_equal(Matrix(expectedH1), Matrix(H1[i]));
+    ok &= assert_equal(Matrix(expectedH2), Matrix(H2[i]));
+  }
+
+  const typename Batch::Elements between = Batch::Between(g, h, &H1, &H2);
+  for (size_t i = 0; i < g.size(); i++) {
+    typename Batch::Jacobian expectedH1, expectedH2;
+    ok &= assert_equal<T>(Traits::Between(g[i], h[i], expectedH1, expectedH2),
+                          between[i]);
+    ok &= assert_equal(Matrix(expectedH1), Matrix(H1[i]));
+    ok &= assert_equal(Matrix(expectedH2), Matrix(H2[i]));
+  }
+
+  const typename Batch::Elements inverse = Batch::Inverse(g, &H);
+  for (size_t i = 0; i < g.size(); i++) {
+    typename Batch::Jacobian expectedH;
+    ok &= assert_equal<T>(Traits::Inverse(g[i], expectedH), inverse[i]);
+    ok &= assert_equal(Matrix(expectedH), Matrix(H[i]));
+  }
+  return ok;
+}
+}  // namespace
+
+/* ************************************************************************* */
+TEST(LieBatch, SO3) { EXPECT(checkBatch<SO3>()); }
+TEST(LieBatch, Rot3) { EXPECT(checkBatch<Rot3>()); }
+TEST(LieBatch, Pose3) { EXPECT(checkBatch<Pose3>()); }
+TEST(LieBatch, Rot2) { EXPECT(checkBatch<Rot2>()); }
+TEST(LieBatch, Pose2) { EXPECT(checkBatch<Pose2>()); }
+
+/* ************************************************************************* */
+TEST(LieBatch, DifferentSizes) {
+  LieBatch<Pose2>::Elements g(3), h(2);
+  CHECK_EXCEPTION(LieBatch<Pose2>::Compose(g, h), std::invalid_argument);
+}
+
+/* ************************************************************************* */
+int main() {
+  TestResult tr;
+  return TestRegistry::runAllTests(tr);
+}
+/* ************************************************************************* */
@@ -352,6 +352,19 @@ TEST(Unit3, basis_derivatives) {
   }
 }
 
+//*******************************************************************************
+/// Copies and assignments carry the basis along with the direction.
+TEST(Unit3, basis_copy) {
+  const Unit3 p(0.1, -0.2, 0.9), q(-0.5, 0.3, 0.2);
+  const Unit3 copy(p);
+  EXPECT(assert_equal(p.basis(), copy.basis()));
+
+  Unit3 assigned;
+  assigned = q;
+  EXPECT(assert_equal(q.basis(), assigned.basis()));
+  EXPECT(assert_equal(Unit3(q.unitVector()).basis(), assigned.basis(), 1e-9));
+}
+
 //*******************************************************************************
 TEST(Unit3, retract) {
   {
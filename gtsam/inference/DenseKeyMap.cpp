@@ -0,0 +1,57 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    DenseKeyMap.cpp
+ * @brief   Compaction of a set of Keys to the contiguous indices 0..n-1
+ */
+
+#include <gtsam/inference/DenseKeyMap.h>
+
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace gtsam {
+
+const size_t DenseKeyMap::None;
+
+/* ************************************************************************* */
+size_t DenseKeyMap::at(Key key) const {
+  const size_t i = find(key);
+  if (i == None)
+    throw out_of_range("DenseKeyMap::at: key " + DefaultKeyFormatter(key) +
+                       " is not in the map");
+  return i;
+}
+
+/* ************************************************************************* */
+void DenseKeyMap::print(const string& str,
+                        const KeyFormatter& keyFormatter) const {
+  cout << str << size() << " keys in " << nrRuns() << " runs\n";
+  for (size_t i = 0; i < keys_.size(); i++)
+    cout << "  " << keyFormatter(keys_[i]) << " -> " << i << "\n";
+  cout.flush();
+}
+
+/* ************************************************************************* */
+void DenseKeyMap::buildRuns() {
+  runs_.clear();
+  for (size_t i = 0; i < keys_.size(); i++) {
+    if (i == 0 || keys_[i] != keys_[i - 1] + 1) {
+      const Run run = {keys_[i], i};
+      runs_.push_back(run);
+    }
+  }
+}
+
+}  // namespace gtsam
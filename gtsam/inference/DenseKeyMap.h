@@ -0,0 +1,112 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    DenseKeyMap.h
+ * @brief   Compaction of a set of Keys to the contiguous indices 0..n-1
+ */
+
+#pragma once
+
+#include <gtsam/inference/Key.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace gtsam {
+
+/**
+ * Assigns the contiguous indices 0..n-1 to a set of Keys, in Key order, so
+ * that inference code can keep per-variable data in plain vectors instead of
+ * ordered maps and only translates back to Keys at the API boundary.
+ *
+ * Lookups do not search all keys: the keys are stored as runs of consecutive
+ * Key values, such as the indices of one Symbol character, and a lookup only
+ * searches the (typically few) runs before offsetting into one.
+ */
+class GTSAM_EXPORT DenseKeyMap {
+ public:
+  /// Returned by find for keys that are not in the map
+  static const size_t None = size_t(-1);
+
+  /// Create an empty map
+  DenseKeyMap() {}
+
+  /// Create a map from any container of Keys, duplicates are allowed
+  template <class KEYS>
+  explicit DenseKeyMap(const KEYS& keys) : keys_(keys.begin(), keys.end()) {
+    if (!std::is_sorted(keys_.begin(), keys_.end()))
+      std::sort(keys_.begin(), keys_.end());
+    keys_.erase(std::unique(keys_.begin(), keys_.end()), keys_.end());
+    buildRuns();
+  }
+
+  /// Number of keys, the indices are 0..size()-1
+  size_t size() const { return keys_.size(); }
+
+  /// Whether there are no keys
+  bool empty() const { return keys_.empty(); }
+
+  /// All keys, in index order
+  const KeyVector& keys() const { return keys_; }
+
+  /// The key with index i
+  Key key(size_t i) const { return keys_[i]; }
+
+  /// The index of a key, or None if it is not in the map
+  size_t find(Key key) const {
+    // First run starting after key, the key can only be in the one before
+    std::vector<Run>::const_iterator run = std::upper_bound(
+        runs_.begin(), runs_.end(), key,
+        [](Key k, const Run& r) { return k < r.first; });
+    if (run == runs_.begin()) return None;
+    const size_t end = (run == runs_.end()) ? keys_.size() : run->index;
+    --run;
+    const Key offset = key - run->first;
+    return offset < end - run->index ? run->index + offset : None;
+  }
+
+  /// The index of a key, throws std::out_of_range if it is not in the map
+  size_t at(Key key) const;
+
+  /// Whether a key is in the map
+  bool exists(Key key) const { return find(key) != None; }
+
+  /// Number of runs of consecutive keys
+  size_t nrRuns() const { return runs_.size(); }
+
+  /// Print the key to index mapping
+  void print(const std::string& str = "DenseKeyMap: ",
+             const KeyFormatter& keyFormatter = DefaultKeyFormatter) const;
+
+  /// Check equality
+  bool equals(const DenseKeyMap& other, double tol = 0.0) const {
+    return keys_ == other.keys_;
+  }
+
+ private:
+  /// A run of consecutive Key values, starting at key first with index index
+  struct Run {
+    Key first;
+    size_t index;
+  };
+
+  KeyVector keys_;
+  std::vector<Run> runs_;
+
+  void buildRuns();
+};
+
+/// traits
+template <>
+struct traits<DenseKeyMap> : public Testable<DenseKeyMap> {};
+
+}  // namespace gtsam
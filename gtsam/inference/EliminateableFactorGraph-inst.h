@@ -56,7 +56,7 @@ namespace gtsam {
       // have a VariableIndex already here because we computed one if needed in the previous 'else'
       // block.
       if (orderingType == Ordering::METIS) {
-        Ordering computedOrdering = Ordering::Metis(asDerived());
+        Ordering computedOrdering = Ordering::Metis(MetisIndex(asDerived(), *variableIndex));
         return eliminateSequential(computedOrdering, function, variableIndex, orderingType);
       } else {
         Ordering computedOrdering = Ordering::Colamd(*variableIndex);
@@ -98,7 +98,7 @@ namespace gtsam {
       // have a VariableIndex already here because we computed one if needed in the previous 'else'
       // block.
       if (orderingType == Ordering::METIS) {
-        Ordering computedOrdering = Ordering::Metis(asDerived());
+        Ordering computedOrdering = Ordering::Metis(MetisIndex(asDerived(), *variableIndex));
         return eliminateMultifrontal(computedOrdering, function, variableIndex, orderingType);
       } else {
         Ordering computedOrdering = Ordering::Colamd(*variableIndex);
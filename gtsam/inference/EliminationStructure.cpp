@@ -0,0 +1,423 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    EliminationStructure.cpp
+ * @brief   Symbolic analysis of elimination: elimination tree and column
+ *          counts, computed without forming symbolic factors
+ */
+
+#include <gtsam/inference/EliminationStructure.h>
+#include <gtsam/inference/Ordering.h>
+#include <gtsam/inference/VariableIndex.h>
+#include <gtsam/base/timing.h>
+#include <gtsam/config.h> // for GTSAM_USE_TBB
+
+#ifdef GTSAM_USE_TBB
+#  include <tbb/blocked_range.h>
+#  include <tbb/parallel_for.h>
+#  include <tbb/task_scheduler_init.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+#include <utility>
+
+using namespace std;
+
+namespace gtsam {
+
+const size_t EliminationStructure::None;
+
+/* ************************************************************************* */
+EliminationStructure::EliminationStructure(const VariableIndex& structure,
+    const Ordering& order) {
+  gttic(EliminationStructure_etree);
+  const size_t n = order.size();
+  parents_.assign(n, None);
+  childOffsets_.assign(n + 1, 0);
+  children_.reserve(n);
+  firstColumns_.assign(structure.nFactors(), None);
+
+  // Liu's algorithm on the columns of A'A: the last node seen in every factor,
+  // and path-compressed shortcuts from every node towards its current root
+  vector<size_t> previous(structure.nFactors(), None);
+  vector<size_t> ancestors(n, None);
+  for (size_t k = 0; k < n; ++k) {
+    for (const FactorIndex i : structure.factors(order[k])) {
+      size_t j = previous[i];
+      if (j == None)
+        firstColumns_[i] = k;
+      // The root of the subtree containing j becomes a child of k
+      while (j != None && j != k) {
+        const size_t next = ancestors[j];
+        ancestors[j] = k;
+        if (next == None) {
+          parents_[j] = k;
+          children_.push_back(j);
+        }
+        j = next;
+      }
+      previous[i] = k;
+    }
+    childOffsets_[k + 1] = children_.size();
+  }
+
+  for (size_t j = 0; j < n; ++j)
+    if (parents_[j] == None)
+      roots_.push_back(j);
+}
+
+/* ************************************************************************* */
+EliminationStructure::EliminationStructure(const vector<size_t>& parents)
+    : parents_(parents) {
+  linkChildren();
+}
+
+/* ************************************************************************* */
+void EliminationStructure::linkChildren() {
+  const size_t n = parents_.size();
+  childOffsets_.assign(n + 1, 0);
+  roots_.clear();
+  for (size_t j = 0; j < n; ++j) {
+    if (parents_[j] == None) {
+      roots_.push_back(j);
+    } else {
+      assert(parents_[j] > j && parents_[j] < n);
+      ++childOffsets_[parents_[j] + 1];
+    }
+  }
+  for (size_t j = 0; j < n; ++j)
+    childOffsets_[j + 1] += childOffsets_[j];
+  children_.resize(childOffsets_[n]);
+  vector<size_t> next(childOffsets_.begin(), childOffsets_.end() - 1);
+  for (size_t j = 0; j < n; ++j)
+    if (parents_[j] != None)
+      children_[next[parents_[j]]++] = j;
+}
+
+/* ************************************************************************* */
+vector<size_t> EliminationStructure::postorder() const {
+  vector<size_t> post;
+  post.reserve(size());
+  // Stack of (node, number of children already visited)
+  vector<pair<size_t, size_t> > stack;
+  for (const size_t root : roots_) {
+    stack.push_back(make_pair(root, 0));
+    while (!stack.empty()) {
+      const size_t j = stack.back().first;
+      const size_t visited = stack.back().second;
+      if (visited < childOffsets_[j + 1] - childOffsets_[j]) {
+        ++stack.back().second;
+        stack.push_back(make_pair(children_[childOffsets_[j] + visited], 0));
+      } else {
+        post.push_back(j);
+        stack.pop_back();
+      }
+    }
+  }
+  return post;
+}
+
+/* ************************************************************************* */
+vector<size_t> EliminationStructure::subtreeRoots(size_t maxSize) const {
+  const size_t n = size();
+  vector<size_t> sizes(n, 1);
+  for (size_t j = 0; j < n; ++j)
+    if (parents_[j] != None)
+      sizes[parents_[j]] += sizes[j];
+
+  vector<size_t> roots;
+  for (const size_t j : postorder())
+    if (sizes[j] <= maxSize && (parents_[j] == None || sizes[parents_[j]] > maxSize))
+      roots.push_back(j);
+  return roots;
+}
+
+/* ************************************************************************* */
+namespace {
+/// State of the column counts computation, see Gilbert, Ng and Peyton 1994
+/// and cs_counts in CSparse
+struct ColumnCounter {
+  static const size_t None = EliminationStructure::None;
+
+  size_t n;                      ///< Number of eliminated columns
+  const vector<size_t>& parents;
+  const vector<size_t>& rowOffsets;
+  const vector<size_t>& rowColumns;
+  vector<size_t> headOffsets;    ///< Factors grouped by their first column
+  vector<size_t> heads;
+  vector<size_t> first;          ///< Postorder position of the first descendant
+  vector<size_t> position;       ///< Postorder position of every node
+  vector<size_t> ancestors;      ///< Union-find forest, with virtual root n
+  vector<size_t> maxFirst;       ///< Largest first[] of a leaf of every row subtree
+  vector<size_t> prevLeaf;       ///< Previous leaf of every row subtree
+  vector<long> delta;            ///< Column counts, before summing over subtrees
+
+  ColumnCounter(const vector<size_t>& _parents,
+                const vector<size_t>& _rowOffsets,
+                const vector<size_t>& _rowColumns)
+      : n(_parents.size()), parents(_parents), rowOffsets(_rowOffsets),
+        rowColumns(_rowColumns) {}
+
+  /// Parent of j, with the virtual root n above all roots
+  size_t parent(size_t j) const { return parents[j] == None ? n : parents[j]; }
+
+  /// Root of the union-find set of j, with path compression
+  size_t find(size_t j) {
+    size_t q = j;
+    while (q != ancestors[q])
+      q = ancestors[q];
+    while (j != q) {
+      const size_t next = ancestors[j];
+      ancestors[j] = q;
+      j = next;
+    }
+    return q;
+  }
+
+  /// Visit the entry (i, j) of A'A at node j, with the row subtree state of column i
+  template <class STATE>
+  void visitEntry(size_t i, size_t j, STATE& state) {
+    // Only the leaves of the row subtree of i contribute
+    if (i <= j || (state.maxFirst != None && first[j] <= state.maxFirst))
+      return;
+    state.maxFirst = first[j];
+    const size_t jprev = state.prevLeaf;
+    state.prevLeaf = j;
+    ++delta[j];
+    if (jprev == None)
+      state.firstLeaf(j);
+    else
+      --delta[find(jprev)];  // Overlap at the least common ancestor
+  }
+
+  /// Row subtree state in the shared arrays
+  struct SharedState {
+    size_t& maxFirst;
+    size_t& prevLeaf;
+    void firstLeaf(size_t) {}
+  };
+  SharedState shared(size_t i) { return SharedState{maxFirst[i], prevLeaf[i]}; }
+
+  /// Process node j, except for merging it into its parent
+  template <class VISIT>
+  void visitNode(size_t j, VISIT visit) {
+    for (size_t h = headOffsets[j]; h < headOffsets[j + 1]; ++h) {
+      const size_t row = heads[h];
+      for (size_t e = rowOffsets[row]; e < rowOffsets[row + 1]; ++e)
+        visit(rowColumns[e], j);
+    }
+  }
+
+  /// Serial step for node j: visit it and merge it into its parent
+  void step(size_t j) {
+    --delta[parent(j)];
+    visitNode(j, [this](size_t i, size_t j) {
+      SharedState state = shared(i);
+      visitEntry(i, j, state);
+    });
+    ancestors[j] = parent(j);
+  }
+};
+
+/// Row subtree state of a column above a subtree, local to that subtree
+struct LocalLeaf {
+  size_t maxFirst = EliminationStructure::None;
+  size_t prevLeaf = EliminationStructure::None;
+};
+
+/// Subtree state of a column above it, as a reference for visitEntry
+struct LocalState {
+  size_t& maxFirst;
+  size_t& prevLeaf;
+  bool& isFirst;
+  void firstLeaf(size_t) { isFirst = true; }
+};
+
+/// A subtree whose column counts are computed independently
+struct Subtree {
+  size_t begin, end;  ///< Postorder positions [begin, end], end is the root
+  /// Row subtree state of the columns above the subtree, at its end
+  struct Leaves {
+    size_t column, lastLeaf, maxFirst;
+  };
+  vector<Leaves> leaves;
+};
+}  // namespace
+
+/* ************************************************************************* */
+vector<size_t> EliminationStructure::columnCounts(
+    const vector<size_t>& rowOffsets, const vector<size_t>& rowColumns,
+    size_t nThreads) const {
+  gttic(EliminationStructure_columnCounts);
+  const size_t n = size();
+  const size_t m = rowOffsets.empty() ? 0 : rowOffsets.size() - 1;
+  size_t nrColumns = n;
+  for (const size_t column : rowColumns)
+    nrColumns = std::max(nrColumns, column + 1);
+
+  ColumnCounter counter(parents_, rowOffsets, rowColumns);
+
+  // Group the factors by their first eliminated column
+  vector<size_t> rowFirst(m, None);
+  counter.headOffsets.assign(n + 1, 0);
+  for (size_t row = 0; row < m; ++row) {
+    for (size_t e = rowOffsets[row]; e < rowOffsets[row + 1]; ++e)
+      if (rowColumns[e] < n)
+        rowFirst[row] = std::min(rowFirst[row], rowColumns[e]);
+    if (rowFirst[row] != None)
+      ++counter.headOffsets[rowFirst[row] + 1];
+  }
+  for (size_t j = 0; j < n; ++j)
+    counter.headOffsets[j + 1] += counter.headOffsets[j];
+  counter.heads.resize(counter.headOffsets[n]);
+  {
+    vector<size_t> next(counter.headOffsets.begin(), counter.headOffsets.end() - 1);
+    for (size_t row = 0; row < m; ++row)
+      if (rowFirst[row] != None)
+        counter.heads[next[rowFirst[row]]++] = row;
+  }
+
+  // Postorder, first descendants, and leaves of the elimination tree
+  const vector<size_t> post = postorder();
+  counter.position.resize(n);
+  counter.first.assign(n, None);
+  counter.delta.assign(n + 1, 0);
+  for (size_t k = 0; k < n; ++k) {
+    size_t j = post[k];
+    counter.position[j] = k;
+    counter.delta[j] = (counter.first[j] == None) ? 1 : 0;
+    for (; j != None && counter.first[j] == None; j = parents_[j])
+      counter.first[j] = k;
+  }
+  counter.ancestors.resize(n + 1);
+  for (size_t j = 0; j <= n; ++j)
+    counter.ancestors[j] = j;
+  counter.maxFirst.assign(nrColumns, None);
+  counter.prevLeaf.assign(nrColumns, None);
+
+  // Split the tree into the largest subtrees of at most n/(4 nThreads) nodes,
+  // for large trees only
+  static const size_t minParallelSize = 1 << 14;
+  if (nThreads == 0) {
+#ifdef GTSAM_USE_TBB
+    nThreads = tbb::task_scheduler_init::default_num_threads();
+#else
+    nThreads = 1;
+#endif
+  }
+  vector<Subtree> subtrees;
+  vector<size_t> subtreeAt(n, None);  // Subtree starting at each position
+  if (nThreads > 1 && n >= minParallelSize) {
+    const size_t maxSubtreeSize = n / (4 * nThreads);
+    size_t covered = 0;
+    for (const size_t root : subtreeRoots(maxSubtreeSize)) {
+      const size_t begin = counter.first[root], end = counter.position[root];
+      subtreeAt[begin] = subtrees.size();
+      subtrees.push_back(Subtree{begin, end, {}});
+      covered += end - begin + 1;
+    }
+    // A tree that is mostly a path has no useful parallelism
+    if (covered < n / 2) {
+      subtrees.clear();
+      subtreeAt.assign(n, None);
+    }
+  }
+
+  // Count the subtrees, in parallel with TBB.  Every subtree only touches the
+  // state of its own nodes, while the state of the columns above it is kept in
+  // a task-local map and merged in the serial pass below.
+  const auto countSubtree = [&](Subtree& subtree,
+                                unordered_map<size_t, LocalLeaf>& above) {
+    above.clear();
+    for (size_t k = subtree.begin; k <= subtree.end; ++k) {
+      const size_t j = post[k];
+      const bool isRoot = (k == subtree.end);
+      if (!isRoot)
+        --counter.delta[parents_[j]];
+      counter.visitNode(j, [&](size_t i, size_t j) {
+        if (i <= j)
+          return;
+        if (i < n && counter.position[i] >= subtree.begin &&
+            counter.position[i] <= subtree.end) {
+          ColumnCounter::SharedState state = counter.shared(i);
+          counter.visitEntry(i, j, state);
+        } else {
+          LocalLeaf& leaf = above[i];
+          bool isFirst = false;
+          LocalState state{leaf.maxFirst, leaf.prevLeaf, isFirst};
+          counter.visitEntry(i, j, state);
+          if (isFirst)
+            subtree.leaves.push_back(Subtree::Leaves{i, None, None});
+        }
+      });
+      if (!isRoot)
+        counter.ancestors[j] = parents_[j];
+    }
+    for (Subtree::Leaves& leaves : subtree.leaves) {
+      const LocalLeaf& leaf = above[leaves.column];
+      leaves.lastLeaf = leaf.prevLeaf;
+      leaves.maxFirst = leaf.maxFirst;
+    }
+  };
+#ifdef GTSAM_USE_TBB
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, subtrees.size()),
+                    [&](const tbb::blocked_range<size_t>& range) {
+                      unordered_map<size_t, LocalLeaf> above;
+                      for (size_t s = range.begin(); s != range.end(); ++s)
+                        countSubtree(subtrees[s], above);
+                    });
+#else
+  {
+    unordered_map<size_t, LocalLeaf> above;
+    for (Subtree& subtree : subtrees)
+      countSubtree(subtree, above);
+  }
+#endif
+
+  // Serial pass in postorder over the nodes above the subtrees, and the
+  // columns above every subtree at the time its first node comes up
+  for (size_t k = 0; k < n;) {
+    if (subtreeAt[k] == None) {
+      counter.step(post[k]);
+      ++k;
+      continue;
+    }
+    const Subtree& subtree = subtrees[subtreeAt[k]];
+    for (const Subtree::Leaves& leaves : subtree.leaves) {
+      // The first leaf in the subtree overlaps with the previous leaf outside
+      // it, and every leaf before the subtree has a smaller first[]
+      const size_t i = leaves.column;
+      if (counter.prevLeaf[i] != None)
+        --counter.delta[counter.find(counter.prevLeaf[i])];
+      counter.maxFirst[i] = leaves.maxFirst;
+      counter.prevLeaf[i] = leaves.lastLeaf;
+    }
+    const size_t root = post[subtree.end];
+    --counter.delta[counter.parent(root)];
+    counter.ancestors[root] = counter.parent(root);
+    k = subtree.end + 1;
+  }
+
+  // Sum the counts over subtrees
+  vector<size_t> counts(n);
+  for (size_t k = 0; k < n; ++k) {
+    const size_t j = post[k];
+    if (parents_[j] != None)
+      counter.delta[parents_[j]] += counter.delta[j];
+    counts[j] = counter.delta[j];
+  }
+  return counts;
+}
+
+}  // namespace gtsam
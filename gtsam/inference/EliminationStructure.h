@@ -0,0 +1,138 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    EliminationStructure.h
+ * @brief   Symbolic analysis of elimination: elimination tree and column
+ *          counts, computed without forming symbolic factors
+ */
+
+#pragma once
+
+#include <gtsam/inference/Key.h>
+#include <gtsam/dllexport.h>
+
+#include <vector>
+
+namespace gtsam {
+
+class Ordering;
+class VariableIndex;
+
+/**
+ * The symbolic structure of eliminating the variables of a factor graph in a
+ * given order, as integer arrays over the positions 0..n-1 in the ordering,
+ * so that symbolic analysis does not need to create any symbolic factors or
+ * conditionals.
+ *
+ * The elimination tree is computed with Liu's algorithm with path
+ * compression, and the column counts (the size of the conditional of every
+ * variable) with the skeleton-matrix algorithm of Gilbert, Ng and Peyton, in
+ * the A'A form where every factor is a row of A.  Both run in near-linear time
+ * in the number of variable-factor entries.  With TBB, the column counts of
+ * independent subtrees of large trees are computed as parallel tasks, followed
+ * by a short serial pass over the part of the tree above them.
+ */
+class GTSAM_EXPORT EliminationStructure {
+ public:
+  /// Parent of roots, and first column of factors involving no eliminated variable
+  static const size_t None = size_t(-1);
+
+  /// A range of positions, such as the children of a node
+  class Range {
+   public:
+    typedef const size_t* const_iterator;
+    Range(const size_t* first, const size_t* last) : begin_(first), end_(last) {}
+    const_iterator begin() const { return begin_; }
+    const_iterator end() const { return end_; }
+    size_t size() const { return end_ - begin_; }
+    bool empty() const { return begin_ == end_; }
+    size_t operator[](size_t i) const { return begin_[i]; }
+
+   private:
+    const size_t* begin_;
+    const size_t* end_;
+  };
+
+  /// Create an empty structure
+  EliminationStructure() {}
+
+  /**
+   * Compute the elimination tree of a factor graph for an ordering.  Children
+   * are listed in the order EliminationTree links them, and firstColumns()
+   * tells which node every factor is assigned to.
+   * @throws std::invalid_argument if the ordering contains a variable that is
+   *         not in the VariableIndex
+   */
+  EliminationStructure(const VariableIndex& structure, const Ordering& order);
+
+  /// Create the structure of a given elimination tree, where every parent comes after its children
+  explicit EliminationStructure(const std::vector<size_t>& parents);
+
+  /// Number of eliminated variables, i.e. nodes of the elimination tree
+  size_t size() const { return parents_.size(); }
+
+  /// The parent of every node in the elimination tree, or None for roots
+  const std::vector<size_t>& parents() const { return parents_; }
+
+  /// The children of a node
+  Range children(size_t j) const {
+    return Range(children_.data() + childOffsets_[j],
+                 children_.data() + childOffsets_[j + 1]);
+  }
+
+  /// The roots of the elimination forest, in increasing order
+  const std::vector<size_t>& roots() const { return roots_; }
+
+  /**
+   * The node every factor is assigned to, which is its first variable in the
+   * ordering, or None for factors that do not involve eliminated variables.
+   * Indexed by factor index, and only computed from a VariableIndex.
+   */
+  const std::vector<size_t>& firstColumns() const { return firstColumns_; }
+
+  /// The nodes in a postorder, in which every subtree is contiguous
+  std::vector<size_t> postorder() const;
+
+  /**
+   * The roots of the largest subtrees with at most maxSize nodes, in
+   * postorder.  The variables of different subtrees can be eliminated
+   * independently, and only pass factors on to the nodes above all subtrees.
+   */
+  std::vector<size_t> subtreeRoots(size_t maxSize) const;
+
+  /**
+   * Count the variables in the conditional of every eliminated variable, i.e.
+   * the nonzero blocks in each column of the Cholesky factor, including the
+   * diagonal.  The factors are given in compressed sparse row form, with
+   * columns numbered by position in the ordering; columns from size() upward
+   * are variables that are not eliminated.
+   * @param rowOffsets factor i involves columns rowColumns[rowOffsets[i]..rowOffsets[i+1])
+   * @param nThreads number of threads to split the work for, 0 for the TBB
+   * default (1 without TBB).  The subtrees run as TBB tasks, or serially
+   * without TBB.
+   */
+  std::vector<size_t> columnCounts(const std::vector<size_t>& rowOffsets,
+                                   const std::vector<size_t>& rowColumns,
+                                   size_t nThreads = 0) const;
+
+ private:
+  std::vector<size_t> parents_;
+  std::vector<size_t> childOffsets_;
+  std::vector<size_t> children_;
+  std::vector<size_t> roots_;
+  std::vector<size_t> firstColumns_;
+
+  /// Fill childOffsets_, children_ and roots_ from parents_, children in increasing order
+  void linkChildren();
+};
+
+}  // namespace gtsam
@@ -24,6 +24,7 @@
 #include <gtsam/base/timing.h>
 #include <gtsam/base/treeTraversal-inst.h>
 #include <gtsam/inference/EliminationTree.h>
+#include <gtsam/inference/EliminationStructure.h>
 #include <gtsam/inference/VariableIndex.h>
 #include <gtsam/inference/Ordering.h>
 #include <gtsam/inference/inference-inst.h>
@@ -85,73 +86,44 @@ namespace gtsam {
     const size_t m = graph.size();
     const size_t n = order.size();
 
-    static const size_t none = std::numeric_limits<size_t>::max();
-
-    // Allocate result parent vector and vector of last factor columns
-    FastVector<sharedNode> nodes(n);
-    FastVector<size_t> parents(n, none);
-    FastVector<size_t> prevCol(m, none);
-    FastVector<bool> factorUsed(m, false);
-
+    // Compute the parent array, with path compression, before creating any nodes
+    EliminationStructure etree;
     try {
-      // for column j \in 1 to n do
-      for (size_t j = 0; j < n; j++)
-      {
-        // Retrieve the factors involving this variable and create the current node
-        const FactorIndices& factors = structure[order[j]];
-        const sharedNode node = boost::make_shared<Node>();
-        node->key = order[j];
-
-        // for row i \in Struct[A*j] do
-        node->children.reserve(factors.size());
-        node->factors.reserve(factors.size());
-        for(const size_t i: factors) {
-          // If we already hit a variable in this factor, make the subtree containing the previous
-          // variable in this factor a child of the current node.  This means that the variables
-          // eliminated earlier in the factor depend on the later variables in the factor.  If we
-          // haven't yet hit a variable in this factor, we add the factor to the current node.
-          // TODO: Store root shortcuts instead of parents.
-          if (prevCol[i] != none) {
-            size_t k = prevCol[i];
-            // Find root r of the current tree that contains k. Use raw pointers in computing the
-            // parents to avoid changing the reference counts while traversing up the tree.
-            size_t r = k;
-            while (parents[r] != none)
-              r = parents[r];
-            // If the root of the subtree involving this node is actually the current node,
-            // TODO: what does this mean?  forest?
-            if (r != j) {
-              // Now that we found the root, hook up parent and child pointers in the nodes.
-              parents[r] = j;
-              node->children.push_back(nodes[r]);
-            }
-          } else {
-            // Add the factor to the current node since we are at the first variable in this factor.
-            node->factors.push_back(graph[i]);
-            factorUsed[i] = true;
-          }
-          prevCol[i] = j;
-        }
-        nodes[j] = node;
-      }
+      etree = EliminationStructure(structure, order);
     } catch(std::invalid_argument& e) {
-      // If this is thrown from structure[order[j]] above, it means that it was requested to
+      // If this is thrown from structure.factors(order[j]), it means that it was requested to
       // eliminate a variable not present in the graph, so throw a more informative error message.
       (void)e; // Prevent unused variable warning
       throw std::invalid_argument("EliminationTree: given ordering contains variables that are not involved in the factor graph");
-    } catch(...) {
-      throw;
+    }
+    const std::vector<size_t>& firstColumns = etree.firstColumns();
+
+    FastVector<sharedNode> nodes(n);
+    for (size_t j = 0; j < n; j++) {
+      nodes[j] = boost::make_shared<Node>();
+      nodes[j]->key = order[j];
+    }
+
+    for (size_t j = 0; j < n; j++) {
+      // Each factor goes to the node of its first variable in the ordering
+      Node& node = *nodes[j];
+      for (const size_t i : structure.factors(order[j]))
+        if (firstColumns[i] == j)
+          node.factors.push_back(graph[i]);
+      const EliminationStructure::Range children = etree.children(j);
+      node.children.reserve(children.size());
+      for (const size_t child : children)
+        node.children.push_back(nodes[child]);
     }
 
     // Find roots
-    assert(parents.empty() || parents.back() == none); // We expect the last-eliminated node to be a root no matter what
-    for(size_t j = 0; j < n; ++j)
-      if(parents[j] == none)
-        roots_.push_back(nodes[j]);
+    assert(etree.parents().empty() || etree.parents().back() == EliminationStructure::None); // We expect the last-eliminated node to be a root no matter what
+    for (const size_t root : etree.roots())
+      roots_.push_back(nodes[root]);
 
     // Gather remaining factors (exclude null factors)
     for(size_t i = 0; i < m; ++i)
-      if(!factorUsed[i] && graph[i])
+      if((i >= firstColumns.size() || firstColumns[i] == EliminationStructure::None) && graph[i])
         remainingFactors_.push_back(graph[i]);
   }
 
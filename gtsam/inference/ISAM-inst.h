@@ -49,7 +49,8 @@ void ISAM<BAYESTREE>::updateInternal(const FactorGraphType& newFactors,
       KeyVector(newFactorKeys.begin(), newFactorKeys.end()));
 
   // eliminate all factors (top, added, orphans) into a new Bayes tree
-  auto bayesTree = factors.eliminateMultifrontal(ordering, function, index);
+  auto bayesTree =
+      factors.eliminateMultifrontal(ordering, EliminateWithOrphans(function), index);
 
   // Re-add into Bayes tree data structures
   this->roots_.insert(this->roots_.end(), bayesTree->roots().begin(),
@@ -57,6 +58,13 @@ void ISAM<BAYESTREE>::updateInternal(const FactorGraphType& newFactors,
   this->nodes_.insert(bayesTree->nodes().begin(), bayesTree->nodes().end());
 }
 
+/* ************************************************************************* */
+template<class BAYESTREE>
+typename ISAM<BAYESTREE>::Eliminate ISAM<BAYESTREE>::EliminateWithOrphans(
+    const Eliminate& function) {
+  return function;
+}
+
 /* ************************************************************************* */
 template<class BAYESTREE>
 void ISAM<BAYESTREE>::update(const FactorGraphType& newFactors,
@@ -73,6 +73,16 @@ class ISAM : public BAYESTREE {
 
   /// @}
 
+ protected:
+  /**
+   * The elimination function used to re-eliminate the top of the tree, where
+   * the orphaned subtrees appear as BayesTreeOrphanWrapper factors on their
+   * separators.  By default \c function itself; specialize this member for
+   * Bayes trees whose elimination cannot take such placeholder factors.
+   */
+  static Eliminate EliminateWithOrphans(const Eliminate& function);
+
+ public:
 #ifdef GTSAM_ALLOW_DEPRECATED_SINCE_V4
   /// @name Deprecated
   /// @{
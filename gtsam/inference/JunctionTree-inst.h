@@ -22,11 +22,93 @@
 
 #include <gtsam/inference/JunctionTree.h>
 #include <gtsam/inference/ClusterTree-inst.h>
-#include <gtsam/symbolic/SymbolicConditional.h>
-#include <gtsam/symbolic/SymbolicFactor-inst.h>
+#include <gtsam/inference/DenseKeyMap.h>
+#include <gtsam/inference/EliminationStructure.h>
+
+#include <utility>
+#include <vector>
 
 namespace gtsam {
 
+/**
+ * Count the variables in the conditional of every elimination tree node, in
+ * the DFS postorder in which ConstructorTraversalData visits them, from the
+ * factors of the nodes alone.  This replaces symbolic elimination of every
+ * node, which creates a symbolic factor and conditional per variable.
+ */
+template<class ETREE>
+std::vector<size_t> ColumnCountsInPostorder(const ETREE& eliminationTree) {
+  gttic(JunctionTree_columnCounts);
+  typedef typename ETREE::Node Node;
+  static const size_t None = EliminationStructure::None;
+
+  // Number the nodes in postorder, children in order, and link every node to
+  // its parent.  The positions of finished children wait on a stack until
+  // their parent is finished.
+  std::vector<const Node*> nodes;
+  std::vector<size_t> parents;
+  std::vector<std::pair<const Node*, size_t> > stack;  // (node, children visited)
+  std::vector<size_t> finishedChildren;
+  for (const auto& root : eliminationTree.roots()) {
+    stack.push_back(std::make_pair(root.get(), size_t(0)));
+    while (!stack.empty()) {
+      const Node* node = stack.back().first;
+      const size_t visited = stack.back().second;
+      if (visited < node->children.size()) {
+        ++stack.back().second;
+        stack.push_back(std::make_pair(node->children[visited].get(), size_t(0)));
+      } else {
+        const size_t position = nodes.size();
+        nodes.push_back(node);
+        parents.push_back(None);
+        for (size_t c = finishedChildren.size() - node->children.size();
+             c < finishedChildren.size(); ++c)
+          parents[finishedChildren[c]] = position;
+        finishedChildren.resize(finishedChildren.size() - node->children.size());
+        finishedChildren.push_back(position);
+        stack.pop_back();
+      }
+    }
+    finishedChildren.clear();
+  }
+  const size_t n = nodes.size();
+
+  // Columns of the eliminated keys are their positions, other keys come after
+  KeyVector eliminatedKeys(n);
+  for (size_t j = 0; j < n; ++j)
+    eliminatedKeys[j] = nodes[j]->key;
+  const DenseKeyMap eliminated(eliminatedKeys);
+  std::vector<size_t> columnOfIndex(n);
+  for (size_t j = 0; j < n; ++j)
+    columnOfIndex[eliminated.find(eliminatedKeys[j])] = j;
+  KeyVector otherKeys;
+  for (const Node* node : nodes)
+    for (const auto& factor : node->factors)
+      if (factor)
+        for (const Key key : *factor)
+          if (!eliminated.exists(key))
+            otherKeys.push_back(key);
+  const DenseKeyMap others(otherKeys);
+
+  // The factors of all nodes as rows
+  std::vector<size_t> rowOffsets(1, 0), rowColumns;
+  for (const Node* node : nodes) {
+    for (const auto& factor : node->factors) {
+      if (!factor)
+        continue;
+      for (const Key key : *factor) {
+        const size_t index = eliminated.find(key);
+        rowColumns.push_back(index != DenseKeyMap::None
+                                 ? columnOfIndex[index]
+                                 : n + others.find(key));
+      }
+      rowOffsets.push_back(rowColumns.size());
+    }
+  }
+
+  return EliminationStructure(parents).columnCounts(rowOffsets, rowColumns);
+}
+
 template<class BAYESTREE, class GRAPH, class ETREE_NODE>
 struct ConstructorTraversalData {
   typedef typename JunctionTree<BAYESTREE, GRAPH>::Node Node;
@@ -34,15 +116,18 @@ struct ConstructorTraversalData {
 
   ConstructorTraversalData* const parentData;
   sharedNode myJTNode;
-  FastVector<SymbolicConditional::shared_ptr> childSymbolicConditionals;
-  FastVector<SymbolicFactor::shared_ptr> childSymbolicFactors;
+  FastVector<size_t> childColumnCounts;
 
-  // Small inner class to store symbolic factors
-  class SymbolicFactors: public FactorGraph<Factor> {
-  };
+  // Column counts of all nodes in postorder, and the position of the next node
+  const std::vector<size_t>* columnCounts;
+  size_t* nextPosition;
 
   ConstructorTraversalData(ConstructorTraversalData* _parentData) :
-      parentData(_parentData) {
+      parentData(_parentData), columnCounts(0), nextPosition(0) {
+    if (parentData) {
+      columnCounts = parentData->columnCounts;
+      nextPosition = parentData->nextPosition;
+    }
   }
 
   // Pre-order visitor function
@@ -62,45 +147,29 @@ struct ConstructorTraversalData {
   static void ConstructorTraversalVisitorPostAlg2(
       const boost::shared_ptr<ETREE_NODE>& ETreeNode,
       const ConstructorTraversalData& myData) {
-    // In this post-order visitor, we combine the symbolic elimination results
-    // from the elimination tree children and symbolically eliminate the current
-    // elimination tree node.  We then check whether each of our elimination
-    // tree child nodes should be merged with us.  The check for this is that
-    // our number of symbolic elimination parents is exactly 1 less than
-    // our child's symbolic elimination parents - this condition indicates that
-    // eliminating the current node did not introduce any parents beyond those
-    // already in the child->
-
-    // Do symbolic elimination for this node
-    SymbolicFactors symbolicFactors;
-    symbolicFactors.reserve(
-        ETreeNode->factors.size() + myData.childSymbolicFactors.size());
-    // Add ETree node factors
-    symbolicFactors += ETreeNode->factors;
-    // Add symbolic factors passed up from children
-    symbolicFactors += myData.childSymbolicFactors;
-
-    Ordering keyAsOrdering;
-    keyAsOrdering.push_back(ETreeNode->key);
-    SymbolicConditional::shared_ptr myConditional;
-    SymbolicFactor::shared_ptr mySeparatorFactor;
-    boost::tie(myConditional, mySeparatorFactor) = internal::EliminateSymbolic(
-        symbolicFactors, keyAsOrdering);
-
-    // Store symbolic elimination results in the parent
-    myData.parentData->childSymbolicConditionals.push_back(myConditional);
-    myData.parentData->childSymbolicFactors.push_back(mySeparatorFactor);
+    // In this post-order visitor, we look up the size of the conditional from
+    // symbolically eliminating the current elimination tree node, which was
+    // counted for all nodes beforehand.  We then check whether each of our
+    // elimination tree child nodes should be merged with us.  The check for
+    // this is that our number of symbolic elimination parents is exactly 1
+    // less than our child's symbolic elimination parents - this condition
+    // indicates that eliminating the current node did not introduce any
+    // parents beyond those already in the child->
+
+    // Size of our conditional, and pass it on to the parent
+    const size_t myColumnCount = (*myData.columnCounts)[(*myData.nextPosition)++];
+    myData.parentData->childColumnCounts.push_back(myColumnCount);
 
     sharedNode node = myData.myJTNode;
-    const FastVector<SymbolicConditional::shared_ptr>& childConditionals =
-        myData.childSymbolicConditionals;
-    node->problemSize_ = (int) (myConditional->size() * symbolicFactors.size());
+    const FastVector<size_t>& childColumnCounts = myData.childColumnCounts;
+    node->problemSize_ = (int) (myColumnCount *
+        (ETreeNode->factors.size() + childColumnCounts.size()));
 
     // Merge our children if they are in our clique - if our conditional has
     // exactly one fewer parent than our child's conditional.
-    const size_t myNrParents = myConditional->nrParents();
+    const size_t myNrParents = myColumnCount - 1;
     const size_t nrChildren = node->nrChildren();
-    assert(childConditionals.size() == nrChildren);
+    assert(childColumnCounts.size() == nrChildren);
 
     // decide which children to merge, as index into children
     std::vector<size_t> nrFrontals = node->nrFrontalsOfChildren();
@@ -108,7 +177,7 @@ struct ConstructorTraversalData {
     size_t myNrFrontals = 1;
     for (size_t i = 0;i<nrChildren;i++){
       // Check if we should merge the i^th child
-      if (myNrParents + myNrFrontals == childConditionals[i]->nrParents()) {
+      if (myNrParents + myNrFrontals == childColumnCounts[i] - 1) {
         // Increment number of frontal variables
         myNrFrontals += nrFrontals[i];
         merge[i] = true;
@@ -126,18 +195,21 @@ template<class ETREE_BAYESNET, class ETREE_GRAPH>
 JunctionTree<BAYESTREE, GRAPH>::JunctionTree(
     const EliminationTree<ETREE_BAYESNET, ETREE_GRAPH>& eliminationTree) {
   gttic(JunctionTree_FromEliminationTree);
-  // Here we rely on the BayesNet having been produced by this elimination tree,
-  // such that the conditionals are arranged in DFS post-order.  We traverse the
-  // elimination tree, and inspect the symbolic conditional corresponding to
-  // each node.  The elimination tree node is added to the same clique with its
-  // parent if it has exactly one more Bayes net conditional parent than
-  // does its elimination tree parent.
-
-  // Traverse the elimination tree, doing symbolic elimination and merging nodes
-  // as we go.  Gather the created junction tree roots in a dummy Node.
+  // We count the variables of the conditional of every elimination tree node,
+  // in DFS post-order, without doing symbolic elimination.  We then traverse
+  // the elimination tree, and add each elimination tree node to the same
+  // clique with its parent if its conditional has exactly one more parent
+  // than the conditional of its elimination tree parent.
+  const std::vector<size_t> columnCounts = ColumnCountsInPostorder(eliminationTree);
+
+  // Traverse the elimination tree, merging nodes as we go.  Gather the created
+  // junction tree roots in a dummy Node.
   typedef typename EliminationTree<ETREE_BAYESNET, ETREE_GRAPH>::Node ETreeNode;
   typedef ConstructorTraversalData<BAYESTREE, GRAPH, ETreeNode> Data;
+  size_t nextPosition = 0;
   Data rootData(0);
+  rootData.columnCounts = &columnCounts;
+  rootData.nextPosition = &nextPosition;
   rootData.myJTNode = boost::make_shared<typename Base::Node>(); // Make a dummy node to gather
                                                                  // the junction tree roots
   treeTraversal::DepthFirstForest(eliminationTree, rootData,
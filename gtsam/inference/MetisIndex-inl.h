@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -81,4 +82,38 @@ void MetisIndex::augment(const FactorGraph<FACTOR>& factors) {
   }
 }
 
+/* ************************************************************************* */
+template<class FG>
+MetisIndex::MetisIndex(const FG& factors, const VariableIndex& variableIndex) :
+    nKeys_(variableIndex.size()) {
+  // Number the variables densely, in Key order
+  int32_t i = 0;
+  for (const auto& key_factors : variableIndex)
+    intKeyBMap_.insert(bm_type::value_type(key_factors.first, i++));
+
+  // Collect the neighbors of every variable through its factors, using a
+  // marker per variable instead of a set
+  std::vector<int32_t> marker(nKeys_, -1);
+  xadj_.reserve(nKeys_ + 1);
+  xadj_.push_back(0);
+  i = 0;
+  for (const auto& key_factors : variableIndex) {
+    marker[i] = i;
+    for (const FactorIndex factor : key_factors.second) {
+      if (!factors[factor])
+        continue;
+      for (const Key key : *factors[factor]) {
+        const int32_t j = intKeyBMap_.left.at(key);
+        if (marker[j] != i) {
+          marker[j] = i;
+          adj_.push_back(j);
+        }
+      }
+    }
+    std::sort(adj_.begin() + xadj_.back(), adj_.end());
+    xadj_.push_back((int32_t) adj_.size());
+    ++i;
+  }
+}
+
 } // \ gtsam
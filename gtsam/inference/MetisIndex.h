@@ -19,6 +19,7 @@
 
 #include <gtsam/inference/Key.h>
 #include <gtsam/inference/FactorGraph.h>
+#include <gtsam/inference/VariableIndex.h>
 #include <gtsam/base/types.h>
 #include <gtsam/base/timing.h>
 
@@ -68,6 +69,14 @@ public:
     augment(factorGraph);
   }
 
+  /**
+   * Create from a factor graph and its VariableIndex, which gives the
+   * neighbors of every variable in time linear in the size of the graph.
+   * Variables are numbered in Key order.
+   */
+  template<class FG>
+  MetisIndex(const FG& factorGraph, const VariableIndex& variableIndex);
+
   ~MetisIndex() {
   }
   /// @}
@@ -16,6 +16,8 @@
  * @date    Sep 2, 2010
  */
 
+#include <algorithm>
+#include <mutex>
 #include <vector>
 #include <limits>
 
@@ -23,15 +25,29 @@
 
 #include <gtsam/inference/Ordering.h>
 #include <gtsam/3rdparty/CCOLAMD/Include/ccolamd.h>
+#include <gtsam/config.h> // for GTSAM_USE_TBB
 
 #ifdef GTSAM_SUPPORT_NESTED_DISSECTION
 #include <gtsam/3rdparty/metis/include/metis.h>
 #endif
 
+#ifdef GTSAM_USE_TBB
+#include <tbb/parallel_invoke.h>
+#include <tbb/task_scheduler_init.h>
+#endif
+
 using namespace std;
 
 namespace gtsam {
 
+#ifdef GTSAM_SUPPORT_NESTED_DISSECTION
+namespace {
+/// METIS is not reentrant: it installs process-wide signal handlers
+/// (gk_sigtrap) around every call, so all calls into it are serialized
+std::mutex metisMutex;
+}  // namespace
+#endif
+
 /* ************************************************************************* */
 FastMap<Key, size_t> Ordering::invert() const {
   FastMap<Key, size_t> inverted;
@@ -79,7 +95,7 @@ Ordering Ordering::ColamdConstrained(const VariableIndex& variableIndex,
   size_t index = 0;
   for (auto key_factors: variableIndex) {
     // Arrange factor indices into COLAMD format
-    const FactorIndices& column = key_factors.second;
+    const auto& column = key_factors.second;
     for(size_t factorIndex: column) {
       A[count++] = (int) factorIndex; // copy sparse column
     }
@@ -185,6 +201,69 @@ Ordering Ordering::ColamdConstrainedFirst(const VariableIndex& variableIndex,
   return Ordering::ColamdConstrained(variableIndex, cmember);
 }
 
+/* ************************************************************************* */
+namespace {
+/// VariableIndex of the subproblem induced by some variables, factors renumbered.
+/// Variables absent from the full index, e.g. because all their factors were
+/// removed, are kept without factors.
+class SubVariableIndex : public VariableIndex {
+ public:
+  SubVariableIndex(const VariableIndex& full, const KeyVector& keys) {
+    KeyVector sortedKeys(keys), entryKeys;
+    std::sort(sortedKeys.begin(), sortedKeys.end());
+    FactorIndices entryFactors;
+    FastMap<FactorIndex, FactorIndex> localFactors;
+    for (Key key : sortedKeys) {
+      const const_iterator entry = full.find(key);
+      if (entry == full.end())
+        continue;
+      for (FactorIndex factor : entry->second) {
+        const FactorIndex next = localFactors.size();
+        entryKeys.push_back(key);
+        entryFactors.push_back(localFactors.insert(make_pair(factor, next)).first->second);
+      }
+    }
+    nEntries_ = entryKeys.size();
+    nFactors_ = localFactors.size();
+    build(entryKeys, entryFactors, &sortedKeys);
+  }
+};
+}  // namespace
+
+/* ************************************************************************* */
+Ordering Ordering::ColamdIncremental(const Ordering& previous,
+    const VariableIndex& variableIndex, const KeySet& newFactorKeys) {
+  gttic(Ordering_COLAMDIncremental);
+
+  // Variables before the first one touched by the new factors keep their place
+  size_t first = 0;
+  while (first < previous.size() && !newFactorKeys.count(previous[first]))
+    ++first;
+  if (first == previous.size() && newFactorKeys.empty())
+    return previous;
+
+  // Reorder the tail, which contains all new variables as these can only
+  // appear in the new factors
+  KeyVector tail(previous.begin() + first, previous.end());
+  const KeySet ordered(tail.begin(), tail.end());
+  for (Key key : newFactorKeys)
+    if (!ordered.count(key))
+      tail.push_back(key);
+  const SubVariableIndex subIndex(variableIndex, tail);
+
+  // Constrain the variables of the new factors last
+  vector<int> cmember;
+  cmember.reserve(subIndex.size());
+  const int last = (newFactorKeys.size() != subIndex.size() ? 1 : 0);
+  for (const auto& key_factors : subIndex)
+    cmember.push_back(newFactorKeys.count(key_factors.first) ? last : 0);
+  const Ordering reordered = Ordering::ColamdConstrained(subIndex, cmember);
+
+  Ordering result(previous.begin(), previous.begin() + first);
+  result.insert(result.end(), reordered.begin(), reordered.end());
+  return result;
+}
+
 /* ************************************************************************* */
 Ordering Ordering::ColamdConstrained(const VariableIndex& variableIndex,
     const FastMap<Key, int>& groups) {
@@ -225,8 +304,11 @@ Ordering Ordering::Metis(const MetisIndex& met) {
 
   int outputError;
 
-  outputError = METIS_NodeND(&size, &xadj[0], &adj[0], NULL, NULL, &perm[0],
-      &iperm[0]);
+  {
+    std::lock_guard<std::mutex> lock(metisMutex);
+    outputError = METIS_NodeND(&size, &xadj[0], &adj[0], NULL, NULL, &perm[0],
+        &iperm[0]);
+  }
   Ordering result;
 
   if (outputError != METIS_OK) {
@@ -246,6 +328,152 @@ Ordering Ordering::Metis(const MetisIndex& met) {
 #endif
 }
 
+/* ************************************************************************* */
+#ifdef GTSAM_SUPPORT_NESTED_DISSECTION
+namespace {
+/// Graph in METIS CSR format, with the MetisIndex vertex of every local vertex
+struct MetisGraph {
+  vector<idx_t> xadj, adj, vertices;
+};
+
+/// The subgraph induced by the vertices in the given part
+MetisGraph inducedSubgraph(const MetisGraph& graph, const vector<idx_t>& part,
+    idx_t which) {
+  const idx_t n = graph.vertices.size();
+  vector<idx_t> local(n, -1);
+  MetisGraph sub;
+  for (idx_t i = 0; i < n; i++)
+    if (part[i] == which) {
+      local[i] = sub.vertices.size();
+      sub.vertices.push_back(graph.vertices[i]);
+    }
+  sub.xadj.reserve(sub.vertices.size() + 1);
+  sub.xadj.push_back(0);
+  for (idx_t i = 0; i < n; i++) {
+    if (part[i] != which)
+      continue;
+    for (idx_t k = graph.xadj[i]; k < graph.xadj[i + 1]; k++)
+      if (part[graph.adj[k]] == which)
+        sub.adj.push_back(local[graph.adj[k]]);
+    sub.xadj.push_back(sub.adj.size());
+  }
+  return sub;
+}
+
+/// Append the METIS_NodeND ordering of a graph to order
+void nodeND(MetisGraph& graph, vector<idx_t>& order) {
+  idx_t n = graph.vertices.size();
+  if (n <= 2 || graph.adj.empty()) {
+    order.insert(order.end(), graph.vertices.begin(), graph.vertices.end());
+    return;
+  }
+  vector<idx_t> perm(n), iperm(n);
+  int outputError;
+  {
+    std::lock_guard<std::mutex> lock(metisMutex);
+    outputError = METIS_NodeND(&n, &graph.xadj[0], &graph.adj[0], NULL, NULL,
+        &perm[0], &iperm[0]);
+  }
+  if (outputError != METIS_OK)
+    throw runtime_error("METIS failed during Nested Dissection ordering");
+  for (idx_t j = 0; j < n; j++)
+    order.push_back(graph.vertices[perm[j]]);
+}
+
+/// Recursive nested dissection, with the top parallelDepth levels forked as
+/// TBB tasks
+void nestedDissection(MetisGraph& graph, size_t parallelDepth,
+    size_t minPartitionSize, vector<idx_t>& order) {
+  idx_t n = graph.vertices.size();
+  if ((size_t) n <= minPartitionSize || graph.adj.empty())
+    return nodeND(graph, order);
+
+  // Part 2 is the separator between parts 0 and 1
+  idx_t separatorSize;
+  vector<idx_t> part(n);
+  int outputError;
+  {
+    std::lock_guard<std::mutex> lock(metisMutex);
+    outputError = METIS_ComputeVertexSeparator(&n, &graph.xadj[0],
+        &graph.adj[0], NULL, NULL, &separatorSize, &part[0]);
+  }
+  if (outputError != METIS_OK)
+    throw runtime_error("METIS failed to compute a vertex separator");
+  MetisGraph part0 = inducedSubgraph(graph, part, 0);
+  MetisGraph part1 = inducedSubgraph(graph, part, 1);
+  if (part0.vertices.empty() || part1.vertices.empty())
+    return nodeND(graph, order);
+
+  vector<idx_t> order0, order1;
+#ifdef GTSAM_USE_TBB
+  if (parallelDepth > 0) {
+    tbb::parallel_invoke(
+        [&]() {
+          nestedDissection(part0, parallelDepth - 1, minPartitionSize, order0);
+        },
+        [&]() {
+          nestedDissection(part1, parallelDepth - 1, minPartitionSize, order1);
+        });
+  } else
+#endif
+  {
+    nestedDissection(part0, 0, minPartitionSize, order0);
+    nestedDissection(part1, 0, minPartitionSize, order1);
+  }
+
+  order.insert(order.end(), order0.begin(), order0.end());
+  order.insert(order.end(), order1.begin(), order1.end());
+  for (idx_t i = 0; i < n; i++)
+    if (part[i] == 2)
+      order.push_back(graph.vertices[i]);
+}
+}  // namespace
+#endif
+
+/* ************************************************************************* */
+Ordering Ordering::MetisParallel(const MetisIndex& met, size_t nThreads,
+    size_t minPartitionSize) {
+#ifdef GTSAM_SUPPORT_NESTED_DISSECTION
+  gttic(Ordering_METISParallel);
+
+  MetisGraph graph;
+  graph.xadj.assign(met.xadj().begin(), met.xadj().end());
+  graph.adj.assign(met.adj().begin(), met.adj().end());
+  const idx_t n = graph.xadj.empty() ? 0 : graph.xadj.size() - 1;
+  graph.vertices.resize(n);
+  for (idx_t i = 0; i < n; i++)
+    graph.vertices[i] = i;
+  if (n == 0)
+    return Ordering();
+
+  // Fork at the top levels of the recursion, until there is a task per thread
+  if (nThreads == 0) {
+#ifdef GTSAM_USE_TBB
+    nThreads = tbb::task_scheduler_init::default_num_threads();
+#else
+    nThreads = 1;
+#endif
+  }
+  size_t parallelDepth = 0;
+  while ((size_t(1) << parallelDepth) < nThreads)
+    ++parallelDepth;
+
+  vector<idx_t> order;
+  order.reserve(n);
+  nestedDissection(graph, parallelDepth, std::max<size_t>(minPartitionSize, 1),
+      order);
+
+  Ordering result;
+  result.reserve(n);
+  for (idx_t i : order)
+    result.push_back(met.intToKey(i));
+  return result;
+#else
+  throw runtime_error("GTSAM was built without support for Metis-based "
+                      "nested dissection");
+#endif
+}
+
 /* ************************************************************************* */
 void Ordering::print(const std::string& str,
     const KeyFormatter& keyFormatter) const {
@@ -194,6 +194,48 @@ public:
     return Metis(MetisIndex(graph));
   }
 
+  /**
+   * Compute a nested dissection ordering by recursive METIS vertex bisection.
+   * The two halves of every bisection are ordered independently, as TBB tasks
+   * for the top levels of the recursion, and the separator goes last.
+   * Partitions smaller than minPartitionSize are ordered with METIS_NodeND.
+   * METIS itself is not reentrant, so only the work between the METIS calls
+   * runs concurrently; without TBB everything runs serially.
+   * @param nThreads number of tasks to fork, 0 for the TBB default (1 without TBB)
+   */
+  static GTSAM_EXPORT Ordering MetisParallel(const MetisIndex& met,
+      size_t nThreads = 0, size_t minPartitionSize = 1000);
+
+  template<class FACTOR_GRAPH>
+  static Ordering MetisParallel(const FACTOR_GRAPH& graph,
+      size_t nThreads = 0, size_t minPartitionSize = 1000) {
+    return MetisParallel(MetisIndex(graph), nThreads, minPartitionSize);
+  }
+
+  /**
+   * Update a fill-reducing ordering after factors were added to the graph,
+   * instead of recomputing it from scratch. Variables ordered before every
+   * variable of the new factors are eliminated exactly as before, so they keep
+   * their positions. The rest, together with variables not in the previous
+   * ordering, are reordered by constrained COLAMD on the subproblem they
+   * induce, with the variables of the new factors last, so that the next
+   * update touching recent variables again only reorders a short tail.
+   * Variables of previous or newFactorKeys that are not in variableIndex,
+   * e.g. because all their factors were removed, are ordered without factors.
+   * @param previous the ordering computed before the new factors were added
+   * @param variableIndex index of the whole graph, including the new factors
+   * @param newFactorKeys the variables involved in the new factors
+   */
+  static GTSAM_EXPORT Ordering ColamdIncremental(const Ordering& previous,
+      const VariableIndex& variableIndex, const KeySet& newFactorKeys);
+
+  /// Update a fill-reducing ordering after newFactors were added to graph (see above)
+  template<class FACTOR_GRAPH>
+  static Ordering ColamdIncremental(const Ordering& previous,
+      const FACTOR_GRAPH& graph, const FACTOR_GRAPH& newFactors) {
+    return ColamdIncremental(previous, VariableIndex(graph), newFactors.keys());
+  }
+
   /// @}
 
   /// @name Named Constructors @{
@@ -28,13 +28,25 @@ void VariableIndex::augment(const FG& factors,
     boost::optional<const FactorIndices&> newFactorIndices) {
   gttic(VariableIndex_augment);
 
+  // An empty index is built in compact form directly, otherwise the new
+  // entries go to the overflow area
+  const bool buildCompact = (nKeys_ == 0);
+  KeyVector entryKeys;
+  FactorIndices entryFactors;
+
   // Augment index for each factor
   for (size_t i = 0; i < factors.size(); ++i) {
     if (factors[i]) {
       const size_t globalI =
           newFactorIndices ? (*newFactorIndices)[i] : nFactors_;
       for(const Key key: *factors[i]) {
-        index_[key].push_back(globalI);
+        if (buildCompact) {
+          entryKeys.push_back(key);
+          entryFactors.push_back(globalI);
+        } else {
+          mutableFactors(key).push_back(globalI);
+          ++overflowEntries_;
+        }
         ++nEntries_;
       }
     }
@@ -47,6 +59,11 @@ void VariableIndex::augment(const FG& factors,
       ++nFactors_;
     }
   }
+
+  if (buildCompact)
+    build(entryKeys, entryFactors);
+  else
+    maybeCompact();
 }
 
 /* ************************************************************************* */
@@ -67,29 +84,38 @@ void VariableIndex::remove(ITERATOR firstFactor, ITERATOR lastFactor,
           "Internal error, requested inconsistent number of factor indices and factors in VariableIndex::remove");
     if (factors[i]) {
       for(Key j: *factors[i]) {
-        FactorIndices& factorEntries = internalAt(j);
+        FactorRange existing;
+        if (!lookup(j, &existing))
+          throw std::invalid_argument(
+              "Internal error, indices and factors passed into VariableIndex::remove are not consistent with the existing variable index");
+        FactorIndices& factorEntries = mutableFactors(j);
         auto entry = std::find(factorEntries.begin(),
             factorEntries.end(), *factorIndex);
         if (entry == factorEntries.end())
           throw std::invalid_argument(
               "Internal error, indices and factors passed into VariableIndex::remove are not consistent with the existing variable index");
         factorEntries.erase(entry);
+        --overflowEntries_;
         --nEntries_;
       }
     }
   }
+  maybeCompact();
 }
 
 /* ************************************************************************* */
 template<typename ITERATOR>
 void VariableIndex::removeUnusedVariables(ITERATOR firstKey, ITERATOR lastKey) {
   for (ITERATOR key = firstKey; key != lastKey; ++key) {
-    KeyMap::iterator entry = index_.find(*key);
-    if (!entry->second.empty())
+    FactorRange factors;
+    if (!lookup(*key, &factors))
+      continue;
+    if (!factors.empty())
       throw std::invalid_argument(
           "Asking to remove variables from the variable index that are not unused");
-    index_.erase(entry);
+    eraseVariable(*key);
   }
+  maybeCompact();
 }
 
 }
@@ -15,9 +15,15 @@
  * @date    March 26, 2013
  */
 
+#include <algorithm>
 #include <iostream>
 
 #include <gtsam/inference/VariableIndex.h>
+#include <gtsam/config.h> // for GTSAM_USE_TBB
+
+#ifdef GTSAM_USE_TBB
+#  include <tbb/parallel_for.h>
+#endif
 
 namespace gtsam {
 
@@ -26,14 +32,14 @@ using namespace std;
 /* ************************************************************************* */
 bool VariableIndex::equals(const VariableIndex& other, double tol) const {
   return this->nEntries_ == other.nEntries_ && this->nFactors_ == other.nFactors_
-    && this->index_ == other.index_;
+    && this->nKeys_ == other.nKeys_ && std::equal(begin(), end(), other.begin());
 }
 
 /* ************************************************************************* */
 void VariableIndex::print(const string& str, const KeyFormatter& keyFormatter) const {
   cout << str;
   cout << "nEntries = " << nEntries() << ", nFactors = " << nFactors() << "\n";
-  for(KeyMap::value_type key_factors: index_) {
+  for(const value_type& key_factors: *this) {
     cout << "var " << keyFormatter(key_factors.first) << ":";
     for(const auto index: key_factors.second)
       cout << " " << index;
@@ -46,7 +52,7 @@ void VariableIndex::print(const string& str, const KeyFormatter& keyFormatter) c
 void VariableIndex::outputMetisFormat(ostream& os) const {
   os << size() << " " << nFactors() << "\n";
   // run over variables, which will be hyper-edges.
-  for(KeyMap::value_type key_factors: index_) {
+  for(const value_type& key_factors: *this) {
     // every variable is a hyper-edge covering its factors
     for(const auto index: key_factors.second)
       os << (index+1) << " "; // base 1
@@ -61,11 +67,288 @@ void VariableIndex::augmentExistingFactor(const FactorIndex factorIndex, const K
   gttic(VariableIndex_augmentExistingFactor);
 
   for(const Key key: newKeys) {
-    index_[key].push_back(factorIndex);
+    mutableFactors(key).push_back(factorIndex);
+    ++overflowEntries_;
     ++nEntries_;
   }
+  maybeCompact();
 
   gttoc(VariableIndex_augmentExistingFactor);
 }
 
+/* ************************************************************************* */
+const FactorIndices& VariableIndex::operator[](Key variable) const {
+  const KeyMap::const_iterator item = overflow_.find(variable);
+  if (item != overflow_.end())
+    return item->second;
+  const size_t position = compactPosition(variable);
+  if (position == keys_.size() || erased_.count(variable))
+    throw std::invalid_argument("Requested non-existent variable from VariableIndex");
+
+  // Copy the compact list out once, it does not change until the next build
+  std::lock_guard<std::mutex> lock(materialized_.mutex);
+  const std::pair<KeyMap::iterator, bool> inserted =
+      materialized_.lists.insert(std::make_pair(variable, FactorIndices()));
+  if (inserted.second)
+    inserted.first->second.assign(entries_.begin() + offsets_[position],
+                                  entries_.begin() + offsets_[position + 1]);
+  return inserted.first->second;
+}
+
+/* ************************************************************************* */
+void VariableIndex::replace(Key variable, const FactorIndices& factors)
+{
+  FactorIndices& entries = mutableFactors(variable);
+  overflowEntries_ -= entries.size();
+  nEntries_ -= entries.size();
+  entries = factors;
+  overflowEntries_ += entries.size();
+  nEntries_ += entries.size();
+  for(const FactorIndex factor: factors)
+    if (factor >= nFactors_)
+      nFactors_ = factor + 1;
+  maybeCompact();
+}
+
+/* ************************************************************************* */
+VariableIndex::const_iterator VariableIndex::find(Key key) const {
+  FactorRange factors;
+  if (!lookup(key, &factors))
+    return end();
+  // Both positions are at the key, settle picks the one that is not shadowed
+  const size_t position =
+      std::lower_bound(keys_.begin(), keys_.end(), key) - keys_.begin();
+  return const_iterator(this, position, overflow_.lower_bound(key));
+}
+
+/* ************************************************************************* */
+bool VariableIndex::lookup(Key variable, FactorRange* factors) const {
+  if (!overflow_.empty()) {
+    const KeyMap::const_iterator item = overflow_.find(variable);
+    if (item != overflow_.end()) {
+      const FactorIndex* first = item->second.data();
+      *factors = FactorRange(first, first + item->second.size());
+      return true;
+    }
+  }
+  const size_t position = compactPosition(variable);
+  if (position == keys_.size() ||
+      (!erased_.empty() && erased_.count(variable)))
+    return false;
+  const FactorIndex* entries = entries_.data();
+  *factors = FactorRange(entries + offsets_[position],
+                         entries + offsets_[position + 1]);
+  return true;
+}
+
+/* ************************************************************************* */
+size_t VariableIndex::compactPosition(Key variable) const {
+  const KeyVector::const_iterator item =
+      std::lower_bound(keys_.begin(), keys_.end(), variable);
+  if (item != keys_.end() && *item == variable)
+    return item - keys_.begin();
+  return keys_.size();
+}
+
+/* ************************************************************************* */
+FactorIndices& VariableIndex::mutableFactors(Key variable) {
+  const KeyMap::iterator item = overflow_.find(variable);
+  if (item != overflow_.end())
+    return item->second;
+
+  // Move a compact list to the overflow, or start a new variable
+  FactorIndices& factors = overflow_[variable];
+  const size_t position = compactPosition(variable);
+  if (position < keys_.size() && erased_.erase(variable) == 0) {
+    factors.assign(entries_.begin() + offsets_[position],
+                   entries_.begin() + offsets_[position + 1]);
+    overflowEntries_ += factors.size();
+  } else {
+    ++nKeys_;
+  }
+  return factors;
+}
+
+/* ************************************************************************* */
+void VariableIndex::eraseVariable(Key variable) {
+  const KeyMap::iterator item = overflow_.find(variable);
+  if (item != overflow_.end()) {
+    overflowEntries_ -= item->second.size();
+    overflow_.erase(item);
+  }
+  if (compactPosition(variable) < keys_.size())
+    erased_.insert(variable);
+  --nKeys_;
+}
+
+/* ************************************************************************* */
+void VariableIndex::maybeCompact() {
+  // Amortized: the overflow has to grow by a fraction of the index first
+  static const size_t slack = 1024;
+  if (overflowEntries_ + overflow_.size() + erased_.size() >
+      entries_.size() / 2 + slack)
+    compact();
+}
+
+/* ************************************************************************* */
+void VariableIndex::compact() {
+  if (overflow_.empty() && erased_.empty())
+    return;
+  gttic(VariableIndex_compact);
+
+  KeyVector keys, entryKeys;
+  FactorIndices entryFactors;
+  keys.reserve(nKeys_);
+  entryKeys.reserve(nEntries_);
+  entryFactors.reserve(nEntries_);
+  for (const value_type& key_factors : *this) {
+    keys.push_back(key_factors.first);
+    for (const FactorIndex factor : key_factors.second) {
+      entryKeys.push_back(key_factors.first);
+      entryFactors.push_back(factor);
+    }
+  }
+  build(entryKeys, entryFactors, &keys);
+}
+
+/* ************************************************************************* */
+namespace {
+// Run body(t) for t in [0, nChunks), as TBB tasks when GTSAM is built with TBB
+template <class BODY>
+void parallelFor(size_t nChunks, const BODY& body) {
+#ifdef GTSAM_USE_TBB
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, nChunks, 1),
+                    [&body](const tbb::blocked_range<size_t>& range) {
+    for (size_t t = range.begin(); t != range.end(); ++t)
+      body(t);
+  });
+#else
+  for (size_t t = 0; t < nChunks; ++t)
+    body(t);
+#endif
+}
+}  // namespace
+
+/* ************************************************************************* */
+void VariableIndex::build(const KeyVector& entryKeys,
+    const FactorIndices& entryFactors, const KeyVector* sortedKeys) {
+  gttic(VariableIndex_build);
+  assert(entryKeys.size() == entryFactors.size());
+  const size_t n = entryKeys.size();
+
+  // Split large inputs in chunks that TBB can process in parallel
+#ifdef GTSAM_USE_TBB
+  static const size_t minEntriesPerChunk = 1 << 16;
+  size_t nChunks = n / minEntriesPerChunk + 1;
+#else
+  size_t nChunks = 1;
+#endif
+  const auto chunkBegin = [&](size_t t) { return n * t / nChunks; };
+
+  // Dense remapping: variables in Key order
+  KeyVector keys;
+  if (sortedKeys) {
+    keys = *sortedKeys;
+  } else {
+    keys = entryKeys;
+    parallelFor(nChunks, [&](size_t t) {
+      std::sort(keys.begin() + chunkBegin(t), keys.begin() + chunkBegin(t + 1));
+    });
+    for (size_t t = 1; t < nChunks; ++t)
+      std::inplace_merge(keys.begin(), keys.begin() + chunkBegin(t),
+                         keys.begin() + chunkBegin(t + 1));
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  }
+  const size_t nKeys = keys.size();
+
+  // Every chunk keeps a count per variable, so limit the chunks such that
+  // the counts take no more memory than the entries
+  if (nKeys > 0)
+    nChunks = std::max<size_t>(1, std::min(nChunks, n / nKeys));
+
+  // Counting pass: dense position of every entry and counts per chunk
+  vector<size_t> positions(n);
+  vector<vector<size_t> > counts(nChunks, vector<size_t>(nKeys, 0));
+  parallelFor(nChunks, [&](size_t t) {
+    vector<size_t>& count = counts[t];
+    for (size_t e = chunkBegin(t); e < chunkBegin(t + 1); ++e) {
+      positions[e] = std::lower_bound(keys.begin(), keys.end(), entryKeys[e]) -
+                     keys.begin();
+      ++count[positions[e]];
+    }
+  });
+
+  // Offsets of the variables, and where each chunk starts writing in them
+  offsets_.assign(nKeys + 1, 0);
+  for (size_t j = 0; j < nKeys; ++j) {
+    size_t next = offsets_[j];
+    for (size_t t = 0; t < nChunks; ++t) {
+      const size_t count = counts[t][j];
+      counts[t][j] = next;
+      next += count;
+    }
+    offsets_[j + 1] = next;
+  }
+
+  // Scatter, keeping the order of the entries within every variable
+  entries_.resize(n);
+  parallelFor(nChunks, [&](size_t t) {
+    vector<size_t>& next = counts[t];
+    for (size_t e = chunkBegin(t); e < chunkBegin(t + 1); ++e)
+      entries_[next[positions[e]]++] = entryFactors[e];
+  });
+
+  keys_.swap(keys);
+  overflow_.clear();
+  erased_.clear();
+  materialized_ = MaterializedLists();
+  overflowEntries_ = 0;
+  nKeys_ = nKeys;
+}
+
+/* ************************************************************************* */
+VariableIndex::const_iterator::const_iterator(const VariableIndex* index,
+    size_t position, KeyMap::const_iterator overflow)
+    : index_(index), position_(position), overflow_(overflow),
+      fromOverflow_(false) {
+  settle();
+}
+
+/* ************************************************************************* */
+VariableIndex::const_iterator& VariableIndex::const_iterator::operator++() {
+  if (fromOverflow_)
+    ++overflow_;
+  else
+    ++position_;
+  settle();
+  return *this;
+}
+
+/* ************************************************************************* */
+void VariableIndex::const_iterator::settle() {
+  const KeyVector& keys = index_->keys_;
+  const KeyMap& overflow = index_->overflow_;
+
+  // Skip compact variables that were erased or moved to the overflow
+  while (position_ < keys.size() &&
+         ((overflow_ != overflow.end() && overflow_->first == keys[position_]) ||
+          (!index_->erased_.empty() && index_->erased_.count(keys[position_]))))
+    ++position_;
+
+  // Take the smaller Key of the two
+  if (position_ < keys.size() &&
+      (overflow_ == overflow.end() || keys[position_] < overflow_->first)) {
+    fromOverflow_ = false;
+    const FactorIndex* entries = index_->entries_.data();
+    current_ = value_type(keys[position_],
+                          FactorRange(entries + index_->offsets_[position_],
+                                      entries + index_->offsets_[position_ + 1]));
+  } else if (overflow_ != overflow.end()) {
+    fromOverflow_ = true;
+    const FactorIndex* first = overflow_->second.data();
+    current_ = value_type(overflow_->first,
+                          FactorRange(first, first + overflow_->second.size()));
+  }
+}
+
 }
@@ -24,10 +24,17 @@
 #include <gtsam/dllexport.h>
 
 #include <boost/optional/optional.hpp>
+#include <boost/serialization/nvp.hpp>
+#include <boost/serialization/vector.hpp>
 #include <boost/smart_ptr/shared_ptr.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <iterator>
+#include <mutex>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace gtsam {
 
@@ -36,39 +43,137 @@ namespace gtsam {
  * factor graph.  The factor graph stores a collection of factors, each of
  * which involves a set of variables.  In contrast, the VariableIndex is built
  * from a factor graph prior to elimination, and stores the list of factors
- * that involve each variable.  This information is stored as a deque of
- * lists of factor indices.
+ * that involve each variable.
+ *
+ * The lists are stored in compressed sparse row (CSR) form: the variables are
+ * remapped to dense positions in Key order, and the factor indices of all of
+ * them are packed into one array, which is built with a parallel counting
+ * pass.  Incremental changes, as made by ISAM2, go to an overflow area holding
+ * separate lists for the variables they touch, which is folded back into the
+ * compact arrays once it grows large.
  * \nosubgrouping
  */
 class GTSAM_EXPORT VariableIndex {
  public:
   typedef boost::shared_ptr<VariableIndex> shared_ptr;
-  typedef FactorIndices::iterator Factor_iterator;
-  typedef FactorIndices::const_iterator Factor_const_iterator;
+  typedef const FactorIndex* Factor_const_iterator;
+
+  /// The indices of the factors involving one variable, a view into the index
+  class FactorRange {
+   public:
+    typedef FactorIndex value_type;
+    typedef Factor_const_iterator const_iterator;
+    typedef Factor_const_iterator iterator;
+
+    FactorRange() : begin_(nullptr), end_(nullptr) {}
+    FactorRange(const FactorIndex* first, const FactorIndex* last)
+        : begin_(first), end_(last) {}
+
+    const_iterator begin() const { return begin_; }
+    const_iterator end() const { return end_; }
+    size_t size() const { return end_ - begin_; }
+    bool empty() const { return begin_ == end_; }
+    FactorIndex operator[](size_t i) const { return begin_[i]; }
+    FactorIndex front() const { return *begin_; }
+    FactorIndex back() const { return *(end_ - 1); }
+
+    bool operator==(const FactorRange& other) const {
+      return size() == other.size() && std::equal(begin_, end_, other.begin_);
+    }
+    bool operator!=(const FactorRange& other) const { return !(*this == other); }
+
+   private:
+    const FactorIndex* begin_;
+    const FactorIndex* end_;
+  };
+
+  typedef std::pair<Key, FactorRange> value_type;
 
  protected:
   typedef FastMap<Key, FactorIndices> KeyMap;
-  KeyMap index_;
+
+  // Compact storage: the factors of keys_[i] are entries_[offsets_[i]..offsets_[i+1])
+  KeyVector keys_;
+  std::vector<size_t> offsets_;
+  FactorIndices entries_;
+
+  // Overflow storage: complete lists of variables changed since the last
+  // compaction, which shadow their compact lists, and compact variables erased
+  KeyMap overflow_;
+  KeySet erased_;
+  size_t overflowEntries_;
+
+  size_t nKeys_;     // Number of variables.
   size_t nFactors_;  // Number of factors in the original factor graph.
   size_t nEntries_;  // Sum of involved variable counts of each factor.
 
+  // Lists of compact variables copied out by operator[], which stay valid
+  // until the compact arrays are rebuilt.  Not copied with the index.
+  struct MaterializedLists {
+    std::mutex mutex;
+    KeyMap lists;
+    MaterializedLists() {}
+    MaterializedLists(const MaterializedLists&) {}
+    MaterializedLists& operator=(const MaterializedLists&) {
+      std::lock_guard<std::mutex> lock(mutex);
+      lists.clear();
+      return *this;
+    }
+  };
+  mutable MaterializedLists materialized_;
+
  public:
-  typedef KeyMap::const_iterator const_iterator;
-  typedef KeyMap::const_iterator iterator;
-  typedef KeyMap::value_type value_type;
+  /// Iterates over (Key, FactorRange) pairs in Key order
+  class GTSAM_EXPORT const_iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef VariableIndex::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef const value_type& reference;
+
+    const_iterator() : index_(nullptr), position_(0), fromOverflow_(false) {}
+
+    reference operator*() const { return current_; }
+    pointer operator->() const { return &current_; }
+    const_iterator& operator++();
+    const_iterator operator++(int) {
+      const_iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+    bool operator==(const const_iterator& other) const {
+      return position_ == other.position_ && overflow_ == other.overflow_;
+    }
+    bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+   private:
+    friend class VariableIndex;
+    const_iterator(const VariableIndex* index, size_t position,
+                   KeyMap::const_iterator overflow);
+    void settle();  ///< Skip shadowed entries and load current_
+
+    const VariableIndex* index_;
+    size_t position_;                  ///< Position in the compact keys
+    KeyMap::const_iterator overflow_;  ///< Position in the overflow
+    bool fromOverflow_;
+    value_type current_;
+  };
+  typedef const_iterator iterator;
 
   /// @name Standard Constructors
   /// @{
 
   /// Default constructor, creates an empty VariableIndex
-  VariableIndex() : nFactors_(0), nEntries_(0) {}
+  VariableIndex() : overflowEntries_(0), nKeys_(0), nFactors_(0), nEntries_(0) {}
 
   /**
    * Create a VariableIndex that computes and stores the block column structure
    * of a factor graph.
    */
   template <class FG>
-  explicit VariableIndex(const FG& factorGraph) : nFactors_(0), nEntries_(0) {
+  explicit VariableIndex(const FG& factorGraph)
+      : overflowEntries_(0), nKeys_(0), nFactors_(0), nEntries_(0) {
     augment(factorGraph);
   }
 
@@ -77,7 +182,7 @@ class GTSAM_EXPORT VariableIndex {
   /// @{
 
   /// The number of variable entries.  This is equal to the number of unique variable Keys.
-  size_t size() const { return index_.size(); }
+  size_t size() const { return nKeys_; }
 
   /// The number of factors in the original factor graph
   size_t nFactors() const { return nFactors_; }
@@ -85,18 +190,28 @@ class GTSAM_EXPORT VariableIndex {
   /// The number of nonzero blocks, i.e. the number of variable-factor entries
   size_t nEntries() const { return nEntries_; }
 
-  /// Access a list of factors by variable
-  const FactorIndices& operator[](Key variable) const {
-    KeyMap::const_iterator item = index_.find(variable);
-    if(item == index_.end())
+  /**
+   * Access a list of factors by variable.  The reference stays valid until
+   * the index is modified.  Variables in the compact arrays are copied out on
+   * first access, so prefer factors() in loops over many variables.
+   */
+  const FactorIndices& operator[](Key variable) const;
+
+  /**
+   * View of the list of factors of a variable, without copying.  The view
+   * points into the storage of the index, so it is invalidated by augment,
+   * augmentExistingFactor, remove, removeUnusedVariables, replace and compact.
+   */
+  FactorRange factors(Key variable) const {
+    FactorRange factors;
+    if (!lookup(variable, &factors))
       throw std::invalid_argument("Requested non-existent variable from VariableIndex");
-    else
-    return item->second;
+    return factors;
   }
 
   /// Return true if no factors associated with a variable
   bool empty(Key variable) const {
-    return (*this)[variable].empty();
+    return factors(variable).empty();
   }
 
   /// @}
@@ -152,37 +267,74 @@ class GTSAM_EXPORT VariableIndex {
   template<typename ITERATOR>
   void removeUnusedVariables(ITERATOR firstKey, ITERATOR lastKey);
 
+  /**
+   * Replace the list of factors of a variable, adding the variable if it does
+   * not exist, and raise nFactors() to cover the new indices.  This restores
+   * single entries of a saved index, e.g. from an ISAM2 checkpoint.
+   */
+  void replace(Key variable, const FactorIndices& factors);
+
+  /// Fold the overflow area back into the compact arrays
+  void compact();
+
   /// Iterator to the first variable entry
-  const_iterator begin() const { return index_.begin(); }
+  const_iterator begin() const {
+    return const_iterator(this, 0, overflow_.begin());
+  }
 
   /// Iterator to the first variable entry
-  const_iterator end() const { return index_.end(); }
+  const_iterator end() const {
+    return const_iterator(this, keys_.size(), overflow_.end());
+  }
 
   /// Find the iterator for the requested variable entry
-  const_iterator find(Key key) const { return index_.find(key); }
+  const_iterator find(Key key) const;
 
 protected:
-  Factor_iterator factorsBegin(Key variable) { return internalAt(variable).begin(); }
-  Factor_iterator factorsEnd(Key variable) { return internalAt(variable).end(); }
+  /// Find the factors of a variable, returns false if it does not exist
+  bool lookup(Key variable, FactorRange* factors) const;
 
-  Factor_const_iterator factorsBegin(Key variable) const { return internalAt(variable).begin(); }
-  Factor_const_iterator factorsEnd(Key variable) const { return internalAt(variable).end(); }
+  /// Position of a variable in the compact arrays, or keys_.size()
+  size_t compactPosition(Key variable) const;
 
-  /// Internal version of 'at' that asserts existence
-  const FactorIndices& internalAt(Key variable) const {
-    const KeyMap::const_iterator item = index_.find(variable);
-    assert(item != index_.end());
-    return item->second; 
-  }
+  /// The list of a variable in the overflow area, moved or created there on first use
+  FactorIndices& mutableFactors(Key variable);
 
-  /// Internal version of 'at' that asserts existence
-  FactorIndices& internalAt(Key variable) {
-    const KeyMap::iterator item = index_.find(variable);
-    assert(item != index_.end());
-    return item->second; 
-  }
+  /// Erase a variable that has no factors left
+  void eraseVariable(Key variable);
+
+  /// Compact if the overflow holds a large share of the entries
+  void maybeCompact();
+
+  /**
+   * Replace the storage with the compact index of the given entries, which
+   * are (variable, factor) pairs listed in the order the factors of each
+   * variable should appear. Uses several threads for large inputs.
+   * @param sortedKeys all variables in Key order, if known, which may include
+   *        variables without entries
+   */
+  void build(const KeyVector& entryKeys, const FactorIndices& entryFactors,
+             const KeyVector* sortedKeys = nullptr);
 
   /// @}
+
+ private:
+  /** Serialization function */
+  friend class boost::serialization::access;
+  template<class ARCHIVE>
+  void serialize(ARCHIVE & ar, const unsigned int /*version*/) {
+    if (ARCHIVE::is_loading::value)
+      materialized_ = MaterializedLists();
+    ar & BOOST_SERIALIZATION_NVP(keys_);
+    ar & BOOST_SERIALIZATION_NVP(offsets_);
+    ar & BOOST_SERIALIZATION_NVP(entries_);
+    ar & BOOST_SERIALIZATION_NVP(overflow_);
+    ar & BOOST_SERIALIZATION_NVP(erased_);
+    ar & BOOST_SERIALIZATION_NVP(overflowEntries_);
+    ar & BOOST_SERIALIZATION_NVP(nKeys_);
+    ar & BOOST_SERIALIZATION_NVP(nFactors_);
+    ar & BOOST_SERIALIZATION_NVP(nEntries_);
+  }
 };
 
 /// traits
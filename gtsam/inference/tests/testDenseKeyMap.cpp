@@ -0,0 +1,88 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    testDenseKeyMap.cpp
+ * @brief   Unit tests for DenseKeyMap
+ */
+
+#include <gtsam/inference/DenseKeyMap.h>
+#include <gtsam/inference/Symbol.h>
+#include <gtsam/base/TestableAssertions.h>
+
+#include <CppUnitLite/TestHarness.h>
+
+#include <stdexcept>
+
+using namespace std;
+using namespace gtsam;
+using symbol_shorthand::L;
+using symbol_shorthand::X;
+
+/* ************************************************************************* */
+TEST(DenseKeyMap, indices) {
+  // Unsorted, with a duplicate and two runs of symbols
+  KeyVector keys;
+  keys.push_back(X(2));
+  keys.push_back(L(7));
+  keys.push_back(X(0));
+  keys.push_back(X(1));
+  keys.push_back(L(8));
+  keys.push_back(X(2));
+  const DenseKeyMap keyMap(keys);
+
+  LONGS_EQUAL(5, keyMap.size());
+  LONGS_EQUAL(2, keyMap.nrRuns());
+
+  KeyVector expectedKeys;
+  expectedKeys.push_back(L(7));
+  expectedKeys.push_back(L(8));
+  expectedKeys.push_back(X(0));
+  expectedKeys.push_back(X(1));
+  expectedKeys.push_back(X(2));
+  EXPECT(assert_container_equality(expectedKeys, keyMap.keys()));
+
+  for (size_t i = 0; i < expectedKeys.size(); i++) {
+    LONGS_EQUAL(i, keyMap.find(expectedKeys[i]));
+    LONGS_EQUAL(i, keyMap.at(expectedKeys[i]));
+    EXPECT(keyMap.key(i) == expectedKeys[i]);
+  }
+}
+
+/* ************************************************************************* */
+TEST(DenseKeyMap, missing) {
+  KeySet keys;
+  keys.insert(3);
+  keys.insert(4);
+  keys.insert(10);
+  const DenseKeyMap keyMap(keys);
+  LONGS_EQUAL(2, keyMap.nrRuns());
+
+  // Before, between and after the runs
+  EXPECT(keyMap.find(0) == DenseKeyMap::None);
+  EXPECT(keyMap.find(5) == DenseKeyMap::None);
+  EXPECT(keyMap.find(9) == DenseKeyMap::None);
+  EXPECT(keyMap.find(11) == DenseKeyMap::None);
+  EXPECT(!keyMap.exists(5));
+  EXPECT(keyMap.exists(10));
+  CHECK_EXCEPTION(keyMap.at(5), std::out_of_range);
+
+  const DenseKeyMap empty;
+  EXPECT(empty.empty());
+  EXPECT(empty.find(3) == DenseKeyMap::None);
+}
+
+/* ************************************************************************* */
+int main() {
+  TestResult tr;
+  return TestRegistry::runAllTests(tr);
+}
+/* ************************************************************************* */
@@ -0,0 +1,165 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    testEliminationStructure.cpp
+ * @brief   Unit tests for EliminationStructure
+ */
+
+#include <gtsam/inference/EliminationStructure.h>
+#include <gtsam/inference/Ordering.h>
+#include <gtsam/inference/VariableIndex.h>
+#include <gtsam/symbolic/SymbolicBayesNet.h>
+#include <gtsam/symbolic/SymbolicFactorGraph.h>
+#include <gtsam/symbolic/tests/symbolicExampleGraphs.h>
+
+#include <CppUnitLite/TestHarness.h>
+
+#include <stdexcept>
+
+using namespace std;
+using namespace gtsam;
+
+static const size_t None = EliminationStructure::None;
+
+/* ************************************************************************* */
+namespace {
+/// Rows of the factors of a graph, with columns by position in the ordering,
+/// and the keys that are not in the ordering after those
+void factorRows(const SymbolicFactorGraph& graph, const Ordering& order,
+                vector<size_t>& offsets, vector<size_t>& columns) {
+  FastMap<Key, size_t> column = order.invert();
+  offsets.assign(1, 0);
+  columns.clear();
+  for (const auto& factor : graph) {
+    for (const Key key : *factor) {
+      if (!column.count(key))
+        column.insert(make_pair(key, column.size()));
+      columns.push_back(column[key]);
+    }
+    offsets.push_back(columns.size());
+  }
+}
+
+/// Sizes of the conditionals from symbolic elimination, by position in the ordering
+vector<size_t> conditionalSizes(const SymbolicFactorGraph& graph,
+                                const Ordering& order) {
+  const SymbolicBayesNet::shared_ptr bayesNet =
+      graph.eliminatePartialSequential(order).first;
+  const FastMap<Key, size_t> position = order.invert();
+  vector<size_t> sizes(order.size());
+  for (const auto& conditional : *bayesNet)
+    sizes[position.at(conditional->firstFrontalKey())] = conditional->size();
+  return sizes;
+}
+
+/// A grid of n x n variables
+SymbolicFactorGraph grid(size_t n) {
+  SymbolicFactorGraph graph;
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = 0; j < n; j++) {
+      if (i + 1 < n) graph.push_factor(i * n + j, (i + 1) * n + j);
+      if (j + 1 < n) graph.push_factor(i * n + j, i * n + j + 1);
+    }
+  return graph;
+}
+}  // namespace
+
+/* ************************************************************************* */
+TEST(EliminationStructure, etree) {
+  // 0-1, 0-2, 1-4, 2-4, 3-4, eliminated in order 0..4
+  const SymbolicFactorGraph& graph = simpleTestGraph1;
+  const Ordering order = Ordering::Natural(graph);
+  const EliminationStructure etree(VariableIndex(graph), order);
+
+  const vector<size_t> expectedParents{1, 2, 4, 4, None};
+  EXPECT(expectedParents == etree.parents());
+  EXPECT_LONGS_EQUAL(2, etree.children(4).size());
+  EXPECT_LONGS_EQUAL(2, etree.children(4)[0]);
+  EXPECT_LONGS_EQUAL(3, etree.children(4)[1]);
+  EXPECT(vector<size_t>{4} == etree.roots());
+
+  // Factors go to their first variable
+  const vector<size_t> expectedFirst{0, 0, 1, 2, 3};
+  EXPECT(expectedFirst == etree.firstColumns());
+
+  const vector<size_t> expectedPostorder{0, 1, 2, 3, 4};
+  EXPECT(expectedPostorder == etree.postorder());
+
+  // Same tree from the parents alone
+  const EliminationStructure fromParents(etree.parents());
+  EXPECT(expectedParents == fromParents.parents());
+  EXPECT(expectedPostorder == fromParents.postorder());
+}
+
+/* ************************************************************************* */
+TEST(EliminationStructure, subtreeRoots) {
+  // 0 -> 2, 1 -> 2, 3 -> 4 -> 5, and 2, 5 -> 6
+  const EliminationStructure etree(vector<size_t>{2, 2, 6, 4, 5, 6, None});
+  EXPECT(vector<size_t>{6} == etree.subtreeRoots(7));
+  EXPECT((vector<size_t>{2, 5}) == etree.subtreeRoots(3));
+  EXPECT((vector<size_t>{0, 1, 4}) == etree.subtreeRoots(2));
+  EXPECT((vector<size_t>{0, 1, 3}) == etree.subtreeRoots(1));
+}
+
+/* ************************************************************************* */
+TEST(EliminationStructure, invalidOrdering) {
+  Ordering order;
+  order += 0, 1, 7;
+  CHECK_EXCEPTION(EliminationStructure(VariableIndex(simpleTestGraph1), order),
+                  std::invalid_argument);
+}
+
+/* ************************************************************************* */
+TEST(EliminationStructure, columnCounts) {
+  const SymbolicFactorGraph& graph = simpleTestGraph2;
+  const Ordering order = Ordering::Colamd(graph);
+  const EliminationStructure etree(VariableIndex(graph), order);
+
+  vector<size_t> offsets, columns;
+  factorRows(graph, order, offsets, columns);
+  EXPECT(conditionalSizes(graph, order) == etree.columnCounts(offsets, columns));
+}
+
+/* ************************************************************************* */
+TEST(EliminationStructure, partialElimination) {
+  // Eliminate only part of a grid, the conditionals involve the rest
+  const SymbolicFactorGraph graph = grid(4);
+  Ordering order;
+  order += 0, 3, 12, 15, 5;
+  const EliminationStructure etree(VariableIndex(graph), order);
+  EXPECT_LONGS_EQUAL(5, etree.roots().size());
+
+  vector<size_t> offsets, columns;
+  factorRows(graph, order, offsets, columns);
+  EXPECT(conditionalSizes(graph, order) == etree.columnCounts(offsets, columns));
+}
+
+/* ************************************************************************* */
+TEST(EliminationStructure, parallelColumnCounts) {
+  // Large enough to be split into subtrees
+  const SymbolicFactorGraph graph = grid(130);
+  const Ordering order = Ordering::Colamd(graph);
+  const EliminationStructure etree(VariableIndex(graph), order);
+
+  vector<size_t> offsets, columns;
+  factorRows(graph, order, offsets, columns);
+  const vector<size_t> expected = conditionalSizes(graph, order);
+  EXPECT(expected == etree.columnCounts(offsets, columns, 1));
+  EXPECT(expected == etree.columnCounts(offsets, columns, 4));
+}
+
+/* ************************************************************************* */
+int main() {
+  TestResult tr;
+  return TestRegistry::runAllTests(tr);
+}
+/* ************************************************************************* */
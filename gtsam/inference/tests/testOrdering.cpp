@@ -17,6 +17,7 @@
 
 #include <gtsam/inference/Symbol.h>
 #include <gtsam/symbolic/SymbolicFactorGraph.h>
+#include <gtsam/symbolic/SymbolicBayesNet.h>
 #include <gtsam/inference/Ordering.h>
 #include <gtsam/inference/MetisIndex.h>
 #include <gtsam/base/TestableAssertions.h>
@@ -256,6 +257,11 @@ TEST(Ordering, metis) {
   EXPECT(adjExpected.size() == mi.adj().size());
   EXPECT(adjExpected == mi.adj());
 
+  // Same structure when built from a VariableIndex
+  MetisIndex fromIndex(symbolicGraph, VariableIndex(symbolicGraph));
+  EXPECT(xadjExpected == fromIndex.xadj());
+  EXPECT(adjExpected == fromIndex.adj());
+
   Ordering metis = Ordering::Metis(symbolicGraph);
 }
 #endif
@@ -293,6 +299,87 @@ TEST(Ordering, MetisLoop) {
 #endif
 }
 #endif
+
+/* ************************************************************************* */
+#ifdef GTSAM_SUPPORT_NESTED_DISSECTION
+TEST(Ordering, MetisParallel) {
+  // 20x20 grid, large enough for several levels of dissection
+  const size_t n = 20;
+  SymbolicFactorGraph grid;
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = 0; j < n; j++) {
+      if (i + 1 < n) grid.push_factor(i * n + j, (i + 1) * n + j);
+      if (j + 1 < n) grid.push_factor(i * n + j, i * n + j + 1);
+    }
+
+  for (size_t nThreads : {1, 4}) {
+    const Ordering actual = Ordering::MetisParallel(grid, nThreads, 10);
+
+    // Every variable appears exactly once
+    KeyVector sorted(actual.begin(), actual.end());
+    sort(sorted.begin(), sorted.end());
+    KeySet keys = grid.keys();
+    EXPECT(sorted == KeyVector(keys.begin(), keys.end()));
+
+    // The result is usable for elimination
+    EXPECT_LONGS_EQUAL(n * n, grid.eliminateSequential(actual)->size());
+  }
+
+  // Below the partition size this is plain METIS
+  EXPECT(assert_equal(Ordering::Metis(grid), Ordering::MetisParallel(grid, 4, n * n)));
+}
+#endif
+
+/* ************************************************************************* */
+TEST(Ordering, ColamdIncremental) {
+  SymbolicFactorGraph graph = example::symbolicChain();
+  const Ordering previous = Ordering::Colamd(graph);
+
+  // Extending the end of the chain only reorders the tail
+  {
+    SymbolicFactorGraph newFactors;
+    newFactors.push_factor(5, 6);
+    SymbolicFactorGraph full = graph;
+    full.push_back(newFactors);
+    const Ordering actual = Ordering::ColamdIncremental(previous, full, newFactors);
+    EXPECT_LONGS_EQUAL(7, actual.size());
+    EXPECT(KeyVector(previous.begin(), previous.begin() + 5) ==
+           KeyVector(actual.begin(), actual.begin() + 5));
+    EXPECT(KeySet(actual.begin() + 5, actual.end()) == newFactors.keys());
+  }
+
+  // A loop closure to an early variable moves it, and the new one, last
+  {
+    SymbolicFactorGraph newFactors;
+    newFactors.push_factor(1, 6);
+    SymbolicFactorGraph full = graph;
+    full.push_back(newFactors);
+    const Ordering actual = Ordering::ColamdIncremental(previous, full, newFactors);
+    EXPECT_LONGS_EQUAL(7, actual.size());
+    EXPECT_LONGS_EQUAL(previous[0], actual[0]);
+    EXPECT(KeySet(actual.begin() + 5, actual.end()) == newFactors.keys());
+    EXPECT_LONGS_EQUAL(7, full.eliminateSequential(actual)->size());
+  }
+
+  // Nothing new keeps the ordering
+  EXPECT(assert_equal(previous, Ordering::ColamdIncremental(
+      previous, graph, SymbolicFactorGraph())));
+
+  // A variable without factors left is still ordered
+  {
+    Ordering withUnused = previous;
+    withUnused.push_back(9);
+    SymbolicFactorGraph newFactors;
+    newFactors.push_factor(5, 6);
+    SymbolicFactorGraph full = graph;
+    full.push_back(newFactors);
+    const Ordering actual = Ordering::ColamdIncremental(withUnused, VariableIndex(full),
+                                                        newFactors.keys());
+    EXPECT_LONGS_EQUAL(8, actual.size());
+    EXPECT(std::find(actual.begin(), actual.end(), 9) != actual.end());
+  }
+}
+
 /* ************************************************************************* */
 TEST(Ordering, Create) {
 
@@ -662,6 +662,9 @@ namespace gtsam {
         Base(const ReweightScheme reweight = Block):reweight_(reweight) {}
         virtual ~Base() {}
 
+        /// The reweighting scheme of this robust function
+        ReweightScheme reweightScheme() const { return reweight_; }
+
         /*
          * This method is responsible for returning the total penalty for a given amount of error.
          * For example, this method is responsible for implementing the quadratic function for an
@@ -755,6 +758,7 @@ namespace gtsam {
         void print(const std::string &s) const;
         bool equals(const Base& expected, double tol=1e-8) const;
         static shared_ptr Create(double c, const ReweightScheme reweight = Block) ;
+        double modelParameter() const { return c_; }
 
       private:
         /** Serialization function */
@@ -781,6 +785,7 @@ namespace gtsam {
         void print(const std::string &s) const;
         bool equals(const Base& expected, double tol=1e-8) const;
         static shared_ptr Create(double k, const ReweightScheme reweight = Block) ;
+        double modelParameter() const { return k_; }
 
       private:
         /** Serialization function */
@@ -811,6 +816,7 @@ namespace gtsam {
         void print(const std::string &s) const;
         bool equals(const Base& expected, double tol=1e-8) const;
         static shared_ptr Create(double k, const ReweightScheme reweight = Block) ;
+        double modelParameter() const { return k_; }
 
       private:
         /** Serialization function */
@@ -841,6 +847,7 @@ namespace gtsam {
         void print(const std::string &s) const;
         bool equals(const Base& expected, double tol=1e-8) const;
         static shared_ptr Create(double k, const ReweightScheme reweight = Block) ;
+        double modelParameter() const { return c_; }
 
       private:
         /** Serialization function */
@@ -868,6 +875,7 @@ namespace gtsam {
         void print(const std::string &s) const;
         bool equals(const Base& expected, double tol=1e-8) const;
         static shared_ptr Create(double k, const ReweightScheme reweight = Block) ;
+        double modelParameter() const { return c_; }
 
       private:
         /** Serialization function */
@@ -895,6 +903,7 @@ namespace gtsam {
         virtual void print(const std::string &s) const;
         virtual bool equals(const Base& expected, double tol=1e-8) const;
         static shared_ptr Create(double k, const ReweightScheme reweight = Block) ;
+        double modelParameter() const { return c_; }
 
       protected:
         double c_;
@@ -924,6 +933,7 @@ namespace gtsam {
         virtual void print(const std::string &s) const;
         virtual bool equals(const Base& expected, double tol=1e-8) const;
         static shared_ptr Create(double k, const ReweightScheme reweight = Block) ;
+        double modelParameter() const { return c_; }
 
       protected:
         double c_;
@@ -966,6 +976,7 @@ namespace gtsam {
           void print(const std::string &s) const;
           bool equals(const Base& expected, double tol=1e-8) const;
           static shared_ptr Create(double k, const ReweightScheme reweight = Block);
+          double modelParameter() const { return k_; }
 
       private:
           /** Serialization function */
@@ -17,11 +17,15 @@
 
 #include <gtsam/linear/VectorValues.h>
 #include <gtsam/linear/GaussianConditional.h>
+#include <gtsam/inference/DenseKeyMap.h>
 #include <gtsam/base/treeTraversal-inst.h>
 
 #include <boost/optional.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <iterator>
+#include <vector>
+
 namespace gtsam
 {
   namespace internal
@@ -29,82 +33,59 @@ namespace gtsam
     namespace linearAlgorithms
     {
       /* ************************************************************************* */
-      struct OptimizeData {
-        boost::optional<OptimizeData&> parentData;
-        FastMap<Key, VectorValues::const_iterator> cliqueResults;
-        //VectorValues ancestorResults;
-        //VectorValues results;
-      };
+      struct OptimizeData {};
 
       /* ************************************************************************* */
       /** Pre-order visitor for back-substitution in a Bayes tree.  The visitor function operator()()
-      *  optimizes the clique given the solution for the parents, and returns the solution for the
-      *  clique's frontal variables.  In addition, it adds the solution to a global collected
-      *  solution that will finally be returned to the user.  The reason we pass the individual
-      *  clique solutions between nodes is to avoid log(n) lookups over all variables, they instead
-      *  then are only over a node's parent variables. */
+      *  optimizes the clique given the solution for the parents, and stores the solution for the
+      *  clique's frontal variables.  The solution of all variables is kept in a vector indexed by
+      *  the dense index of each key, which is set up once for the whole tree, so that gathering the
+      *  parent solutions and storing the frontal ones does not search any map.  Every variable is
+      *  written by a single clique before its descendants read it, so the cliques of different
+      *  subtrees can be solved in parallel. */
       template<class CLIQUE>
       struct OptimizeClique
       {
-        VectorValues collectedResult;
+        const DenseKeyMap& keyMap;
+        std::vector<Vector>& solution;
+
+        OptimizeClique(const DenseKeyMap& keyMap, std::vector<Vector>& solution) :
+          keyMap(keyMap), solution(solution) {}
 
         OptimizeData operator()(
           const boost::shared_ptr<CLIQUE>& clique,
           OptimizeData& parentData)
         {
-          OptimizeData myData;
-          myData.parentData = parentData;
-          // Take any ancestor results we'll need
-          for(Key parent: clique->conditional_->parents())
-            myData.cliqueResults.emplace(parent, myData.parentData->cliqueResults.at(parent));
-
-          // Solve and store in our results
-          {
-            GaussianConditional& c = *clique->conditional();
-            // Solve matrix
-            Vector xS;
-            {
-              // Count dimensions of vector
-              DenseIndex dim = 0;
-              FastVector<VectorValues::const_iterator> parentPointers;
-              parentPointers.reserve(clique->conditional()->nrParents());
-              for(Key parent: clique->conditional()->parents()) {
-                parentPointers.push_back(myData.cliqueResults.at(parent));
-                dim += parentPointers.back()->second.size();
-              }
-
-              // Fill parent vector
-              xS.resize(dim);
-              DenseIndex vectorPos = 0;
-              for(const VectorValues::const_iterator& parentPointer: parentPointers) {
-                const Vector& parentVector = parentPointer->second;
-                xS.block(vectorPos,0,parentVector.size(),1) = parentVector.block(0,0,parentVector.size(),1);
-                vectorPos += parentVector.size();
-              }
-            }
-
-            // NOTE(gareth): We can no longer write: xS = b - S * xS
-            // This is because Eigen (as of 3.3) no longer evaluates S * xS into
-            // a temporary, and the operation trashes valus in xS.
-            // See: http://eigen.tuxfamily.org/index.php?title=3.3
-            const Vector rhs = c.getb() - c.S() * xS;
-
-            // TODO(gareth): Inline instantiation of Eigen::Solve and check flag
-            const Vector solution = c.R().triangularView<Eigen::Upper>().solve(rhs);
-
-            // Check for indeterminant solution
-            if(solution.hasNaN()) throw IndeterminantLinearSystemException(c.keys().front());
-
-            // Insert solution into a VectorValues
-            DenseIndex vectorPosition = 0;
-            for(GaussianConditional::const_iterator frontal = c.beginFrontals(); frontal != c.endFrontals(); ++frontal) {
-              VectorValues::const_iterator r =
-                collectedResult.emplace(*frontal, solution.segment(vectorPosition, c.getDim(frontal)));
-              myData.cliqueResults.emplace(r->first, r);
-              vectorPosition += c.getDim(frontal);
-            }
+          const GaussianConditional& c = *clique->conditional();
+
+          // Fill parent vector
+          Vector xS(c.S().cols());
+          DenseIndex vectorPos = 0;
+          for(GaussianConditional::const_iterator parent = c.beginParents(); parent != c.endParents(); ++parent) {
+            const Vector& parentVector = solution[keyMap.find(*parent)];
+            xS.segment(vectorPos, parentVector.size()) = parentVector;
+            vectorPos += parentVector.size();
+          }
+
+          // NOTE(gareth): We can no longer write: xS = b - S * xS
+          // This is because Eigen (as of 3.3) no longer evaluates S * xS into
+          // a temporary, and the operation trashes valus in xS.
+          // See: http://eigen.tuxfamily.org/index.php?title=3.3
+          const Vector rhs = c.getb() - c.S() * xS;
+
+          // TODO(gareth): Inline instantiation of Eigen::Solve and check flag
+          const Vector frontalSolution = c.R().triangularView<Eigen::Upper>().solve(rhs);
+
+          // Check for indeterminant solution
+          if(frontalSolution.hasNaN()) throw IndeterminantLinearSystemException(c.keys().front());
+
+          // Store the solution of each frontal variable
+          DenseIndex vectorPosition = 0;
+          for(GaussianConditional::const_iterator frontal = c.beginFrontals(); frontal != c.endFrontals(); ++frontal) {
+            solution[keyMap.find(*frontal)] = frontalSolution.segment(vectorPosition, c.getDim(frontal));
+            vectorPosition += c.getDim(frontal);
           }
-          return myData;
+          return OptimizeData();
         }
       };
 
@@ -138,12 +119,26 @@ namespace gtsam
         //internal::OptimizeData rootData; // Will hold final solution
         //treeTraversal::DepthFirstForest(*this, rootData, internal::OptimizePreVisitor, internal::OptimizePostVisitor);
         //return rootData.results;
+        // Every variable is frontal in exactly one clique
+        KeyVector keys;
+        keys.reserve(bayesTree.nodes().size());
+        for(const auto& node: bayesTree.nodes())
+          keys.push_back(node.first);
+        const DenseKeyMap keyMap(keys);
+        std::vector<Vector> solution(keyMap.size());
+
         OptimizeData rootData;
-        OptimizeClique<typename BAYESTREE::Clique> preVisitor;
+        OptimizeClique<typename BAYESTREE::Clique> preVisitor(keyMap, solution);
         treeTraversal::no_op postVisitor;
         TbbOpenMPMixedScope threadLimiter; // Limits OpenMP threads since we're mixing TBB and OpenMP
         treeTraversal::DepthFirstForestParallel(bayesTree, rootData, preVisitor, postVisitor);
-        return preVisitor.collectedResult;
+
+        // Map back to keys, which are in sorted order so the result is built in linear time
+        std::vector<std::pair<Key, Vector> > result;
+        result.reserve(keyMap.size());
+        for(size_t i = 0; i < keyMap.size(); ++i)
+          result.emplace_back(keyMap.key(i), std::move(solution[i]));
+        return VectorValues(std::make_move_iterator(result.begin()), std::make_move_iterator(result.end()));
       }
     }
   }
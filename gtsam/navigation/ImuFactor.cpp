@@ -86,16 +86,99 @@ void PreintegratedImuMeasurements::integrateMeasurements(
     const Matrix& measuredAccs, const Matrix& measuredOmegas,
     const Matrix& dts) {
   assert(
-      measuredAccs.rows() == 3 && measuredOmegas.rows() == 3 && dts.rows() == 1);
-  assert(dts.cols() >= 1);
-  assert(measuredAccs.cols() == dts.cols());
-  assert(measuredOmegas.cols() == dts.cols());
-  size_t n = static_cast<size_t>(dts.cols());
+      measuredAccs.rows() == 3 && measuredOmegas.rows() == 3
+          && (dts.rows() == 1 || dts.cols() == 1));
+  assert(dts.size() >= 1);
+  assert(measuredAccs.cols() == dts.size());
+  assert(measuredOmegas.cols() == dts.size());
+  size_t n = static_cast<size_t>(dts.size());
+#ifdef GTSAM_TANGENT_PREINTEGRATION
+  if (!p().body_P_sensor) {
+    for (size_t j = 0; j < n; j++) {
+      integrateMeasurementBlocked(measuredAccs.col(j), measuredOmegas.col(j),
+          dts(j));
+    }
+    return;
+  }
+#endif
   for (size_t j = 0; j < n; j++) {
-    integrateMeasurement(measuredAccs.col(j), measuredOmegas.col(j), dts(0, j));
+    integrateMeasurement(measuredAccs.col(j), measuredOmegas.col(j), dts(j));
   }
 }
 
+//------------------------------------------------------------------------------
+#ifdef GTSAM_TANGENT_PREINTEGRATION
+// Without a sensor pose, the Jacobians computed in
+// TangentPreintegration::UpdatePreintegrated have the block structure
+//   A = [F 0 0; Gp I dt*I; Gv 0 I], B = [0; R*dt22; R*dt], C = [invH*dt; 0; 0]
+// with F = I + w_tangent_H_theta*dt, Gp = a_nav_H_theta*dt22 and
+// Gv = a_nav_H_theta*dt. Exploiting it, A*P*A' and the noise terms only need
+// fixed-size 3x3 products, rather than dense 9x9 ones.
+void PreintegratedImuMeasurements::integrateMeasurementBlocked(
+    const Vector3& measuredAcc, const Vector3& measuredOmega, double dt) {
+  if (dt <= 0) {
+    throw std::runtime_error(
+        "PreintegratedImuMeasurements::integrateMeasurements: dt <=0");
+  }
+
+  // Correct for bias in the sensor frame
+  const Vector3 acc = biasHat_.correctAccelerometer(measuredAcc);
+  const Vector3 omega = biasHat_.correctGyroscope(measuredOmega);
+
+  // Mean propagation, identical to UpdatePreintegrated
+  const Vector3 theta = preintegrated_.head<3>();
+  so3::DexpFunctor local(theta);
+  Matrix3 w_tangent_H_theta, invH;
+  const Vector3 w_tangent = local.applyInvDexp(omega, w_tangent_H_theta, invH);
+  const Matrix3 R = local.expmap().matrix();
+  const Vector3 a_nav = R * acc;
+  const double dt22 = 0.5 * dt * dt;
+
+  preintegrated_.segment<3>(3) += preintegrated_.tail<3>() * dt + a_nav * dt22;
+  preintegrated_.tail<3>() += a_nav * dt;
+  preintegrated_.head<3>() += w_tangent * dt;
+  deltaTij_ += dt;
+
+  // Non-trivial blocks of A
+  const Matrix3 a_nav_H_theta = R * skewSymmetric(-acc) * local.dexp();
+  const Matrix3 F = I_3x3 + w_tangent_H_theta * dt;
+  const Matrix3 Gp = a_nav_H_theta * dt22;
+  const Matrix3 Gv = a_nav_H_theta * dt;
+
+  // Bias Jacobians: new_H_bias = A * old_H_bias - B (resp. C)
+  Matrix93& Ha = preintegrated_H_biasAcc_;
+  Matrix93& Hw = preintegrated_H_biasOmega_;
+  const Matrix3 Ha0 = Ha.topRows<3>(), Hw0 = Hw.topRows<3>();
+  Ha.middleRows<3>(3) += Gp * Ha0 + Ha.bottomRows<3>() * dt - R * dt22;
+  Ha.bottomRows<3>() += Gv * Ha0 - R * dt;
+  Ha.topRows<3>() = F * Ha0;
+  Hw.middleRows<3>(3) += Gp * Hw0 + Hw.bottomRows<3>() * dt;
+  Hw.bottomRows<3>() += Gv * Hw0;
+  Hw.topRows<3>() = F * Hw0 - invH * dt;
+
+  // Covariance: P = A * P * A', first the rows, then the columns
+  Matrix9& P = preintMeasCov_;
+  const Eigen::Matrix<double, 3, 9> P0 = P.topRows<3>();
+  P.middleRows<3>(3) += Gp * P0 + P.bottomRows<3>() * dt;
+  P.bottomRows<3>() += Gv * P0;
+  P.topRows<3>() = F * P0;
+  const Eigen::Matrix<double, 9, 3> Q0 = P.leftCols<3>();
+  P.middleCols<3>(3) += Q0 * Gp.transpose() + P.rightCols<3>() * dt;
+  P.rightCols<3>() += Q0 * Gv.transpose();
+  P.leftCols<3>() = Q0 * F.transpose();
+
+  // Noise terms, (1/dt) converting continuous time noise to discrete time
+  const Matrix3 aCov = R * p().accelerometerCovariance * R.transpose() / dt;
+  P.block<3, 3>(3, 3).noalias() += (dt22 * dt22) * aCov
+      + p().integrationCovariance * dt;
+  P.block<3, 3>(3, 6).noalias() += (dt22 * dt) * aCov;
+  P.block<3, 3>(6, 3).noalias() += (dt22 * dt) * aCov;
+  P.block<3, 3>(6, 6).noalias() += (dt * dt) * aCov;
+  P.block<3, 3>(0, 0).noalias() += invH * p().gyroscopeCovariance
+      * invH.transpose() * dt;
+}
+#endif
+
 //------------------------------------------------------------------------------
 #ifdef GTSAM_TANGENT_PREINTEGRATION
 void PreintegratedImuMeasurements::mergeWith(const PreintegratedImuMeasurements& pim12, //
@@ -128,7 +128,16 @@ public:
   void integrateMeasurement(const Vector3& measuredAcc,
       const Vector3& measuredOmega, const double dt) override;
 
-  /// Add multiple measurements, in matrix columns
+  /**
+   * Add multiple measurements, in matrix columns.
+   * With tangent-space preintegration and no body_P_sensor, the covariance and
+   * bias Jacobians are propagated using only the non-zero 3x3 blocks of the
+   * per-sample Jacobians, which is considerably cheaper than calling
+   * integrateMeasurement once per sample.
+   * @param measuredAccs 3*N matrix of measured accelerations
+   * @param measuredOmegas 3*N matrix of measured angular velocities
+   * @param dts time intervals, either as a 1*N or a N*1 matrix
+   */
   void integrateMeasurements(const Matrix& measuredAccs, const Matrix& measuredOmegas,
                              const Matrix& dts);
 
@@ -158,6 +167,12 @@ public:
 
 private:
 
+#ifdef GTSAM_TANGENT_PREINTEGRATION
+  /// Block-sparse version of integrateMeasurement, valid without body_P_sensor
+  void integrateMeasurementBlocked(const Vector3& measuredAcc,
+      const Vector3& measuredOmega, double dt);
+#endif
+
   /// Serialization function
   friend class boost::serialization::access;
   template<class ARCHIVE>
@@ -239,6 +239,37 @@ TEST(ImuFactor, MultipleMeasurements) {
   EXPECT(assert_equal(expected,actual));
 }
 
+/* ************************************************************************* */
+TEST(ImuFactor, MultipleMeasurementsBlocked) {
+  const Bias biasHat(Vector3(0.2, 0.0, 0.1), Vector3(0.0, 0.02, 0.01));
+  const testing::SomeMeasurements measurements;
+
+  const size_t n = measurements.size();
+  Matrix acc(3, n), gyro(3, n);
+  Vector dts(n);
+  for (size_t j = 0; j < n; j++) {
+    acc.col(j) = measurements[j].acc;
+    gyro.col(j) = measurements[j].gyro;
+    dts(j) = measurements[j].dt;
+  }
+
+  // Without sensor pose, batch integration uses the block-sparse update
+  PreintegratedImuMeasurements expected(testing::Params(), biasHat);
+  testing::integrateMeasurements(measurements, &expected);
+  PreintegratedImuMeasurements actual(testing::Params(), biasHat);
+  actual.integrateMeasurements(acc, gyro, dts);
+  EXPECT(assert_equal(expected, actual));
+
+  // With sensor pose, it falls back to integrating one measurement at a time
+  auto p = testing::Params();
+  p->body_P_sensor = Pose3(Rot3::Ypr(0.1, 0.2, 0.3), Point3(0.1, 0.0, 0.2));
+  PreintegratedImuMeasurements expected2(p, biasHat);
+  testing::integrateMeasurements(measurements, &expected2);
+  PreintegratedImuMeasurements actual2(p, biasHat);
+  actual2.integrateMeasurements(acc, gyro, dts);
+  EXPECT(assert_equal(expected2, actual2));
+}
+
 /* ************************************************************************* */
 TEST(ImuFactor, ErrorAndJacobians) {
   using namespace common;
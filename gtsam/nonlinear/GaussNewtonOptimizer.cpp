@@ -43,10 +43,18 @@ GaussNewtonOptimizer::GaussNewtonOptimizer(const NonlinearFactorGraph& graph,
 /* ************************************************************************* */
 GaussianFactorGraph::shared_ptr GaussNewtonOptimizer::iterate() {
   gttic(GaussNewtonOptimizer_Iterate);
+  counters_ = PerformanceCounters();
 
   // Linearize graph
   gttic(GaussNewtonOptimizer_Linearize);
-  GaussianFactorGraph::shared_ptr linear = graph_.linearize(state_->values);
+  GaussianFactorGraph::shared_ptr linear;
+  {
+    PerformanceCounters::ScopedTimer timer(&counters_.linearizeTime);
+    linear = graph_.linearize(state_->values);
+  }
+  // Every factor is linearized again, except in the first iteration
+  if (iterations() > 0) counters_.factorsRelinearized = graph_.nrFactors();
+  counters_.addLinearFactors(*linear);
   gttoc(GaussNewtonOptimizer_Linearize);
 
   // Solve Factor Graph
@@ -60,7 +68,12 @@ GaussianFactorGraph::shared_ptr GaussNewtonOptimizer::iterate() {
 
   // Create new state with new values and new error
   Values newValues = state_->values.retract(delta);
-  state_.reset(new State(std::move(newValues), graph_.error(newValues), state_->iterations + 1));
+  double newError;
+  {
+    PerformanceCounters::ScopedTimer timer(&counters_.errorTime);
+    newError = graph_.error(newValues);
+  }
+  state_.reset(new State(std::move(newValues), newError, state_->iterations + 1));
 
   return linear;
 }
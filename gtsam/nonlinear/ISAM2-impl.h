@@ -83,11 +83,13 @@ struct GTSAM_EXPORT DeltaImpl {
 
   /**
    * Update the Newton's method step point, using wildfire
+   * @param changedKeys if given, the variables whose delta changed are added
    */
   static size_t UpdateGaussNewtonDelta(const ISAM2::Roots& roots,
                                        const KeySet& replacedKeys,
                                        double wildfireThreshold,
-                                       VectorValues* delta);
+                                       VectorValues* delta,
+                                       KeySet* changedKeys = nullptr);
 
   /**
    * Update the RgProd (R*g) incrementally taking into account which variables
@@ -524,7 +526,7 @@ struct GTSAM_EXPORT UpdateImpl {
     gttic(GetAffectedFactors);
     FactorIndexSet indices;
     for (const Key key : keys) {
-      const FactorIndices& factors(variableIndex[key]);
+      const VariableIndex::FactorRange factors = variableIndex.factors(key);
       indices.insert(factors.begin(), factors.end());
     }
     return indices;
@@ -61,11 +61,16 @@ bool ISAM2::equals(const ISAM2& other, double tol) const {
 /* ************************************************************************* */
 GaussianFactorGraph ISAM2::relinearizeAffectedFactors(
     const ISAM2UpdateParams& updateParams, const FastList<Key>& affectedKeys,
-    const KeySet& relinKeys) {
+    const KeySet& relinKeys, const FactorIndices& newFactorsIndices,
+    PerformanceCounters& counters) {
   gttic(relinearizeAffectedFactors);
   FactorIndexSet candidates =
       UpdateImpl::GetAffectedFactors(affectedKeys, variableIndex_);
 
+  // The new factors were already counted when they were linearized in step 7
+  const FactorIndexSet newFactors(newFactorsIndices.begin(),
+                                  newFactorsIndices.end());
+
   gttic(affectedKeysSet);
   // for fast lookup below
   KeySet affectedKeysSet;
@@ -73,6 +78,7 @@ GaussianFactorGraph ISAM2::relinearizeAffectedFactors(
   gttoc(affectedKeysSet);
 
   gttic(check_candidates_and_linearize);
+  PerformanceCounters::ScopedTimer timer(&counters.linearizeTime);
   GaussianFactorGraph linearized;
   for (const FactorIndex idx : candidates) {
     bool inside = true;
@@ -95,6 +101,10 @@ GaussianFactorGraph ISAM2::relinearizeAffectedFactors(
       } else {
         auto linearFactor = nonlinearFactors_[idx]->linearize(theta_);
         linearized.push_back(linearFactor);
+        if (!newFactors.exists(idx)) {
+          ++counters.factorsRelinearized;
+          if (linearFactor) counters.addLinearFactor(*linearFactor);
+        }
         if (params_.cacheLinearizedFactors) {
 #ifdef GTSAM_EXTRA_CONSISTENCY_CHECKS
           assert(linearFactors_[idx]->keys() == linearFactor->keys());
@@ -122,9 +132,12 @@ void ISAM2::recalculate(const ISAM2UpdateParams& updateParams,
     // removed cliques.
     GaussianBayesNet affectedBayesNet;
     Cliques orphans;
-    this->removeTop(
-        KeyVector(result->markedKeys.begin(), result->markedKeys.end()),
-        &affectedBayesNet, &orphans);
+    {
+      PerformanceCounters::ScopedTimer timer(&result->counters.symbolicTime);
+      this->removeTop(
+          KeyVector(result->markedKeys.begin(), result->markedKeys.end()),
+          &affectedBayesNet, &orphans);
+    }
 
     // FactorGraph<GaussianFactor> factors(affectedBayesNet);
     // bug was here: we cannot reuse the original factors, because then the
@@ -167,6 +180,7 @@ void ISAM2::recalculate(const ISAM2UpdateParams& updateParams,
 
     // Update replaced keys mask (accumulates until back-substitution happens)
     deltaReplacedMask_.insert(affectedKeysSet.begin(), affectedKeysSet.end());
+    recordCheckpointKeys(affectedKeysSet);
   }
 }
 
@@ -175,6 +189,10 @@ void ISAM2::recalculateBatch(const ISAM2UpdateParams& updateParams,
                              KeySet* affectedKeysSet, ISAM2Result* result) {
   gttic(recalculateBatch);
 
+  PerformanceCounters& counters = result->counters;
+  boost::optional<PerformanceCounters::ScopedTimer> symbolicTimer;
+  symbolicTimer.emplace(&counters.symbolicTime);
+
   gttic(add_keys);
   br::copy(variableIndex_ | br::map_keys,
            std::inserter(*affectedKeysSet, affectedKeysSet->end()));
@@ -208,17 +226,36 @@ void ISAM2::recalculateBatch(const ISAM2UpdateParams& updateParams,
   }
   gttoc(ordering);
 
+  symbolicTimer.reset();
+
   gttic(linearize);
-  auto linearized = nonlinearFactors_.linearize(theta_);
+  GaussianFactorGraph::shared_ptr linearized;
+  {
+    PerformanceCounters::ScopedTimer timer(&counters.linearizeTime);
+    linearized = nonlinearFactors_.linearize(theta_);
+  }
   if (params_.cacheLinearizedFactors) linearFactors_ = *linearized;
+  // The new factors were already counted when they were linearized in step 7
+  counters.factorsRelinearized +=
+      nonlinearFactors_.nrFactors() - result->newFactorsIndices.size();
+  const FactorIndexSet newFactors(result->newFactorsIndices.begin(),
+                                  result->newFactorsIndices.end());
+  for (size_t i = 0; i < linearized->size(); ++i)
+    if ((*linearized)[i] && !newFactors.exists(i))
+      counters.addLinearFactor(*(*linearized)[i]);
   gttoc(linearize);
 
   gttic(eliminate);
-  ISAM2BayesTree::shared_ptr bayesTree =
-      ISAM2JunctionTree(
-          GaussianEliminationTree(*linearized, affectedFactorsVarIndex, order))
-          .eliminate(params_.getEliminationFunction())
-          .first;
+  symbolicTimer.emplace(&counters.symbolicTime);
+  const ISAM2JunctionTree junctionTree(
+      GaussianEliminationTree(*linearized, affectedFactorsVarIndex, order));
+  symbolicTimer.reset();
+  ISAM2BayesTree::shared_ptr bayesTree;
+  {
+    PerformanceCounters::ScopedTimer timer(&counters.numericTime);
+    bayesTree = junctionTree.eliminate(params_.getEliminationFunction()).first;
+  }
+  counters.addCliques(*bayesTree);
   gttoc(eliminate);
 
   gttic(insert);
@@ -256,8 +293,10 @@ void ISAM2::recalculateIncremental(const ISAM2UpdateParams& updateParams,
   affectedAndNewKeys.insert(affectedAndNewKeys.end(),
                             result->observedKeys.begin(),
                             result->observedKeys.end());
+  PerformanceCounters& counters = result->counters;
   GaussianFactorGraph factors =
-      relinearizeAffectedFactors(updateParams, affectedAndNewKeys, relinKeys);
+      relinearizeAffectedFactors(updateParams, affectedAndNewKeys, relinKeys,
+                                 result->newFactorsIndices, counters);
 
   if (debug) {
     factors.print("Relinearized factors: ");
@@ -298,6 +337,8 @@ void ISAM2::recalculateIncremental(const ISAM2UpdateParams& updateParams,
   // [alg:BayesTree])
 
   gttic(reorder_and_eliminate);
+  boost::optional<PerformanceCounters::ScopedTimer> symbolicTimer;
+  symbolicTimer.emplace(&counters.symbolicTime);
 
   gttic(list_to_set);
   // create a partial reordering for the new and contaminated factors
@@ -342,9 +383,14 @@ void ISAM2::recalculateIncremental(const ISAM2UpdateParams& updateParams,
 
   // Do elimination
   GaussianEliminationTree etree(factors, affectedFactorsVarIndex, ordering);
-  auto bayesTree = ISAM2JunctionTree(etree)
-                       .eliminate(params_.getEliminationFunction())
-                       .first;
+  const ISAM2JunctionTree junctionTree(etree);
+  symbolicTimer.reset();
+  ISAM2BayesTree::shared_ptr bayesTree;
+  {
+    PerformanceCounters::ScopedTimer timer(&counters.numericTime);
+    bayesTree = junctionTree.eliminate(params_.getEliminationFunction()).first;
+  }
+  counters.addCliques(*bayesTree);
   gttoc(reorder_and_eliminate);
 
   gttic(reassemble);
@@ -362,6 +408,8 @@ void ISAM2::addVariables(const Values& newTheta,
   gttic(addNewVariables);
 
   theta_.insert(newTheta);
+  if (checkpointWriter_)
+    for (const auto key_value : newTheta) checkpointKeys_.insert(key_value.key);
   if (ISDEBUG("ISAM2 AddVariables")) newTheta.print("The new variables are: ");
   // Add zeros into the VectorValues
   delta_.insert(newTheta.zeroVectors());
@@ -380,6 +428,7 @@ void ISAM2::addVariables(const Values& newTheta,
 void ISAM2::removeVariables(const KeySet& unusedKeys) {
   gttic(removeVariables);
 
+  recordCheckpointKeys(unusedKeys);
   variableIndex_.removeUnusedVariables(unusedKeys.begin(), unusedKeys.end());
   for (Key key : unusedKeys) {
     delta_.erase(key);
@@ -421,8 +470,11 @@ ISAM2Result ISAM2::update(const NonlinearFactorGraph& newFactors,
   UpdateImpl update(params_, updateParams);
 
   // Update delta if we need it to check relinearization later
-  if (update.relinarizationNeeded(update_count_))
+  if (update.relinarizationNeeded(update_count_)) {
+    PerformanceCounters::ScopedTimer timer(
+        &result.counters.backSubstitutionTime);
     updateDelta(updateParams.forceFullSolve);
+  }
 
   // 1. Add any new factors \Factors:=\Factors\cup\Factors'.
   update.pushBackFactors(newFactors, &nonlinearFactors_, &linearFactors_,
@@ -434,8 +486,10 @@ ISAM2Result ISAM2::update(const NonlinearFactorGraph& newFactors,
   // 2. Initialize any new variables \Theta_{new} and add
   // \Theta:=\Theta\cup\Theta_{new}.
   addVariables(newTheta, result.details());
-  if (params_.evaluateNonlinearError)
+  if (params_.evaluateNonlinearError) {
+    PerformanceCounters::ScopedTimer timer(&result.counters.errorTime);
     update.error(nonlinearFactors_, calculateEstimate(), &result.errorBefore);
+  }
 
   // 3. Mark linear update
   update.gatherInvolvedKeys(newFactors, nonlinearFactors_,
@@ -458,10 +512,18 @@ ISAM2Result ISAM2::update(const NonlinearFactorGraph& newFactors,
     }
     result.variablesRelinearized = result.markedKeys.size();
   }
+  // The marked keys include the keys of new and removed factors
+  recordCheckpointKeys(result.markedKeys);
 
   // 7. Linearize new factors
-  update.linearizeNewFactors(newFactors, theta_, nonlinearFactors_.size(),
-                             result.newFactorsIndices, &linearFactors_);
+  {
+    PerformanceCounters::ScopedTimer timer(&result.counters.linearizeTime);
+    update.linearizeNewFactors(newFactors, theta_, nonlinearFactors_.size(),
+                               result.newFactorsIndices, &linearFactors_);
+  }
+  for (const FactorIndex index : result.newFactorsIndices)
+    if (linearFactors_[index])
+      result.counters.addLinearFactor(*linearFactors_[index]);
   update.augmentVariableIndex(newFactors, result.newFactorsIndices,
                               &variableIndex_);
 
@@ -469,9 +531,16 @@ ISAM2Result ISAM2::update(const NonlinearFactorGraph& newFactors,
   recalculate(updateParams, relinKeys, &result);
   if (!result.unusedKeys.empty()) removeVariables(result.unusedKeys);
   result.cliques = this->nodes().size();
+  if (params_.publishEstimate) {
+    PerformanceCounters::ScopedTimer timer(
+        &result.counters.backSubstitutionTime);
+    publishEstimate(relinKeys);
+  }
 
-  if (params_.evaluateNonlinearError)
+  if (params_.evaluateNonlinearError) {
+    PerformanceCounters::ScopedTimer timer(&result.counters.errorTime);
     update.error(nonlinearFactors_, calculateEstimate(), &result.errorAfter);
+  }
   return result;
 }
 
@@ -672,6 +741,7 @@ void ISAM2::marginalizeLeaves(
         for (Key factorKey : *factor) {
           fixedVariables_.insert(factorKey);
         }
+        recordCheckpointKeys(*factor);
       }
     }
   }
@@ -682,6 +752,7 @@ void ISAM2::marginalizeLeaves(
   NonlinearFactorGraph removedFactors;
   for (const auto index : factorIndicesToRemove) {
     removedFactors.push_back(nonlinearFactors_[index]);
+    recordCheckpointKeys(*nonlinearFactors_[index]);
     nonlinearFactors_.remove(index);
     if (params_.cacheLinearizedFactors) linearFactors_.remove(index);
   }
@@ -694,6 +765,148 @@ void ISAM2::marginalizeLeaves(
 
   // Remove the marginalized variables
   removeVariables(KeySet(leafKeys.begin(), leafKeys.end()));
+  if (params_.publishEstimate) publishEstimate(KeySet());
+}
+
+/* ************************************************************************* */
+FactorIndices ISAM2::attach(ISAM2&& session) {
+  gttic(ISAM2_attach);
+  for (const auto& keyValue : session.theta_) {
+    if (theta_.exists(keyValue.key))
+      throw invalid_argument(
+          "ISAM2::attach: variable " + DefaultKeyFormatter(keyValue.key) +
+          " is in both sessions");
+  }
+
+  // The trees of the session become trees of this forest, sharing the cliques
+  for (const sharedClique& root : session.roots_) insertRoot(root);
+
+  // Append the factors, keeping null slots so the indices stay consistent
+  FactorIndices indices(session.nonlinearFactors_.size());
+  for (size_t i = 0; i < indices.size(); ++i)
+    indices[i] = nonlinearFactors_.size() + i;
+  nonlinearFactors_.push_back(session.nonlinearFactors_);
+  if (params_.cacheLinearizedFactors) {
+    if (session.linearFactors_.size() == session.nonlinearFactors_.size()) {
+      linearFactors_.push_back(session.linearFactors_);
+    } else {
+      for (const auto& factor : session.nonlinearFactors_)
+        linearFactors_.push_back(factor ? factor->linearize(session.theta_)
+                                        : GaussianFactor::shared_ptr());
+    }
+  }
+  variableIndex_.augment(session.nonlinearFactors_, indices);
+
+  // Move the variables and the solution of the session
+  theta_.insert(session.theta_);
+  if (checkpointWriter_)
+    for (const auto key_value : session.theta_)
+      checkpointKeys_.insert(key_value.key);
+  delta_.insert(session.delta_);
+  deltaNewton_.insert(session.deltaNewton_);
+  RgProd_.insert(session.RgProd_);
+  deltaReplacedMask_.insert(session.deltaReplacedMask_.begin(),
+                            session.deltaReplacedMask_.end());
+  fixedVariables_.insert(session.fixedVariables_.begin(),
+                         session.fixedVariables_.end());
+
+  // Leave the session empty
+  const ISAM2Params sessionParams = session.params_;
+  session = ISAM2(sessionParams);
+
+  if (params_.publishEstimate) publishEstimate(KeySet());
+  return indices;
+}
+
+/* ************************************************************************* */
+FactorIndices ISAM2::detach(const KeySet& keys, ISAM2* session) {
+  gttic(ISAM2_detach);
+  if (!session->theta_.empty() || !session->nonlinearFactors_.empty())
+    throw invalid_argument("ISAM2::detach: the session has to be empty");
+
+  // Find the trees of the keys, and check they contain only those keys
+  set<sharedClique> detachedRoots;
+  for (Key key : keys) {
+    const auto node = nodes_.find(key);
+    if (node == nodes_.end())
+      throw invalid_argument("ISAM2::detach: variable " +
+                             DefaultKeyFormatter(key) + " does not exist");
+    sharedClique root = node->second;
+    while (!root->isRoot()) root = root->parent();
+    detachedRoots.insert(root);
+  }
+  size_t nrDetachedKeys = 0;
+  for (const sharedClique& root : detachedRoots) {
+    Cliques cliques;
+    cliques.push_back(root);
+    for (auto clique = cliques.begin(); clique != cliques.end(); ++clique) {
+      for (Key key : (*clique)->conditional()->frontals()) {
+        if (!keys.exists(key))
+          throw invalid_argument(
+              "ISAM2::detach: variable " + DefaultKeyFormatter(key) +
+              " is in the same tree as the detached variables");
+        ++nrDetachedKeys;
+      }
+      cliques.insert(cliques.end(), (*clique)->children.begin(),
+                     (*clique)->children.end());
+    }
+  }
+  assert(nrDetachedKeys == keys.size());
+  (void)nrDetachedKeys;
+
+  // Find the factors of the keys, and check they involve only those keys
+  set<FactorIndex> detachedFactors;
+  for (Key key : keys) {
+    for (FactorIndex i : variableIndex_[key]) {
+      if (!detachedFactors.insert(i).second) continue;
+      for (Key factorKey : *nonlinearFactors_[i]) {
+        if (!keys.exists(factorKey))
+          throw invalid_argument(
+              "ISAM2::detach: factor " + to_string(i) + " involves variable " +
+              DefaultKeyFormatter(factorKey) +
+              ", which is not detached");
+      }
+    }
+  }
+
+  // Move the trees, sharing the cliques
+  for (const sharedClique& root : detachedRoots) {
+    roots_.erase(std::find(roots_.begin(), roots_.end(), root));
+    session->insertRoot(root);
+  }
+
+  // Move the factors, renumbering them in their order
+  const FactorIndices indices(detachedFactors.begin(), detachedFactors.end());
+  NonlinearFactorGraph removedFactors;
+  removedFactors.reserve(indices.size());
+  for (FactorIndex i : indices) {
+    removedFactors.push_back(nonlinearFactors_[i]);
+    if (session->params_.cacheLinearizedFactors)
+      session->linearFactors_.push_back(
+          params_.cacheLinearizedFactors
+              ? linearFactors_[i]
+              : nonlinearFactors_[i]->linearize(theta_));
+    nonlinearFactors_.remove(i);
+    if (params_.cacheLinearizedFactors) linearFactors_.remove(i);
+  }
+  variableIndex_.remove(indices.begin(), indices.end(), removedFactors);
+  session->nonlinearFactors_ = removedFactors;
+  session->variableIndex_.augment(removedFactors);
+
+  // Move the variables and the solution
+  for (Key key : keys) {
+    session->theta_.insert(key, theta_.at(key));
+    session->delta_.insert(key, delta_.at(key));
+    session->deltaNewton_.insert(key, deltaNewton_.at(key));
+    session->RgProd_.insert(key, RgProd_.at(key));
+    if (deltaReplacedMask_.exists(key)) session->deltaReplacedMask_.insert(key);
+    if (fixedVariables_.exists(key)) session->fixedVariables_.insert(key);
+  }
+  removeVariables(keys);
+
+  if (params_.publishEstimate) publishEstimate(KeySet());
+  if (session->params_.publishEstimate) session->publishEstimate(KeySet());
+  return indices;
 }
 
 /* ************************************************************************* */
@@ -707,8 +920,9 @@ void ISAM2::updateDelta(bool forceFullSolve) const {
     const double effectiveWildfireThreshold =
         forceFullSolve ? 0.0 : gaussNewtonParams.wildfireThreshold;
     gttic(Wildfire_update);
-    DeltaImpl::UpdateGaussNewtonDelta(roots_, deltaReplacedMask_,
-                                      effectiveWildfireThreshold, &delta_);
+    DeltaImpl::UpdateGaussNewtonDelta(
+        roots_, deltaReplacedMask_, effectiveWildfireThreshold, &delta_,
+        checkpointWriter_ ? &checkpointKeys_ : nullptr);
     deltaReplacedMask_.clear();
     gttoc(Wildfire_update);
 
@@ -750,6 +964,7 @@ void ISAM2::updateDelta(bool forceFullSolve) const {
     gttic(Copy_dx_d);
     // Update Delta and linear step
     doglegDelta_ = doglegResult.delta;
+    recordCheckpointKeys(delta_ | br::map_keys);  // all deltas are replaced
     delta_ =
         doglegResult
             .dx_d;  // Copy the VectorValues containing with the linear solution
@@ -774,6 +989,14 @@ const Value& ISAM2::calculateEstimate(Key key) const {
   return *theta_.at(key).retract_(delta);
 }
 
+/* ************************************************************************* */
+void ISAM2::publishEstimate(const KeySet& changedTheta) {
+  gttic(publishEstimate);
+  std::atomic_store(&estimate_,
+                    ISAM2Estimate::Create(theta_, getDelta(), update_count_,
+                                          estimate_, changedTheta));
+}
+
 /* ************************************************************************* */
 Values ISAM2::calculateBestEstimate() const {
   updateDelta(true);  // Force full solve when updating delta_
@@ -22,6 +22,7 @@
 
 #include <gtsam/linear/GaussianBayesTree.h>
 #include <gtsam/nonlinear/ISAM2Clique.h>
+#include <gtsam/nonlinear/ISAM2Estimate.h>
 #include <gtsam/nonlinear/ISAM2Params.h>
 #include <gtsam/nonlinear/ISAM2Result.h>
 #include <gtsam/nonlinear/ISAM2UpdateParams.h>
@@ -96,6 +97,20 @@ class GTSAM_EXPORT ISAM2 : public BayesTree<ISAM2Clique> {
   int update_count_;  ///< Counter incremented every update(), used to determine
                       ///< periodic relinearization
 
+  /** The estimate published after the last update, only accessed atomically
+   * by readers, see ISAM2Params::publishEstimate */
+  ISAM2Estimate::shared_ptr estimate_;
+
+  /** Variables whose linearization point, deltas, bookkeeping or factor
+   * lists changed since the last checkpoint, recorded only while an
+   * ISAM2CheckpointWriter tracks this instance */
+  mutable KeySet checkpointKeys_;
+  mutable size_t checkpointWriter_ = 0;  ///< Id of the tracking writer, or 0
+
+  // Checkpoints read and write the complete state
+  friend class ISAM2CheckpointReader;
+  friend class ISAM2CheckpointWriter;
+
  public:
   using This = ISAM2;                       ///< This class
   using Base = BayesTree<ISAM2Clique>;      ///< The BayesTree base class
@@ -201,6 +216,33 @@ class GTSAM_EXPORT ISAM2 : public BayesTree<ISAM2Clique> {
       boost::optional<FactorIndices&> marginalFactorsIndices = boost::none,
       boost::optional<FactorIndices&> deletedFactorsIndices = boost::none);
 
+  /**
+   * Attach an independent session, an ISAM2 instance without variables in
+   * common with this one, for example the map of another robot.  The Bayes
+   * tree of the session becomes another tree of the Bayes forest of this
+   * instance, and its cliques, variables and factors are moved instead of being
+   * eliminated again.  A factor between the sessions added with update() later
+   * only re-eliminates the paths from its variables to the roots.  The session
+   * is left empty, and the parameters of this instance apply.
+   * @return the new indices of the factors of the session, in order
+   * @throw std::invalid_argument if the session has a variable of this instance
+   */
+  FactorIndices attach(ISAM2&& session);
+
+  /**
+   * Detach the variables in keys, with their factors and their part of the
+   * Bayes tree, into session, which has to be empty.  The keys have to make up
+   * whole trees of the Bayes forest; factors between the detached and the
+   * remaining variables have to be removed with update() first, which splits
+   * the trees again.  Only the detached trees are visited.
+   * @return the indices in this instance of the factors of the session, in the
+   * order of their new indices
+   * @throw std::invalid_argument if the keys do not make up whole trees, if a
+   * factor involves detached and remaining variables, or if session is not
+   * empty
+   */
+  FactorIndices detach(const KeySet& keys, ISAM2* session);
+
   /// Access the current linearization point
   const Values& getLinearizationPoint() const { return theta_; }
 
@@ -236,6 +278,16 @@ class GTSAM_EXPORT ISAM2 : public BayesTree<ISAM2Clique> {
    */
   const Value& calculateEstimate(Key key) const;
 
+  /**
+   * The snapshot of the estimate published after the last update when
+   * ISAM2Params::publishEstimate is set, or null.  Unlike the other methods,
+   * this can be called from other threads while ISAM2 is updated, and the
+   * snapshot stays valid and unchanged while it is held.
+   */
+  ISAM2Estimate::shared_ptr estimate() const {
+    return std::atomic_load(&estimate_);
+  }
+
   /** Return marginal on any variable as a covariance matrix */
   Matrix marginalCovariance(Key key) const;
 
@@ -293,7 +345,8 @@ class GTSAM_EXPORT ISAM2 : public BayesTree<ISAM2Clique> {
   // (note that the remaining stuff is summarized in the cached factors)
   GaussianFactorGraph relinearizeAffectedFactors(
       const ISAM2UpdateParams& updateParams, const FastList<Key>& affectedKeys,
-      const KeySet& relinKeys);
+      const KeySet& relinKeys, const FactorIndices& newFactorsIndices,
+      PerformanceCounters& counters);
 
   void recalculateIncremental(const ISAM2UpdateParams& updateParams,
                               const KeySet& relinKeys,
@@ -314,6 +367,18 @@ class GTSAM_EXPORT ISAM2 : public BayesTree<ISAM2Clique> {
    */
   void removeVariables(const KeySet& unusedKeys);
 
+  /**
+   * Publish a new estimate snapshot, sharing the variables not in
+   * changedTheta whose delta did not change with the last one.
+   */
+  void publishEstimate(const KeySet& changedTheta);
+
+  /// Record variables whose state changed, for the next checkpoint
+  template <class KEYS>
+  void recordCheckpointKeys(const KEYS& keys) const {
+    if (checkpointWriter_) checkpointKeys_.insert(keys.begin(), keys.end());
+  }
+
   void updateDelta(bool forceFullSolve = false) const;
 };  // ISAM2
 
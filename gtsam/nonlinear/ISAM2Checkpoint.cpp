@@ -0,0 +1,489 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    ISAM2Checkpoint.cpp
+ * @brief   Full and incremental checkpoints of the state of ISAM2
+ */
+
+#include <gtsam/nonlinear/ISAM2Checkpoint.h>
+#include <gtsam/linear/HessianFactor.h>
+#include <gtsam/linear/JacobianFactor.h>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <typeinfo>
+
+using namespace std;
+
+namespace gtsam {
+
+namespace {
+
+const unsigned int kCheckpointVersion = 2;
+const int64_t kNoParent = -1;
+
+enum LinearFactorKind : uint8_t { kNull, kJacobian, kHessian, kConditional };
+enum DiagonalKind : uint8_t { kNoModel, kUnit, kIsotropic, kDiagonal, kConstrained };
+
+/* ************************************************************************* */
+// Linear factors and conditionals are written as keys, block dimensions and
+// dense matrices, so they need no Boost export
+void saveModel(boost::archive::binary_oarchive& ar,
+               const SharedDiagonal& model) {
+  uint8_t kind = kNoModel;
+  if (!model) {
+    ar << kind;
+    return;
+  }
+  const size_t dim = model->dim();
+  Vector sigmas = model->sigmas();
+  if (auto constrained =
+          boost::dynamic_pointer_cast<noiseModel::Constrained>(model)) {
+    kind = kConstrained;
+    ar << kind << dim << sigmas;
+    ar << constrained->mu();
+  } else if (boost::dynamic_pointer_cast<noiseModel::Unit>(model)) {
+    kind = kUnit;
+    ar << kind << dim;
+  } else if (auto isotropic =
+                 boost::dynamic_pointer_cast<noiseModel::Isotropic>(model)) {
+    kind = kIsotropic;
+    const double sigma = isotropic->sigma();
+    ar << kind << dim << sigma;
+  } else {
+    kind = kDiagonal;
+    ar << kind << dim << sigmas;
+  }
+}
+
+SharedDiagonal loadModel(boost::archive::binary_iarchive& ar) {
+  uint8_t kind;
+  ar >> kind;
+  if (kind == kNoModel) return SharedDiagonal();
+  size_t dim;
+  ar >> dim;
+  switch (kind) {
+    case kUnit:
+      return noiseModel::Unit::Create(dim);
+    case kIsotropic: {
+      double sigma;
+      ar >> sigma;
+      return noiseModel::Isotropic::Sigma(dim, sigma);
+    }
+    case kDiagonal: {
+      Vector sigmas;
+      ar >> sigmas;
+      return noiseModel::Diagonal::Sigmas(sigmas, false);
+    }
+    case kConstrained: {
+      Vector sigmas, mu;
+      ar >> sigmas >> mu;
+      return noiseModel::Constrained::MixedSigmas(mu, sigmas);
+    }
+    default:
+      throw runtime_error("ISAM2CheckpointReader: unknown noise model");
+  }
+}
+
+void saveFactor(boost::archive::binary_oarchive& ar,
+                const GaussianFactor::shared_ptr& factor) {
+  uint8_t kind = kNull;
+  if (!factor) {
+    ar << kind;
+    return;
+  }
+
+  // Keys and block dimensions
+  const KeyVector keys(factor->begin(), factor->end());
+  vector<size_t> dims;
+  dims.reserve(keys.size());
+  for (auto it = factor->begin(); it != factor->end(); ++it)
+    dims.push_back(factor->getDim(it));
+
+  auto conditional = boost::dynamic_pointer_cast<GaussianConditional>(factor);
+  auto jacobian = boost::dynamic_pointer_cast<JacobianFactor>(factor);
+  auto hessian = boost::dynamic_pointer_cast<HessianFactor>(factor);
+  if (conditional || jacobian) {
+    kind = conditional ? kConditional : kJacobian;
+    // Only the active view of the matrix, which marginalizeLeaves narrows
+    const Matrix Ab = jacobian->matrixObject().full();
+    ar << kind << keys << dims << Ab;
+    if (conditional) {
+      const size_t nrFrontals = conditional->nrFrontals();
+      ar << nrFrontals;
+    }
+    saveModel(ar, jacobian->get_model());
+  } else if (hessian) {
+    kind = kHessian;
+    const Matrix info = hessian->augmentedInformation();
+    ar << kind << keys << dims << info;
+  } else {
+    throw invalid_argument(
+        "ISAM2CheckpointWriter: unsupported linear factor type " +
+        string(typeid(*factor).name()));
+  }
+}
+
+GaussianFactor::shared_ptr loadFactor(boost::archive::binary_iarchive& ar) {
+  uint8_t kind;
+  ar >> kind;
+  if (kind == kNull) return GaussianFactor::shared_ptr();
+  KeyVector keys;
+  vector<size_t> dims;
+  Matrix matrix;
+  ar >> keys >> dims >> matrix;
+  switch (kind) {
+    case kJacobian: {
+      const VerticalBlockMatrix Ab(dims, matrix, true);
+      return boost::make_shared<JacobianFactor>(keys, Ab, loadModel(ar));
+    }
+    case kConditional: {
+      size_t nrFrontals;
+      ar >> nrFrontals;
+      const VerticalBlockMatrix Ab(dims, matrix, true);
+      return boost::make_shared<GaussianConditional>(keys, nrFrontals, Ab,
+                                                     loadModel(ar));
+    }
+    case kHessian:
+      return boost::make_shared<HessianFactor>(
+          keys, SymmetricBlockMatrix(dims, matrix, true));
+    default:
+      throw runtime_error("ISAM2CheckpointReader: unknown linear factor");
+  }
+}
+
+}  // namespace
+
+/* ************************************************************************* */
+ISAM2CheckpointWriter::ISAM2CheckpointWriter()
+    : id_([] {
+        static atomic<size_t> nextId(1);
+        return nextId++;
+      }()) {}
+
+/* ************************************************************************* */
+void ISAM2CheckpointWriter::write(const ISAM2& isam, ostream& os, bool full) {
+  // The recorded variables are only complete if this writer wrote isam last
+  if (full || isam_ != &isam || isam.checkpointWriter_ != id_) {
+    sequence_ = 0;
+    nextCliqueId_ = 0;
+    cliques_.clear();
+    nonlinearFactors_.clear();
+    nonlinearFactorSizes_.clear();
+    linearFactors_.clear();
+    full = true;
+  } else {
+    ++sequence_;
+  }
+  isam_ = &isam;
+  isam.checkpointWriter_ = id_;
+
+  boost::archive::binary_oarchive ar(os);
+  ar << kCheckpointVersion << full << sequence_;
+
+  const bool hasDoglegDelta = isam.doglegDelta_.is_initialized();
+  const double doglegDelta = hasDoglegDelta ? *isam.doglegDelta_ : 0.0;
+  ar << isam.update_count_ << hasDoglegDelta << doglegDelta;
+
+  if (full) {
+    ar << isam.theta_ << isam.delta_ << isam.deltaNewton_ << isam.RgProd_
+       << isam.deltaReplacedMask_ << isam.fixedVariables_
+       << isam.variableIndex_;
+  } else {
+    // Only the variables recorded as changed, and those removed
+    KeyVector removedKeys, replacedKeys, fixedKeys, indexedKeys;
+    Values values;
+    VectorValues delta, deltaNewton, RgProd;
+    vector<FactorIndices> indexedFactors;
+    for (Key key : isam.checkpointKeys_) {
+      const auto value = isam.theta_.find(key);
+      if (value == isam.theta_.end()) {
+        removedKeys.push_back(key);
+        continue;
+      }
+      values.insert(key, value->value);
+      delta.insert(key, isam.delta_.at(key));
+      deltaNewton.insert(key, isam.deltaNewton_.at(key));
+      RgProd.insert(key, isam.RgProd_.at(key));
+      if (isam.deltaReplacedMask_.exists(key)) replacedKeys.push_back(key);
+      if (isam.fixedVariables_.exists(key)) fixedKeys.push_back(key);
+      const auto factors = isam.variableIndex_.find(key);
+      if (factors != isam.variableIndex_.end()) {
+        indexedKeys.push_back(key);
+        indexedFactors.emplace_back(factors->second.begin(),
+                                    factors->second.end());
+      }
+    }
+    const size_t nrIndexFactors = isam.variableIndex_.nFactors();
+    ar << removedKeys << values << delta << deltaNewton << RgProd
+       << replacedKeys << fixedKeys << indexedKeys << indexedFactors
+       << nrIndexFactors;
+  }
+  isam.checkpointKeys_.clear();
+
+  // Nonlinear factors, only the slots that changed.  Smart factors can gain
+  // keys in place, so the number of keys is compared as well.
+  const NonlinearFactorGraph& nonlinearFactors = isam.nonlinearFactors_;
+  vector<size_t> changedSlots;
+  nonlinearFactors_.resize(nonlinearFactors.size());
+  nonlinearFactorSizes_.resize(nonlinearFactors.size(), 0);
+  for (size_t i = 0; i < nonlinearFactors.size(); i++) {
+    const auto& factor = nonlinearFactors[i];
+    const size_t size = factor ? factor->size() : 0;
+    if (full || factor != nonlinearFactors_[i] || size != nonlinearFactorSizes_[i]) {
+      changedSlots.push_back(i);
+      nonlinearFactors_[i] = factor;
+      nonlinearFactorSizes_[i] = size;
+    }
+  }
+  const size_t nrNonlinearFactors = nonlinearFactors.size();
+  ar << nrNonlinearFactors << changedSlots;
+  for (size_t i : changedSlots) ar << nonlinearFactors_[i];
+
+  // Cached linear factors, only the slots that changed
+  const GaussianFactorGraph& linearFactors = isam.linearFactors_;
+  changedSlots.clear();
+  linearFactors_.resize(linearFactors.size());
+  for (size_t i = 0; i < linearFactors.size(); i++) {
+    if (full || linearFactors[i] != linearFactors_[i]) {
+      changedSlots.push_back(i);
+      linearFactors_[i] = linearFactors[i];
+    }
+  }
+  const size_t nrLinearFactors = linearFactors.size();
+  ar << nrLinearFactors << changedSlots;
+  for (size_t i : changedSlots) saveFactor(ar, linearFactors_[i]);
+
+  // Bayes tree in pre-order, without recursion.  Every clique refers to the
+  // position of its parent, and only new or changed cliques carry their
+  // content.  marginalizeLeaves narrows conditionals in place, so their size is
+  // compared as well.
+  vector<pair<ISAM2::sharedClique, int64_t> > stack;
+  for (auto root = isam.roots_.rbegin(); root != isam.roots_.rend(); ++root)
+    stack.emplace_back(*root, kNoParent);
+  const size_t nrCliques = isam.nodes_.size();  // upper bound, to reserve
+  ar << nrCliques;
+  unordered_map<const ISAM2Clique*, WrittenClique> cliques;
+  cliques.reserve(cliques_.size());
+  int64_t position = 0;
+  while (!stack.empty()) {
+    const ISAM2::sharedClique clique = stack.back().first;
+    const int64_t parent = stack.back().second;
+    stack.pop_back();
+    for (auto child = clique->children.rbegin();
+         child != clique->children.rend(); ++child)
+      stack.emplace_back(*child, position);
+    ++position;
+
+    const auto& conditional = clique->conditional();
+    WrittenClique written{0, clique, conditional, clique->cachedFactor_,
+                          conditional->size(), conditional->nrFrontals()};
+    auto last = cliques_.find(clique.get());
+    const bool changed = last == cliques_.end() ||
+                         last->second.conditional != written.conditional ||
+                         last->second.cachedFactor != written.cachedFactor ||
+                         last->second.nrKeys != written.nrKeys ||
+                         last->second.nrFrontals != written.nrFrontals;
+    written.id = last == cliques_.end() ? nextCliqueId_++ : last->second.id;
+
+    const bool more = true;
+    ar << more << written.id << parent << changed;
+    if (changed) {
+      saveFactor(ar, conditional);
+      saveFactor(ar, clique->cachedFactor_);
+      ar << clique->gradientContribution_ << clique->problemSize_;
+    }
+    cliques.emplace(clique.get(), written);
+  }
+  const bool more = false;
+  ar << more;
+  cliques_.swap(cliques);
+}
+
+/* ************************************************************************* */
+ISAM2CheckpointReader::ISAM2CheckpointReader(const ISAM2Params& params)
+    : isam_(params) {}
+
+/* ************************************************************************* */
+void ISAM2CheckpointReader::read(istream& is) {
+  boost::archive::binary_iarchive ar(is);
+  unsigned int version;
+  bool full;
+  size_t sequence;
+  ar >> version >> full >> sequence;
+  if (version != kCheckpointVersion)
+    throw runtime_error("ISAM2CheckpointReader: unsupported version");
+  if (!full && (!started_ || sequence != sequence_ + 1))
+    throw runtime_error(
+        "ISAM2CheckpointReader: incremental checkpoint out of order");
+  if (full) {
+    isam_ = ISAM2(isam_.params());
+    cliques_.clear();
+  }
+  started_ = true;
+  sequence_ = sequence;
+
+  bool hasDoglegDelta;
+  double doglegDelta;
+  ar >> isam_.update_count_ >> hasDoglegDelta >> doglegDelta;
+  isam_.doglegDelta_ = boost::none;
+  if (hasDoglegDelta) isam_.doglegDelta_ = doglegDelta;
+
+  if (full) {
+    ar >> isam_.theta_ >> isam_.delta_ >> isam_.deltaNewton_ >>
+        isam_.RgProd_ >> isam_.deltaReplacedMask_ >> isam_.fixedVariables_ >>
+        isam_.variableIndex_;
+  } else {
+    KeyVector removedKeys, replacedKeys, fixedKeys, indexedKeys;
+    Values values;
+    VectorValues delta, deltaNewton, RgProd;
+    vector<FactorIndices> indexedFactors;
+    size_t nrIndexFactors;
+    ar >> removedKeys >> values >> delta >> deltaNewton >> RgProd >>
+        replacedKeys >> fixedKeys >> indexedKeys >> indexedFactors >>
+        nrIndexFactors;
+    if (indexedFactors.size() != indexedKeys.size())
+      throw runtime_error("ISAM2CheckpointReader: invalid variable index");
+
+    // Variables removed since the last checkpoint, or added and removed in
+    // between, and variables that lost their entry in the variable index
+    VariableIndex& variableIndex = isam_.variableIndex_;
+    KeyVector unindexedKeys;
+    for (Key key : removedKeys) {
+      if (isam_.theta_.exists(key)) isam_.theta_.erase(key);
+      if (isam_.delta_.exists(key)) isam_.delta_.erase(key);
+      if (isam_.deltaNewton_.exists(key)) isam_.deltaNewton_.erase(key);
+      if (isam_.RgProd_.exists(key)) isam_.RgProd_.erase(key);
+      isam_.deltaReplacedMask_.erase(key);
+      isam_.fixedVariables_.erase(key);
+      unindexedKeys.push_back(key);
+    }
+    const KeySet indexed(indexedKeys.begin(), indexedKeys.end());
+    for (const auto key_value : values) {
+      const Key key = key_value.key;
+      if (isam_.theta_.exists(key))
+        isam_.theta_.update(key, key_value.value);
+      else
+        isam_.theta_.insert(key, key_value.value);
+      isam_.delta_.tryInsert(key, Vector()).first->second = delta.at(key);
+      isam_.deltaNewton_.tryInsert(key, Vector()).first->second =
+          deltaNewton.at(key);
+      isam_.RgProd_.tryInsert(key, Vector()).first->second = RgProd.at(key);
+      isam_.deltaReplacedMask_.erase(key);
+      isam_.fixedVariables_.erase(key);
+      if (!indexed.exists(key)) unindexedKeys.push_back(key);
+    }
+    isam_.deltaReplacedMask_.insert(replacedKeys.begin(), replacedKeys.end());
+    isam_.fixedVariables_.insert(fixedKeys.begin(), fixedKeys.end());
+
+    // Variable index entries, keeping nFactors as written even if the last
+    // factors were removed
+    for (Key key : unindexedKeys) {
+      if (variableIndex.find(key) == variableIndex.end()) continue;
+      variableIndex.replace(key, FactorIndices());
+      variableIndex.removeUnusedVariables(&key, &key + 1);
+    }
+    for (size_t i = 0; i < indexedKeys.size(); i++)
+      variableIndex.replace(indexedKeys[i], indexedFactors[i]);
+    if (nrIndexFactors > variableIndex.nFactors()) {
+      NonlinearFactorGraph nullFactor;
+      nullFactor.resize(1);
+      const FactorIndices lastIndex{nrIndexFactors - 1};
+      variableIndex.augment(nullFactor, lastIndex);
+    }
+  }
+
+  // Nonlinear factors
+  size_t nrFactors;
+  vector<size_t> changedSlots;
+  ar >> nrFactors >> changedSlots;
+  isam_.nonlinearFactors_.resize(nrFactors);
+  for (size_t i : changedSlots) {
+    if (i >= nrFactors)
+      throw runtime_error("ISAM2CheckpointReader: invalid factor slot");
+    ar >> isam_.nonlinearFactors_[i];
+  }
+
+  // Cached linear factors
+  ar >> nrFactors >> changedSlots;
+  isam_.linearFactors_.resize(nrFactors);
+  for (size_t i : changedSlots) {
+    if (i >= nrFactors)
+      throw runtime_error("ISAM2CheckpointReader: invalid factor slot");
+    isam_.linearFactors_[i] = loadFactor(ar);
+  }
+
+  // Bayes tree, always built from new cliques so no cached shortcuts survive
+  size_t nrCliques;
+  ar >> nrCliques;
+  vector<ISAM2::sharedClique> cliques;
+  cliques.reserve(nrCliques);
+  unordered_map<size_t, ReadClique> contents;
+  contents.reserve(cliques_.size());
+  isam_.roots_.clear();
+  isam_.nodes_.clear();
+  bool more;
+  ar >> more;
+  while (more) {
+    size_t id;
+    int64_t parent;
+    bool changed;
+    ar >> id >> parent >> changed;
+    ReadClique content;
+    if (changed) {
+      content.conditional =
+          boost::dynamic_pointer_cast<GaussianConditional>(loadFactor(ar));
+      content.cachedFactor = loadFactor(ar);
+      ar >> content.gradientContribution >> content.problemSize;
+      if (!content.conditional)
+        throw runtime_error("ISAM2CheckpointReader: clique without conditional");
+    } else {
+      auto last = cliques_.find(id);
+      if (last == cliques_.end())
+        throw runtime_error("ISAM2CheckpointReader: unknown clique");
+      content = last->second;
+    }
+
+    auto clique = boost::make_shared<ISAM2Clique>();
+    clique->conditional_ = content.conditional;
+    clique->cachedFactor_ = content.cachedFactor;
+    clique->gradientContribution_ = content.gradientContribution;
+    clique->problemSize_ = content.problemSize;
+    if (parent == kNoParent) {
+      isam_.roots_.push_back(clique);
+    } else {
+      if (parent < 0 || size_t(parent) >= cliques.size())
+        throw runtime_error("ISAM2CheckpointReader: invalid clique parent");
+      clique->parent_ = cliques[parent];
+      cliques[parent]->children.push_back(clique);
+    }
+    for (Key frontal : clique->conditional_->frontals())
+      isam_.nodes_[frontal] = clique;
+    cliques.push_back(clique);
+    contents.emplace(id, content);
+    ar >> more;
+  }
+  cliques_.swap(contents);
+
+  // Nothing of a published estimate can be shared with the restored state
+  isam_.estimate_.reset();
+  if (isam_.params_.publishEstimate) isam_.publishEstimate(KeySet());
+}
+
+}  // namespace gtsam
@@ -0,0 +1,128 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    ISAM2Checkpoint.h
+ * @brief   Full and incremental checkpoints of the state of ISAM2
+ */
+
+#pragma once
+
+#include <gtsam/nonlinear/ISAM2.h>
+
+#include <iosfwd>
+#include <unordered_map>
+#include <vector>
+
+namespace gtsam {
+
+/**
+ * Writes checkpoints of the complete state of an ISAM2 instance: the
+ * linearization point, the deltas, the nonlinear and cached linear factors,
+ * the Bayes tree with the cached factor of every clique, the variable index and
+ * the relinearization bookkeeping.  Restoring a checkpoint with
+ * ISAM2CheckpointReader does not linearize or eliminate anything.
+ *
+ * The first checkpoint written by a writer is full.  Later ones are
+ * incremental: they only contain the factors and cliques that changed since
+ * the previous checkpoint written by the same writer, and the values, deltas,
+ * bookkeeping and variable index entries of the variables that ISAM2 recorded
+ * as changed, which makes frequent checkpoints of a large map cheap.  ISAM2
+ * records these variables only while a writer tracks it, and a checkpoint is
+ * full again if the instance was written by another writer in between.  The
+ * writer keeps the factors and cliques of the last checkpoint alive to find
+ * the changed ones, which still compares every factor slot and clique by
+ * pointer, and every clique still writes its position in the tree.
+ *
+ * Nonlinear factors and values are written with Boost serialization, so their
+ * types have to be exported with BOOST_CLASS_EXPORT and GTSAM_VALUE_EXPORT, as
+ * for serialization.h, after including the Boost binary archive headers.
+ * Linear factors and conditionals are written as dense matrices and need no
+ * registration; JacobianFactor, HessianFactor and their derived classes are
+ * supported.
+ */
+class GTSAM_EXPORT ISAM2CheckpointWriter {
+ public:
+  ISAM2CheckpointWriter();
+  ISAM2CheckpointWriter(const ISAM2CheckpointWriter&) = delete;
+  ISAM2CheckpointWriter& operator=(const ISAM2CheckpointWriter&) = delete;
+
+  /**
+   * Write a checkpoint of isam.  It is incremental on top of the previous
+   * checkpoint written by this writer, unless it is the first, the previous
+   * one was of another instance, or full is set.  Set full after assigning
+   * another instance to isam.
+   * @throw std::invalid_argument if a linear factor type is not supported
+   */
+  void write(const ISAM2& isam, std::ostream& os, bool full = false);
+
+  /// Number of checkpoints written since the last full one
+  size_t sequence() const { return sequence_; }
+
+ private:
+  /// A clique of the last checkpoint and what its content was written from
+  struct WrittenClique {
+    size_t id;
+    ISAM2::sharedClique clique;
+    GaussianConditional::shared_ptr conditional;
+    GaussianFactor::shared_ptr cachedFactor;
+    size_t nrKeys, nrFrontals;
+  };
+
+  const size_t id_;  ///< Unique, to recognize the instances this writer tracks
+  const ISAM2* isam_ = nullptr;  ///< The instance of the last checkpoint
+  size_t sequence_ = 0;
+  size_t nextCliqueId_ = 0;
+  std::unordered_map<const ISAM2Clique*, WrittenClique> cliques_;
+  std::vector<NonlinearFactor::shared_ptr> nonlinearFactors_;
+  std::vector<size_t> nonlinearFactorSizes_;
+  std::vector<GaussianFactor::shared_ptr> linearFactors_;
+};
+
+/**
+ * Restores ISAM2 from a full checkpoint written by ISAM2CheckpointWriter,
+ * followed by any of the incremental checkpoints written after it, in order.
+ * Incremental checkpoints have to be read before the restored instance is
+ * updated.
+ */
+class GTSAM_EXPORT ISAM2CheckpointReader {
+ public:
+  /// Restored instances use the given parameters, which are not checkpointed
+  explicit ISAM2CheckpointReader(const ISAM2Params& params = ISAM2Params());
+
+  /**
+   * Read a full checkpoint, or an incremental one following the last one read
+   * @throw std::runtime_error if an incremental checkpoint is out of order
+   */
+  void read(std::istream& is);
+
+  /// The restored instance
+  const ISAM2& isam() const { return isam_; }
+
+  /// The restored instance, to continue updating it
+  ISAM2& isam() { return isam_; }
+
+ private:
+  /// The content of a clique of the last checkpoint
+  struct ReadClique {
+    GaussianConditional::shared_ptr conditional;
+    GaussianFactor::shared_ptr cachedFactor;
+    Vector gradientContribution;
+    int problemSize;
+  };
+
+  ISAM2 isam_;
+  bool started_ = false;
+  size_t sequence_ = 0;
+  std::unordered_map<size_t, ReadClique> cliques_;
+};
+
+}  // namespace gtsam
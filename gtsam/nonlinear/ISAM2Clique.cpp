@@ -259,7 +259,7 @@ bool ISAM2Clique::optimizeWildfireNode(const KeySet& replaced, double threshold,
 
 size_t optimizeWildfireNonRecursive(const ISAM2Clique::shared_ptr& root,
                                     double threshold, const KeySet& keys,
-                                    VectorValues* delta) {
+                                    VectorValues* delta, KeySet* changedKeys) {
   KeySet changed;
   size_t count = 0;
 
@@ -280,6 +280,7 @@ size_t optimizeWildfireNonRecursive(const ISAM2Clique::shared_ptr& root,
     }
   }
 
+  if (changedKeys) changedKeys->insert(changed.begin(), changed.end());
   return count;
 }
 
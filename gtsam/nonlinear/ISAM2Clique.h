@@ -170,8 +170,10 @@ class GTSAM_EXPORT ISAM2Clique
 size_t optimizeWildfire(const ISAM2Clique::shared_ptr& root, double threshold,
                         const KeySet& replaced, VectorValues* delta);
 
+/// As optimizeWildfire, adding the variables whose delta changed to changedKeys
 size_t optimizeWildfireNonRecursive(const ISAM2Clique::shared_ptr& root,
                                     double threshold, const KeySet& replaced,
-                                    VectorValues* delta);
+                                    VectorValues* delta,
+                                    KeySet* changedKeys = nullptr);
 
 }  // namespace gtsam
@@ -0,0 +1,145 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    ISAM2Estimate.cpp
+ * @brief   Immutable snapshots of the ISAM2 estimate for concurrent readers
+ */
+
+#include <gtsam/nonlinear/ISAM2Estimate.h>
+#include <gtsam/base/timing.h>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace gtsam {
+
+/* ************************************************************************* */
+ISAM2Estimate::shared_ptr ISAM2Estimate::Create(const Values& theta,
+                                                const VectorValues& delta,
+                                                size_t version,
+                                                const shared_ptr& previous,
+                                                const KeySet& changedTheta) {
+  gttic(ISAM2Estimate_Create);
+  auto estimate = std::make_shared<ISAM2Estimate>();
+  estimate->version_ = version;
+  estimate->size_ = theta.size();
+
+  // Variables are collected in a chunk until it is full
+  Chunk pending;
+  auto flush = [&]() {
+    if (pending.empty()) return;
+    estimate->firstKeys_.push_back(pending.front().key);
+    estimate->chunks_.push_back(std::make_shared<const Chunk>(move(pending)));
+    pending = Chunk();
+  };
+  auto add = [&](Entry&& entry) {
+    pending.push_back(move(entry));
+    if (pending.size() == kChunkSize) flush();
+  };
+  auto retract = [&](const Values::ConstKeyValuePair& keyValue) {
+    const Vector& d = delta.at(keyValue.key);
+    std::shared_ptr<const Value> value(
+        keyValue.value.retract_(d), [](const Value* v) { v->deallocate_(); });
+    return Entry{keyValue.key, d, value};
+  };
+  auto unchanged = [&](const Entry& entry,
+                       const Values::ConstKeyValuePair& keyValue) {
+    const Vector& d = delta.at(keyValue.key);
+    return !changedTheta.exists(keyValue.key) &&
+           d.size() == entry.delta.size() && d == entry.delta;
+  };
+
+  // Merge the sorted variables of theta with the chunks of previous
+  Values::const_iterator it = theta.begin();
+  if (previous) {
+    for (const std::shared_ptr<const Chunk>& chunk : previous->chunks_) {
+      for (; it != theta.end() && it->key < chunk->front().key; ++it)
+        add(retract(*it));
+
+      // Share the chunk if theta continues with exactly its unchanged variables
+      Values::const_iterator next = it;
+      bool share = true;
+      for (const Entry& entry : *chunk) {
+        if (next == theta.end() || next->key != entry.key ||
+            !unchanged(entry, *next)) {
+          share = false;
+          break;
+        }
+        ++next;
+      }
+      if (share) {
+        if (!pending.empty() && pending.size() + chunk->size() <= kChunkSize) {
+          // Fill the pending chunk instead of fragmenting
+          for (const Entry& entry : *chunk) add(Entry(entry));
+        } else {
+          flush();
+          estimate->firstKeys_.push_back(chunk->front().key);
+          estimate->chunks_.push_back(chunk);
+        }
+        it = next;
+        continue;
+      }
+
+      // Otherwise copy the unchanged variables and retract the others
+      for (const Entry& entry : *chunk) {
+        for (; it != theta.end() && it->key < entry.key; ++it)
+          add(retract(*it));
+        if (it != theta.end() && it->key == entry.key) {
+          add(unchanged(entry, *it) ? Entry(entry) : retract(*it));
+          ++it;
+        }
+      }
+    }
+  }
+  for (; it != theta.end(); ++it) add(retract(*it));
+  flush();
+  return estimate;
+}
+
+/* ************************************************************************* */
+const Value& ISAM2Estimate::at(Key j) const {
+  const Entry* entry = find(j);
+  if (!entry) throw ValuesKeyDoesNotExist("at", j);
+  return *entry->value;
+}
+
+/* ************************************************************************* */
+KeyVector ISAM2Estimate::keys() const {
+  KeyVector result;
+  result.reserve(size_);
+  for (const std::shared_ptr<const Chunk>& chunk : chunks_)
+    for (const Entry& entry : *chunk) result.push_back(entry.key);
+  return result;
+}
+
+/* ************************************************************************* */
+Values ISAM2Estimate::values() const {
+  Values result;
+  for (const std::shared_ptr<const Chunk>& chunk : chunks_)
+    for (const Entry& entry : *chunk) result.insert(entry.key, *entry.value);
+  return result;
+}
+
+/* ************************************************************************* */
+const ISAM2Estimate::Entry* ISAM2Estimate::find(Key j) const {
+  auto first = upper_bound(firstKeys_.begin(), firstKeys_.end(), j);
+  if (first == firstKeys_.begin()) return nullptr;
+  const Chunk& chunk = *chunks_[first - firstKeys_.begin() - 1];
+  auto entry = lower_bound(
+      chunk.begin(), chunk.end(), j,
+      [](const Entry& entry, Key key) { return entry.key < key; });
+  if (entry == chunk.end() || entry->key != j) return nullptr;
+  return &*entry;
+}
+
+}  // namespace gtsam
@@ -0,0 +1,106 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    ISAM2Estimate.h
+ * @brief   Immutable snapshots of the ISAM2 estimate for concurrent readers
+ */
+
+#pragma once
+
+#include <gtsam/nonlinear/Values.h>
+#include <gtsam/linear/VectorValues.h>
+
+#include <memory>
+#include <typeinfo>
+#include <vector>
+
+namespace gtsam {
+
+/**
+ * An immutable snapshot of the estimate theta.retract(delta) of ISAM2, as
+ * published after every update when ISAM2Params::publishEstimate is set.
+ *
+ * Snapshots are reference counted and never change once created, so any
+ * number of threads can read a snapshot without locking while ISAM2 is
+ * updated.  Consecutive snapshots share structure: variables are stored in
+ * sorted chunks, and a chunk in which no linearization point or delta changed
+ * is shared with the previous snapshot instead of being retracted again.
+ */
+class GTSAM_EXPORT ISAM2Estimate {
+ public:
+  typedef std::shared_ptr<const ISAM2Estimate> shared_ptr;
+
+  /**
+   * Create the snapshot of theta.retract(delta), sharing the variables of
+   * previous (which may be null) whose delta did not change and that are not
+   * in changedTheta, the variables whose linearization point was changed
+   * since previous was created.
+   */
+  static shared_ptr Create(const Values& theta, const VectorValues& delta,
+                           size_t version, const shared_ptr& previous = nullptr,
+                           const KeySet& changedTheta = KeySet());
+
+  /// The version it was created with, the update count of ISAM2
+  size_t version() const { return version_; }
+
+  /// Number of variables
+  size_t size() const { return size_; }
+
+  /// Whether a variable exists
+  bool exists(Key j) const { return find(j) != nullptr; }
+
+  /**
+   * The estimate of a variable
+   * @throw ValuesKeyDoesNotExist if it does not exist
+   */
+  const Value& at(Key j) const;
+
+  /**
+   * The estimate of a variable of a given type, without copying it
+   * @throw ValuesKeyDoesNotExist if it does not exist
+   * @throw ValuesIncorrectType if it has a different type
+   */
+  template <typename ValueType>
+  const ValueType& at(Key j) const {
+    const Value& value = at(j);
+    const GenericValue<ValueType>* generic =
+        dynamic_cast<const GenericValue<ValueType>*>(&value);
+    if (!generic) throw ValuesIncorrectType(j, typeid(value), typeid(ValueType));
+    return generic->value();
+  }
+
+  /// All keys, in increasing order
+  KeyVector keys() const;
+
+  /// Copy the estimate into Values
+  Values values() const;
+
+ private:
+  struct Entry {
+    Key key;
+    Vector delta;  ///< The delta the value was retracted with
+    std::shared_ptr<const Value> value;
+  };
+  typedef std::vector<Entry> Chunk;
+
+  /// Maximum number of variables in a chunk
+  static const size_t kChunkSize = 64;
+
+  size_t version_ = 0;
+  size_t size_ = 0;
+  std::vector<std::shared_ptr<const Chunk> > chunks_;
+  std::vector<Key> firstKeys_;  ///< The first key of every chunk
+
+  const Entry* find(Key j) const;
+};
+
+}  // namespace gtsam
@@ -223,6 +223,11 @@ struct GTSAM_EXPORT ISAM2Params {
   /// cost of having to search for slots every time a factor is added.
   bool findUnusedFactorSlots;
 
+  /// Publish an immutable snapshot of the estimate after every update, which
+  /// other threads can read with ISAM2::estimate() while ISAM2 is updated.
+  /// This back-substitutes for delta after every update (default: false).
+  bool publishEstimate;
+
   /**
    * Specify parameters as constructor arguments
    * See the documentation of member variables above.
@@ -246,7 +251,8 @@ struct GTSAM_EXPORT ISAM2Params {
         keyFormatter(_keyFormatter),
         enableDetailedResults(_enableDetailedResults),
         enablePartialRelinearizationCheck(false),
-        findUnusedFactorSlots(false) {}
+        findUnusedFactorSlots(false),
+        publishEstimate(false) {}
 
   /// print iSAM2 parameters
   void print(const std::string& str = "") const {
@@ -288,6 +294,7 @@ struct GTSAM_EXPORT ISAM2Params {
          << enablePartialRelinearizationCheck << "\n";
     cout << "findUnusedFactorSlots:             " << findUnusedFactorSlots
          << "\n";
+    cout << "publishEstimate:                   " << publishEstimate << "\n";
     cout.flush();
   }
 
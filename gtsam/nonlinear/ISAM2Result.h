@@ -26,6 +26,7 @@
 #include <gtsam/nonlinear/DoglegOptimizerImpl.h>
 #include <gtsam/nonlinear/ISAM2Params.h>
 #include <gtsam/nonlinear/NonlinearFactorGraph.h>
+#include <gtsam/nonlinear/PerformanceCounters.h>
 
 #include <boost/variant.hpp>
 
@@ -110,6 +111,13 @@ struct GTSAM_EXPORT ISAM2Result {
   /** All keys that were marked during the update process. */
   KeySet markedKeys;
 
+  /** Wall time per phase and other counters of the work done in this update,
+   * where cliques counts the reeliminated cliques.  Back-substitution is the
+   * delta update at the start of the update, and the error time is only
+   * nonzero if ISAM2Params::evaluateNonlinearError is set.
+   */
+  PerformanceCounters counters;
+
   /**
    * A struct holding detailed results, which must be enabled with
    * ISAM2Params::enableDetailedResults.
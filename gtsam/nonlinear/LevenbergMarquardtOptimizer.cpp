@@ -178,7 +178,10 @@ bool LevenbergMarquardtOptimizer::tryLambda(const GaussianFactorGraph& linear,
       gttic(compute_error);
       if (verbose)
         cout << "calculating error:" << endl;
-      newError = graph_.error(newValues);
+      {
+        PerformanceCounters::ScopedTimer timer(&counters_.errorTime);
+        newError = graph_.error(newValues);
+      }
       gttoc(compute_error);
 
       if (verbose)
@@ -260,11 +263,19 @@ GaussianFactorGraph::shared_ptr LevenbergMarquardtOptimizer::iterate() {
   auto currentState = static_cast<const State*>(state_.get());
 
   gttic(LM_iterate);
+  counters_ = PerformanceCounters();
 
   // Linearize graph
   if (params_.verbosityLM >= LevenbergMarquardtParams::DAMPED)
     cout << "linearizing = " << endl;
-  GaussianFactorGraph::shared_ptr linear = linearize();
+  GaussianFactorGraph::shared_ptr linear;
+  {
+    PerformanceCounters::ScopedTimer timer(&counters_.linearizeTime);
+    linear = linearize();
+  }
+  // Every factor is linearized again, except in the first iteration
+  if (iterations() > 0) counters_.factorsRelinearized = graph_.nrFactors();
+  counters_.addLinearFactors(*linear);
 
   if(currentState->totalNumberInnerIterations==0) { // write initial error
     writeLogFile(currentState->error);
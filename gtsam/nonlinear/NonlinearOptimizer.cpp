@@ -18,7 +18,10 @@
 
 #include <gtsam/nonlinear/NonlinearOptimizer.h>
 #include <gtsam/nonlinear/internal/NonlinearOptimizerState.h>
+#include <gtsam/linear/GaussianBayesNet.h>
+#include <gtsam/linear/GaussianBayesTree.h>
 #include <gtsam/linear/GaussianEliminationTree.h>
+#include <gtsam/linear/GaussianJunctionTree.h>
 #include <gtsam/linear/VectorValues.h>
 #include <gtsam/linear/SubgraphSolver.h>
 #include <gtsam/linear/PCGSolver.h>
@@ -26,8 +29,11 @@
 #include <gtsam/linear/VectorValues.h>
 
 #include <gtsam/inference/Ordering.h>
+#include <gtsam/inference/MetisIndex.h>
+#include <gtsam/inference/inferenceExceptions.h>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/optional.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include <stdexcept>
@@ -126,33 +132,71 @@ const Values& NonlinearOptimizer::optimizeSafely() {
 /* ************************************************************************* */
 VectorValues NonlinearOptimizer::solve(const GaussianFactorGraph& gfg,
                                        const NonlinearOptimizerParams& params) const {
-  // solution of linear solver is an update to the linearization point
-  VectorValues delta;
-  boost::optional<const Ordering&> optionalOrdering;
-  if (params.ordering)
-    optionalOrdering.reset(*params.ordering);
-
-  // Check which solver we are using
-  if (params.isMultifrontal()) {
-    // Multifrontal QR or Cholesky (decided by params.getEliminationFunction())
-    delta = gfg.optimize(optionalOrdering, params.getEliminationFunction());
-  } else if (params.isSequential()) {
-    // Sequential QR or Cholesky (decided by params.getEliminationFunction())
-    delta = gfg.eliminateSequential(optionalOrdering, params.getEliminationFunction(), boost::none,
-                                    params.orderingType)->optimize();
+  return solve(gfg, params, &counters_);
+}
+
+/* ************************************************************************* */
+VectorValues NonlinearOptimizer::solve(const GaussianFactorGraph& gfg,
+                                       const NonlinearOptimizerParams& params,
+                                       PerformanceCounters* counters) const {
+  typedef PerformanceCounters::ScopedTimer Timer;
+  if (params.isMultifrontal() || params.isSequential()) {
+    // Multifrontal or sequential QR or Cholesky (decided by
+    // params.getEliminationFunction()), eliminating step by step to time the
+    // phases
+    boost::optional<Timer> timer;
+    timer.emplace(counters ? &counters->symbolicTime : nullptr);
+    const VariableIndex variableIndex(gfg);
+    Ordering ordering;
+    if (params.ordering)
+      ordering = *params.ordering;
+    else if (params.isSequential() && params.orderingType == Ordering::METIS)
+      ordering = Ordering::Metis(MetisIndex(gfg, variableIndex));
+    else
+      ordering = Ordering::Colamd(variableIndex);
+    const GaussianEliminationTree etree(gfg, variableIndex, ordering);
+
+    if (params.isMultifrontal()) {
+      gttic(eliminateMultifrontal);
+      const GaussianJunctionTree junctionTree(etree);
+      timer.emplace(counters ? &counters->numericTime : nullptr);
+      const auto eliminated = junctionTree.eliminate(params.getEliminationFunction());
+      timer.reset();
+      gttoc(eliminateMultifrontal);
+      // If any factors are remaining, the ordering was incomplete
+      if (!eliminated.second->empty())
+        throw InconsistentEliminationRequested();
+      if (counters) counters->addCliques(*eliminated.first);
+      Timer backSubstitution(counters ? &counters->backSubstitutionTime : nullptr);
+      return eliminated.first->optimize();
+    } else {
+      gttic(eliminateSequential);
+      timer.emplace(counters ? &counters->numericTime : nullptr);
+      const auto eliminated = etree.eliminate(params.getEliminationFunction());
+      timer.reset();
+      gttoc(eliminateSequential);
+      if (!eliminated.second->empty())
+        throw InconsistentEliminationRequested();
+      if (counters)
+        for (const auto& conditional : *eliminated.first)
+          counters->addConditional(*conditional);
+      Timer backSubstitution(counters ? &counters->backSubstitutionTime : nullptr);
+      return eliminated.first->optimize();
+    }
   } else if (params.isIterative()) {
+    Timer timer(counters ? &counters->numericTime : nullptr);
     // Conjugate Gradient -> needs params.iterativeParams
     if (!params.iterativeParams)
       throw std::runtime_error("NonlinearOptimizer::solve: cg parameter has to be assigned ...");
 
     if (boost::shared_ptr<PCGSolverParameters> pcg =
             boost::dynamic_pointer_cast<PCGSolverParameters>(params.iterativeParams)) {
-      delta = PCGSolver(*pcg).optimize(gfg);
+      return PCGSolver(*pcg).optimize(gfg);
     } else if (boost::shared_ptr<SubgraphSolverParameters> spcg =
                    boost::dynamic_pointer_cast<SubgraphSolverParameters>(params.iterativeParams)) {
       if (!params.ordering)
         throw std::runtime_error("SubgraphSolver needs an ordering");
-      delta = SubgraphSolver(gfg, *spcg, *params.ordering).optimize();
+      return SubgraphSolver(gfg, *spcg, *params.ordering).optimize();
     } else {
       throw std::runtime_error(
           "NonlinearOptimizer::solve: special cg parameter type is not handled in LM solver ...");
@@ -160,9 +204,6 @@ VectorValues NonlinearOptimizer::solve(const GaussianFactorGraph& gfg,
   } else {
     throw std::runtime_error("NonlinearOptimizer::solve: Optimization parameter is invalid");
   }
-
-  // return update
-  return delta;
 }
 
 /* ************************************************************************* */
@@ -20,6 +20,7 @@
 
 #include <gtsam/nonlinear/NonlinearFactorGraph.h>
 #include <gtsam/nonlinear/NonlinearOptimizerParams.h>
+#include <gtsam/nonlinear/PerformanceCounters.h>
 
 namespace gtsam {
 
@@ -79,6 +80,9 @@ protected:
 
   std::unique_ptr<internal::NonlinearOptimizerState> state_; ///< PIMPL'd state
 
+  /// Counters of the current iteration, the default solve() adds to them
+  mutable PerformanceCounters counters_;
+
 public:
   /** A shared pointer to this class */
   typedef boost::shared_ptr<const NonlinearOptimizer> shared_ptr;
@@ -114,6 +118,13 @@ public:
   /// return values
   const Values& values() const;
 
+  /**
+   * Counters of the work done in the last iteration, adding up all lambda
+   * trials of Levenberg-Marquardt.  The linear solve phases are only counted
+   * by the default solve(), not by overrides in derived classes.
+   */
+  const PerformanceCounters& counters() const { return counters_; }
+
   /// @}
 
   /// @name Advanced interface
@@ -122,10 +133,19 @@ public:
   /** Virtual destructor */
   virtual ~NonlinearOptimizer();
 
-  /** Default function to do linear solve, i.e. optimize a GaussianFactorGraph */
+  /** Default function to do linear solve, i.e. optimize a GaussianFactorGraph,
+   * adding the phases to counters() */
   virtual VectorValues solve(const GaussianFactorGraph &gfg,
       const NonlinearOptimizerParams& params) const;
 
+  /**
+   * Linear solve that also adds the symbolic, numeric, and back-substitution
+   * times and the eliminated cliques to counters, if not null.  Iterative
+   * solvers are counted as numeric time only.
+   */
+  VectorValues solve(const GaussianFactorGraph &gfg,
+      const NonlinearOptimizerParams& params, PerformanceCounters* counters) const;
+
   /** 
    * Perform a single iteration, returning GaussianFactorGraph corresponding to 
    * the linearized factor graph.
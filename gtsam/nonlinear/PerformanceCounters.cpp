@@ -0,0 +1,92 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    PerformanceCounters.cpp
+ * @brief   Counters of the work done by an optimizer iteration or iSAM2 update
+ */
+
+#include <gtsam/nonlinear/PerformanceCounters.h>
+
+#include <gtsam/linear/GaussianConditional.h>
+#include <gtsam/linear/GaussianFactorGraph.h>
+#include <gtsam/linear/HessianFactor.h>
+#include <gtsam/linear/JacobianFactor.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace gtsam {
+
+/* ************************************************************************* */
+PerformanceCounters& PerformanceCounters::operator+=(
+    const PerformanceCounters& other) {
+  linearizeTime += other.linearizeTime;
+  symbolicTime += other.symbolicTime;
+  numericTime += other.numericTime;
+  backSubstitutionTime += other.backSubstitutionTime;
+  errorTime += other.errorTime;
+  factorsRelinearized += other.factorsRelinearized;
+  cliques += other.cliques;
+  maxCliqueSize = std::max(maxCliqueSize, other.maxCliqueSize);
+  flops += other.flops;
+  bytesAllocated += other.bytesAllocated;
+  return *this;
+}
+
+/* ************************************************************************* */
+void PerformanceCounters::addConditional(
+    const GaussianConditional& conditional) {
+  ++cliques;
+  maxCliqueSize = std::max(maxCliqueSize, conditional.size());
+  const size_t frontalDim = conditional.rows();
+  const size_t separatorDim = conditional.cols() - 1 - frontalDim;
+  flops += EliminationFlops(frontalDim, separatorDim);
+  bytesAllocated += conditional.rows() * conditional.cols() * sizeof(double);
+}
+
+/* ************************************************************************* */
+void PerformanceCounters::addLinearFactor(const GaussianFactor& factor) {
+  if (auto jacobian = dynamic_cast<const JacobianFactor*>(&factor))
+    bytesAllocated += jacobian->rows() * jacobian->cols() * sizeof(double);
+  else if (auto hessian = dynamic_cast<const HessianFactor*>(&factor))
+    bytesAllocated += hessian->rows() * hessian->rows() * sizeof(double);
+}
+
+/* ************************************************************************* */
+void PerformanceCounters::addLinearFactors(const GaussianFactorGraph& factors) {
+  for (const GaussianFactor::shared_ptr& factor : factors)
+    if (factor) addLinearFactor(*factor);
+}
+
+/* ************************************************************************* */
+double PerformanceCounters::EliminationFlops(size_t frontalDim,
+                                             size_t separatorDim) {
+  // Factor the frontal block, solve for the off-diagonal block, and update
+  // the separator block with the Schur complement
+  const double f = double(frontalDim), s = double(separatorDim);
+  return f * f * f / 3.0 + f * f * s + f * s * s;
+}
+
+/* ************************************************************************* */
+void PerformanceCounters::print(const std::string& s) const {
+  std::cout << s << "linearize: " << linearizeTime
+            << " s, symbolic: " << symbolicTime
+            << " s, numeric: " << numericTime
+            << " s, back-substitution: " << backSubstitutionTime
+            << " s, error: " << errorTime << " s\n"
+            << "  relinearized factors: " << factorsRelinearized
+            << ", cliques: " << cliques << ", max clique size: "
+            << maxCliqueSize << ", flops: " << flops
+            << ", bytes: " << bytesAllocated << std::endl;
+}
+
+}  // namespace gtsam
@@ -0,0 +1,128 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    PerformanceCounters.h
+ * @brief   Counters of the work done by an optimizer iteration or iSAM2 update
+ */
+
+#pragma once
+
+#include <gtsam/dllexport.h>
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace gtsam {
+
+class GaussianConditional;
+class GaussianFactor;
+class GaussianFactorGraph;
+
+/**
+ * Machine-readable counters of the work done in a single iteration of
+ * LevenbergMarquardtOptimizer or a single ISAM2::update().  Unlike the timing
+ * outline in timing.h, these are always collected, so they can be monitored in
+ * release builds.  Times are wall-clock seconds.
+ */
+struct GTSAM_EXPORT PerformanceCounters {
+  double linearizeTime;         ///< Linearizing nonlinear factors
+  double symbolicTime;          ///< Ordering and building elimination structures
+  double numericTime;           ///< Numerical elimination into conditionals
+  double backSubstitutionTime;  ///< Solving for the linear delta
+  double errorTime;             ///< Evaluating the nonlinear error
+
+  /** Existing factors that were linearized again, at a new or the same
+   * linearization point.  Factors linearized for the first time are not
+   * counted. */
+  size_t factorsRelinearized;
+
+  size_t cliques;        ///< Cliques that were eliminated
+  size_t maxCliqueSize;  ///< Variables in the largest eliminated clique
+
+  /** Estimate of the floating point operations of elimination, counting the
+   * dense partial Cholesky factorization of every eliminated clique. */
+  double flops;
+
+  /** Bytes of matrix storage allocated for linearized factors and
+   * conditionals. */
+  size_t bytesAllocated;
+
+  PerformanceCounters()
+      : linearizeTime(0.0),
+        symbolicTime(0.0),
+        numericTime(0.0),
+        backSubstitutionTime(0.0),
+        errorTime(0.0),
+        factorsRelinearized(0),
+        cliques(0),
+        maxCliqueSize(0),
+        flops(0.0),
+        bytesAllocated(0) {}
+
+  /// Total of the phase times
+  double totalTime() const {
+    return linearizeTime + symbolicTime + numericTime + backSubstitutionTime +
+           errorTime;
+  }
+
+  /// Add the counts of another iteration or update
+  PerformanceCounters& operator+=(const PerformanceCounters& other);
+
+  /// Count an eliminated clique, given its conditional
+  void addConditional(const GaussianConditional& conditional);
+
+  /// Count the cliques of a Bayes tree, or of the part eliminated last
+  template <class BAYESTREE>
+  void addCliques(const BAYESTREE& bayesTree) {
+    for (const auto& key_clique : bayesTree.nodes()) {
+      const auto& conditional = key_clique.second->conditional();
+      if (conditional && conditional->firstFrontalKey() == key_clique.first)
+        addConditional(*conditional);
+    }
+  }
+
+  /// Count the storage of a linearized factor
+  void addLinearFactor(const GaussianFactor& factor);
+
+  /// Count the storage of linearized factors
+  void addLinearFactors(const GaussianFactorGraph& factors);
+
+  /// Floating point operations of eliminating frontal from frontal +
+  /// separator scalar dimensions with a dense Cholesky factorization
+  static double EliminationFlops(size_t frontalDim, size_t separatorDim);
+
+  /// Print the counters
+  void print(const std::string& s = "") const;
+
+  /**
+   * Adds the wall-clock time from construction to destruction to a counter,
+   * or does nothing if constructed with a null pointer.
+   */
+  class ScopedTimer {
+   public:
+    explicit ScopedTimer(double* seconds)
+        : seconds_(seconds), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+      if (seconds_)
+        *seconds_ += std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start_)
+                         .count();
+    }
+
+   private:
+    double* seconds_;
+    std::chrono::steady_clock::time_point start_;
+  };
+};
+
+}  // namespace gtsam
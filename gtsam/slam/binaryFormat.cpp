@@ -0,0 +1,743 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file binaryFormat.cpp
+ * @brief Compact binary files for factor graphs and values
+ */
+
+#include <gtsam/slam/binaryFormat.h>
+#include <gtsam/sam/BearingRangeFactor.h>
+#include <gtsam/slam/BetweenFactor.h>
+#include <gtsam/slam/PriorFactor.h>
+#include <gtsam/geometry/Point2.h>
+#include <gtsam/geometry/Point3.h>
+#include <gtsam/geometry/Pose2.h>
+#include <gtsam/geometry/Pose3.h>
+#include <gtsam/geometry/Rot2.h>
+#include <gtsam/geometry/Rot3.h>
+#include <gtsam/base/GenericValue.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <typeinfo>
+
+using namespace std;
+
+namespace gtsam {
+
+/*
+ * Layout of a file, all integers and doubles in native byte order:
+ *
+ *   "GTSAMBIN", uint32 version, uint32 byte order mark
+ *   Values:  uint64 #groups, per group
+ *            name, uint64 dim, uint64 n, Key[n], double[n*dim]
+ *   Noise:   uint64 #models, per model
+ *            uint32 kind, uint64 dim, parameters depending on kind
+ *   Factors: uint64 graph size, uint64 #groups, per group
+ *            name, uint64 #keys, uint64 dim, uint64 n, uint64 position[n],
+ *            Key[n*#keys], uint32 noise model[n], double[n*dim]
+ *
+ * Names are a uint64 length followed by the characters.
+ */
+namespace {
+
+const char kMagic[8] = {'G', 'T', 'S', 'A', 'M', 'B', 'I', 'N'};
+const uint32_t kByteOrderMark = 0x01020304;
+const uint32_t kNoNoiseModel = 0xffffffff;
+
+enum NoiseModelKind {
+  kUnit, kIsotropic, kDiagonal, kConstrained, kGaussian, kRobust
+};
+
+enum MEstimatorKind {
+  kNull, kFair, kHuber, kCauchy, kTukey, kWelsh, kGemanMcClure, kDCS,
+  kL2WithDeadZone
+};
+
+/* ************************************************************************* */
+// Appends binary data to a buffer
+class Writer {
+ public:
+  template <class T>
+  void write(const T& x) {
+    append(&x, sizeof(T));
+  }
+
+  template <class T>
+  void write(const vector<T>& x) {
+    append(x.data(), x.size() * sizeof(T));
+  }
+
+  void write(const double* x, size_t n) { append(x, n * sizeof(double)); }
+
+  void write(const Writer& other) { buffer_ += other.buffer_; }
+
+  void writeName(const string& name) {
+    write(uint64_t(name.size()));
+    append(name.data(), name.size());
+  }
+
+  const string& buffer() const { return buffer_; }
+
+ private:
+  string buffer_;
+
+  void append(const void* data, size_t size) {
+    buffer_.append(static_cast<const char*>(data), size);
+  }
+};
+
+/* ************************************************************************* */
+// Reads binary data from a buffer, throws if the buffer is too short
+class Reader {
+ public:
+  Reader(const char* begin, const char* end) : p_(begin), end_(end) {}
+
+  template <class T>
+  T read() {
+    T x;
+    copy(&x, sizeof(T));
+    return x;
+  }
+
+  template <class T>
+  void read(vector<T>& x, size_t n) {
+    require(n, sizeof(T));
+    x.resize(n);
+    copy(x.data(), n * sizeof(T));
+  }
+
+  void read(double* x, size_t n) {
+    require(n, sizeof(double));
+    copy(x, n * sizeof(double));
+  }
+
+  string readName() {
+    const size_t size = read<uint64_t>();
+    require(size, 1);
+    string name(p_, size);
+    p_ += size;
+    return name;
+  }
+
+  /// Throw unless n items of the given size are left
+  void require(size_t n, size_t size) const {
+    if (size != 0 && n > size_t(end_ - p_) / size)
+      throw runtime_error("readBinary: file is truncated");
+  }
+
+ private:
+  const char* p_;
+  const char* end_;
+
+  void copy(void* x, size_t size) {
+    require(size, 1);
+    memcpy(x, p_, size);
+    p_ += size;
+  }
+};
+
+/* ************************************************************************* */
+// How a type is laid out as doubles
+template <class T>
+struct Columns;
+
+template <>
+struct Columns<Point2> {
+  static const size_t dim = 2;
+  static void write(const Point2& p, double* x) {
+    x[0] = p.x();
+    x[1] = p.y();
+  }
+  static Point2 read(const double* x) { return Point2(x[0], x[1]); }
+};
+
+template <>
+struct Columns<Point3> {
+  static const size_t dim = 3;
+  static void write(const Point3& p, double* x) {
+    x[0] = p.x();
+    x[1] = p.y();
+    x[2] = p.z();
+  }
+  static Point3 read(const double* x) { return Point3(x[0], x[1], x[2]); }
+};
+
+template <>
+struct Columns<Rot2> {
+  static const size_t dim = 2;
+  static void write(const Rot2& R, double* x) {
+    x[0] = R.c();
+    x[1] = R.s();
+  }
+  static Rot2 read(const double* x) { return Rot2::fromCosSin(x[0], x[1]); }
+};
+
+template <>
+struct Columns<Rot3> {
+  static const size_t dim = 9;
+  static void write(const Rot3& R, double* x) {
+    const Matrix3 M = R.matrix();
+    for (size_t i = 0; i < 3; i++)
+      for (size_t j = 0; j < 3; j++) x[3 * i + j] = M(i, j);
+  }
+  static Rot3 read(const double* x) {
+    return Rot3(x[0], x[1], x[2], x[3], x[4], x[5], x[6], x[7], x[8]);
+  }
+};
+
+template <>
+struct Columns<Pose2> {
+  static const size_t dim = 4;
+  static void write(const Pose2& pose, double* x) {
+    x[0] = pose.x();
+    x[1] = pose.y();
+    Columns<Rot2>::write(pose.r(), x + 2);
+  }
+  static Pose2 read(const double* x) {
+    return Pose2(Columns<Rot2>::read(x + 2), Point2(x[0], x[1]));
+  }
+};
+
+template <>
+struct Columns<Pose3> {
+  static const size_t dim = 12;
+  static void write(const Pose3& pose, double* x) {
+    Columns<Rot3>::write(pose.rotation(), x);
+    Columns<Point3>::write(pose.translation(), x + 9);
+  }
+  static Pose3 read(const double* x) {
+    return Pose3(Columns<Rot3>::read(x), Columns<Point3>::read(x + 9));
+  }
+};
+
+/* ************************************************************************* */
+// A type of value stored in the file
+class ValueType {
+ public:
+  virtual ~ValueType() {}
+  virtual string name() const = 0;
+  virtual size_t dim() const = 0;
+  virtual bool matches(const Value& value) const = 0;
+  virtual void write(const Value& value, double* x) const = 0;
+  virtual void insert(Key key, const double* x, Values* values) const = 0;
+};
+
+template <class T>
+class ValueTypeT : public ValueType {
+  string name_;
+
+ public:
+  explicit ValueTypeT(const string& name) : name_(name) {}
+  string name() const override { return name_; }
+  size_t dim() const override { return Columns<T>::dim; }
+  bool matches(const Value& value) const override {
+    return typeid(value) == typeid(GenericValue<T>);
+  }
+  void write(const Value& value, double* x) const override {
+    Columns<T>::write(static_cast<const GenericValue<T>&>(value).value(), x);
+  }
+  void insert(Key key, const double* x, Values* values) const override {
+    values->insert(key, Columns<T>::read(x));
+  }
+};
+
+/* ************************************************************************* */
+// A type of factor stored in the file
+class FactorType {
+ public:
+  virtual ~FactorType() {}
+  virtual string name() const = 0;
+  virtual size_t nrKeys() const = 0;
+  virtual size_t dim() const = 0;
+  virtual bool matches(const NonlinearFactor& factor) const = 0;
+  virtual void write(const NonlinearFactor& factor, double* x) const = 0;
+  virtual NonlinearFactor::shared_ptr read(const Key* keys, const double* x,
+      const SharedNoiseModel& model) const = 0;
+};
+
+template <class FACTOR, size_t N, size_t D>
+class FactorTypeBase : public FactorType {
+  string name_;
+
+ public:
+  explicit FactorTypeBase(const string& name) : name_(name) {}
+  string name() const override { return name_; }
+  size_t nrKeys() const override { return N; }
+  size_t dim() const override { return D; }
+  bool matches(const NonlinearFactor& factor) const override {
+    return typeid(factor) == typeid(FACTOR);
+  }
+};
+
+template <class T>
+class PriorFactorType
+    : public FactorTypeBase<PriorFactor<T>, 1, Columns<T>::dim> {
+ public:
+  using FactorTypeBase<PriorFactor<T>, 1, Columns<T>::dim>::FactorTypeBase;
+  void write(const NonlinearFactor& factor, double* x) const override {
+    Columns<T>::write(static_cast<const PriorFactor<T>&>(factor).prior(), x);
+  }
+  NonlinearFactor::shared_ptr read(const Key* keys, const double* x,
+      const SharedNoiseModel& model) const override {
+    return boost::make_shared<PriorFactor<T> >(keys[0], Columns<T>::read(x),
+                                               model);
+  }
+};
+
+template <class T>
+class BetweenFactorType
+    : public FactorTypeBase<BetweenFactor<T>, 2, Columns<T>::dim> {
+ public:
+  using FactorTypeBase<BetweenFactor<T>, 2, Columns<T>::dim>::FactorTypeBase;
+  void write(const NonlinearFactor& factor, double* x) const override {
+    Columns<T>::write(static_cast<const BetweenFactor<T>&>(factor).measured(),
+                      x);
+  }
+  NonlinearFactor::shared_ptr read(const Key* keys, const double* x,
+      const SharedNoiseModel& model) const override {
+    return boost::make_shared<BetweenFactor<T> >(keys[0], keys[1],
+                                                 Columns<T>::read(x), model);
+  }
+};
+
+typedef BearingRangeFactor<Pose2, Point2> BearingRangeFactor2D;
+
+class BearingRangeFactor2DType
+    : public FactorTypeBase<BearingRangeFactor2D, 2, 3> {
+ public:
+  using FactorTypeBase<BearingRangeFactor2D, 2, 3>::FactorTypeBase;
+  void write(const NonlinearFactor& factor, double* x) const override {
+    const auto& measured =
+        static_cast<const BearingRangeFactor2D&>(factor).measured();
+    Columns<Rot2>::write(measured.bearing(), x);
+    x[2] = measured.range();
+  }
+  NonlinearFactor::shared_ptr read(const Key* keys, const double* x,
+      const SharedNoiseModel& model) const override {
+    return boost::make_shared<BearingRangeFactor2D>(
+        keys[0], keys[1], Columns<Rot2>::read(x), x[2], model);
+  }
+};
+
+/* ************************************************************************* */
+// The supported types, in the order their groups are written
+struct Types {
+  vector<unique_ptr<ValueType> > values;
+  vector<unique_ptr<FactorType> > factors;
+
+  template <class T>
+  void add(const string& name) {
+    values.emplace_back(new ValueTypeT<T>(name));
+    factors.emplace_back(new PriorFactorType<T>("PriorFactor<" + name + ">"));
+    factors.emplace_back(
+        new BetweenFactorType<T>("BetweenFactor<" + name + ">"));
+  }
+
+  Types() {
+    add<Point2>("Point2");
+    add<Point3>("Point3");
+    add<Rot2>("Rot2");
+    add<Rot3>("Rot3");
+    add<Pose2>("Pose2");
+    add<Pose3>("Pose3");
+    factors.emplace_back(
+        new BearingRangeFactor2DType("BearingRangeFactor<Pose2,Point2>"));
+  }
+
+  static const Types& Instance() {
+    static const Types types;
+    return types;
+  }
+};
+
+/* ************************************************************************* */
+// Table of the distinct noise models of a graph, in the order written
+class NoiseModelTable {
+ public:
+  uint32_t index(const SharedNoiseModel& model) {
+    if (!model) return kNoNoiseModel;
+    auto it = indices_.find(model.get());
+    if (it != indices_.end()) return it->second;
+
+    // A robust model refers to its base model, which is written first
+    Writer w;
+    if (auto robust = boost::dynamic_pointer_cast<noiseModel::Robust>(model)) {
+      const uint32_t base = index(robust->noise());
+      w.write(uint32_t(kRobust));
+      w.write(uint64_t(model->dim()));
+      writeMEstimator(*robust->robust(), &w);
+      w.write(base);
+    } else if (auto unit =
+                   boost::dynamic_pointer_cast<noiseModel::Unit>(model)) {
+      w.write(uint32_t(kUnit));
+      w.write(uint64_t(model->dim()));
+    } else if (auto isotropic =
+                   boost::dynamic_pointer_cast<noiseModel::Isotropic>(model)) {
+      w.write(uint32_t(kIsotropic));
+      w.write(uint64_t(model->dim()));
+      w.write(isotropic->sigma());
+    } else if (auto constrained =
+                   boost::dynamic_pointer_cast<noiseModel::Constrained>(model)) {
+      w.write(uint32_t(kConstrained));
+      w.write(uint64_t(model->dim()));
+      w.write(constrained->mu().data(), model->dim());
+      w.write(constrained->sigmas().data(), model->dim());
+    } else if (auto diagonal =
+                   boost::dynamic_pointer_cast<noiseModel::Diagonal>(model)) {
+      w.write(uint32_t(kDiagonal));
+      w.write(uint64_t(model->dim()));
+      w.write(diagonal->sigmas().data(), model->dim());
+    } else if (auto gaussian =
+                   boost::dynamic_pointer_cast<noiseModel::Gaussian>(model)) {
+      w.write(uint32_t(kGaussian));
+      w.write(uint64_t(model->dim()));
+      const Matrix R = gaussian->R();  // column major
+      w.write(R.data(), R.size());
+    } else {
+      throw invalid_argument("writeBinary: unsupported noise model type");
+    }
+
+    const uint32_t i = uint32_t(indices_.size());
+    models_.write(w);
+    indices_.emplace(model.get(), i);
+    return i;
+  }
+
+  void write(Writer* writer) const {
+    writer->write(uint64_t(indices_.size()));
+    writer->write(models_);
+  }
+
+ private:
+  map<const noiseModel::Base*, uint32_t> indices_;
+  Writer models_;
+
+  static void writeMEstimator(const noiseModel::mEstimator::Base& robust,
+                              Writer* w) {
+    namespace mE = noiseModel::mEstimator;
+    uint32_t kind;
+    double parameter = 0.0;
+    if (dynamic_cast<const mE::Null*>(&robust)) {
+      kind = kNull;
+    } else if (auto fair = dynamic_cast<const mE::Fair*>(&robust)) {
+      kind = kFair, parameter = fair->modelParameter();
+    } else if (auto huber = dynamic_cast<const mE::Huber*>(&robust)) {
+      kind = kHuber, parameter = huber->modelParameter();
+    } else if (auto cauchy = dynamic_cast<const mE::Cauchy*>(&robust)) {
+      kind = kCauchy, parameter = cauchy->modelParameter();
+    } else if (auto tukey = dynamic_cast<const mE::Tukey*>(&robust)) {
+      kind = kTukey, parameter = tukey->modelParameter();
+    } else if (auto welsh = dynamic_cast<const mE::Welsh*>(&robust)) {
+      kind = kWelsh, parameter = welsh->modelParameter();
+    } else if (auto gm = dynamic_cast<const mE::GemanMcClure*>(&robust)) {
+      kind = kGemanMcClure, parameter = gm->modelParameter();
+    } else if (auto dcs = dynamic_cast<const mE::DCS*>(&robust)) {
+      kind = kDCS, parameter = dcs->modelParameter();
+    } else if (auto l2 = dynamic_cast<const mE::L2WithDeadZone*>(&robust)) {
+      kind = kL2WithDeadZone, parameter = l2->modelParameter();
+    } else {
+      throw invalid_argument("writeBinary: unsupported robust error function");
+    }
+    w->write(kind);
+    w->write(uint32_t(robust.reweightScheme()));
+    w->write(parameter);
+  }
+};
+
+/* ************************************************************************* */
+vector<SharedNoiseModel> readNoiseModels(Reader* reader) {
+  namespace mE = noiseModel::mEstimator;
+  const size_t nrModels = reader->read<uint64_t>();
+  vector<SharedNoiseModel> models;
+  for (size_t i = 0; i < nrModels; i++) {
+    const uint32_t kind = reader->read<uint32_t>();
+    const size_t dim = reader->read<uint64_t>();
+    if (kind != kUnit && kind != kRobust) reader->require(dim, sizeof(double));
+    switch (kind) {
+      case kUnit:
+        models.push_back(noiseModel::Unit::Create(dim));
+        break;
+      case kIsotropic:
+        // Not smart, so that an isotropic model with sigma 1 stays isotropic
+        models.push_back(
+            noiseModel::Isotropic::Sigma(dim, reader->read<double>(), false));
+        break;
+      case kDiagonal: {
+        Vector sigmas(dim);
+        reader->read(sigmas.data(), dim);
+        models.push_back(noiseModel::Diagonal::Sigmas(sigmas, false));
+        break;
+      }
+      case kConstrained: {
+        reader->require(2 * dim, sizeof(double));
+        Vector mu(dim), sigmas(dim);
+        reader->read(mu.data(), dim);
+        reader->read(sigmas.data(), dim);
+        models.push_back(noiseModel::Constrained::MixedSigmas(mu, sigmas));
+        break;
+      }
+      case kGaussian: {
+        reader->require(dim * dim, sizeof(double));
+        Matrix R(dim, dim);
+        reader->read(R.data(), R.size());
+        models.push_back(noiseModel::Gaussian::SqrtInformation(R, false));
+        break;
+      }
+      case kRobust: {
+        const uint32_t estimator = reader->read<uint32_t>();
+        const auto reweight =
+            mE::Base::ReweightScheme(reader->read<uint32_t>());
+        const double parameter = reader->read<double>();
+        const uint32_t base = reader->read<uint32_t>();
+        if (base >= models.size() || !models[base])
+          throw runtime_error("readBinary: invalid robust noise model");
+        mE::Base::shared_ptr robust;
+        switch (estimator) {
+          case kNull: robust = mE::Null::Create(); break;
+          case kFair: robust = mE::Fair::Create(parameter, reweight); break;
+          case kHuber: robust = mE::Huber::Create(parameter, reweight); break;
+          case kCauchy: robust = mE::Cauchy::Create(parameter, reweight); break;
+          case kTukey: robust = mE::Tukey::Create(parameter, reweight); break;
+          case kWelsh: robust = mE::Welsh::Create(parameter, reweight); break;
+          case kGemanMcClure:
+            robust = mE::GemanMcClure::Create(parameter, reweight);
+            break;
+          case kDCS: robust = mE::DCS::Create(parameter, reweight); break;
+          case kL2WithDeadZone:
+            robust = mE::L2WithDeadZone::Create(parameter, reweight);
+            break;
+          default:
+            throw runtime_error("readBinary: unknown robust error function");
+        }
+        models.push_back(noiseModel::Robust::Create(robust, models[base]));
+        break;
+      }
+      default:
+        throw runtime_error("readBinary: unknown noise model type");
+    }
+  }
+  return models;
+}
+
+/* ************************************************************************* */
+GraphAndValues readBinary(const char* begin, const char* end) {
+  Reader reader(begin, end);
+  const Types& types = Types::Instance();
+
+  char magic[sizeof(kMagic)];
+  for (char& c : magic) c = reader.read<char>();
+  if (memcmp(magic, kMagic, sizeof(kMagic)) != 0)
+    throw runtime_error("readBinary: not a GTSAM binary file");
+  const uint32_t version = reader.read<uint32_t>();
+  if (version > kBinaryFormatVersion)
+    throw runtime_error("readBinary: unsupported version " +
+                        to_string(version));
+  if (reader.read<uint32_t>() != kByteOrderMark)
+    throw runtime_error("readBinary: file was written with a different byte order");
+
+  // Values
+  Values::shared_ptr values(new Values);
+  vector<Key> keys;
+  vector<double> data;
+  const size_t nrValueGroups = reader.read<uint64_t>();
+  for (size_t g = 0; g < nrValueGroups; g++) {
+    const string name = reader.readName();
+    const size_t dim = reader.read<uint64_t>();
+    const size_t n = reader.read<uint64_t>();
+    const ValueType* type = nullptr;
+    for (const auto& t : types.values)
+      if (t->name() == name) type = t.get();
+    if (!type || type->dim() != dim)
+      throw runtime_error("readBinary: unknown value type " + name);
+    reader.read(keys, n);
+    reader.require(n, dim * sizeof(double));
+    reader.read(data, n * dim);
+    for (size_t i = 0; i < n; i++) type->insert(keys[i], &data[i * dim], values.get());
+  }
+
+  // Noise models
+  const vector<SharedNoiseModel> models = readNoiseModels(&reader);
+
+  // Factors, put back in their positions in the graph
+  NonlinearFactorGraph::shared_ptr graph(new NonlinearFactorGraph);
+  const size_t graphSize = reader.read<uint64_t>();
+  if (graphSize > size_t(end - begin))
+    throw runtime_error("readBinary: file is truncated");
+  graph->resize(graphSize);
+  vector<uint64_t> positions;
+  vector<uint32_t> noise;
+  const size_t nrFactorGroups = reader.read<uint64_t>();
+  for (size_t g = 0; g < nrFactorGroups; g++) {
+    const string name = reader.readName();
+    const size_t nrKeys = reader.read<uint64_t>();
+    const size_t dim = reader.read<uint64_t>();
+    const size_t n = reader.read<uint64_t>();
+    const FactorType* type = nullptr;
+    for (const auto& t : types.factors)
+      if (t->name() == name) type = t.get();
+    if (!type || type->nrKeys() != nrKeys || type->dim() != dim)
+      throw runtime_error("readBinary: unknown factor type " + name);
+    reader.read(positions, n);
+    reader.require(n, nrKeys * sizeof(Key));
+    reader.read(keys, n * nrKeys);
+    reader.read(noise, n);
+    reader.require(n, dim * sizeof(double));
+    reader.read(data, n * dim);
+    for (size_t i = 0; i < n; i++) {
+      if (positions[i] >= graphSize || graph->at(positions[i]))
+        throw runtime_error("readBinary: invalid factor position");
+      if (noise[i] != kNoNoiseModel && noise[i] >= models.size())
+        throw runtime_error("readBinary: invalid noise model index");
+      const SharedNoiseModel model =
+          noise[i] == kNoNoiseModel ? SharedNoiseModel() : models[noise[i]];
+      (*graph)[positions[i]] =
+          type->read(&keys[i * nrKeys], &data[i * dim], model);
+    }
+  }
+
+  return make_pair(graph, values);
+}
+
+}  // namespace
+
+/* ************************************************************************* */
+void writeBinary(const NonlinearFactorGraph& graph, const Values& values,
+                 ostream& os) {
+  const Types& types = Types::Instance();
+  Writer writer;
+  for (char c : kMagic) writer.write(c);
+  writer.write(uint32_t(kBinaryFormatVersion));
+  writer.write(kByteOrderMark);
+
+  // Values, grouped by type
+  struct ValueGroup {
+    vector<Key> keys;
+    vector<double> data;
+  };
+  vector<ValueGroup> valueGroups(types.values.size());
+  for (const auto& key_value : values) {
+    size_t t = 0;
+    while (t < types.values.size() && !types.values[t]->matches(key_value.value))
+      ++t;
+    if (t == types.values.size())
+      throw invalid_argument("writeBinary: unsupported value type for key " +
+                             DefaultKeyFormatter(key_value.key));
+    ValueGroup& group = valueGroups[t];
+    group.keys.push_back(key_value.key);
+    group.data.resize(group.data.size() + types.values[t]->dim());
+    types.values[t]->write(key_value.value,
+                           &group.data[group.data.size() - types.values[t]->dim()]);
+  }
+  size_t nrValueGroups = 0;
+  for (const ValueGroup& group : valueGroups)
+    if (!group.keys.empty()) ++nrValueGroups;
+  writer.write(uint64_t(nrValueGroups));
+  for (size_t t = 0; t < valueGroups.size(); t++) {
+    const ValueGroup& group = valueGroups[t];
+    if (group.keys.empty()) continue;
+    writer.writeName(types.values[t]->name());
+    writer.write(uint64_t(types.values[t]->dim()));
+    writer.write(uint64_t(group.keys.size()));
+    writer.write(group.keys);
+    writer.write(group.data);
+  }
+
+  // Factors, grouped by type, and the table of their noise models
+  struct FactorGroup {
+    vector<uint64_t> positions;
+    vector<Key> keys;
+    vector<uint32_t> noise;
+    vector<double> data;
+  };
+  vector<FactorGroup> factorGroups(types.factors.size());
+  NoiseModelTable noiseModels;
+  for (size_t i = 0; i < graph.size(); i++) {
+    if (!graph[i]) continue;
+    const NonlinearFactor& factor = *graph[i];
+    size_t t = 0;
+    while (t < types.factors.size() && !types.factors[t]->matches(factor)) ++t;
+    if (t == types.factors.size())
+      throw invalid_argument("writeBinary: unsupported factor type " +
+                             string(typeid(factor).name()));
+    const FactorType& type = *types.factors[t];
+    FactorGroup& group = factorGroups[t];
+    group.positions.push_back(i);
+    group.keys.insert(group.keys.end(), factor.begin(), factor.end());
+    group.noise.push_back(noiseModels.index(
+        static_cast<const NoiseModelFactor&>(factor).noiseModel()));
+    group.data.resize(group.data.size() + type.dim());
+    type.write(factor, &group.data[group.data.size() - type.dim()]);
+  }
+  noiseModels.write(&writer);
+
+  size_t nrFactorGroups = 0;
+  for (const FactorGroup& group : factorGroups)
+    if (!group.positions.empty()) ++nrFactorGroups;
+  writer.write(uint64_t(graph.size()));
+  writer.write(uint64_t(nrFactorGroups));
+  for (size_t t = 0; t < factorGroups.size(); t++) {
+    const FactorGroup& group = factorGroups[t];
+    if (group.positions.empty()) continue;
+    writer.writeName(types.factors[t]->name());
+    writer.write(uint64_t(types.factors[t]->nrKeys()));
+    writer.write(uint64_t(types.factors[t]->dim()));
+    writer.write(uint64_t(group.positions.size()));
+    writer.write(group.positions);
+    writer.write(group.keys);
+    writer.write(group.noise);
+    writer.write(group.data);
+  }
+
+  const string& buffer = writer.buffer();
+  os.write(buffer.data(), buffer.size());
+  if (!os)
+    throw runtime_error("writeBinary: could not write the data");
+}
+
+/* ************************************************************************* */
+void writeBinary(const NonlinearFactorGraph& graph, const Values& values,
+                 const string& filename) {
+  ofstream os(filename.c_str(), ios::out | ios::binary);
+  if (!os)
+    throw invalid_argument("writeBinary: can not open file " + filename);
+  writeBinary(graph, values, os);
+}
+
+/* ************************************************************************* */
+GraphAndValues readBinary(istream& is) {
+  const string buffer((istreambuf_iterator<char>(is)),
+                      istreambuf_iterator<char>());
+  return readBinary(buffer.data(), buffer.data() + buffer.size());
+}
+
+/* ************************************************************************* */
+GraphAndValues readBinary(const string& filename) {
+  ifstream is(filename.c_str(), ios::in | ios::binary);
+  if (!is)
+    throw invalid_argument("readBinary: can not find file " + filename);
+
+  // Read the whole file at once
+  string buffer;
+  is.seekg(0, ios::end);
+  buffer.resize(size_t(is.tellg()));
+  is.seekg(0, ios::beg);
+  if (!buffer.empty()) is.read(&buffer[0], buffer.size());
+  return readBinary(buffer.data(), buffer.data() + buffer.size());
+}
+
+}  // namespace gtsam
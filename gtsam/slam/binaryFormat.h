@@ -0,0 +1,63 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file binaryFormat.h
+ * @brief Compact binary files for factor graphs and values
+ */
+
+#pragma once
+
+#include <gtsam/slam/dataset.h>
+
+#include <iosfwd>
+#include <string>
+
+namespace gtsam {
+
+/**
+ * A versioned, columnar binary format for a NonlinearFactorGraph and its
+ * Values, which is much faster to write and load than serialization.h.
+ *
+ * Values and factors are grouped by type, and every group stores its keys and
+ * measurements in contiguous arrays, so a type is named once per group rather
+ * than once per object.  Noise models are stored once in a table shared by all
+ * factors, and the order of the factors in the graph is preserved.
+ *
+ * Supported are values of type Point2, Point3, Rot2, Rot3, Pose2 and Pose3,
+ * PriorFactor and BetweenFactor on these types, BearingRangeFactor<Pose2,
+ * Point2>, and Unit, Isotropic, Diagonal, Constrained, Gaussian and Robust
+ * noise models.  Writing other types throws std::invalid_argument; use
+ * serialization.h for those.
+ */
+
+/// Current version of the binary format
+static const unsigned int kBinaryFormatVersion = 1;
+
+/// Write a factor graph and values in the binary format to a stream
+GTSAM_EXPORT void writeBinary(const NonlinearFactorGraph& graph,
+                              const Values& values, std::ostream& os);
+
+/// Write a factor graph and values in the binary format to a file
+GTSAM_EXPORT void writeBinary(const NonlinearFactorGraph& graph,
+                              const Values& values, const std::string& filename);
+
+/**
+ * Read a factor graph and values in the binary format from a stream
+ * @throw std::runtime_error if the data is corrupt, truncated or of a newer
+ * version
+ */
+GTSAM_EXPORT GraphAndValues readBinary(std::istream& is);
+
+/// Read a factor graph and values in the binary format from a file
+GTSAM_EXPORT GraphAndValues readBinary(const std::string& filename);
+
+} // namespace gtsam
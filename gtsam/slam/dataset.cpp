@@ -33,14 +33,25 @@
 #include <gtsam/base/types.h>
 #include <gtsam/base/Value.h>
 #include <gtsam/base/Vector.h>
+#include <gtsam/config.h> // for GTSAM_USE_TBB
 
 #include <boost/assign/list_inserter.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 
+#ifdef GTSAM_USE_TBB
+#  include <tbb/parallel_for.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
 
 using namespace std;
@@ -100,6 +111,214 @@ string createRewrittenFileName(const string& name) {
   return newpath.string();
 }
 
+/* ************************************************************************* */
+// Dataset files are read into memory with a single read, split into lines, and
+// parsed with strtod, in parallel when GTSAM is built with TBB.  Only the steps
+// that depend on the order of the lines, such as inserting odometry-chained
+// initial values, are done serially.
+namespace {
+
+/// Read a whole file into a string, returns false if it cannot be opened
+bool readFile(const string& filename, string* contents) {
+  ifstream is(filename.c_str(), ios::in | ios::binary);
+  if (!is)
+    return false;
+  is.seekg(0, ios::end);
+  contents->resize(size_t(is.tellg()));
+  is.seekg(0, ios::beg);
+  if (!contents->empty())
+    is.read(&(*contents)[0], contents->size());
+  return bool(is);
+}
+
+/// A line of a file in memory, without the newline
+struct Line {
+  const char* begin;
+  const char* end;
+};
+
+/// Split a file in memory into lines
+vector<Line> splitLines(const string& contents) {
+  vector<Line> lines;
+  const char* p = contents.data();
+  const char* const end = p + contents.size();
+  while (p != end) {
+    const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+    const char* lineEnd = newline ? newline : end;
+    lines.push_back(Line{p, lineEnd});
+    p = newline ? newline + 1 : end;
+  }
+  return lines;
+}
+
+/// Whitespace-separated words and numbers of a single line
+class LineParser {
+ public:
+  explicit LineParser(const Line& line) : p_(line.begin), end_(line.end) {}
+
+  /// The next word, empty at the end of the line
+  string word() {
+    skipSpace();
+    const char* begin = p_;
+    while (p_ != end_ && !isspace(static_cast<unsigned char>(*p_))) ++p_;
+    return string(begin, p_);
+  }
+
+  /// Parse the next number, returns false if there is none
+  bool read(double& x) {
+    skipSpace();
+    if (p_ == end_) return false;
+    char* next;
+    x = strtod(p_, &next);
+    return advance(next);
+  }
+
+  /// Parse the next key, returns false if there is none
+  bool readKey(Key& key) {
+    skipSpace();
+    if (p_ == end_) return false;
+    char* next;
+    key = strtoull(p_, &next, 10);
+    return advance(next);
+  }
+
+  /// Parse the next n numbers
+  bool read(double* x, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      if (!read(x[i])) return false;
+    return true;
+  }
+
+ private:
+  const char* p_;
+  const char* end_;
+
+  void skipSpace() {
+    while (p_ != end_ && isspace(static_cast<unsigned char>(*p_))) ++p_;
+  }
+
+  bool advance(const char* next) {
+    if (next == p_ || next > end_) return false;
+    p_ = next;
+    return true;
+  }
+};
+
+/**
+ * Call f(begin, end) on ranges covering [0, n), in parallel when GTSAM is
+ * built with TBB.  If any call throws, the exception of the first range in
+ * order is rethrown, as it would be when running serially.
+ */
+template <class F>
+void parallelRanges(size_t n, const F& f) {
+#ifdef GTSAM_USE_TBB
+  std::mutex mutex;
+  size_t firstFailure = n;
+  std::exception_ptr exception;
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, n, 256),
+                    [&](const tbb::blocked_range<size_t>& range) {
+    try {
+      f(range.begin(), range.end());
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (range.begin() < firstFailure) {
+        firstFailure = range.begin();
+        exception = std::current_exception();
+      }
+    }
+  });
+  if (exception) std::rethrow_exception(exception);
+#else
+  f(0, n);
+#endif
+}
+
+/**
+ * Parse a file consisting only of whitespace-separated numbers.  The file is
+ * split into chunks at whitespace, the numbers in every chunk are counted and
+ * then parsed into their place, both in parallel.  Returns false if any token
+ * is not a number.
+ */
+bool parseNumbers(const string& contents, vector<double>* numbers) {
+  static const size_t kChunkSize = size_t(1) << 20;
+  const char* const data = contents.data();
+  const size_t size = contents.size();
+  const auto isSpace = [](char c) {
+    return isspace(static_cast<unsigned char>(c)) != 0;
+  };
+
+  vector<size_t> chunks(1, 0);
+  while (chunks.back() < size) {
+    size_t next = std::min(chunks.back() + kChunkSize, size);
+    while (next < size && !isSpace(data[next])) ++next;
+    chunks.push_back(next);
+  }
+  const size_t nrChunks = chunks.size() - 1;
+
+  // Count the numbers in every chunk
+  vector<size_t> offsets(nrChunks + 1, 0);
+  parallelRanges(nrChunks, [&](size_t begin, size_t end) {
+    for (size_t c = begin; c < end; ++c) {
+      size_t count = 0;
+      bool inToken = false;
+      for (size_t i = chunks[c]; i < chunks[c + 1]; ++i) {
+        const bool space = isSpace(data[i]);
+        if (!space && !inToken) ++count;
+        inToken = !space;
+      }
+      offsets[c + 1] = count;
+    }
+  });
+  for (size_t c = 0; c < nrChunks; ++c) offsets[c + 1] += offsets[c];
+
+  // Parse them
+  numbers->resize(offsets.back());
+  vector<char> valid(nrChunks, 1);
+  parallelRanges(nrChunks, [&](size_t begin, size_t end) {
+    for (size_t c = begin; c < end; ++c) {
+      const char* p = data + chunks[c];
+      const char* const chunkEnd = data + chunks[c + 1];
+      double* x = numbers->data() + offsets[c];
+      while (true) {
+        while (p != chunkEnd && isSpace(*p)) ++p;
+        if (p == chunkEnd) break;
+        char* next;
+        *x++ = strtod(p, &next);
+        if (next == p || (next != chunkEnd && !isSpace(*next))) {
+          valid[c] = 0;
+          break;
+        }
+        p = next;
+      }
+    }
+  });
+  return std::find(valid.begin(), valid.end(), 0) == valid.end();
+}
+
+/**
+ * Convert a number parsed from a file to a count or index, returns false
+ * unless it is a finite non-negative integer below bound.
+ */
+bool toIndex(double value, size_t bound, size_t* index) {
+  if (!(value >= 0.0) || !(value < double(bound)) || value != std::floor(value))
+    return false;
+  *index = size_t(value);
+  return true;
+}
+
+/// Tags of the 2D pose vertices, shared by parseVertex and load2D
+bool isVertexTag(const string& tag) {
+  return tag == "VERTEX2" || tag == "VERTEX_SE2" || tag == "VERTEX";
+}
+
+/// Tags of the 2D pose edges, shared by parseEdge and load2D
+bool isEdgeTag(const string& tag) {
+  return tag == "EDGE2" || tag == "EDGE" || tag == "EDGE_SE2" ||
+         tag == "ODOMETRY";
+}
+
+}  // namespace
+
 /* ************************************************************************* */
 GraphAndValues load2D(pair<string, SharedNoiseModel> dataset, int maxID,
     bool addNoise, bool smart, NoiseFormat noiseFormat,
@@ -109,11 +328,11 @@ GraphAndValues load2D(pair<string, SharedNoiseModel> dataset, int maxID,
 }
 
 /* ************************************************************************* */
-// Read noise parameters and interpret them according to flags
-static SharedNoiseModel readNoiseModel(ifstream& is, bool smart,
+// Interpret the six noise parameters of an edge according to flags
+static SharedNoiseModel readNoiseModel(const double* v, bool smart,
     NoiseFormat noiseFormat, KernelFunctionType kernelFunctionType) {
-  double v1, v2, v3, v4, v5, v6;
-  is >> v1 >> v2 >> v3 >> v4 >> v5 >> v6;
+  const double v1 = v[0], v2 = v[1], v3 = v[2], v4 = v[3], v5 = v[4],
+               v6 = v[5];
 
   if (noiseFormat == NoiseFormatAUTO) {
     // Try to guess covariance matrix layout
@@ -193,7 +412,7 @@ static SharedNoiseModel readNoiseModel(ifstream& is, bool smart,
 
 /* ************************************************************************* */
 boost::optional<IndexedPose> parseVertex(istream& is, const string& tag) {
-  if ((tag == "VERTEX2") || (tag == "VERTEX_SE2") || (tag == "VERTEX")) {
+  if (isVertexTag(tag)) {
     Key id;
     double x, y, yaw;
     is >> id >> x >> y >> yaw;
@@ -205,8 +424,7 @@ boost::optional<IndexedPose> parseVertex(istream& is, const string& tag) {
 
 /* ************************************************************************* */
 boost::optional<IndexedEdge> parseEdge(istream& is, const string& tag) {
-  if ((tag == "EDGE2") || (tag == "EDGE") || (tag == "EDGE_SE2")
-      || (tag == "ODOMETRY")) {
+  if (isEdgeTag(tag)) {
 
     Key id1, id2;
     double x, y, yaw;
@@ -217,40 +435,32 @@ boost::optional<IndexedEdge> parseEdge(istream& is, const string& tag) {
   }
 }
 
+/* ************************************************************************* */
+namespace {
+/// A line of a 2D dataset file, parsed independently of the others
+struct Line2D {
+  enum Type { OTHER, VERTEX, EDGE, BR, LANDMARK } type;
+  Key id1, id2;
+  double v[7]; ///< pose, bearing-range or landmark measurement
+  SharedNoiseModel model; ///< noise model of an edge
+  NonlinearFactor::shared_ptr factor; ///< edge factor, if it can be made in parallel
+  Line2D() : type(OTHER), id1(0), id2(0) {}
+};
+}  // namespace
+
 /* ************************************************************************* */
 GraphAndValues load2D(const string& filename, SharedNoiseModel model, Key maxID,
     bool addNoise, bool smart, NoiseFormat noiseFormat,
     KernelFunctionType kernelFunctionType) {
 
-  ifstream is(filename.c_str());
-  if (!is)
+  string contents;
+  if (!readFile(filename, &contents))
     throw invalid_argument("load2D: can not find file " + filename);
+  const vector<Line> lines = splitLines(contents);
 
   Values::shared_ptr initial(new Values);
   NonlinearFactorGraph::shared_ptr graph(new NonlinearFactorGraph);
 
-  string tag;
-
-  // load the poses
-  while (!is.eof()) {
-    if (!(is >> tag))
-      break;
-
-    const auto indexed_pose = parseVertex(is, tag);
-    if (indexed_pose) {
-      Key id = indexed_pose->first;
-
-      // optional filter
-      if (maxID && id >= maxID)
-        continue;
-
-      initial->insert(id, indexed_pose->second);
-    }
-    is.ignore(LINESIZE, '\n');
-  }
-  is.clear(); /* clears the end-of-file and error flags */
-  is.seekg(0, ios::beg);
-
   // If asked, create a sampler with random number generator
   Sampler sampler;
   if (addNoise) {
@@ -264,32 +474,74 @@ GraphAndValues load2D(const string& filename, SharedNoiseModel model, Key maxID,
     sampler = Sampler(noise);
   }
 
-  // Parse the pose constraints
-  Key id1, id2;
-  bool haveLandmark = false;
+  // Parse all lines, with the noise models and, without noise, the factors
   const bool useModelInFile = !model;
-  while (!is.eof()) {
-    if (!(is >> tag))
-      break;
+  vector<Line2D> parsed(lines.size());
+  parallelRanges(lines.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      LineParser parser(lines[i]);
+      const string tag = parser.word();
+      Line2D& line = parsed[i];
+      if (isVertexTag(tag)) {
+        if (parser.readKey(line.id1) && parser.read(line.v, 3))
+          line.type = Line2D::VERTEX;
+      } else if (isEdgeTag(tag)) {
+        double noise[6];
+        if (!parser.readKey(line.id1) || !parser.readKey(line.id2) ||
+            !parser.read(line.v, 3) || !parser.read(noise, 6))
+          continue;
+        line.type = Line2D::EDGE;
+        SharedNoiseModel modelInFile = readNoiseModel(noise, smart, noiseFormat,
+            kernelFunctionType);
+        line.model = useModelInFile ? modelInFile : model;
+        if (!addNoise)
+          line.factor.reset(new BetweenFactor<Pose2>(line.id1, line.id2,
+              Pose2(line.v[0], line.v[1], line.v[2]), line.model));
+      } else if (tag == "BR") {
+        if (parser.readKey(line.id1) && parser.readKey(line.id2) &&
+            parser.read(line.v, 4))
+          line.type = Line2D::BR;
+      } else if (tag == "LANDMARK") {
+        if (parser.readKey(line.id1) && parser.readKey(line.id2) &&
+            parser.read(line.v, 5))
+          line.type = Line2D::LANDMARK;
+      }
+    }
+  });
 
-    auto between_pose = parseEdge(is, tag);
-    if (between_pose) {
-      std::tie(id1, id2) = between_pose->first;
-      Pose2& l1Xl2 = between_pose->second;
+  // load the poses
+  for (const Line2D& line : parsed) {
+    if (line.type != Line2D::VERTEX)
+      continue;
 
-      // read noise model
-      SharedNoiseModel modelInFile = readNoiseModel(is, smart, noiseFormat,
-          kernelFunctionType);
+    // optional filter
+    if (maxID && line.id1 >= maxID)
+      continue;
+
+    initial->insert(line.id1, Pose2(line.v[0], line.v[1], line.v[2]));
+  }
+
+  // Parse the pose constraints
+  size_t nrFactors = 0;
+  for (const Line2D& line : parsed)
+    if (line.type != Line2D::OTHER && line.type != Line2D::VERTEX)
+      ++nrFactors;
+  graph->reserve(nrFactors);
 
+  bool haveLandmark = false;
+  for (const Line2D& line : parsed) {
+    const Key id1 = line.id1, id2 = line.id2;
+    if (line.type == Line2D::EDGE) {
       // optional filter
       if (maxID && (id1 >= maxID || id2 >= maxID))
         continue;
 
-      if (useModelInFile)
-        model = modelInFile;
-
-      if (addNoise)
+      Pose2 l1Xl2(line.v[0], line.v[1], line.v[2]);
+      NonlinearFactor::shared_ptr factor = line.factor;
+      if (addNoise) {
         l1Xl2 = l1Xl2.retract(sampler.sample());
+        factor.reset(new BetweenFactor<Pose2>(id1, id2, l1Xl2, line.model));
+      }
 
       // Insert vertices if pure odometry file
       if (!initial->exists(id1))
@@ -297,24 +549,23 @@ GraphAndValues load2D(const string& filename, SharedNoiseModel model, Key maxID,
       if (!initial->exists(id2))
         initial->insert(id2, initial->at<Pose2>(id1) * l1Xl2);
 
-      NonlinearFactor::shared_ptr factor(
-          new BetweenFactor<Pose2>(id1, id2, l1Xl2, model));
       graph->push_back(factor);
     }
     // Parse measurements
     double bearing, range, bearing_std, range_std;
 
     // A bearing-range measurement
-    if (tag == "BR") {
-      is >> id1 >> id2 >> bearing >> range >> bearing_std >> range_std;
+    if (line.type == Line2D::BR) {
+      bearing = line.v[0];
+      range = line.v[1];
+      bearing_std = line.v[2];
+      range_std = line.v[3];
     }
 
     // A landmark measurement, TODO Frank says: don't know why is converted to bearing-range
-    if (tag == "LANDMARK") {
-      double lmx, lmy;
-      double v1, v2, v3;
-
-      is >> id1 >> id2 >> lmx >> lmy >> v1 >> v2 >> v3;
+    if (line.type == Line2D::LANDMARK) {
+      const double lmx = line.v[0], lmy = line.v[1];
+      const double v1 = line.v[2], v3 = line.v[4];
 
       // Convert x,y to bearing,range
       bearing = atan2(lmy, lmx);
@@ -339,7 +590,7 @@ GraphAndValues load2D(const string& filename, SharedNoiseModel model, Key maxID,
     }
 
     // Do some common stuff for bearing-range measurements
-    if (tag == "LANDMARK" || tag == "BR") {
+    if (line.type == Line2D::LANDMARK || line.type == Line2D::BR) {
 
       // optional filter
       if (maxID && id1 >= maxID)
@@ -363,7 +614,6 @@ GraphAndValues load2D(const string& filename, SharedNoiseModel model, Key maxID,
         initial->insert(L(id2), global);
       }
     }
-    is.ignore(LINESIZE, '\n');
   }
 
   return make_pair(graph, initial);
@@ -511,96 +761,115 @@ void writeG2o(const NonlinearFactorGraph& graph, const Values& estimate,
 }
 
 /* ************************************************************************* */
-std::map<Key, Pose3> parse3DPoses(const string& filename) {
-  ifstream is(filename.c_str());
-  if (!is)
-    throw invalid_argument("parse3DPoses: can not find file " + filename);
-
-  std::map<Key, Pose3> poses;
-  while (!is.eof()) {
-    char buf[LINESIZE];
-    is.getline(buf, LINESIZE);
-    istringstream ls(buf);
-    string tag;
-    ls >> tag;
-
-    if (tag == "VERTEX3") {
+namespace {
+// Parse the 3D poses in the lines of a file, the first pose of a key wins
+std::map<Key, Pose3> parse3DPoses(const vector<Line>& lines) {
+  vector<boost::optional<std::pair<Key, Pose3> > > parsed(lines.size());
+  parallelRanges(lines.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      LineParser parser(lines[i]);
+      const string tag = parser.word();
       Key id;
-      double x, y, z, roll, pitch, yaw;
-      ls >> id >> x >> y >> z >> roll >> pitch >> yaw;
-      poses.emplace(id, Pose3(Rot3::Ypr(yaw, pitch, roll), {x, y, z}));
-    }
-    if (tag == "VERTEX_SE3:QUAT") {
-      Key id;
-      double x, y, z, qx, qy, qz, qw;
-      ls >> id >> x >> y >> z >> qx >> qy >> qz >> qw;
-      poses.emplace(id, Pose3(Rot3::Quaternion(qw, qx, qy, qz), {x, y, z}));
+      double v[7];
+      if (tag == "VERTEX3") {
+        if (parser.readKey(id) && parser.read(v, 6))
+          parsed[i] = std::make_pair(
+              id, Pose3(Rot3::Ypr(v[5], v[4], v[3]), {v[0], v[1], v[2]}));
+      } else if (tag == "VERTEX_SE3:QUAT") {
+        if (parser.readKey(id) && parser.read(v, 7))
+          parsed[i] = std::make_pair(id,
+              Pose3(Rot3::Quaternion(v[6], v[3], v[4], v[5]), {v[0], v[1], v[2]}));
+      }
     }
-  }
+  });
+
+  std::map<Key, Pose3> poses;
+  for (const auto& pose : parsed)
+    if (pose) poses.emplace(pose->first, pose->second);
   return poses;
 }
 
-/* ************************************************************************* */
-BetweenFactorPose3s parse3DFactors(const string& filename) {
-  ifstream is(filename.c_str());
-  if (!is) throw invalid_argument("parse3DFactors: can not find file " + filename);
-
-  std::vector<BetweenFactor<Pose3>::shared_ptr> factors;
-  while (!is.eof()) {
-    char buf[LINESIZE];
-    is.getline(buf, LINESIZE);
-    istringstream ls(buf);
-    string tag;
-    ls >> tag;
-
-    if (tag == "EDGE3") {
-      Key id1, id2;
-      double x, y, z, roll, pitch, yaw;
-      ls >> id1 >> id2 >> x >> y >> z >> roll >> pitch >> yaw;
-      Matrix m(6, 6);
-      for (size_t i = 0; i < 6; i++)
-        for (size_t j = i; j < 6; j++) ls >> m(i, j);
-      SharedNoiseModel model = noiseModel::Gaussian::Information(m);
-      factors.emplace_back(new BetweenFactor<Pose3>(
-          id1, id2, Pose3(Rot3::Ypr(yaw, pitch, roll), {x, y, z}), model));
-    }
-    if (tag == "EDGE_SE3:QUAT") {
+// Parse the 3D pose constraints in the lines of a file
+BetweenFactorPose3s parse3DFactors(const vector<Line>& lines) {
+  BetweenFactorPose3s parsed(lines.size());
+  parallelRanges(lines.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      LineParser parser(lines[i]);
+      const string tag = parser.word();
+      const bool quaternion = tag == "EDGE_SE3:QUAT";
+      if (tag != "EDGE3" && !quaternion)
+        continue;
+
+      // Pose and upper triangle of the information matrix
       Key id1, id2;
-      double x, y, z, qx, qy, qz, qw;
-      ls >> id1 >> id2 >> x >> y >> z >> qx >> qy >> qz >> qw;
+      double v[7], u[21];
+      if (!parser.readKey(id1) || !parser.readKey(id2) ||
+          !parser.read(v, quaternion ? 7 : 6) || !parser.read(u, 21))
+        continue;
       Matrix m(6, 6);
-      for (size_t i = 0; i < 6; i++) {
-        for (size_t j = i; j < 6; j++) {
-          double mij;
-          ls >> mij;
-          m(i, j) = mij;
-          m(j, i) = mij;
-        }
-      }
-      Matrix mgtsam(6, 6);
+      for (size_t i = 0, k = 0; i < 6; i++)
+        for (size_t j = i; j < 6; j++, k++)
+          m(i, j) = m(j, i) = u[k];
+
+      if (!quaternion) {
+        SharedNoiseModel model = noiseModel::Gaussian::Information(m);
+        parsed[i].reset(new BetweenFactor<Pose3>(id1, id2,
+            Pose3(Rot3::Ypr(v[5], v[4], v[3]), {v[0], v[1], v[2]}), model));
+      } else {
+        Matrix mgtsam(6, 6);
 
-      mgtsam.block<3, 3>(0, 0) = m.block<3, 3>(3, 3);  // cov rotation
-      mgtsam.block<3, 3>(3, 3) = m.block<3, 3>(0, 0);  // cov translation
-      mgtsam.block<3, 3>(0, 3) = m.block<3, 3>(0, 3);  // off diagonal
-      mgtsam.block<3, 3>(3, 0) = m.block<3, 3>(3, 0);  // off diagonal
+        mgtsam.block<3, 3>(0, 0) = m.block<3, 3>(3, 3);  // cov rotation
+        mgtsam.block<3, 3>(3, 3) = m.block<3, 3>(0, 0);  // cov translation
+        mgtsam.block<3, 3>(0, 3) = m.block<3, 3>(0, 3);  // off diagonal
+        mgtsam.block<3, 3>(3, 0) = m.block<3, 3>(3, 0);  // off diagonal
 
-      SharedNoiseModel model = noiseModel::Gaussian::Information(mgtsam);
-      factors.emplace_back(new BetweenFactor<Pose3>(
-          id1, id2, Pose3(Rot3::Quaternion(qw, qx, qy, qz), {x, y, z}), model));
+        SharedNoiseModel model = noiseModel::Gaussian::Information(mgtsam);
+        parsed[i].reset(new BetweenFactor<Pose3>(id1, id2,
+            Pose3(Rot3::Quaternion(v[6], v[3], v[4], v[5]), {v[0], v[1], v[2]}),
+            model));
+      }
     }
-  }
-  return factors;
+  });
+
+  // Keep the factors in file order
+  parsed.erase(std::remove(parsed.begin(), parsed.end(),
+                           BetweenFactor<Pose3>::shared_ptr()),
+               parsed.end());
+  return parsed;
+}
+}  // namespace
+
+/* ************************************************************************* */
+std::map<Key, Pose3> parse3DPoses(const string& filename) {
+  string contents;
+  if (!readFile(filename, &contents))
+    throw invalid_argument("parse3DPoses: can not find file " + filename);
+  return parse3DPoses(splitLines(contents));
+}
+
+/* ************************************************************************* */
+BetweenFactorPose3s parse3DFactors(const string& filename) {
+  string contents;
+  if (!readFile(filename, &contents))
+    throw invalid_argument("parse3DFactors: can not find file " + filename);
+  return parse3DFactors(splitLines(contents));
 }
 
 /* ************************************************************************* */
 GraphAndValues load3D(const string& filename) {
-  const auto factors = parse3DFactors(filename);
+  string contents;
+  if (!readFile(filename, &contents))
+    throw invalid_argument("load3D: can not find file " + filename);
+  const vector<Line> lines = splitLines(contents);
+
+  const auto factors = parse3DFactors(lines);
   NonlinearFactorGraph::shared_ptr graph(new NonlinearFactorGraph);
+  graph->reserve(factors.size());
   for (const auto& factor : factors) {
     graph->push_back(factor);
   }
 
-  const auto poses = parse3DPoses(filename);
+  const auto poses = parse3DPoses(lines);
   Values::shared_ptr initial(new Values);
   for (const auto& key_pose : poses) {
     initial->insert(key_pose.first, key_pose.second);
@@ -735,52 +1004,90 @@ bool readBundler(const string& filename, SfM_data &data) {
 /* ************************************************************************* */
 bool readBAL(const string& filename, SfM_data &data) {
   // Load the data file
-  ifstream is(filename.c_str(), ifstream::in);
-  if (!is) {
+  string contents;
+  if (!readFile(filename, &contents)) {
     cout << "Error in readBAL: can not find the file!!" << endl;
     return false;
   }
 
-  // Get the number of camera poses and 3D points
+  // A BAL file only contains numbers, parse them all at once
+  vector<double> numbers;
+  if (!parseNumbers(contents, &numbers) || numbers.size() < 3) {
+    cout << "Error in readBAL: invalid file!!" << endl;
+    return false;
+  }
+
+  // Get the number of camera poses and 3D points, and check that the file
+  // holds all of them without computing a size that could overflow
   size_t nrPoses, nrPoints, nrObservations;
-  is >> nrPoses >> nrPoints >> nrObservations;
+  if (!toIndex(numbers[0], numbers.size(), &nrPoses) ||
+      !toIndex(numbers[1], numbers.size(), &nrPoints) ||
+      !toIndex(numbers[2], numbers.size(), &nrObservations)) {
+    cout << "Error in readBAL: invalid number of poses, points or observations!!"
+         << endl;
+    return false;
+  }
+  size_t remaining = numbers.size() - 3;
+  if (nrObservations > remaining / 4 ||
+      nrPoses > (remaining -= 4 * nrObservations) / 9 ||
+      nrPoints > (remaining -= 9 * nrPoses) / 3) {
+    cout << "Error in readBAL: file is truncated!!" << endl;
+    return false;
+  }
+  const double* observations = numbers.data() + 3;
+  const double* poses = observations + 4 * nrObservations;
+  const double* points = poses + 9 * nrPoses;
 
   data.tracks.resize(nrPoints);
 
-  // Get the information for the observations
+  // Get the information for the observations, reserving the tracks first
+  vector<size_t> nrMeasurements(nrPoints, 0);
   for (size_t k = 0; k < nrObservations; k++) {
-    size_t i = 0, j = 0;
-    float u, v;
-    is >> i >> j >> u >> v;
-    data.tracks[j].measurements.emplace_back(i, Point2(u, -v));
+    size_t i, j;
+    if (!toIndex(observations[4 * k], nrPoses, &i)) {
+      cout << "Error in readBAL: invalid camera index " << observations[4 * k]
+           << endl;
+      return false;
+    }
+    if (!toIndex(observations[4 * k + 1], nrPoints, &j)) {
+      cout << "Error in readBAL: invalid point index "
+           << observations[4 * k + 1] << endl;
+      return false;
+    }
+    ++nrMeasurements[j];
   }
-
-  // Get the information for the camera poses
-  for (size_t i = 0; i < nrPoses; i++) {
-    // Get the Rodrigues vector
-    float wx, wy, wz;
-    is >> wx >> wy >> wz;
-    Rot3 R = Rot3::Rodrigues(wx, wy, wz); // BAL-OpenGL rotation matrix
-
-    // Get the translation vector
-    float tx, ty, tz;
-    is >> tx >> ty >> tz;
-
-    Pose3 pose = openGL2gtsam(R, tx, ty, tz);
-
-    // Get the focal length and the radial distortion parameters
-    float f, k1, k2;
-    is >> f >> k1 >> k2;
-    Cal3Bundler K(f, k1, k2);
-
-    data.cameras.emplace_back(pose, K);
+  for (size_t j = 0; j < nrPoints; j++)
+    data.tracks[j].measurements.reserve(
+        data.tracks[j].measurements.size() + nrMeasurements[j]);
+  for (size_t k = 0; k < nrObservations; k++) {
+    const double* o = observations + 4 * k;
+    const float u = float(o[2]), v = float(o[3]);
+    data.tracks[size_t(o[1])].measurements.emplace_back(size_t(o[0]),
+                                                        Point2(u, -v));
   }
 
+  // Get the information for the camera poses, values are read as float
+  const size_t firstCamera = data.cameras.size();
+  data.cameras.resize(firstCamera + nrPoses);
+  parallelRanges(nrPoses, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      float c[9];
+      for (size_t k = 0; k < 9; k++)
+        c[k] = float(poses[9 * i + k]);
+
+      // Rodrigues vector, translation, focal length and radial distortion
+      Rot3 R = Rot3::Rodrigues(c[0], c[1], c[2]); // BAL-OpenGL rotation matrix
+      Pose3 pose = openGL2gtsam(R, c[3], c[4], c[5]);
+      Cal3Bundler K(c[6], c[7], c[8]);
+
+      data.cameras[firstCamera + i] = SfM_Camera(pose, K);
+    }
+  });
+
   // Get the information for the 3D points
   for (size_t j = 0; j < nrPoints; j++) {
-    // Get the 3D position
-    float x, y, z;
-    is >> x >> y >> z;
+    const float x = float(points[3 * j]), y = float(points[3 * j + 1]),
+                z = float(points[3 * j + 2]);
     SfM_Track& track = data.tracks[j];
     track.p = Point3(x, y, z);
     track.r = 0.4f;
@@ -788,7 +1095,6 @@ bool readBAL(const string& filename, SfM_data &data) {
     track.b = 0.4f;
   }
 
-  is.close();
   return true;
 }
 
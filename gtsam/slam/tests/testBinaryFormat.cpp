@@ -0,0 +1,156 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    testBinaryFormat.cpp
+ * @brief   Unit tests for the binary factor graph format
+ */
+
+#include <gtsam/slam/binaryFormat.h>
+#include <gtsam/sam/BearingRangeFactor.h>
+#include <gtsam/slam/BetweenFactor.h>
+#include <gtsam/slam/PriorFactor.h>
+#include <gtsam/geometry/Pose2.h>
+#include <gtsam/geometry/Pose3.h>
+#include <gtsam/inference/Symbol.h>
+#include <gtsam/base/TestableAssertions.h>
+
+#include <CppUnitLite/TestHarness.h>
+
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+using namespace gtsam;
+using symbol_shorthand::L;
+using symbol_shorthand::X;
+
+namespace {
+GraphAndValues roundTrip(const NonlinearFactorGraph& graph,
+                         const Values& values) {
+  stringstream ss;
+  writeBinary(graph, values, ss);
+  return readBinary(ss);
+}
+}  // namespace
+
+/* ************************************************************************* */
+TEST(binaryFormat, mixedTypes) {
+  auto unit = noiseModel::Unit::Create(3);
+  auto isotropic = noiseModel::Isotropic::Sigma(2, 0.3);
+  auto diagonal = noiseModel::Diagonal::Sigmas(Vector3(0.1, 0.2, 0.3));
+  auto constrained = noiseModel::Constrained::MixedSigmas(Vector3(0.0, 0.1, 0.0));
+  Matrix33 R;
+  R << 1, 2, 3, 0, 4, 5, 0, 0, 6;
+  auto gaussian = noiseModel::Gaussian::SqrtInformation(R);
+  auto huber = noiseModel::Robust::Create(
+      noiseModel::mEstimator::Huber::Create(1.345), diagonal);
+
+  NonlinearFactorGraph graph;
+  graph.emplace_shared<PriorFactor<Pose2> >(X(0), Pose2(1, 2, 0.3), constrained);
+  graph.emplace_shared<BetweenFactor<Pose2> >(X(0), X(1), Pose2(1, 0, 0.1), diagonal);
+  graph.push_back(NonlinearFactor::shared_ptr());
+  graph.emplace_shared<BetweenFactor<Pose2> >(X(1), X(2), Pose2(1, 0, 0.2), huber);
+  graph.emplace_shared<BearingRangeFactor<Pose2, Point2> >(
+      X(1), L(1), Rot2::fromAngle(0.4), 2.0, isotropic);
+  graph.emplace_shared<BetweenFactor<Pose3> >(
+      X(3), X(4), Pose3(Rot3::Ypr(0.1, 0.2, 0.3), Point3(1, 2, 3)),
+      noiseModel::Unit::Create(6));
+  graph.emplace_shared<PriorFactor<Point3> >(L(2), Point3(1, 2, 3), gaussian);
+  graph.emplace_shared<BetweenFactor<Rot2> >(X(5), X(6), Rot2(0.5),
+                                             noiseModel::Unit::Create(1));
+  graph.emplace_shared<BetweenFactor<Pose2> >(X(2), X(0), Pose2(), unit);
+  graph.emplace_shared<BetweenFactor<Rot2> >(X(6), X(5), Rot2(),
+                                             noiseModel::Isotropic::Sigma(1, 1.0, false));
+
+  Values values;
+  values.insert(X(0), Pose2(1, 2, 0.3));
+  values.insert(X(1), Pose2(2, 2, 0.4));
+  values.insert(X(2), Pose2(3, 2, 0.5));
+  values.insert(L(1), Point2(4, 5));
+  values.insert(L(2), Point3(1, 2, 3));
+  values.insert(X(3), Pose3());
+  values.insert(X(4), Pose3(Rot3::Ypr(0.1, 0.2, 0.3), Point3(1, 2, 3)));
+  values.insert(X(5), Rot2(0.1));
+  values.insert(X(6), Rot2(0.6));
+  values.insert(X(7), Rot3::Rodrigues(0.1, 0.2, 0.3));
+
+  const GraphAndValues actual = roundTrip(graph, values);
+  EXPECT(assert_equal(values, *actual.second));
+  EXPECT_LONGS_EQUAL(graph.size(), actual.first->size());
+  EXPECT(!actual.first->at(2));
+  EXPECT(assert_equal(graph, *actual.first));
+  EXPECT_DOUBLES_EQUAL(graph.error(values), actual.first->error(values), 1e-9);
+
+  // Shared noise models stay shared
+  auto between = [&](size_t i) {
+    return boost::dynamic_pointer_cast<NoiseModelFactor>(actual.first->at(i));
+  };
+  auto robust =
+      boost::dynamic_pointer_cast<noiseModel::Robust>(between(3)->noiseModel());
+  CHECK(robust);
+  EXPECT(between(1)->noiseModel() == robust->noise());
+
+  // An isotropic model with sigma 1 is not read back as a unit model
+  EXPECT(boost::dynamic_pointer_cast<noiseModel::Isotropic>(between(9)->noiseModel()));
+  EXPECT(!boost::dynamic_pointer_cast<noiseModel::Unit>(between(9)->noiseModel()));
+}
+
+/* ************************************************************************* */
+TEST(binaryFormat, dataset) {
+  NonlinearFactorGraph::shared_ptr graph;
+  Values::shared_ptr values;
+  boost::tie(graph, values) = readG2o(findExampleDataFile("pose3example"), true);
+
+  const string filename = "testBinaryFormat_pose3example.bin";
+  writeBinary(*graph, *values, filename);
+  const GraphAndValues actual = readBinary(filename);
+  remove(filename.c_str());
+  EXPECT(assert_equal(*values, *actual.second));
+  EXPECT(assert_equal(*graph, *actual.first));
+}
+
+/* ************************************************************************* */
+TEST(binaryFormat, errors) {
+  NonlinearFactorGraph graph;
+  graph.emplace_shared<BetweenFactor<Pose2> >(0, 1, Pose2(1, 0, 0),
+                                              noiseModel::Unit::Create(3));
+  Values values;
+  values.insert(0, Pose2());
+  values.insert(1, Pose2(1, 0, 0));
+
+  stringstream ss;
+  writeBinary(graph, values, ss);
+  const string data = ss.str();
+
+  // Truncated at any point
+  for (size_t size = 0; size < data.size(); size += 7) {
+    stringstream truncated(data.substr(0, size));
+    CHECK_EXCEPTION(readBinary(truncated), std::runtime_error);
+  }
+
+  // Not a binary file
+  stringstream text("VERTEX_SE2 0 0 0 0");
+  CHECK_EXCEPTION(readBinary(text), std::runtime_error);
+
+  // Unsupported types are rejected when writing
+  values.insert(2, Vector3(1, 2, 3));
+  stringstream unsupported;
+  CHECK_EXCEPTION(writeBinary(graph, values, unsupported), std::invalid_argument);
+}
+
+/* ************************************************************************* */
+int main() {
+  TestResult tr;
+  return TestRegistry::runAllTests(tr);
+}
+/* ************************************************************************* */
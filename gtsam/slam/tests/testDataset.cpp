@@ -23,9 +23,13 @@
 #include <gtsam/base/TestableAssertions.h>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
 
 #include <CppUnitLite/TestHarness.h>
 
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 
@@ -33,6 +37,15 @@ using namespace gtsam::symbol_shorthand;
 using namespace std;
 using namespace gtsam;
 
+namespace {
+/// A file name in the temporary directory, unique to this run
+string tempFileName(const string& name) {
+  const boost::filesystem::path path = boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("%%%%-%%%%-" + name);
+  return path.string();
+}
+}  // namespace
+
 /* ************************************************************************* */
 TEST(dataSet, findExampleDataFile) {
   const string expected_end = "examples/Data/example.graph";
@@ -101,6 +114,35 @@ TEST( dataSet, load2DVictoriaPark)
   EXPECT_LONGS_EQUAL(7120,initial->size());
 }
 
+/* ************************************************************************* */
+TEST( dataSet, load2DLines)
+{
+  // Windows line endings, a truncated edge and unknown tags
+  const string filename = tempFileName("testDataset_load2DLines.graph");
+  {
+    ofstream os(filename.c_str());
+    os << "# comment\r\n"
+       << "VERTEX2 0 0 0 0\r\n"
+       << "EDGE2 0 1 1 0 0 1 0 1 1 0 0\r\n"
+       << "EDGE2 1 2 1 0\n"
+       << "BR 1 3 0 2 0.1 0.2\n"
+       << "EDGE2 1 2 0 1 0 1 0 1 1 0 0";
+  }
+  NonlinearFactorGraph::shared_ptr graph;
+  Values::shared_ptr initial;
+  boost::tie(graph, initial) = load2D(filename);
+  remove(filename.c_str());
+
+  EXPECT_LONGS_EQUAL(3, graph->size());
+  EXPECT_LONGS_EQUAL(4, initial->size());
+  noiseModel::Unit::shared_ptr model = noiseModel::Unit::Create(3);
+  EXPECT(assert_equal(BetweenFactor<Pose2>(1, 2, Pose2(0, 1, 0), model),
+      *boost::dynamic_pointer_cast<BetweenFactor<Pose2> >(graph->at(2))));
+  EXPECT(assert_equal(Pose2(1, 0, 0), initial->at<Pose2>(1)));
+  EXPECT(assert_equal(Pose2(1, 1, 0), initial->at<Pose2>(2)));
+  EXPECT(assert_equal(Point2(3, 0), initial->at<Point2>(L(3)), 1e-9));
+}
+
 /* ************************************************************************* */
 TEST( dataSet, Balbianello)
 {
@@ -405,6 +447,58 @@ TEST( dataSet, readBAL_Dubrovnik)
   EXPECT(assert_equal(expected,actual,12));
 }
 
+/* ************************************************************************* */
+TEST( dataSet, readBALTruncated)
+{
+  const string filename = tempFileName("testDataset_readBALTruncated.txt");
+  {
+    ofstream os(filename.c_str());
+    os << "1 1 1\n0 0 1.5 -2\n0.1 0.2 0.3 1 2 3 500 0 0\n";
+  }
+  SfM_data data;
+  EXPECT(!readBAL(filename, data));
+
+  {
+    ofstream os(filename.c_str(), ios::app);
+    os << "4 5 6\n";
+  }
+  EXPECT(readBAL(filename, data));
+  remove(filename.c_str());
+
+  EXPECT_LONGS_EQUAL(1, data.number_cameras());
+  EXPECT_LONGS_EQUAL(1, data.number_tracks());
+  EXPECT(assert_equal(Point2(1.5, 2), data.tracks[0].measurements[0].second));
+  EXPECT(assert_equal(Point3(4, 5, 6), data.tracks[0].p));
+  EXPECT_DOUBLES_EQUAL(500, data.cameras[0].calibration().fx(), 1e-9);
+}
+
+/* ************************************************************************* */
+TEST( dataSet, readBALInvalidCounts)
+{
+  const string filename = tempFileName("testDataset_readBALInvalidCounts.txt");
+  const string body = "0 0 1.5 -2\n0.1 0.2 0.3 1 2 3 500 0 0\n4 5 6\n";
+  for (const string header : {"-1 1 1", "1 nan 1", "1 1 1.5", "1 1 1e30",
+                              "1 1 4611686018427387904", "2 1 1"}) {
+    {
+      ofstream os(filename.c_str());
+      os << header << "\n" << body;
+    }
+    SfM_data data;
+    EXPECT(!readBAL(filename, data));
+  }
+
+  // Indices of cameras and points beyond their counts
+  for (const string observation : {"1 0 1.5 -2", "0 -1 1.5 -2", "0 nan 1.5 -2"}) {
+    {
+      ofstream os(filename.c_str());
+      os << "1 1 1\n" << observation << "\n0.1 0.2 0.3 1 2 3 500 0 0\n4 5 6\n";
+    }
+    SfM_data data;
+    EXPECT(!readBAL(filename, data));
+  }
+  remove(filename.c_str());
+}
+
 /* ************************************************************************* */
 TEST( dataSet, openGL2gtsam)
 {
@@ -143,6 +143,85 @@ TEST(VariableIndex, deep_copy) {
   EXPECT(assert_equal(expectedRemoved, clone));
 }
 
+/* ************************************************************************* */
+TEST(VariableIndex, overflow) {
+  // Chain built one factor at a time, which goes through the overflow area
+  // and triggers compaction along the way
+  SymbolicFactorGraph chain;
+  VariableIndex actual;
+  for (size_t j = 0; j < 3000; j++) {
+    SymbolicFactorGraph newFactor;
+    newFactor.push_factor(j, j + 1);
+    actual.augment(newFactor);
+    chain.push_back(newFactor);
+  }
+  VariableIndex expected(chain);
+  EXPECT(assert_equal(expected, actual));
+
+  // Lookup and iteration agree, whether the entries are compact or not
+  KeySet addedKeys;
+  addedKeys.insert(5);
+  actual.augmentExistingFactor(0, addedKeys);
+  EXPECT_LONGS_EQUAL(3, actual[5].size());
+  EXPECT_LONGS_EQUAL(0, actual[5].back());
+  VariableIndex::const_iterator it = actual.find(5);
+  EXPECT(it != actual.end());
+  EXPECT_LONGS_EQUAL(5, it->first);
+  EXPECT(it->second == actual.factors(5));
+  EXPECT_LONGS_EQUAL(6, (++it)->first);
+  EXPECT(actual.find(5000) == actual.end());
+  CHECK_EXCEPTION(actual[5000], std::invalid_argument);
+
+  size_t count = 0;
+  Key previous = 0;
+  for (const auto& key_factors : actual) {
+    if (count++ > 0) EXPECT(key_factors.first > previous);
+    previous = key_factors.first;
+  }
+  EXPECT_LONGS_EQUAL(3001, count);
+
+  VariableIndex compacted(actual);
+  compacted.compact();
+  EXPECT(assert_equal(actual, compacted));
+
+  // operator[] copies compact lists out, factors() views them in place
+  const FactorIndices copied = compacted[5];
+  const FactorIndices& list = compacted[5];
+  EXPECT(copied == list);
+  EXPECT(&list == &compacted[5]);
+  EXPECT(compacted.factors(5) ==
+         VariableIndex::FactorRange(list.data(), list.data() + list.size()));
+  CHECK_EXCEPTION(compacted.factors(5000), std::invalid_argument);
+}
+
+/* ************************************************************************* */
+TEST(VariableIndex, removeFromOverflow) {
+  auto fg1 = testGraph1(), fg2 = testGraph2();
+  SymbolicFactorGraph fgCombined; fgCombined.push_back(fg1); fgCombined.push_back(fg2);
+  SymbolicFactorGraph fg2removed(fgCombined);
+  fg2removed.remove(0); fg2removed.remove(1); fg2removed.remove(2); fg2removed.remove(3);
+  VariableIndex expected(fg2removed);
+
+  // Build incrementally so that the removals act on overflow lists
+  VariableIndex actual(fg1);
+  actual.augment(fg2);
+  vector<size_t> indices;
+  indices.push_back(0); indices.push_back(1); indices.push_back(2); indices.push_back(3);
+  actual.remove(indices.begin(), indices.end(), fg1);
+  KeyVector unusedVariables{0, 9};
+  actual.removeUnusedVariables(unusedVariables.begin(), unusedVariables.end());
+  EXPECT(assert_equal(expected, actual));
+  EXPECT(actual.find(9) == actual.end());
+
+  // Variables can come back after being removed
+  SymbolicFactorGraph fg3;
+  fg3.push_factor(0, 9);
+  actual.augment(fg3);
+  expected.augment(fg3);
+  EXPECT(assert_equal(expected, actual));
+  EXPECT_LONGS_EQUAL(8, actual.size());
+}
+
 /* ************************************************************************* */
 int main() {
   TestResult tr;
@@ -99,11 +99,32 @@ namespace gtsam {
   Constraint::shared_ptr AllDiff::partiallyApply(
       const std::vector<Domain>& domains) const {
     DiscreteFactor::Values known;
+    std::set<size_t> taken;
+    KeyVector unknown;
     for(Key k: keys_) {
         const Domain& Dk = domains[k];
-        if (Dk.isSingleton())
+        if (Dk.isSingleton()) {
           known[k] = Dk.firstValue();
+          if (!taken.insert(Dk.firstValue()).second) throw std::runtime_error(
+              "AllDiff::partiallyApply: unsatisfiable");
+        } else
+          unknown.push_back(k);
       }
+
+    // A single unknown key is left with its domain minus the known values
+    if (unknown.size() == 1) {
+      Domain D = domains[unknown.front()];
+      for(size_t value: taken)
+        D.erase(value);
+      return boost::make_shared<Domain>(D);
+    }
+
+    // Known keys can only be dropped if no other domain still has their value,
+    // as is the case when arc consistency ran to completion
+    for(Key k: unknown)
+      for(size_t value: taken)
+        if (domains[k].contains(value))
+          return boost::make_shared<AllDiff>(*this);
     return partiallyApply(known);
   }
 
@@ -11,6 +11,8 @@
 #include <gtsam_unstable/discrete/Constraint.h>
 #include <gtsam/discrete/DecisionTreeFactor.h>
 
+#include <boost/make_shared.hpp>
+
 namespace gtsam {
 
   /**
@@ -78,22 +80,41 @@ namespace gtsam {
      * @param j domain to be checked
      * @param domains all other domains
      */
-    ///
+    /// Only a singleton domain of the other key rules out a value of domain j
     bool ensureArcConsistency(size_t j, std::vector<Domain>& domains) const {
-//      throw std::runtime_error(
-//          "BinaryAllDiff::ensureArcConsistency not implemented");
-      return false;
+      const Domain& Dk = domains[j == keys_[0] ? keys_[1] : keys_[0]];
+      if (!Dk.isSingleton() || !domains[j].contains(Dk.firstValue()))
+        return false;
+      domains[j].erase(Dk.firstValue());
+      return true;
     }
 
-    /// Partially apply known values
-    virtual Constraint::shared_ptr partiallyApply(const Values&) const {
-      throw std::runtime_error("BinaryAllDiff::partiallyApply not implemented");
+    /// Partially apply known values, a known key leaves a domain on the other
+    virtual Constraint::shared_ptr partiallyApply(const Values& values) const {
+      for (size_t i = 0; i < 2; i++) {
+        Values::const_iterator it = values.find(keys_[i]);
+        if (it != values.end()) {
+          Domain other(i == 0 ? DiscreteKey(keys_[1], cardinality1_)
+                              : DiscreteKey(keys_[0], cardinality0_));
+          other.erase(it->second);
+          return boost::make_shared<Domain>(other);
+        }
+      }
+      return boost::make_shared<BinaryAllDiff>(*this);
     }
 
     /// Partially apply known values, domain version
     virtual Constraint::shared_ptr partiallyApply(
-        const std::vector<Domain>&) const {
-      throw std::runtime_error("BinaryAllDiff::partiallyApply not implemented");
+        const std::vector<Domain>& domains) const {
+      for (size_t i = 0; i < 2; i++) {
+        const Domain& Di = domains[keys_[i]];
+        if (Di.isSingleton()) {
+          Domain other = domains[keys_[1 - i]];
+          other.erase(Di.firstValue());
+          return boost::make_shared<Domain>(other);
+        }
+      }
+      return boost::make_shared<BinaryAllDiff>(*this);
     }
   };
 
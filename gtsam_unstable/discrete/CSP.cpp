@@ -8,11 +8,13 @@
 #include <gtsam_unstable/discrete/Domain.h>
 #include <gtsam_unstable/discrete/CSP.h>
 #include <gtsam/base/Testable.h>
+#include <boost/make_shared.hpp>
 
 using namespace std;
 
 namespace gtsam {
 
+  /* ************************************************************************* */
   /// Find the best total assignment - can be expensive
   CSP::sharedValues CSP::optimalAssignment(OptionalOrdering ordering) const {
     DiscreteBayesNet::shared_ptr chordal = this->eliminateSequential(ordering);
@@ -20,7 +22,9 @@ namespace gtsam {
     return mpe;
   }
 
-  void CSP::runArcConsistency(size_t cardinality, size_t nrIterations, bool print) const {
+  /* ************************************************************************* */
+  vector<Domain> CSP::runArcConsistency(size_t cardinality, size_t nrIterations,
+      bool print) const {
     // Create VariableIndex
     VariableIndex index(*this);
     // index.print();
@@ -32,30 +36,52 @@ namespace gtsam {
     for (size_t j = 0; j < n; j++)
       domains.push_back(Domain(DiscreteKey(j,cardinality)));
 
+    // An arc is a variable together with one of its constraints, numbered
+    // by constraint and then by position of the variable in the constraint
+    std::vector<Constraint::shared_ptr> constraints(size());
+    std::vector<size_t> firstArc(size() + 1, 0);
+    KeyVector arcKeys;
+    for (size_t f = 0; f < size(); f++) {
+      constraints[f] = boost::dynamic_pointer_cast<Constraint>((*this)[f]);
+      if (!constraints[f]) throw runtime_error("CSP:runArcConsistency: non-constraint factor");
+      arcKeys.insert(arcKeys.end(), constraints[f]->begin(), constraints[f]->end());
+      firstArc[f + 1] = arcKeys.size();
+    }
+    std::vector<size_t> arcFactors(arcKeys.size());
+    for (size_t f = 0; f < size(); f++)
+      std::fill(arcFactors.begin() + firstArc[f], arcFactors.begin() + firstArc[f + 1], f);
+
+    // Start with all arcs queued
+    std::vector<size_t> queue(arcKeys.size()), next;
+    for (size_t arc = 0; arc < arcKeys.size(); arc++)
+      queue[arc] = arc;
+    std::vector<bool> queued(arcKeys.size(), true);
+
     // Create array of flags indicating a domain changed or not
     std::vector<bool> changed(n);
 
-    // iterate nrIterations over entire grid
-    for (size_t it = 0; it < nrIterations; it++) {
-      bool anyChange = false;
-      // iterate over all cells
-      for (size_t v = 0; v < n; v++) {
-        // keep track of which domains changed
-        changed[v] = false;
-        // loop over all factors/constraints for variable v
-        const FactorIndices& factors = index[v];
-        for(size_t f: factors) {
-          // if not already a singleton
-          if (!domains[v].isSingleton()) {
-            // get the constraint and call its ensureArcConsistency method
-            Constraint::shared_ptr constraint = boost::dynamic_pointer_cast<Constraint>((*this)[f]);
-            if (!constraint) throw runtime_error("CSP:runArcConsistency: non-constraint factor");
-            changed[v] = constraint->ensureArcConsistency(v,domains) || changed[v];
-          }
-        } // f
-        if (changed[v]) anyChange = true;
-      } // v
-      if (!anyChange) break;
+    // iterate until no arc is queued, at most nrIterations times
+    for (size_t it = 0; it < nrIterations && !queue.empty(); it++) {
+      std::fill(changed.begin(), changed.end(), false);
+      for (size_t arc: queue) {
+        queued[arc] = false;
+        const Key v = arcKeys[arc];
+        // if not already a singleton, call the ensureArcConsistency method
+        if (domains[v].isSingleton() ||
+            !constraints[arcFactors[arc]]->ensureArcConsistency(v, domains))
+          continue;
+        changed[v] = true;
+        // queue the arcs of the other variables of all constraints on v
+        for (size_t f: index[v])
+          for (size_t other = firstArc[f]; other < firstArc[f + 1]; other++)
+            if (arcKeys[other] != v && !queued[other]) {
+              queued[other] = true;
+              next.push_back(other);
+            }
+      }
+      queue.swap(next);
+      next.clear();
+
       // TODO: Sudoku specific hack
       if (print) {
         if (cardinality == 9 && n == 81) {
@@ -78,19 +104,37 @@ namespace gtsam {
       } // print
     } // it
 
-#ifndef INPROGRESS
-    // Now create new problem with all singleton variables removed
-    // We do this by adding simplifying all factors using parial application
-    // TODO: create a new ordering as we go, to ensure a connected graph
-    // KeyOrdering ordering;
-    // vector<Index> dkeys;
+    if (print) partiallyApply(domains).print("Reduced CSP:\n");
+    return domains;
+  }
+
+  /* ************************************************************************* */
+  CSP CSP::partiallyApply(const vector<Domain>& domains) const {
+    vector<Domain> pruned(domains);
+    vector<Constraint::shared_ptr> partials;
     for(const DiscreteFactor::shared_ptr& f: factors_) {
       Constraint::shared_ptr constraint = boost::dynamic_pointer_cast<Constraint>(f);
-      if (!constraint) throw runtime_error("CSP:runArcConsistency: non-constraint factor");
-      Constraint::shared_ptr reduced = constraint->partiallyApply(domains);
-      if (print) reduced->print();
+      if (!constraint) throw runtime_error("CSP:partiallyApply: non-constraint factor");
+      Constraint::shared_ptr partial = constraint->partiallyApply(domains);
+      if (partial->size() > 1) {
+        partials.push_back(partial);
+      } else if (partial->size() == 1) {
+        // A constraint left on a single key is intersected into its domain
+        Domain& D = pruned[partial->front()];
+        DiscreteFactor::Values values;
+        for (size_t v = D.firstValue(); v != D.values().npos; v = D.values().find_next(v)) {
+          values[partial->front()] = v;
+          if ((*partial)(values) == 0.0) D.erase(v);
+        }
+      }
     }
-#endif
+
+    CSP reduced;
+    for(const Domain& domain: pruned)
+      reduced.push_back(boost::make_shared<Domain>(domain));
+    for(const Constraint::shared_ptr& partial: partials)
+      reduced.push_back(partial);
+    return reduced;
   }
 } // gtsam
 
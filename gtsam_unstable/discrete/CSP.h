@@ -9,6 +9,7 @@
 
 #include <gtsam_unstable/discrete/AllDiff.h>
 #include <gtsam_unstable/discrete/SingleValue.h>
+#include <gtsam_unstable/discrete/Domain.h>
 #include <gtsam/discrete/DiscreteFactorGraph.h>
 
 namespace gtsam {
@@ -77,10 +78,24 @@ namespace gtsam {
      * Apply arc-consistency ~ Approximate loopy belief propagation
      * We need to give the domains to a constraint, and it returns
      * a domain whose values don't conflict in the arc-consistency way.
+     * Arcs are revised from a queue, and an arc is only queued again when
+     * the domain of another variable of its constraint changed (AC-3).
+     * Every iteration processes the arcs queued by the previous one.
+     * @return the domains of all variables, indexed by key
      * TODO: should get cardinality from Indices
      */
-    void runArcConsistency(size_t cardinality, size_t nrIterations = 10,
-        bool print = false) const;
+    std::vector<Domain> runArcConsistency(size_t cardinality,
+        size_t nrIterations = 10, bool print = false) const;
+
+    /**
+     * The problem restricted to the given domains, e.g. from runArcConsistency.
+     * Every variable gets a Domain factor, and the constraints are partially
+     * applied so that keys with singleton domains drop out of them, so that
+     * elimination multiplies smaller decision trees. Constraints left on a
+     * single key are intersected into that key's Domain, so the reduced
+     * problem has the same solutions even if arc consistency stopped early.
+     */
+    CSP partiallyApply(const std::vector<Domain>& domains) const;
   }; // CSP
 
 } // gtsam
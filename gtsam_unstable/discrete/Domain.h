@@ -10,6 +10,8 @@
 #include <gtsam_unstable/discrete/Constraint.h>
 #include <gtsam/discrete/DiscreteKey.h>
 
+#include <boost/dynamic_bitset.hpp>
+
 namespace gtsam {
 
   /**
@@ -18,7 +20,7 @@ namespace gtsam {
   class GTSAM_UNSTABLE_EXPORT Domain: public Constraint {
 
     size_t cardinality_; /// Cardinality
-    std::set<size_t> values_; /// allowed values
+    boost::dynamic_bitset<> values_; /// allowed values, one bit per value
 
   public:
 
@@ -26,35 +28,30 @@ namespace gtsam {
 
     // Constructor on Discrete Key initializes an "all-allowed" domain
     Domain(const DiscreteKey& dkey) :
-      Constraint(dkey.first), cardinality_(dkey.second) {
-      for (size_t v = 0; v < cardinality_; v++)
-        values_.insert(v);
+      Constraint(dkey.first), cardinality_(dkey.second), values_(dkey.second) {
+      values_.set();
     }
 
     // Constructor on Discrete Key with single allowed value
     // Consider SingleValue constraint
     Domain(const DiscreteKey& dkey, size_t v) :
-      Constraint(dkey.first), cardinality_(dkey.second) {
-      values_.insert(v);
-    }
-
-    /// Constructor
-    Domain(const Domain& other) :
-      Constraint(other.keys_[0]), values_(other.values_) {
+      Constraint(dkey.first), cardinality_(dkey.second), values_(dkey.second) {
+      insert(v);
     }
 
     /// insert a value, non const :-(
     void insert(size_t value) {
-      values_.insert(value);
+      if (value >= values_.size()) values_.resize(value + 1);
+      values_.set(value);
     }
 
     /// erase a value, non const :-(
     void erase(size_t value) {
-       values_.erase(value);
+      if (value < values_.size()) values_.reset(value);
     }
 
     size_t nrValues() const {
-      return values_.size();
+      return values_.count();
     }
 
     bool isSingleton() const {
@@ -62,7 +59,12 @@ namespace gtsam {
     }
 
     size_t firstValue() const {
-      return *values_.begin();
+      return values_.find_first();
+    }
+
+    /// The allowed values, one bit per value
+    const boost::dynamic_bitset<>& values() const {
+      return values_;
     }
 
     // print
@@ -80,7 +82,7 @@ namespace gtsam {
     }
 
     bool contains(size_t value) const {
-      return values_.count(value)>0;
+      return value < values_.size() && values_.test(value);
     }
 
     /// Calculate value
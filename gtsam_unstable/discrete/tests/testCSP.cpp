@@ -223,6 +223,53 @@ TEST_UNSAFE( CSP, AllDiff)
   csp.runArcConsistency(nrColors);
 }
 
+/* ************************************************************************* */
+TEST_UNSAFE( CSP, partiallyApplyEarlyStop)
+{
+  size_t nrColors = 2;
+  DiscreteKey A(0, nrColors), B(1, nrColors), C(2, nrColors);
+
+  // Ordered so that a single round of arc consistency leaves B and C unpruned
+  CSP csp;
+  csp.addAllDiff(B, C);
+  csp.addAllDiff(A, B);
+  csp.addSingleValue(A, 0);
+
+  vector<Domain> domains = csp.runArcConsistency(nrColors, 1);
+  EXPECT(domains[0].isSingleton());
+  LONGS_EQUAL(2, domains[1].nrValues());
+
+  // The reduced problem has exactly the solutions of the original one
+  CSP reduced = csp.partiallyApply(domains);
+  DiscreteFactor::Values values;
+  for (size_t a = 0; a < nrColors; a++)
+    for (size_t b = 0; b < nrColors; b++)
+      for (size_t c = 0; c < nrColors; c++) {
+        values[A.first] = a;
+        values[B.first] = b;
+        values[C.first] = c;
+        EXPECT_DOUBLES_EQUAL(csp(values), reduced(values), 1e-9);
+      }
+
+  // Same for a general AllDiff whose known value is still in other domains
+  size_t nrValues = 3;
+  DiscreteKey X(0, nrValues), Y(1, nrValues), Z(2, nrValues);
+  CSP csp2;
+  vector<DiscreteKey> dkeys;
+  dkeys += X,Y,Z;
+  csp2.addAllDiff(dkeys);
+  csp2.addSingleValue(X, 0);
+  CSP reduced2 = csp2.partiallyApply(csp2.runArcConsistency(nrValues, 1));
+  for (size_t x = 0; x < nrValues; x++)
+    for (size_t y = 0; y < nrValues; y++)
+      for (size_t z = 0; z < nrValues; z++) {
+        values[X.first] = x;
+        values[Y.first] = y;
+        values[Z.first] = z;
+        EXPECT_DOUBLES_EQUAL(csp2(values), reduced2(values), 1e-9);
+      }
+}
+
 /* ************************************************************************* */
 int main() {
   TestResult tr;
@@ -123,7 +123,7 @@ TEST_UNSAFE( Sudoku, small)
       0,1, 0,0);
 
   // Do BP
-  csp.runArcConsistency(4,10,PRINT);
+  const vector<Domain> domains = csp.runArcConsistency(4,10,PRINT);
 
   // optimize and check
   CSP::sharedValues solution = csp.optimalAssignment();
@@ -134,6 +134,12 @@ TEST_UNSAFE( Sudoku, small)
   (csp.key(2,0), 3)(csp.key(2,1), 2)(csp.key(2,2), 1)(csp.key(2,3), 0)
   (csp.key(3,0), 1)(csp.key(3,1), 0)(csp.key(3,2), 3)(csp.key(3,3), 2);
   EXPECT(assert_equal(expected,*solution));
+
+  // The domains still allow the solution, and solving the reduced problem
+  // gives the same solution
+  for (const CSP::Values::value_type& key_value : expected)
+    EXPECT(domains[key_value.first].contains(key_value.second));
+  EXPECT(assert_equal(expected,*csp.partiallyApply(domains).optimalAssignment()));
   //csp.printAssignment(solution);
 }
 
@@ -22,11 +22,148 @@
 #include <gtsam/linear/GaussianJunctionTree.h>
 #include <gtsam/linear/GaussianFactorGraph.h>
 #include <gtsam/linear/GaussianFactor.h>
+#include <gtsam/linear/GaussianEliminationTree.h>
+#include <gtsam/inference/inferenceExceptions.h>
+#include <gtsam/config.h> // for GTSAM_USE_TBB
+
+#ifdef GTSAM_USE_TBB
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#endif
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
 
 using namespace std;
 
 namespace gtsam {
 
+namespace {
+
+/* ************************************************************************* */
+// Error of a factor graph, evaluating the factors in parallel
+double parallelError(const NonlinearFactorGraph& graph, const Values& values) {
+#ifdef GTSAM_USE_TBB
+  vector<double> errors(graph.size(), 0.0);
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, graph.size()),
+      [&](const tbb::blocked_range<size_t>& range) {
+        for (size_t i = range.begin(); i != range.end(); ++i)
+          if (graph[i]) errors[i] = graph[i]->error(values);
+      });
+  return accumulate(errors.begin(), errors.end(), 0.0);
+#else
+  return graph.error(values);
+#endif
+}
+
+/* ************************************************************************* */
+// The damped linear system solved in every L-M iteration: the linearized
+// factors followed by a prior on every variable.  Its structure does not
+// change between iterations as long as every factor linearizes to a factor on
+// the same keys, so it is eliminated with the same junction tree every time,
+// only replacing the factors in the clusters.
+class DampedSystem {
+  // A factor of a cluster, and the position in the damped graph of the factor
+  // it is set to
+  struct ClusterSlot {
+    GaussianFactorGraph* factors;
+    size_t position;
+    size_t index;
+  };
+
+  GaussianFactorGraph graph_;
+  size_t nrLinear_;
+  vector<JacobianFactor::shared_ptr> priors_;
+  boost::shared_ptr<GaussianJunctionTree> junctionTree_;
+  vector<ClusterSlot> slots_;
+
+ public:
+  DampedSystem(const GaussianFactorGraph& linear, const VectorValues& delta,
+      const Ordering& ordering) :
+      graph_(linear), nrLinear_(linear.size()) {
+    graph_.reserve(linear.size() + delta.size());
+    for (const auto& key_value : delta) {
+      const size_t dim = key_value.second.size();
+      priors_.push_back(boost::make_shared<JacobianFactor>(key_value.first,
+          Matrix::Identity(dim, dim), key_value.second));
+      graph_.push_back(priors_.back());
+    }
+
+    // Build the tree on distinct factors, cloning factors that appear more
+    // than once, so every factor in a cluster identifies one position
+    GaussianFactorGraph distinct(graph_);
+    unordered_map<const GaussianFactor*, size_t> positions;
+    for (size_t i = 0; i < distinct.size(); ++i) {
+      if (!distinct[i]) continue;
+      if (!positions.emplace(distinct[i].get(), i).second) {
+        distinct[i] = distinct[i]->clone();
+        positions.emplace(distinct[i].get(), i);
+      }
+    }
+    junctionTree_ = boost::make_shared<GaussianJunctionTree>(
+        GaussianEliminationTree(distinct, ordering));
+
+    // Find the positions of the factors in the clusters
+    vector<GaussianJunctionTree::sharedNode> stack(
+        junctionTree_->roots().begin(), junctionTree_->roots().end());
+    while (!stack.empty()) {
+      const GaussianJunctionTree::sharedNode cluster = stack.back();
+      stack.pop_back();
+      for (size_t k = 0; k < cluster->factors.size(); ++k)
+        slots_.push_back({&cluster->factors, k,
+            positions.at(cluster->factors[k].get())});
+      stack.insert(stack.end(), cluster->children.begin(),
+          cluster->children.end());
+    }
+  }
+
+  // Replace the linearized factors, after relinearizing. Returns false, and
+  // leaves the system unchanged, if a factor became null, stopped being null
+  // or changed keys, in which case the tree has to be built again.
+  bool setLinear(const GaussianFactorGraph& linear) {
+    if (linear.size() != nrLinear_)
+      return false;
+    for (size_t i = 0; i < nrLinear_; ++i) {
+      if (!linear[i] != !graph_[i])
+        return false;
+      if (linear[i] && linear[i]->keys() != graph_[i]->keys())
+        return false;
+    }
+    for (size_t i = 0; i < nrLinear_; ++i)
+      graph_[i] = linear[i];
+    return true;
+  }
+
+  // Set the priors at the current solution for a given lambda, in place as
+  // the junction tree only refers to them
+  void setPriors(double lambda, const VectorValues& delta) {
+    const double sqrtLambda = sqrt(lambda);
+    auto prior = priors_.begin();
+    for (const auto& key_value : delta) {
+      const size_t dim = key_value.second.size();
+      (*prior)->getA((*prior)->begin()) =
+          sqrtLambda * Matrix::Identity(dim, dim);
+      (*prior)->getb() = sqrtLambda * key_value.second;
+      ++prior;
+    }
+  }
+
+  // Solve the damped system
+  VectorValues solve(const GaussianFactorGraph::Eliminate& function) {
+    for (const ClusterSlot& slot : slots_)
+      (*slot.factors)[slot.position] = graph_[slot.index];
+    const auto result = junctionTree_->eliminate(function);
+    // If any factors are remaining, the ordering was incomplete
+    if (!result.second->empty())
+      throw InconsistentEliminationRequested();
+    return result.first->optimize();
+  }
+};
+
+}  // namespace
+
 /* ************************************************************************* */
 void BatchFixedLagSmoother::print(const string& s,
     const KeyFormatter& keyFormatter) const {
@@ -56,23 +193,27 @@ FixedLagSmoother::Result BatchFixedLagSmoother::update(
 
   // Update all of the internal variables with the new information
   gttic(augment_system);
-  // Add the new variables to theta
+  // Add the new variables to theta, they are ordered by reorder()
   theta_.insert(newTheta);
-  // Add new variables to the end of the ordering
-  for (const auto& key_value : newTheta) {
-    ordering_.push_back(key_value.key);
-  }
   // Augment Delta
   delta_.insert(newTheta.zeroVectors());
 
   // Add the new factors to the graph, updating the variable index
   insertFactors(newFactors);
+  for(const auto& factor: newFactors) {
+    newFactorKeys_.insert(factor->begin(), factor->end());
+  }
   gttoc(augment_system);
 
   // remove factors in factorToRemove
   for(const size_t i : factorsToRemove){
-    if(factors_[i])
+    if(factors_[i]) {
+      for(Key key: *factors_[i]) {
+        factorIndex_[key].erase(i);
+      }
       factors_[i].reset();
+      marginalFactorSlots_.erase(i);
+    }
   }
 
   // Update the Timestamps associated with the factor keys
@@ -87,7 +228,7 @@ FixedLagSmoother::Result BatchFixedLagSmoother::update(
 
   // Reorder
   gttic(reorder);
-  reorder(marginalizableKeys);
+  reorder();
   gttoc(reorder);
 
   // Optimize
@@ -109,8 +250,10 @@ FixedLagSmoother::Result BatchFixedLagSmoother::update(
 }
 
 /* ************************************************************************* */
-void BatchFixedLagSmoother::insertFactors(
+vector<size_t> BatchFixedLagSmoother::insertFactors(
     const NonlinearFactorGraph& newFactors) {
+  vector<size_t> slots;
+  slots.reserve(newFactors.size());
   for(const auto& factor: newFactors) {
     Key index;
     // Insert the factor into an existing hole in the factor graph, if possible
@@ -126,7 +269,9 @@ void BatchFixedLagSmoother::insertFactors(
     for(Key key: *factor) {
       factorIndex_[key].insert(index);
     }
+    slots.push_back(index);
   }
+  return slots;
 }
 
 /* ************************************************************************* */
@@ -140,6 +285,7 @@ void BatchFixedLagSmoother::removeFactors(
       }
       // Remove the factor from the factor graph
       factors_.remove(slot);
+      marginalFactorSlots_.erase(slot);
       // Add the factor's old slot to the list of available slots
       availableSlots_.push(slot);
     } else {
@@ -169,16 +315,41 @@ void BatchFixedLagSmoother::eraseKeys(const KeyVector& keys) {
   eraseKeyTimestampMap(keys);
 
   // Remove marginalized keys from the ordering and delta
+  const KeySet erased(keys.begin(), keys.end());
+  ordering_.erase(remove_if(ordering_.begin(), ordering_.end(),
+      [&erased](Key key) { return erased.exists(key); }), ordering_.end());
   for(Key key: keys) {
-    ordering_.erase(find(ordering_.begin(), ordering_.end(), key));
     delta_.erase(key);
+    newFactorKeys_.erase(key);
   }
 }
 
 /* ************************************************************************* */
-void BatchFixedLagSmoother::reorder(const KeyVector& marginalizeKeys) {
-  // COLAMD groups will be used to place marginalize keys in Group 0, and everything else in Group 1
-  ordering_ = Ordering::ColamdConstrainedFirst(factors_, marginalizeKeys);
+void BatchFixedLagSmoother::reorder() {
+  // The variables ordered before those of the new factors keep their place.
+  // Marginalized variables do not have to be ordered first, as marginalize()
+  // eliminates them separately from the factors they are involved in.
+  // Only the variables from the first one of the new factors on are
+  // reordered, so the index is built from the factor index for their factors
+  // only, instead of for the whole window.
+  KeySet reorderedKeys(newFactorKeys_);
+  Ordering::iterator first = find_if(ordering_.begin(), ordering_.end(),
+      [this](Key key) { return newFactorKeys_.exists(key); });
+  reorderedKeys.insert(first, ordering_.end());
+  set<size_t> slots;
+  for(Key key: reorderedKeys) {
+    const auto keySlots = factorIndex_.find(key);
+    if (keySlots != factorIndex_.end())
+      slots.insert(keySlots->second.begin(), keySlots->second.end());
+  }
+  NonlinearFactorGraph reorderedFactors;
+  for(size_t slot: slots)
+    if (factors_.at(slot))
+      reorderedFactors.push_back(factors_.at(slot));
+
+  ordering_ = Ordering::ColamdIncremental(ordering_,
+      VariableIndex(reorderedFactors), newFactorKeys_);
+  newFactorKeys_.clear();
 }
 
 /* ************************************************************************* */
@@ -201,7 +372,7 @@ FixedLagSmoother::Result BatchFixedLagSmoother::optimize() {
 
   // Create a Values that holds the current evaluation point
   Values evalpoint = theta_.retract(delta_);
-  result.error = factors_.error(evalpoint);
+  result.error = parallelError(factors_, evalpoint);
 
   // check if we're already close enough
   if (result.error <= errorTol) {
@@ -211,49 +382,42 @@ FixedLagSmoother::Result BatchFixedLagSmoother::optimize() {
   // Use a custom optimization loop so the linearization points can be controlled
   double previousError;
   VectorValues newDelta;
+  boost::optional<DampedSystem> dampedSystem;
   do {
     previousError = result.error;
 
     // Do next iteration
     gttic(optimizer_iteration);
     {
-      // Linearize graph around the linearization point
-      GaussianFactorGraph linearFactorGraph = *factors_.linearize(theta_);
+      // Linearize graph around the linearization point, in parallel
+      gttic(linearize);
+      const GaussianFactorGraph::shared_ptr linearFactorGraph =
+          factors_.linearize(theta_);
+      if (!dampedSystem || !dampedSystem->setLinear(*linearFactorGraph)) {
+        // The symbolic structure is only computed again if it changed
+        dampedSystem.emplace(*linearFactorGraph, delta_, ordering_);
+      }
+      gttoc(linearize);
 
       // Keep increasing lambda until we make make progress
       while (true) {
 
         // Add prior factors at the current solution
         gttic(damp);
-        GaussianFactorGraph dampedFactorGraph(linearFactorGraph);
-        dampedFactorGraph.reserve(linearFactorGraph.size() + delta_.size());
-        {
-          // for each of the variables, add a prior at the current solution
-          double sigma = 1.0 / sqrt(lambda);
-          for(const auto& key_value: delta_) {
-            size_t dim = key_value.second.size();
-            Matrix A = Matrix::Identity(dim, dim);
-            Vector b = key_value.second;
-            SharedDiagonal model = noiseModel::Isotropic::Sigma(dim, sigma);
-            GaussianFactor::shared_ptr prior(
-                new JacobianFactor(key_value.first, A, b, model));
-            dampedFactorGraph.push_back(prior);
-          }
-        }
+        dampedSystem->setPriors(lambda, delta_);
         gttoc(damp);
         result.intermediateSteps++;
 
         gttic(solve);
         // Solve Damped Gaussian Factor Graph
-        newDelta = dampedFactorGraph.optimize(ordering_,
-            parameters_.getEliminationFunction());
+        newDelta = dampedSystem->solve(parameters_.getEliminationFunction());
         // update the evalpoint with the new delta
         evalpoint = theta_.retract(newDelta);
         gttoc(solve);
 
         // Evaluate the new error
         gttic(compute_error);
-        double error = factors_.error(evalpoint);
+        double error = parallelError(factors_, evalpoint);
         gttoc(compute_error);
 
         if (error < result.error) {
@@ -312,11 +476,34 @@ void BatchFixedLagSmoother::marginalize(const KeyVector& marginalizeKeys) {
   // adds the linearized factors back in.
 
   // Identify all of the factors involving any marginalized variable. These must be removed.
+  // Only these factors are linearized and eliminated to compute the marginal factors on the
+  // separator, through the factor index rather than an index of the whole graph.
   set<size_t> removedFactorSlots;
-  const VariableIndex variableIndex(factors_);
   for(Key key: marginalizeKeys) {
-    const auto& slots = variableIndex[key];
-    removedFactorSlots.insert(slots.begin(), slots.end());
+    const auto slots = factorIndex_.find(key);
+    if (slots != factorIndex_.end())
+      removedFactorSlots.insert(slots->second.begin(), slots->second.end());
+  }
+
+  // When sparsifying, the earlier marginal factors on the separator are replaced as well, so that
+  // the separator is covered by a single tree instead of an accumulation of trees
+  if (sparsifyMarginals_) {
+    KeySet separatorKeys;
+    for(size_t slot: removedFactorSlots) {
+      if (factors_.at(slot)) {
+        separatorKeys.insert(factors_.at(slot)->begin(), factors_.at(slot)->end());
+      }
+    }
+    for(Key key: marginalizeKeys) {
+      separatorKeys.erase(key);
+    }
+    for(size_t slot: marginalFactorSlots_) {
+      const auto& factor = factors_.at(slot);
+      if (all_of(factor->begin(), factor->end(),
+          [&](Key key) { return separatorKeys.exists(key); })) {
+        removedFactorSlots.insert(slot);
+      }
+    }
   }
 
   // Add the removed factors to a factor graph
@@ -328,8 +515,16 @@ void BatchFixedLagSmoother::marginalize(const KeyVector& marginalizeKeys) {
   }
 
   // Calculate marginal factors on the remaining keys
-  NonlinearFactorGraph marginalFactors = CalculateMarginalFactors(
-      removedFactors, theta_, marginalizeKeys, parameters_.getEliminationFunction());
+  NonlinearFactorGraph marginalFactors;
+  if (sparsifyMarginals_) {
+    const GaussianFactorGraph marginalLinearFactors = CalculateMarginalFactors(
+        *removedFactors.linearize(theta_), marginalizeKeys, parameters_.getEliminationFunction());
+    marginalFactors = LinearContainerFactor::ConvertLinearGraph(
+        SparsifyMarginalFactors(marginalLinearFactors), theta_);
+  } else {
+    marginalFactors = CalculateMarginalFactors(
+        removedFactors, theta_, marginalizeKeys, parameters_.getEliminationFunction());
+  }
 
   // Remove marginalized factors from the factor graph
   removeFactors(removedFactorSlots);
@@ -338,7 +533,10 @@ void BatchFixedLagSmoother::marginalize(const KeyVector& marginalizeKeys) {
   eraseKeys(marginalizeKeys);
 
   // Insert the new marginal factors
-  insertFactors(marginalFactors);
+  const vector<size_t> marginalSlots = insertFactors(marginalFactors);
+  if (sparsifyMarginals_) {
+    marginalFactorSlots_.insert(marginalSlots.begin(), marginalSlots.end());
+  }
 }
 
 /* ************************************************************************* */
@@ -416,6 +614,122 @@ GaussianFactorGraph BatchFixedLagSmoother::CalculateMarginalFactors(
   }
 }
 
+/* ************************************************************************* */
+GaussianFactorGraph BatchFixedLagSmoother::SparsifyMarginalFactors(
+    const GaussianFactorGraph& marginalFactors) {
+  // A tree over at most two variables is exact
+  const KeyVector keys = marginalFactors.keyVector();
+  const size_t n = keys.size();
+  if (n <= 2) {
+    return marginalFactors;
+  }
+
+  // Recover the mean and covariance of the marginal from its information form
+  const Ordering ordering(keys);
+  const Matrix augmented = marginalFactors.augmentedHessian(ordering);
+  const size_t dim = augmented.rows() - 1;
+  const Eigen::LLT<Matrix> information(augmented.topLeftCorner(dim, dim));
+  if (information.info() != Eigen::Success || information.rcond() < 1e-12) {
+    return marginalFactors;
+  }
+  const Matrix covariance = information.solve(Matrix::Identity(dim, dim));
+  const Vector mean = information.solve(augmented.topRightCorner(dim, 1));
+
+  const std::map<Key, size_t> dims = marginalFactors.getKeyDimMap();
+  vector<size_t> offsets(n), sizes(n);
+  for(size_t i = 0, offset = 0; i < n; ++i) {
+    offsets[i] = offset;
+    sizes[i] = dims.at(keys[i]);
+    offset += sizes[i];
+  }
+  auto block = [&](size_t i, size_t j) {
+    return covariance.block(offsets[i], offsets[j], sizes[i], sizes[j]);
+  };
+  auto logDet = [](const Matrix& m) {
+    return 2.0 * Eigen::LLT<Matrix>(m).matrixLLT().diagonal().array().log().sum();
+  };
+
+  // Weigh every pair of variables with their mutual information
+  vector<double> logDets(n);
+  for(size_t i = 0; i < n; ++i) {
+    logDets[i] = logDet(block(i, i));
+  }
+  vector<tuple<double, size_t, size_t> > edges;
+  edges.reserve(n * (n - 1) / 2);
+  for(size_t i = 0; i < n; ++i) {
+    for(size_t j = i + 1; j < n; ++j) {
+      Matrix joint(sizes[i] + sizes[j], sizes[i] + sizes[j]);
+      joint << block(i, i), block(i, j), block(j, i), block(j, j);
+      const double mutualInformation = 0.5 * (logDets[i] + logDets[j] - logDet(joint));
+      if (mutualInformation > 0.0) {
+        edges.emplace_back(mutualInformation, i, j);
+      }
+    }
+  }
+
+  // Kruskal's algorithm for the maximum spanning forest
+  sort(edges.begin(), edges.end(), greater<tuple<double, size_t, size_t> >());
+  vector<size_t> components(n);
+  iota(components.begin(), components.end(), 0);
+  auto find = [&](size_t i) {
+    while (components[i] != i) {
+      i = components[i] = components[components[i]];
+    }
+    return i;
+  };
+  vector<vector<size_t> > neighbors(n);
+  for(const auto& edge: edges) {
+    const size_t i = get<1>(edge), j = get<2>(edge);
+    const size_t ci = find(i), cj = find(j);
+    if (ci != cj) {
+      components[ci] = cj;
+      neighbors[i].push_back(j);
+      neighbors[j].push_back(i);
+    }
+  }
+
+  // Whiten (x - mu) with the square root information of a covariance
+  auto sqrtInformation = [](const Matrix& cov) -> Matrix {
+    const Eigen::LLT<Matrix> llt(cov);
+    return llt.matrixL().solve(Matrix::Identity(cov.rows(), cov.cols()));
+  };
+
+  // Factor every tree as a root marginal and the conditionals of the children on their parents
+  GaussianFactorGraph sparseFactors;
+  vector<bool> visited(n, false);
+  for(size_t root = 0; root < n; ++root) {
+    if (visited[root]) {
+      continue;
+    }
+    visited[root] = true;
+    const Matrix R = sqrtInformation(block(root, root));
+    sparseFactors.emplace_shared<JacobianFactor>(keys[root], R,
+        R * mean.segment(offsets[root], sizes[root]));
+
+    vector<size_t> stack(1, root);
+    while (!stack.empty()) {
+      const size_t parent = stack.back();
+      stack.pop_back();
+      for(size_t child: neighbors[parent]) {
+        if (visited[child]) {
+          continue;
+        }
+        visited[child] = true;
+        stack.push_back(child);
+
+        // x_child = A x_parent + N(mu_child - A mu_parent, conditional covariance)
+        const Matrix A = block(parent, parent).llt().solve(block(parent, child)).transpose();
+        const Matrix conditional = block(child, child) - A * block(parent, child);
+        const Matrix Rc = sqrtInformation(conditional);
+        const Vector b = mean.segment(offsets[child], sizes[child])
+            - A * mean.segment(offsets[parent], sizes[parent]);
+        sparseFactors.emplace_shared<JacobianFactor>(keys[child], Rc, keys[parent], -Rc * A, Rc * b);
+      }
+    }
+  }
+  return sparseFactors;
+}
+
 /* ************************************************************************* */
 NonlinearFactorGraph BatchFixedLagSmoother::CalculateMarginalFactors(
     const NonlinearFactorGraph& graph, const Values& theta, const KeyVector& keys,
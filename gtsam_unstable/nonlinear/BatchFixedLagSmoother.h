@@ -34,8 +34,9 @@ public:
   typedef boost::shared_ptr<BatchFixedLagSmoother> shared_ptr;
 
   /** default constructor */
-  BatchFixedLagSmoother(double smootherLag = 0.0, const LevenbergMarquardtParams& parameters = LevenbergMarquardtParams(), bool enforceConsistency = true) :
-    FixedLagSmoother(smootherLag), parameters_(parameters), enforceConsistency_(enforceConsistency) { };
+  BatchFixedLagSmoother(double smootherLag = 0.0, const LevenbergMarquardtParams& parameters = LevenbergMarquardtParams(), bool enforceConsistency = true,
+      bool sparsifyMarginals = false) :
+    FixedLagSmoother(smootherLag), parameters_(parameters), enforceConsistency_(enforceConsistency), sparsifyMarginals_(sparsifyMarginals) { };
 
   /** destructor */
   virtual ~BatchFixedLagSmoother() { };
@@ -117,6 +118,12 @@ public:
       const NonlinearFactorGraph& graph, const Values& theta, const KeyVector& keys,
       const GaussianFactorGraph::Eliminate& eliminateFunction = EliminatePreferCholesky);
 
+  /// Approximate marginal factors by a Chow-Liu tree: one unary factor per tree root and one
+  /// pairwise factor per tree edge, keeping the mean and the marginals of single variables and of
+  /// the edges. The tree maximizes the mutual information of its edges, which minimizes the KL
+  /// divergence to the marginal. Returns the input if its information matrix is singular.
+  static GaussianFactorGraph SparsifyMarginalFactors(const GaussianFactorGraph& marginalFactors);
+
 #ifdef GTSAM_ALLOW_DEPRECATED_SINCE_V4
   static NonlinearFactorGraph calculateMarginalFactors(
       const NonlinearFactorGraph& graph, const Values& theta, const std::set<Key>& keys,
@@ -139,6 +146,11 @@ protected:
    * smoothing window. This idea is from ??? TODO: Look up paper reference **/
   bool enforceConsistency_;
 
+  /** A flag indicating if marginal factors are sparsified with SparsifyMarginalFactors. The marginal
+   * on the separator then stays a tree of pairwise factors instead of a dense factor growing with
+   * long-lived variables. **/
+  bool sparsifyMarginals_;
+
   /** The nonlinear factors **/
   NonlinearFactorGraph factors_;
 
@@ -160,8 +172,14 @@ protected:
   /** A cross-reference structure to allow efficient factor lookups by key **/
   FactorIndex factorIndex_;
 
-  /** Augment the list of factors with a set of new factors */
-  void insertFactors(const NonlinearFactorGraph& newFactors);
+  /** The variables of the new factors passed to update() since the ordering was last updated **/
+  KeySet newFactorKeys_;
+
+  /** The slots of the sparsified marginal factors **/
+  std::set<size_t> marginalFactorSlots_;
+
+  /** Augment the list of factors with a set of new factors, returning their slots */
+  std::vector<size_t> insertFactors(const NonlinearFactorGraph& newFactors);
 
   /** Remove factors from the list of factors by slot index */
   void removeFactors(const std::set<size_t>& deleteFactors);
@@ -169,10 +187,13 @@ protected:
   /** Erase any keys associated with timestamps before the provided time */
   void eraseKeys(const KeyVector& keys);
 
-  /** Use colamd to update into an efficient ordering */
-  void reorder(const KeyVector& marginalizeKeys = KeyVector());
+  /** Update the ordering with incremental colamd, only reordering the
+   * variables eliminated after the variables of the new factors */
+  void reorder();
 
-  /** Optimize the current graph using a modified version of L-M */
+  /** Optimize the current graph using a modified version of L-M. The damped
+   * linear system has the same structure in every iteration, so its junction
+   * tree is built once per update. */
   Result optimize();
 
   /** Marginalize out selected variables */
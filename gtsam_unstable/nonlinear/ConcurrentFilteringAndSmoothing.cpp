@@ -13,7 +13,8 @@
  * @file    ConcurrentFilteringAndSmoothing.cpp
  * @brief   Base classes for the 'filter' and 'smoother' portion of the Concurrent
  *          Filtering and Smoothing architecture, as well as an external synchronization
- *          function. These classes act as an interface only.
+ *          function and a runtime running the smoother on its own thread. The base
+ *          classes act as an interface only.
  * @author  Stephen Williams
  */
 
@@ -22,6 +23,7 @@
 #include <gtsam_unstable/nonlinear/ConcurrentFilteringAndSmoothing.h>
 #include <gtsam/nonlinear/LinearContainerFactor.h>
 
+
 namespace gtsam {
 
 /* ************************************************************************* */
@@ -48,6 +50,120 @@ void synchronize(ConcurrentFilter& filter, ConcurrentSmoother& smoother) {
   smoother.postsync();
 }
 
+/* ************************************************************************* */
+ConcurrentFilterSmootherRuntime::ConcurrentFilterSmootherRuntime(ConcurrentFilter& filter,
+    ConcurrentSmoother& smoother, const UpdateFunction& updateSmoother) :
+    filter_(filter), smoother_(smoother), updateSmoother_(updateSmoother),
+    smootherHalf_(nullptr), filterHalf_(nullptr), stopping_(false), failed_(false),
+    synchronizations_(0) {
+  thread_ = std::thread(&ConcurrentFilterSmootherRuntime::run, this);
+}
+
+/* ************************************************************************* */
+ConcurrentFilterSmootherRuntime::~ConcurrentFilterSmootherRuntime() {
+  try {
+    stop();
+  } catch (...) {
+    // Errors of the smoother thread can only be reported by stop()
+  }
+}
+
+/* ************************************************************************* */
+bool ConcurrentFilterSmootherRuntime::synchronizeFilter() {
+  rethrowSmootherError();
+  std::unique_ptr<SmootherHalf> smootherHalf(smootherHalf_.exchange(nullptr));
+  if (!smootherHalf)
+    return false;
+
+  gttic(synchronize_filter);
+  std::unique_ptr<FilterHalf> filterHalf(new FilterHalf);
+  filter_.presync();
+  filter_.synchronize(smootherHalf->summarizedFactors, smootherHalf->separatorValues);
+  filter_.getSmootherFactors(filterHalf->smootherFactors, filterHalf->smootherValues);
+  filter_.getSummarizedFactors(filterHalf->summarizedFactors, filterHalf->rootValues);
+  filter_.postsync();
+  gttoc(synchronize_filter);
+
+  // Hand the filter half to the smoother thread, which waits for it
+  filterHalf_.store(filterHalf.release());
+  notifySmoother();
+  ++synchronizations_;
+  return true;
+}
+
+/* ************************************************************************* */
+void ConcurrentFilterSmootherRuntime::stop() {
+  if (thread_.joinable()) {
+    stopping_ = true;
+    notifySmoother();
+    thread_.join();
+    // A summarization the filter did not pick up is dropped
+    delete smootherHalf_.exchange(nullptr);
+  }
+  rethrowSmootherError();
+}
+
+/* ************************************************************************* */
+void ConcurrentFilterSmootherRuntime::run() {
+  try {
+    while (!stopping_) {
+      updateSmoother_();
+
+      // Offer the smoother summarization to the filter
+      std::unique_ptr<SmootherHalf> smootherHalf(new SmootherHalf);
+      smoother_.presync();
+      smoother_.getSummarizedFactors(smootherHalf->summarizedFactors,
+          smootherHalf->separatorValues);
+      smootherHalf_.store(smootherHalf.release());
+
+      // Complete the synchronization once the filter answered
+      const std::unique_ptr<FilterHalf> filterHalf = waitForFilterHalf();
+      if (!filterHalf) {
+        // Stopped before the filter answered: close the synchronization
+        // started by presync without any filter factors
+        smoother_.postsync();
+        break;
+      }
+      gttic(synchronize_smoother);
+      smoother_.synchronize(filterHalf->smootherFactors, filterHalf->smootherValues,
+          filterHalf->summarizedFactors, filterHalf->rootValues);
+      smoother_.postsync();
+      gttoc(synchronize_smoother);
+    }
+  } catch (...) {
+    error_ = std::current_exception();
+    failed_ = true;
+  }
+}
+
+/* ************************************************************************* */
+std::unique_ptr<ConcurrentFilterSmootherRuntime::FilterHalf>
+ConcurrentFilterSmootherRuntime::waitForFilterHalf() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    std::unique_ptr<FilterHalf> filterHalf(filterHalf_.exchange(nullptr));
+    if (filterHalf || stopping_)
+      return filterHalf;
+    filterHalfPosted_.wait(lock);
+  }
+}
+
+/* ************************************************************************* */
+void ConcurrentFilterSmootherRuntime::notifySmoother() {
+  // Taking the lock once orders the notification after the smoother thread
+  // either checked the mailbox before it was filled, and is now waiting, or
+  // will check it after, so the wakeup cannot be lost. The smoother thread only
+  // holds the lock while checking, so this does not make the filter wait.
+  { std::lock_guard<std::mutex> lock(mutex_); }
+  filterHalfPosted_.notify_one();
+}
+
+/* ************************************************************************* */
+void ConcurrentFilterSmootherRuntime::rethrowSmootherError() const {
+  if (failed_)
+    std::rethrow_exception(error_);
+}
+
 namespace internal {
 
 /* ************************************************************************* */
@@ -13,7 +13,8 @@
  * @file    ConcurrentFilteringAndSmoothing.h
  * @brief   Base classes for the 'filter' and 'smoother' portion of the Concurrent
  *          Filtering and Smoothing architecture, as well as an external synchronization
- *          function. These classes act as an interface only.
+ *          function and a runtime running the smoother on its own thread. The base
+ *          classes act as an interface only.
  * @author  Stephen Williams
  */
 
@@ -25,6 +26,14 @@
 #include <gtsam/nonlinear/Values.h>
 #include <gtsam/linear/GaussianFactorGraph.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 namespace gtsam {
 
 // Forward declare the Filter and Smoother classes for the 'synchronize' function
@@ -147,6 +156,101 @@ public:
 
 }; // ConcurrentSmoother
 
+/**
+ * Runs a smoother on its own thread, concurrently with a filter updated on the caller's thread,
+ * and synchronizes them without pausing the filter.
+ *
+ * The smoother thread repeatedly updates the smoother and offers its summarization to the filter.
+ * Calling synchronizeFilter() after each filter update applies a pending smoother summarization
+ * to the filter, and hands the smoother factors and the filter summarization back to the
+ * smoother thread, which completes the synchronization. This is the same exchange as
+ * synchronize(), split into a filter half and a smoother half. The halves are passed through
+ * one single-slot mailbox per direction with atomic pointer exchanges: each side fills its own
+ * buffer and then publishes it, so the filter never waits for a smoother update. Since the
+ * exchanges alternate, one slot per direction suffices. After publishing, the filter briefly
+ * takes a mutex to wake the smoother thread; the smoother thread only holds it while checking
+ * its mailbox.
+ *
+ * The filter and smoother must outlive the runtime. Until stop() returns, the smoother may only
+ * be accessed by the runtime, and the filter only from the thread calling synchronizeFilter().
+ */
+class GTSAM_UNSTABLE_EXPORT ConcurrentFilterSmootherRuntime {
+public:
+  /// A function running one update of the smoother
+  typedef std::function<void()> UpdateFunction;
+
+  /** Start the smoother thread, which updates the smoother with updateSmoother */
+  ConcurrentFilterSmootherRuntime(ConcurrentFilter& filter, ConcurrentSmoother& smoother,
+      const UpdateFunction& updateSmoother);
+
+  /** Start the smoother thread, which updates the smoother without new factors */
+  template<class SMOOTHER>
+  ConcurrentFilterSmootherRuntime(ConcurrentFilter& filter, SMOOTHER& smoother) :
+      ConcurrentFilterSmootherRuntime(filter, smoother, [&smoother]() { smoother.update(); }) {}
+
+  /** Stop the smoother thread */
+  ~ConcurrentFilterSmootherRuntime();
+
+  ConcurrentFilterSmootherRuntime(const ConcurrentFilterSmootherRuntime&) = delete;
+  ConcurrentFilterSmootherRuntime& operator=(const ConcurrentFilterSmootherRuntime&) = delete;
+
+  /**
+   * Synchronize the filter if the smoother offered its summarization since the last call, and
+   * return whether it did. Call this from the filter thread between filter updates. It never
+   * blocks; if the smoother is still updating, the filter simply continues.
+   * @throw any exception thrown by the smoother thread
+   */
+  bool synchronizeFilter();
+
+  /**
+   * Stop the smoother thread after its current update, from the filter thread. Factors the
+   * filter already handed over are applied to the smoother, but not yet optimized.
+   * @throw any exception thrown by the smoother thread
+   */
+  void stop();
+
+  /** The number of completed synchronizations of the filter */
+  size_t synchronizations() const { return synchronizations_.load(); }
+
+private:
+  /// The summarization of the smoother, for the filter
+  struct SmootherHalf {
+    NonlinearFactorGraph summarizedFactors;
+    Values separatorValues;
+  };
+
+  /// The new smoother factors and summarization of the filter, for the smoother
+  struct FilterHalf {
+    NonlinearFactorGraph smootherFactors;
+    Values smootherValues;
+    NonlinearFactorGraph summarizedFactors;
+    Values rootValues;
+  };
+
+  ConcurrentFilter& filter_;
+  ConcurrentSmoother& smoother_;
+  UpdateFunction updateSmoother_;
+
+  std::atomic<SmootherHalf*> smootherHalf_;
+  std::atomic<FilterHalf*> filterHalf_;
+  std::atomic<bool> stopping_;
+  std::atomic<bool> failed_;
+  std::atomic<size_t> synchronizations_;
+  std::exception_ptr error_;
+
+  // Only the smoother thread waits on these, the filter only notifies
+  // through notifySmoother()
+  std::mutex mutex_;
+  std::condition_variable filterHalfPosted_;
+
+  std::thread thread_;
+
+  void run();
+  std::unique_ptr<FilterHalf> waitForFilterHalf();
+  void notifySmoother();
+  void rethrowSmootherError() const;
+}; // ConcurrentFilterSmootherRuntime
+
 namespace internal {
 
   /** Calculate the marginal on the specified keys, returning a set of LinearContainerFactors.
@@ -22,10 +22,14 @@
 #include <gtsam/inference/Key.h>
 #include <gtsam/inference/Ordering.h>
 #include <gtsam/geometry/Point2.h>
+#include <gtsam/geometry/Pose2.h>
 #include <gtsam/linear/GaussianBayesNet.h>
 #include <gtsam/linear/GaussianFactorGraph.h>
+#include <gtsam/inference/Symbol.h>
+#include <gtsam/nonlinear/LinearContainerFactor.h>
 #include <gtsam/nonlinear/NonlinearFactorGraph.h>
 #include <gtsam/nonlinear/Values.h>
+#include <gtsam/sam/BearingRangeFactor.h>
 #include <gtsam/slam/PriorFactor.h>
 #include <gtsam/slam/BetweenFactor.h>
 
@@ -238,6 +242,182 @@ TEST( BatchFixedLagSmoother, Example )
   }
 }
 
+/* ************************************************************************* */
+TEST( BatchFixedLagSmoother, NonlinearWithinLag )
+{
+  // Without marginalization, the smoother reuses the structure of the damped
+  // system over several nonlinear iterations and converges to the batch solution
+  SharedDiagonal odometerNoise = noiseModel::Diagonal::Sigmas(Vector3(0.1, 0.1, 0.05));
+  LevenbergMarquardtParams parameters;
+  parameters.maxIterations = 50;
+  parameters.relativeErrorTol = 1e-10;
+  parameters.absoluteErrorTol = 1e-10;
+  BatchFixedLagSmoother smoother(100.0, parameters);
+  const Pose2 odometry(1.0, 0.0, 0.3);
+  const Pose2 loop = odometry * odometry * odometry * odometry * odometry;
+
+  NonlinearFactorGraph fullgraph;
+  Values fullinit;
+  for (size_t i = 0; i < 20; ++i) {
+    NonlinearFactorGraph newFactors;
+    Values newValues;
+    BatchFixedLagSmoother::KeyTimestampMap newTimestamps;
+    if (i == 0)
+      newFactors.push_back(PriorFactor<Pose2>(i, Pose2(), odometerNoise));
+    else
+      newFactors.push_back(BetweenFactor<Pose2>(i - 1, i, odometry, odometerNoise));
+    if (i >= 5 && i % 5 == 0)
+      newFactors.push_back(BetweenFactor<Pose2>(i - 5, i, loop, odometerNoise));
+    newValues.insert(i, Pose2(i * 0.9, 0.2 * i, 0.25 * i));
+    newTimestamps[i] = double(i);
+    fullgraph.push_back(newFactors);
+    fullinit.insert(newValues);
+    smoother.update(newFactors, newValues, newTimestamps);
+  }
+
+  Values expected = LevenbergMarquardtOptimizer(fullgraph, fullinit, parameters).optimize();
+  EXPECT(assert_equal(expected, smoother.calculateEstimate(), 1e-4));
+  EXPECT_LONGS_EQUAL(20, smoother.getOrdering().size());
+}
+
+/* ************************************************************************* */
+// A prior on a scalar that is only active while the scalar is above one
+class GatedPrior : public NoiseModelFactor1<double> {
+public:
+  GatedPrior(Key key) : NoiseModelFactor1<double>(noiseModel::Isotropic::Sigma(1, 0.1), key) {}
+  virtual bool active(const Values& values) const {
+    return values.at<double>(key()) > 1.0;
+  }
+  virtual Vector evaluateError(const double& x,
+      boost::optional<Matrix&> H = boost::none) const {
+    if (H) *H = I_1x1;
+    return (Vector(1) << x).finished();
+  }
+};
+
+TEST( BatchFixedLagSmoother, FactorBecomesInactive )
+{
+  // The gated prior linearizes to a null factor once the estimate drops below
+  // one, so the damped system has to be built again for the later iterations
+  LevenbergMarquardtParams parameters;
+  parameters.lambdaInitial = 1e-5;
+  BatchFixedLagSmoother smoother(100.0, parameters);
+
+  NonlinearFactorGraph newFactors;
+  newFactors.push_back(PriorFactor<double>(0, 0.5, noiseModel::Isotropic::Sigma(1, 1.0)));
+  newFactors.push_back(boost::make_shared<GatedPrior>(0));
+  Values newValues;
+  newValues.insert(0, 5.0);
+  BatchFixedLagSmoother::KeyTimestampMap newTimestamps;
+  newTimestamps[0] = 0.0;
+  smoother.update(newFactors, newValues, newTimestamps);
+
+  EXPECT_DOUBLES_EQUAL(0.5, smoother.calculateEstimate<double>(0), 1e-6);
+}
+
+/* ************************************************************************* */
+TEST( BatchFixedLagSmoother, SparsifyMarginalFactors )
+{
+  // A loopy Gaussian over four variables
+  const SharedDiagonal unit = noiseModel::Unit::Create(2);
+  GaussianFactorGraph dense;
+  dense.add(0, Matrix2::Identity(), Vector2(1.0, 2.0), unit);
+  dense.add(0, (Matrix2() << 1.0, 0.2, 0.0, 1.0).finished(), 1, -Matrix2::Identity(), Vector2(0.5, 0.0), unit);
+  dense.add(1, (Matrix2() << 2.0, 0.0, 0.3, 1.0).finished(), 2, -Matrix2::Identity(), Vector2(0.0, 0.5), unit);
+  dense.add(2, Matrix2::Identity(), 3, (Matrix2() << -1.0, 0.1, 0.0, -0.5).finished(), Vector2(1.0, 1.0), unit);
+  dense.add(3, Matrix2::Identity(), 0, -0.5 * Matrix2::Identity(), Vector2(0.0, -1.0), unit);
+  dense.add(1, 0.5 * Matrix2::Identity(), 3, -0.5 * Matrix2::Identity(), Vector2(0.2, 0.2), unit);
+
+  // A tree: one unary factor and three pairwise factors
+  GaussianFactorGraph sparse = BatchFixedLagSmoother::SparsifyMarginalFactors(dense);
+  EXPECT_LONGS_EQUAL(4, sparse.size());
+  EXPECT_LONGS_EQUAL(1, count_if(sparse.begin(), sparse.end(),
+      [](const GaussianFactor::shared_ptr& factor) { return factor->size() == 1; }));
+  for (const GaussianFactor::shared_ptr& factor: sparse)
+    EXPECT(factor->size() <= 2);
+
+  // with the same mean and marginals of the variables
+  EXPECT(assert_equal(dense.optimize(), sparse.optimize(), 1e-9));
+  const Ordering ordering(dense.keyVector());
+  const Matrix denseCovariance = dense.hessian(ordering).first.inverse();
+  const Matrix sparseCovariance = sparse.hessian(ordering).first.inverse();
+  for (size_t i = 0; i < 4; ++i)
+    EXPECT(assert_equal(Matrix(denseCovariance.block<2, 2>(2 * i, 2 * i)),
+        Matrix(sparseCovariance.block<2, 2>(2 * i, 2 * i)), 1e-9));
+
+  // A Gaussian that is a tree already is reproduced exactly
+  GaussianFactorGraph chain;
+  chain.add(0, Matrix2::Identity(), Vector2(1.0, 2.0), unit);
+  chain.add(0, (Matrix2() << 1.0, 0.2, 0.0, 1.0).finished(), 1, -Matrix2::Identity(), Vector2(0.5, 0.0), unit);
+  chain.add(1, (Matrix2() << 2.0, 0.0, 0.3, 1.0).finished(), 2, -Matrix2::Identity(), Vector2(0.0, 0.5), unit);
+  const Ordering chainOrdering(chain.keyVector());
+  sparse = BatchFixedLagSmoother::SparsifyMarginalFactors(chain);
+  EXPECT(assert_equal(chain.hessian(chainOrdering).first, sparse.hessian(chainOrdering).first, 1e-9));
+  EXPECT(assert_equal(chain.optimize(), sparse.optimize(), 1e-9));
+
+  // A singular marginal is returned unchanged
+  GaussianFactorGraph singular = chain;
+  singular.add(3, Matrix2::Identity(), 0, -Matrix2::Identity(), Vector2(0.0, 0.0), unit);
+  singular.add(4, Vector2(1.0, 0.0).transpose(), Vector1(0.0), noiseModel::Unit::Create(1));
+  EXPECT(assert_equal(singular, BatchFixedLagSmoother::SparsifyMarginalFactors(singular)));
+}
+
+/* ************************************************************************* */
+TEST( BatchFixedLagSmoother, SparsifiedMarginals )
+{
+  // Poses observe the same landmarks during the whole run, so the separator of every
+  // marginalization contains all landmarks
+  using symbol_shorthand::L;
+  using symbol_shorthand::X;
+  typedef BearingRangeFactor<Pose2, Point2> Measurement;
+  SharedDiagonal odometerNoise = noiseModel::Diagonal::Sigmas(Vector3(0.1, 0.1, 0.05));
+  SharedDiagonal measurementNoise = noiseModel::Diagonal::Sigmas(Vector2(0.05, 0.2));
+  const Pose2 odometry(1.0, 0.0, 0.1);
+  const Point2 landmarks[] = {Point2(5.0, 5.0), Point2(10.0, -3.0), Point2(-2.0, 6.0), Point2(8.0, 8.0)};
+
+  BatchFixedLagSmoother dense(3.0), sparse(3.0, LevenbergMarquardtParams(), true, true);
+  Pose2 pose;
+  size_t nrMarginalFactors = 0;
+  for (size_t i = 0; i < 30; ++i) {
+    NonlinearFactorGraph newFactors;
+    Values newValues;
+    BatchFixedLagSmoother::KeyTimestampMap newTimestamps;
+    if (i == 0) {
+      newFactors.push_back(PriorFactor<Pose2>(X(0), Pose2(), odometerNoise));
+      for (size_t j = 0; j < 4; ++j)
+        newValues.insert(L(j), landmarks[j]);
+    } else {
+      newFactors.push_back(BetweenFactor<Pose2>(X(i - 1), X(i), odometry, odometerNoise));
+      pose = pose.compose(odometry);
+    }
+    for (size_t j = 0; j < 4; ++j) {
+      newFactors.push_back(Measurement(X(i), L(j), pose.bearing(landmarks[j]),
+          pose.range(landmarks[j]), measurementNoise));
+      newTimestamps[L(j)] = double(i);
+    }
+    newValues.insert(X(i), pose.compose(Pose2(0.1, -0.1, 0.02)));
+    newTimestamps[X(i)] = double(i);
+    dense.update(newFactors, newValues, newTimestamps);
+    sparse.update(newFactors, newValues, newTimestamps);
+
+    // The marginal on the separator of the oldest pose and the landmarks is a tree
+    nrMarginalFactors = 0;
+    for (const NonlinearFactor::shared_ptr& factor: sparse.getFactors()) {
+      if (boost::dynamic_pointer_cast<LinearContainerFactor>(factor)) {
+        ++nrMarginalFactors;
+        EXPECT(factor->size() <= 2);
+      }
+    }
+    EXPECT(nrMarginalFactors <= 5);
+  }
+  EXPECT_LONGS_EQUAL(5, nrMarginalFactors);
+
+  // The sparse marginals keep the mean of the dense ones, which is the truth here
+  EXPECT(assert_equal(dense.calculateEstimate(), sparse.calculateEstimate(), 1e-6));
+  EXPECT(assert_equal(pose, sparse.calculateEstimate<Pose2>(X(29)), 1e-6));
+  EXPECT(assert_equal(landmarks[1], sparse.calculateEstimate<Point2>(L(1)), 1e-6));
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
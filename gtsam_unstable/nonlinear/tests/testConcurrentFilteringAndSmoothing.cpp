@@ -0,0 +1,157 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    testConcurrentFilteringAndSmoothing.cpp
+ * @brief   Unit tests for running the smoother concurrently with the filter
+ */
+
+#include <gtsam_unstable/nonlinear/ConcurrentBatchFilter.h>
+#include <gtsam_unstable/nonlinear/ConcurrentBatchSmoother.h>
+#include <gtsam/slam/PriorFactor.h>
+#include <gtsam/slam/BetweenFactor.h>
+#include <gtsam/geometry/Pose2.h>
+#include <gtsam/base/TestableAssertions.h>
+#include <CppUnitLite/TestHarness.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+using namespace gtsam;
+
+namespace {
+
+const Pose2 poseOdometry(1.0, 0.0, 0.1);
+const SharedDiagonal noisePrior = noiseModel::Isotropic::Sigma(3, 0.10);
+const SharedDiagonal noiseOdometry = noiseModel::Diagonal::Sigmas(Vector3(0.1, 0.1, 0.05));
+
+/* ************************************************************************* */
+Pose2 truth(size_t i) {
+  Pose2 pose;
+  for (size_t j = 0; j < i; ++j)
+    pose = pose.compose(poseOdometry);
+  return pose;
+}
+
+/* ************************************************************************* */
+// Add pose i to the filter, and move the poses older than lag to the smoother
+void addPose(size_t i, size_t lag, ConcurrentBatchFilter& filter) {
+  NonlinearFactorGraph factors;
+  if (i == 0)
+    factors.emplace_shared<PriorFactor<Pose2> >(0, Pose2(), noisePrior);
+  else
+    factors.emplace_shared<BetweenFactor<Pose2> >(i - 1, i, poseOdometry, noiseOdometry);
+  Values values;
+  values.insert(i, truth(i));
+  FastList<Key> keysToMove;
+  if (i > lag)
+    keysToMove.push_back(i - lag - 1);
+  filter.update(factors, values, keysToMove);
+}
+
+/* ************************************************************************* */
+// Counts the synchronizations the smoother took part in
+class CountingSmoother : public ConcurrentBatchSmoother {
+public:
+  std::atomic<size_t> presyncs, postsyncs;
+  CountingSmoother() : presyncs(0), postsyncs(0) {}
+  virtual void presync() { ++presyncs; ConcurrentBatchSmoother::presync(); }
+  virtual void postsync() { ++postsyncs; ConcurrentBatchSmoother::postsync(); }
+};
+
+} // end namespace
+
+/* ************************************************************************* */
+TEST( ConcurrentFilterSmootherRuntime, synchronize )
+{
+  ConcurrentBatchFilter filter;
+  ConcurrentBatchSmoother smoother;
+  const size_t lag = 3;
+  size_t i = 0;
+  {
+    ConcurrentFilterSmootherRuntime runtime(filter, smoother);
+
+    // Keep the filter running until it synchronized a few times
+    for (; i < 500 && runtime.synchronizations() < 5; ++i) {
+      addPose(i, lag, filter);
+      runtime.synchronizeFilter();
+      this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    EXPECT(runtime.synchronizations() >= 5);
+    runtime.stop();
+  }
+
+  // Hand the remaining moved poses over, and check nothing was lost
+  synchronize(filter, smoother);
+  smoother.update();
+  const Values smootherValues = smoother.getLinearizationPoint();
+  for (size_t j = 0; j + lag + 1 < i; ++j)
+    EXPECT(smootherValues.exists(j));
+
+  const Values smootherEstimate = smoother.calculateEstimate();
+  const Values filterEstimate = filter.calculateEstimate();
+  for (const Values::ConstKeyValuePair& keyValue: smootherEstimate)
+    EXPECT(assert_equal(truth(keyValue.key), smootherEstimate.at<Pose2>(keyValue.key), 1e-6));
+  for (const Values::ConstKeyValuePair& keyValue: filterEstimate)
+    EXPECT(assert_equal(truth(keyValue.key), filterEstimate.at<Pose2>(keyValue.key), 1e-6));
+}
+
+/* ************************************************************************* */
+TEST( ConcurrentFilterSmootherRuntime, smootherError )
+{
+  ConcurrentBatchFilter filter;
+  ConcurrentBatchSmoother smoother;
+  ConcurrentFilterSmootherRuntime runtime(filter, smoother,
+      []() { throw std::runtime_error("smoother failed"); });
+
+  // The error is reported to the filter thread
+  bool thrown = false;
+  for (size_t i = 0; i < 1000 && !thrown; ++i) {
+    try {
+      runtime.synchronizeFilter();
+      this_thread::sleep_for(chrono::milliseconds(1));
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+  }
+  EXPECT(thrown);
+  CHECK_EXCEPTION(runtime.stop(), std::runtime_error);
+  EXPECT_LONGS_EQUAL(0, runtime.synchronizations());
+}
+
+/* ************************************************************************* */
+TEST( ConcurrentFilterSmootherRuntime, stopDuringUpdate )
+{
+  ConcurrentBatchFilter filter;
+  CountingSmoother smoother;
+  std::atomic<bool> updating(false);
+  ConcurrentFilterSmootherRuntime runtime(filter, smoother, [&]() {
+    updating = true;
+    this_thread::sleep_for(chrono::milliseconds(20));
+  });
+
+  // Stop while the smoother is updating, before the filter ever answers
+  while (!updating)
+    this_thread::yield();
+  runtime.stop();
+
+  // The synchronization the smoother started after the update was closed
+  EXPECT(smoother.presyncs >= 1);
+  EXPECT_LONGS_EQUAL(smoother.presyncs, smoother.postsyncs);
+  EXPECT_LONGS_EQUAL(0, runtime.synchronizations());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
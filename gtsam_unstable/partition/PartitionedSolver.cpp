@@ -0,0 +1,138 @@
+/*
+ * PartitionedSolver.cpp
+ *
+ *  Description: solve a linear factor graph by eliminating the subgraphs of a
+ *               nested dissection in parallel, and their separators last
+ */
+
+#include <gtsam_unstable/partition/PartitionedSolver.h>
+#include <gtsam/linear/GaussianBayesTree.h>
+#include <gtsam/inference/EliminationStructure.h>
+#include <gtsam/inference/VariableIndex.h>
+#include <gtsam/base/timing.h>
+
+#include <gtsam/config.h> // for GTSAM_USE_TBB
+
+#include <boost/tuple/tuple.hpp>
+
+#ifdef GTSAM_USE_TBB
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_scheduler_init.h>
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace gtsam { namespace partition {
+
+  namespace {
+    // Run body(i) for i in [0, n) as TBB tasks, or serially without TBB
+    template <class BODY>
+    void parallelFor(size_t n, const BODY& body) {
+#ifdef GTSAM_USE_TBB
+      tbb::parallel_for(tbb::blocked_range<size_t>(0, n, 1),
+          [&](const tbb::blocked_range<size_t>& range) {
+            for (size_t i = range.begin(); i != range.end(); ++i)
+              body(i);
+          });
+#else
+      for (size_t i = 0; i < n; ++i)
+        body(i);
+#endif
+    }
+
+    // Number of subgraphs to aim for by default, four per TBB thread
+    size_t defaultNrPartitions() {
+#ifdef GTSAM_USE_TBB
+      return 4 * tbb::task_scheduler_init::default_num_threads();
+#else
+      return 1;
+#endif
+    }
+  }
+
+  /* ************************************************************************* */
+  PartitionedSolver::PartitionedSolver(const GaussianFactorGraph& graph, size_t nrPartitions) {
+    partition(graph, Ordering::MetisParallel(graph), nrPartitions);
+  }
+
+  /* ************************************************************************* */
+  PartitionedSolver::PartitionedSolver(const GaussianFactorGraph& graph, const Ordering& ordering,
+      size_t nrPartitions) {
+    partition(graph, ordering, nrPartitions);
+  }
+
+  /* ************************************************************************* */
+  void PartitionedSolver::partition(const GaussianFactorGraph& graph, const Ordering& ordering,
+      size_t nrPartitions) {
+    gttic(PartitionedSolver_partition);
+    static const size_t None = EliminationStructure::None;
+    const VariableIndex structure(graph);
+    if (ordering.size() != structure.size())
+      throw invalid_argument("PartitionedSolver: the ordering has to contain all variables of the graph");
+    const EliminationStructure etree(structure, ordering);
+
+    // Cut the elimination tree into subtrees, the nodes above them are separators
+    if (nrPartitions == 0)
+      nrPartitions = defaultNrPartitions();
+    const size_t n = ordering.size();
+    const vector<size_t> roots = etree.subtreeRoots(std::max<size_t>(1, n / nrPartitions));
+    const size_t separatorPartition = roots.size();
+    vector<size_t> labels(n, separatorPartition);
+    for (size_t p = 0; p < roots.size(); ++p)
+      labels[roots[p]] = p;
+    for (size_t j = n; j-- > 0;) {
+      const size_t parent = etree.parents()[j];
+      if (labels[j] == separatorPartition && parent != None)
+        labels[j] = labels[parent];
+    }
+
+    partitions_.assign(roots.size() + 1, Partition());
+    for (size_t j = 0; j < n; ++j)
+      partitions_[labels[j]].ordering.push_back(ordering[j]);
+    const vector<size_t>& firstColumns = etree.firstColumns();
+    for (size_t i = 0; i < graph.size(); ++i)
+      if (graph[i] && i < firstColumns.size() && firstColumns[i] != None)
+        partitions_[labels[firstColumns[i]]].factors.push_back(graph[i]);
+  }
+
+  /* ************************************************************************* */
+  VectorValues PartitionedSolver::optimize() const {
+    gttic(PartitionedSolver_optimize);
+    const size_t nrSubgraphs = partitions_.size() - 1;
+
+    // Eliminate every subgraph, which leaves a message on the separators
+    vector<GaussianBayesNet::shared_ptr> bayesNets(nrSubgraphs);
+    vector<GaussianFactorGraph::shared_ptr> messages(nrSubgraphs);
+    parallelFor(nrSubgraphs, [&](size_t p) {
+      boost::tie(bayesNets[p], messages[p]) =
+          partitions_[p].factors.eliminatePartialSequential(partitions_[p].ordering);
+    });
+
+    // Combine the messages with the separator factors and solve for the
+    // separators, by multifrontal elimination, which itself runs on TBB tasks
+    GaussianFactorGraph root = separators().factors;
+    for (const GaussianFactorGraph::shared_ptr& message : messages)
+      for (const GaussianFactor::shared_ptr& factor : *message)
+        if (factor && !factor->empty())
+          root.push_back(factor);
+    const VectorValues separatorSolution =
+        root.eliminateMultifrontal(separators().ordering)->optimize();
+
+    // Back-substitute into every subgraph
+    vector<VectorValues> solutions(nrSubgraphs);
+    parallelFor(nrSubgraphs, [&](size_t p) {
+      solutions[p] = bayesNets[p]->optimize(separatorSolution);
+    });
+
+    VectorValues result = separatorSolution;
+    for (size_t p = 0; p < nrSubgraphs; ++p)
+      for (const Key key : partitions_[p].ordering)
+        result.insert(key, solutions[p].at(key));
+    return result;
+  }
+
+}} //namespace
@@ -0,0 +1,67 @@
+/*
+ * PartitionedSolver.h
+ *
+ *  Description: solve a linear factor graph by eliminating the subgraphs of a
+ *               nested dissection in parallel, and their separators last
+ */
+
+#pragma once
+
+#include <gtsam/linear/GaussianBayesNet.h>
+#include <gtsam/linear/GaussianFactorGraph.h>
+#include <gtsam/linear/VectorValues.h>
+#include <gtsam/inference/Ordering.h>
+#include <gtsam_unstable/base/dllexport.h>
+
+#include <vector>
+
+namespace gtsam { namespace partition {
+
+  /**
+   * Solves a linear factor graph by nested dissection.  The elimination tree
+   * of a nested dissection ordering is cut into independent subtrees, which
+   * are subgraphs connected to each other only through the separators above
+   * them.  Every subgraph is eliminated on its own worker, and passes the
+   * factor it induces on the separators (its message) to the root, which
+   * combines all messages and solves for the separators.  The subgraphs are
+   * then back-substituted in parallel given the separator solution.  The
+   * subgraphs are TBB tasks, so without TBB everything runs serially.
+   *
+   * Workers exchange only these messages and the separator solution, so the
+   * partitions never share any other state.
+   */
+  class GTSAM_UNSTABLE_EXPORT PartitionedSolver {
+  public:
+    /** A partition: variables eliminated together, and the factors assigned to them */
+    struct Partition {
+      Ordering ordering;            ///< Variables of the partition, in elimination order
+      GaussianFactorGraph factors;  ///< Factors whose first eliminated variable is in the partition
+    };
+
+  private:
+    std::vector<Partition> partitions_;  // the subgraphs, and the separators last
+
+  public:
+    /**
+     * Partition a graph with a METIS nested dissection ordering.
+     * @param nrPartitions the number of subgraphs to aim for, 0 for four per TBB thread
+     */
+    explicit PartitionedSolver(const GaussianFactorGraph& graph, size_t nrPartitions = 0);
+
+    /** Partition a graph given an elimination ordering of all its variables */
+    PartitionedSolver(const GaussianFactorGraph& graph, const Ordering& ordering, size_t nrPartitions = 0);
+
+    /** The subgraphs, followed by the partition with the separators */
+    const std::vector<Partition>& partitions() const { return partitions_; }
+
+    /** The partition with the separators, which is eliminated last */
+    const Partition& separators() const { return partitions_.back(); }
+
+    /** Solve the graph, eliminating the subgraphs as parallel TBB tasks */
+    VectorValues optimize() const;
+
+  private:
+    void partition(const GaussianFactorGraph& graph, const Ordering& ordering, size_t nrPartitions);
+  };
+
+}} //namespace
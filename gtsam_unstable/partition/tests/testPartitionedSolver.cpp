@@ -0,0 +1,69 @@
+/*
+ * testPartitionedSolver.cpp
+ *
+ *  Description: unit tests for PartitionedSolver
+ */
+
+#include <CppUnitLite/TestHarness.h>
+
+#include <gtsam_unstable/partition/PartitionedSolver.h>
+#include <tests/smallExample.h>
+
+#include <set>
+
+using namespace std;
+using namespace gtsam;
+using namespace gtsam::partition;
+
+/* ************************************************************************* */
+TEST ( PartitionedSolver, partitions )
+{
+  const GaussianFactorGraph graph = example::planarGraph(10).first;
+  const PartitionedSolver solver(graph, Ordering::Metis(graph), 8);
+  CHECK(solver.partitions().size() > 2);
+
+  // every variable and every factor is in exactly one partition
+  set<Key> keys;
+  size_t nrVariables = 0, nrFactors = 0;
+  for (const PartitionedSolver::Partition& partition : solver.partitions()) {
+    keys.insert(partition.ordering.begin(), partition.ordering.end());
+    nrVariables += partition.ordering.size();
+    nrFactors += partition.factors.size();
+  }
+  LONGS_EQUAL(100, keys.size());
+  LONGS_EQUAL(100, nrVariables);
+  LONGS_EQUAL(graph.size(), nrFactors);
+
+  // the factors of a subgraph only involve its own variables and separators
+  const KeySet separators(solver.separators().ordering.begin(), solver.separators().ordering.end());
+  for (size_t p = 0; p + 1 < solver.partitions().size(); ++p) {
+    const PartitionedSolver::Partition& partition = solver.partitions()[p];
+    const KeySet own(partition.ordering.begin(), partition.ordering.end());
+    for (const Key key : partition.factors.keys())
+      CHECK(own.count(key) || separators.count(key));
+  }
+}
+
+/* ************************************************************************* */
+TEST ( PartitionedSolver, optimize )
+{
+  GaussianFactorGraph graph;
+  VectorValues xtrue;
+  boost::tie(graph, xtrue) = example::planarGraph(10);
+
+  const PartitionedSolver solver(graph, 8);
+  CHECK(assert_equal(xtrue, solver.optimize(), 1e-5));
+}
+
+/* ************************************************************************* */
+TEST ( PartitionedSolver, invalidOrdering )
+{
+  const GaussianFactorGraph graph = example::planarGraph(3).first;
+  Ordering ordering = Ordering::Colamd(graph);
+  ordering.pop_back();
+  CHECK_EXCEPTION(PartitionedSolver(graph, ordering), std::invalid_argument);
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -808,6 +808,49 @@ TEST(ISAM2, marginalCovariance)
   EXPECT(assert_equal(expected, actual));
 }
 
+/* ************************************************************************* */
+TEST(ISAM2, counters)
+{
+  ISAM2Params params(ISAM2GaussNewtonParams(0.001), 0.0, 1);
+  params.evaluateNonlinearError = true;
+  Values fullinit;
+  NonlinearFactorGraph fullgraph;
+  ISAM2 isam = createSlamlikeISAM2(fullinit, fullgraph, params);
+
+  // Relinearizing everything involves all factors
+  NonlinearFactorGraph newfactors;
+  newfactors += BetweenFactor<Pose2>(11, 12, Pose2(1.0, 0.0, 0.0), odoNoise);
+  Values init;
+  init.insert(12, Pose2(7.9, 0.1, 0.01));
+  const ISAM2Result result = isam.update(newfactors, init);
+  const PerformanceCounters& counters = result.counters;
+  EXPECT(counters.factorsRelinearized > 0);
+  EXPECT(counters.factorsRelinearized <= fullgraph.size());
+  EXPECT(counters.cliques > 0);
+  EXPECT(counters.maxCliqueSize >= 2);
+  EXPECT(counters.flops > 0);
+  EXPECT(counters.bytesAllocated > 0);
+  EXPECT(counters.linearizeTime >= 0);
+  EXPECT(counters.numericTime >= 0);
+  EXPECT(counters.errorTime >= 0);
+
+  // Without relinearization, only the new factor is linearized
+  params.relinearizeSkip = 1000;
+  ISAM2 isam2 = createSlamlikeISAM2(boost::none, boost::none, params);
+  const ISAM2Result result2 = isam2.update(newfactors, init);
+  EXPECT_LONGS_EQUAL(0, result2.counters.factorsRelinearized);
+  EXPECT(result2.counters.cliques > 0);
+  EXPECT(result2.counters.cliques < counters.cliques);
+
+  // Without caching, the affected factors are linearized again, except the new
+  // one, which is counted as it is added
+  params.cacheLinearizedFactors = false;
+  ISAM2 isam3 = createSlamlikeISAM2(boost::none, boost::none, params);
+  const ISAM2Result result3 = isam3.update(newfactors, init);
+  EXPECT_LONGS_EQUAL(result3.factorsRecalculated - 1,
+                     result3.counters.factorsRelinearized);
+}
+
 /* ************************************************************************* */
 TEST(ISAM2, calculate_nnz)
 {
@@ -0,0 +1,196 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    testISAM2Checkpoint.cpp
+ * @brief   Unit tests for checkpoints of ISAM2
+ */
+
+#include <gtsam/nonlinear/ISAM2Checkpoint.h>
+#include <gtsam/slam/BetweenFactor.h>
+#include <gtsam/slam/PriorFactor.h>
+#include <gtsam/geometry/Pose2.h>
+#include <gtsam/base/GenericValue.h>
+#include <gtsam/base/TestableAssertions.h>
+
+#include <CppUnitLite/TestHarness.h>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/export.hpp>
+
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+using namespace gtsam;
+
+// Nonlinear factors and values are checkpointed with Boost serialization
+BOOST_CLASS_EXPORT_GUID(gtsam::noiseModel::Diagonal, "gtsam_noiseModel_Diagonal");
+BOOST_CLASS_EXPORT_GUID(gtsam::noiseModel::Isotropic, "gtsam_noiseModel_Isotropic");
+BOOST_CLASS_EXPORT_GUID(gtsam::PriorFactor<gtsam::Pose2>, "gtsam::PriorFactorPose2");
+BOOST_CLASS_EXPORT_GUID(gtsam::BetweenFactor<gtsam::Pose2>, "gtsam::BetweenFactorPose2");
+GTSAM_VALUE_EXPORT(gtsam::Pose2);
+
+namespace {
+const SharedNoiseModel odometryNoise =
+    noiseModel::Diagonal::Sigmas(Vector3(0.1, 0.1, 0.05));
+const SharedNoiseModel loopNoise = noiseModel::Isotropic::Sigma(3, 0.2);
+
+// Add pose i with odometry, and a loop closure every few poses
+void addPose(size_t i, ISAM2* isam) {
+  NonlinearFactorGraph factors;
+  Values values;
+  if (i == 0) {
+    factors.emplace_shared<PriorFactor<Pose2> >(0, Pose2(), odometryNoise);
+  } else {
+    factors.emplace_shared<BetweenFactor<Pose2> >(i - 1, i, Pose2(1, 0, 0.1),
+                                                  odometryNoise);
+    if (i % 7 == 0)
+      factors.emplace_shared<BetweenFactor<Pose2> >(
+          i - 7, i, Pose2(1.0, 0.2, 0.7), loopNoise);
+  }
+  values.insert(i, Pose2(i * 1.0, 0.1 * i, 0.1 * i));
+  isam->update(factors, values);
+}
+
+ISAM2Params params() {
+  ISAM2Params params;
+  params.relinearizeThreshold = 0.01;
+  params.relinearizeSkip = 1;
+  params.cacheLinearizedFactors = true;
+  return params;
+}
+}  // namespace
+
+/* ************************************************************************* */
+TEST(ISAM2Checkpoint, fullAndIncremental) {
+  ISAM2 isam(params());
+  ISAM2CheckpointWriter writer;
+  for (size_t i = 0; i < 50; i++) addPose(i, &isam);
+  stringstream full;
+  writer.write(isam, full);
+
+  for (size_t i = 50; i < 53; i++) addPose(i, &isam);
+  stringstream incremental1;
+  writer.write(isam, incremental1);
+  EXPECT_LONGS_EQUAL(1, writer.sequence());
+  EXPECT(incremental1.str().size() < full.str().size());
+
+  addPose(53, &isam);
+  stringstream incremental2;
+  writer.write(isam, incremental2);
+
+  // Restored without updating, and equal to the original
+  ISAM2CheckpointReader reader(params());
+  reader.read(full);
+  reader.read(incremental1);
+  reader.read(incremental2);
+  const ISAM2& restored = reader.isam();
+  EXPECT(assert_equal(isam, restored));
+  EXPECT(assert_equal(isam.getDelta(), restored.getDelta()));
+  EXPECT(assert_equal(isam.calculateEstimate(), restored.calculateEstimate()));
+  EXPECT(assert_equal(isam.getVariableIndex(), restored.getVariableIndex()));
+
+  // Both continue the same way
+  for (size_t i = 54; i < 60; i++) {
+    addPose(i, &isam);
+    addPose(i, &reader.isam());
+  }
+  EXPECT(assert_equal(isam.calculateEstimate(), reader.isam().calculateEstimate()));
+  EXPECT(assert_equal(isam, reader.isam()));
+}
+
+/* ************************************************************************* */
+TEST(ISAM2Checkpoint, outOfOrder) {
+  ISAM2 isam(params());
+  ISAM2CheckpointWriter writer;
+  for (size_t i = 0; i < 10; i++) addPose(i, &isam);
+  stringstream full, incremental1, incremental2;
+  writer.write(isam, full);
+  addPose(10, &isam);
+  writer.write(isam, incremental1);
+  addPose(11, &isam);
+  writer.write(isam, incremental2);
+
+  ISAM2CheckpointReader reader(params());
+  CHECK_EXCEPTION(reader.read(incremental1), std::runtime_error);
+  reader.read(full);
+  CHECK_EXCEPTION(reader.read(incremental2), std::runtime_error);
+
+  // A new full checkpoint restarts the sequence
+  stringstream full2;
+  writer.write(isam, full2, true);
+  EXPECT_LONGS_EQUAL(0, writer.sequence());
+  reader.read(full2);
+  EXPECT(assert_equal(isam, reader.isam()));
+}
+
+/* ************************************************************************* */
+TEST(ISAM2Checkpoint, removedVariable) {
+  ISAM2 isam(params());
+  ISAM2CheckpointWriter writer;
+  for (size_t i = 0; i < 20; i++) addPose(i, &isam);
+  NonlinearFactorGraph factors;
+  factors.emplace_shared<BetweenFactor<Pose2> >(19, 20, Pose2(1, 0, 0.1),
+                                                odometryNoise);
+  Values values;
+  values.insert(20, Pose2(20.0, 2.0, 2.0));
+  const ISAM2Result result = isam.update(factors, values);
+  stringstream full;
+  writer.write(isam, full);
+
+  // Removing the only factor of 20 removes the variable
+  ISAM2UpdateParams updateParams;
+  updateParams.removeFactorIndices = result.newFactorsIndices;
+  isam.update(NonlinearFactorGraph(), Values(), updateParams);
+  EXPECT(!isam.valueExists(20));
+  stringstream incremental;
+  writer.write(isam, incremental);
+
+  ISAM2CheckpointReader reader(params());
+  reader.read(full);
+  reader.read(incremental);
+  EXPECT(assert_equal(isam, reader.isam()));
+  EXPECT(assert_equal(isam.getDelta(), reader.isam().getDelta()));
+  EXPECT(assert_equal(isam.getVariableIndex(), reader.isam().getVariableIndex()));
+}
+
+/* ************************************************************************* */
+TEST(ISAM2Checkpoint, otherWriter) {
+  ISAM2 isam(params());
+  ISAM2CheckpointWriter writer, other;
+  for (size_t i = 0; i < 10; i++) addPose(i, &isam);
+  stringstream full, otherFull;
+  writer.write(isam, full);
+  addPose(10, &isam);
+  other.write(isam, otherFull);
+
+  // The variables changed by pose 10 were only recorded for the other writer,
+  // so the next checkpoint is full again
+  addPose(11, &isam);
+  stringstream full2;
+  writer.write(isam, full2);
+  EXPECT_LONGS_EQUAL(0, writer.sequence());
+
+  ISAM2CheckpointReader reader(params());
+  reader.read(full);
+  reader.read(full2);
+  EXPECT(assert_equal(isam, reader.isam()));
+  EXPECT(assert_equal(isam.getDelta(), reader.isam().getDelta()));
+}
+
+/* ************************************************************************* */
+int main() {
+  TestResult tr;
+  return TestRegistry::runAllTests(tr);
+}
+/* ************************************************************************* */
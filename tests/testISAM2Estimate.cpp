@@ -0,0 +1,110 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    testISAM2Estimate.cpp
+ * @brief   Unit tests for the estimate snapshots published by ISAM2
+ */
+
+#include <gtsam/nonlinear/ISAM2.h>
+#include <gtsam/slam/BetweenFactor.h>
+#include <gtsam/slam/PriorFactor.h>
+#include <gtsam/geometry/Pose2.h>
+#include <gtsam/base/TestableAssertions.h>
+
+#include <CppUnitLite/TestHarness.h>
+
+using namespace std;
+using namespace gtsam;
+
+namespace {
+const SharedNoiseModel odometryNoise =
+    noiseModel::Diagonal::Sigmas(Vector3(0.1, 0.1, 0.05));
+
+void addPose(size_t i, ISAM2* isam) {
+  NonlinearFactorGraph factors;
+  if (i == 0)
+    factors.emplace_shared<PriorFactor<Pose2> >(0, Pose2(), odometryNoise);
+  else
+    factors.emplace_shared<BetweenFactor<Pose2> >(i - 1, i, Pose2(1, 0, 0),
+                                                  odometryNoise);
+  Values values;
+  values.insert(i, Pose2(i * 1.0, 0, 0));
+  isam->update(factors, values);
+}
+}  // namespace
+
+/* ************************************************************************* */
+TEST(ISAM2Estimate, published) {
+  ISAM2Params params;
+  params.relinearizeSkip = 1;
+  params.publishEstimate = true;
+  ISAM2 isam(params);
+  for (size_t i = 0; i < 150; i++) addPose(i, &isam);
+  const ISAM2Estimate::shared_ptr old = isam.estimate();
+  for (size_t i = 150; i < 200; i++) addPose(i, &isam);
+
+  const ISAM2Estimate::shared_ptr estimate = isam.estimate();
+  CHECK(estimate);
+  EXPECT_LONGS_EQUAL(200, estimate->version());
+  EXPECT_LONGS_EQUAL(200, estimate->size());
+  EXPECT(assert_equal(isam.calculateEstimate(), estimate->values()));
+  EXPECT(assert_equal(Pose2(7, 0, 0), estimate->at<Pose2>(7)));
+
+  // The old snapshot is unchanged, and shares the unchanged variables
+  EXPECT_LONGS_EQUAL(150, old->version());
+  EXPECT_LONGS_EQUAL(150, old->size());
+  EXPECT(!old->exists(170));
+  EXPECT(&old->at(3) == &estimate->at(3));
+
+  CHECK_EXCEPTION(estimate->at(200), ValuesKeyDoesNotExist);
+  CHECK_EXCEPTION(estimate->at<Point2>(0), ValuesIncorrectType);
+
+  // Nothing is published by default
+  EXPECT(!ISAM2().estimate());
+}
+
+/* ************************************************************************* */
+TEST(ISAM2Estimate, create) {
+  Values theta;
+  VectorValues delta;
+  for (size_t j = 0; j < 300; j += 2) {
+    theta.insert(j, Pose2(j * 1.0, 0, 0));
+    delta.insert(j, Vector3::Zero());
+  }
+  const ISAM2Estimate::shared_ptr first = ISAM2Estimate::Create(theta, delta, 1);
+  EXPECT(assert_equal(theta, first->values()));
+
+  // Insert, remove, change delta and linearization points
+  theta.insert(101, Pose2(1, 2, 3));
+  delta.insert(101, Vector3::Zero());
+  theta.erase(200);
+  delta.erase(200);
+  delta.at(40) = Vector3(0.1, 0.2, 0.3);
+  theta.update(60, Pose2(0, 0, 1));
+  KeySet changedTheta;
+  changedTheta.insert(60);
+
+  const ISAM2Estimate::shared_ptr second =
+      ISAM2Estimate::Create(theta, delta, 2, first, changedTheta);
+  EXPECT(assert_equal(theta.retract(delta), second->values()));
+  EXPECT_LONGS_EQUAL(theta.size(), second->keys().size());
+  EXPECT(&first->at(298) == &second->at(298));
+  EXPECT(&first->at(40) != &second->at(40));
+  EXPECT(assert_equal(Pose2(0, 0, 1), second->at<Pose2>(60)));
+}
+
+/* ************************************************************************* */
+int main() {
+  TestResult tr;
+  return TestRegistry::runAllTests(tr);
+}
+/* ************************************************************************* */
@@ -0,0 +1,180 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    testISAM2Sessions.cpp
+ * @brief   Unit tests for attaching and detaching sessions of ISAM2
+ */
+
+#include <gtsam/nonlinear/ISAM2.h>
+#include <gtsam/nonlinear/LevenbergMarquardtOptimizer.h>
+#include <gtsam/slam/BetweenFactor.h>
+#include <gtsam/slam/PriorFactor.h>
+#include <gtsam/geometry/Pose2.h>
+#include <gtsam/inference/Symbol.h>
+#include <gtsam/base/TestableAssertions.h>
+
+#include <CppUnitLite/TestHarness.h>
+
+#include <stdexcept>
+
+using namespace std;
+using namespace gtsam;
+using symbol_shorthand::A;
+using symbol_shorthand::B;
+
+namespace {
+const SharedNoiseModel odometryNoise =
+    noiseModel::Diagonal::Sigmas(Vector3(0.1, 0.1, 0.05));
+const Pose2 odometry(1.0, 0.0, 0.1);
+const size_t nrPoses = 20;
+
+Pose2 truth(const Pose2& origin, size_t i) {
+  Pose2 pose = origin;
+  for (size_t j = 0; j < i; j++) pose = pose.compose(odometry);
+  return pose;
+}
+
+// Drive a robot with odometry and a loop closure every few poses, recording
+// all factors and initial values for a batch solution
+void drive(Key (*key)(std::uint64_t), const Pose2& origin, ISAM2* isam,
+           NonlinearFactorGraph* graph, Values* initial) {
+  for (size_t i = 0; i < nrPoses; i++) {
+    NonlinearFactorGraph factors;
+    if (i == 0)
+      factors.emplace_shared<PriorFactor<Pose2> >(key(0), origin, odometryNoise);
+    else
+      factors.emplace_shared<BetweenFactor<Pose2> >(key(i - 1), key(i),
+                                                    odometry, odometryNoise);
+    if (i >= 5 && i % 5 == 0)
+      factors.emplace_shared<BetweenFactor<Pose2> >(
+          key(i - 5), key(i), truth(Pose2(), 5), odometryNoise);
+    Values values;
+    values.insert(key(i), truth(origin, i).compose(Pose2(0.05, -0.05, 0.01)));
+    isam->update(factors, values);
+    graph->push_back(factors);
+    initial->insert(values);
+  }
+}
+
+ISAM2Params params() {
+  ISAM2Params params;
+  params.relinearizeThreshold = 0.001;
+  params.relinearizeSkip = 1;
+  params.cacheLinearizedFactors = true;
+  return params;
+}
+
+KeySet keys(Key (*key)(std::uint64_t)) {
+  KeySet result;
+  for (size_t i = 0; i < nrPoses; i++) result.insert(key(i));
+  return result;
+}
+}  // namespace
+
+/* ************************************************************************* */
+TEST(ISAM2Sessions, attachAndDetach) {
+  const Pose2 originA, originB(0.0, 5.0, 0.0);
+  NonlinearFactorGraph graph;
+  Values initial;
+  ISAM2 isam(params()), sessionB(params());
+  drive(A, originA, &isam, &graph, &initial);
+  drive(B, originB, &sessionB, &graph, &initial);
+  const size_t nrFactorsA = isam.getFactorsUnsafe().size();
+  const size_t nrFactorsB = sessionB.getFactorsUnsafe().size();
+  const Values estimateB = sessionB.calculateEstimate();
+
+  // Attaching moves the session into another tree, without eliminating
+  const FactorIndices attached = isam.attach(std::move(sessionB));
+  EXPECT_LONGS_EQUAL(nrFactorsB, attached.size());
+  EXPECT_LONGS_EQUAL(nrFactorsA, attached.front());
+  EXPECT_LONGS_EQUAL(2, isam.roots().size());
+  EXPECT_LONGS_EQUAL(0, sessionB.getLinearizationPoint().size());
+  EXPECT_LONGS_EQUAL(0, sessionB.getFactorsUnsafe().size());
+  EXPECT(assert_equal(estimateB.at<Pose2>(B(7)),
+                      isam.calculateEstimate<Pose2>(B(7))));
+
+  // A factor between the robots only re-eliminates the paths to the roots
+  NonlinearFactorGraph between;
+  between.emplace_shared<BetweenFactor<Pose2> >(
+      A(nrPoses - 1), B(nrPoses - 1),
+      truth(originA, nrPoses - 1).between(truth(originB, nrPoses - 1)),
+      odometryNoise);
+  const ISAM2Result result = isam.update(between);
+  graph.push_back(between);
+  EXPECT(result.variablesReeliminated < nrPoses);
+  EXPECT_LONGS_EQUAL(1, isam.roots().size());
+
+  // and converges to the batch solution of the merged graph
+  for (size_t i = 0; i < 5; i++) isam.update();
+  const Values expected = LevenbergMarquardtOptimizer(graph, initial).optimize();
+  EXPECT(assert_equal(expected, isam.calculateEstimate(), 1e-4));
+
+  // Detaching requires removing the factor between the robots first
+  ISAM2 detached(params());
+  CHECK_EXCEPTION(isam.detach(keys(B), &detached), std::invalid_argument);
+  isam.update(NonlinearFactorGraph(), Values(), result.newFactorsIndices);
+  EXPECT_LONGS_EQUAL(2, isam.roots().size());
+
+  const FactorIndices indices = isam.detach(keys(B), &detached);
+  EXPECT(attached == indices);
+  EXPECT_LONGS_EQUAL(1, isam.roots().size());
+  EXPECT(!isam.valueExists(B(0)));
+  EXPECT_LONGS_EQUAL(nrPoses, isam.getLinearizationPoint().size());
+  EXPECT_LONGS_EQUAL(nrPoses, detached.getLinearizationPoint().size());
+  EXPECT_LONGS_EQUAL(nrFactorsB, detached.getFactorsUnsafe().size());
+  EXPECT(assert_equal(truth(originB, 7), detached.calculateEstimate<Pose2>(B(7)), 1e-4));
+  EXPECT(assert_equal(truth(originA, 7), isam.calculateEstimate<Pose2>(A(7)), 1e-4));
+
+  // Both continue independently
+  NonlinearFactorGraph next;
+  next.emplace_shared<BetweenFactor<Pose2> >(B(nrPoses - 1), B(nrPoses),
+                                             odometry, odometryNoise);
+  Values nextValues;
+  nextValues.insert(B(nrPoses), truth(originB, nrPoses));
+  detached.update(next, nextValues);
+  isam.update();
+  EXPECT(assert_equal(truth(originB, nrPoses),
+                      detached.calculateEstimate<Pose2>(B(nrPoses)), 1e-4));
+  EXPECT(assert_equal(truth(originA, 7), isam.calculateEstimate<Pose2>(A(7)), 1e-4));
+}
+
+/* ************************************************************************* */
+TEST(ISAM2Sessions, invalid) {
+  NonlinearFactorGraph graph, graphA;
+  Values initial, initialA;
+  ISAM2 isam(params()), sessionA(params());
+  drive(A, Pose2(), &isam, &graph, &initial);
+  drive(A, Pose2(), &sessionA, &graphA, &initialA);
+
+  // Sessions cannot share variables
+  CHECK_EXCEPTION(isam.attach(std::move(sessionA)), std::invalid_argument);
+
+  // Only whole trees can be detached, into an empty session
+  KeySet some = keys(A);
+  some.erase(A(0));
+  ISAM2 session(params());
+  CHECK_EXCEPTION(isam.detach(some, &session), std::invalid_argument);
+  CHECK_EXCEPTION(isam.detach(keys(B), &session), std::invalid_argument);
+  CHECK_EXCEPTION(isam.detach(keys(A), &sessionA), std::invalid_argument);
+
+  // A session can be detached entirely
+  isam.detach(keys(A), &session);
+  EXPECT_LONGS_EQUAL(0, isam.roots().size());
+  EXPECT(assert_equal(sessionA.calculateEstimate(), session.calculateEstimate()));
+}
+
+/* ************************************************************************* */
+int main() {
+  TestResult tr;
+  return TestRegistry::runAllTests(tr);
+}
+/* ************************************************************************* */
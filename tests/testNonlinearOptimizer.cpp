@@ -173,6 +173,49 @@ TEST( NonlinearOptimizer, optimization_method )
   DOUBLES_EQUAL(0,fg.error(actualMFChol),tol);
 }
 
+/* ************************************************************************* */
+TEST(NonlinearOptimizer, Counters) {
+  NonlinearFactorGraph fg;
+  Values c0;
+  fg += PriorFactor<Pose2>(X(1), Pose2(), noiseModel::Isotropic::Sigma(3, 1));
+  c0.insert(X(1), Pose2(0.1, 0.2, 0.1));
+  for (size_t i = 1; i < 5; ++i) {
+    fg += BetweenFactor<Pose2>(X(i), X(i + 1), Pose2(1, 0, 0.1),
+                               noiseModel::Isotropic::Sigma(3, 1));
+    c0.insert(X(i + 1), Pose2(double(i), 0.1, 0.2));
+  }
+
+  for (auto type : {LevenbergMarquardtParams::MULTIFRONTAL_CHOLESKY,
+                    LevenbergMarquardtParams::SEQUENTIAL_QR}) {
+    LevenbergMarquardtParams params;
+    params.linearSolverType = type;
+    LevenbergMarquardtOptimizer optimizer(fg, c0, params);
+    // Factors linearized for the first time are not counted as relinearized
+    optimizer.iterate();
+    EXPECT_LONGS_EQUAL(0, optimizer.counters().factorsRelinearized);
+    optimizer.iterate();
+    const PerformanceCounters& counters = optimizer.counters();
+    EXPECT_LONGS_EQUAL(fg.size(), counters.factorsRelinearized);
+    EXPECT(counters.cliques > 0);
+    EXPECT(counters.maxCliqueSize >= 2);
+    EXPECT(counters.flops > 0);
+    EXPECT(counters.bytesAllocated > 0);
+    EXPECT(counters.totalTime() >= 0);
+
+    // Counting does not change the solution
+    const GaussianFactorGraph linear = *fg.linearize(c0);
+    PerformanceCounters solveCounters;
+    EXPECT(assert_equal(optimizer.solve(linear, params),
+                        optimizer.solve(linear, params, &solveCounters)));
+    EXPECT(assert_equal(linear.optimize(), optimizer.solve(linear, params)));
+    EXPECT_DOUBLES_EQUAL(0, solveCounters.linearizeTime, 0);
+    EXPECT(solveCounters.numericTime >= 0);
+  }
+
+  // Eliminating 3 frontal dimensions with 3 separator dimensions
+  EXPECT_DOUBLES_EQUAL(9 + 27 + 27, PerformanceCounters::EliminationFlops(3, 3), 1e-9);
+}
+
 /* ************************************************************************* */
 TEST( NonlinearOptimizer, Factorization )
 {
@@ -19,6 +19,7 @@
 #include <boost/assign/std/list.hpp> // for operator += in Ordering
 #include <CppUnitLite/TestHarness.h>
 #include <tests/smallExample.h>
+#include <gtsam/linear/GaussianBayesTree.h>
 
 using namespace std;
 using namespace gtsam;
@@ -29,9 +30,10 @@ using namespace boost::assign;
 // Create a Kalman smoother for t=1:T and optimize
 double timeKalmanSmoother(int T) {
   GaussianFactorGraph smoother = createSmoother(T);
-  clock_t start = clock();
   // Keys will come out sorted since keys() returns a set
-  smoother.optimize(Ordering(smoother.keys()));
+  const Ordering ordering(smoother.keys());
+  clock_t start = clock();
+  smoother.optimize(ordering);
   clock_t end = clock ();
   double dif = (double)(end - start) / CLOCKS_PER_SEC;
   return dif;
@@ -40,7 +42,7 @@ double timeKalmanSmoother(int T) {
 /* ************************************************************************* */
 // Create a planar factor graph and optimize
 double timePlanarSmoother(int N, bool old = true) {
-  GaussianFactorGraph fg = planarGraph(N).get<0>();
+  GaussianFactorGraph fg = planarGraph(N).first;
   clock_t start = clock();
   fg.optimize();
   clock_t end = clock ();
@@ -51,7 +53,7 @@ double timePlanarSmoother(int N, bool old = true) {
 /* ************************************************************************* */
 // Create a planar factor graph and eliminate
 double timePlanarSmootherEliminate(int N, bool old = true) {
-  GaussianFactorGraph fg = planarGraph(N).get<0>();
+  GaussianFactorGraph fg = planarGraph(N).first;
   clock_t start = clock();
   fg.eliminateMultifrontal();
   clock_t end = clock ();
@@ -59,6 +61,19 @@ double timePlanarSmootherEliminate(int N, bool old = true) {
   return dif;
 }
 
+/* ************************************************************************* */
+// Create a planar factor graph, eliminate it, and time back-substitution only
+double timePlanarSmootherBacksubstitute(int N, size_t reps) {
+  GaussianFactorGraph fg = planarGraph(N).first;
+  GaussianBayesTree::shared_ptr bayesTree = fg.eliminateMultifrontal();
+  clock_t start = clock();
+  for (size_t i = 0; i < reps; ++i)
+    bayesTree->optimize();
+  clock_t end = clock ();
+  double dif = (double)(end - start) / CLOCKS_PER_SEC;
+  return dif;
+}
+
 ///* ************************************************************************* */
 //// Create a planar factor graph and join factors until matrix formation
 //// This variation uses the original join factors approach
@@ -210,6 +225,13 @@ TEST(timeGaussianFactorGraph, planar_eliminate_new)
 //  //DOUBLES_EQUAL(5.97,time,0.1);
 //}
 
+/* ************************************************************************* */
+TEST(timeGaussianFactorGraph, planar_backsubstitute)
+{
+  cout << "Timing planar back-substitution, 10 times" << endl;
+  double time = timePlanarSmootherBacksubstitute(size, 10);
+  cout << "timeGaussianFactorGraph : " << time << endl;
+}
 
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr); }
@@ -0,0 +1,72 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    timeOrdering.cpp
+ * @brief   time fill-reducing orderings of a large grid, from scratch and
+ *          incrementally after a few factors are added
+ */
+
+#include <gtsam/inference/Ordering.h>
+#include <gtsam/symbolic/SymbolicFactorGraph.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace gtsam;
+
+template <class FUNCTION>
+static Ordering timed(const string& label, FUNCTION function) {
+  auto start = chrono::steady_clock::now();
+  Ordering ordering = function();
+  const double seconds =
+      chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  cout << label << ": " << seconds << " s" << endl;
+  return ordering;
+}
+
+int main(int argc, char* argv[]) {
+  // n*n grid
+  const size_t n = argc > 1 ? atoi(argv[1]) : 500;
+  SymbolicFactorGraph graph;
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = 0; j < n; j++) {
+      if (i + 1 < n) graph.push_factor(i * n + j, (i + 1) * n + j);
+      if (j + 1 < n) graph.push_factor(i * n + j, i * n + j + 1);
+    }
+  cout << n * n << " variables, " << graph.size() << " factors" << endl;
+
+  const Ordering colamd = timed("Colamd", [&]() { return Ordering::Colamd(graph); });
+  timed("Metis", [&]() { return Ordering::Metis(graph); });
+  timed("MetisParallel", [&]() { return Ordering::MetisParallel(graph); });
+
+  // Grow the grid by one row of n variables
+  SymbolicFactorGraph newFactors;
+  for (size_t j = 0; j < n; j++) {
+    newFactors.push_factor((n - 1) * n + j, n * n + j);
+    if (j + 1 < n) newFactors.push_factor(n * n + j, n * n + j + 1);
+  }
+  SymbolicFactorGraph grown = graph;
+  grown.push_back(newFactors);
+  const VariableIndex variableIndex(grown);
+
+  timed("Colamd after growing", [&]() { return Ordering::Colamd(variableIndex); });
+  const Ordering incremental = timed("ColamdIncremental", [&]() {
+    return Ordering::ColamdIncremental(colamd, variableIndex, newFactors.keys());
+  });
+  size_t kept = 0;
+  while (kept < colamd.size() && colamd[kept] == incremental[kept]) ++kept;
+  cout << "reordered " << incremental.size() - kept << " of "
+       << incremental.size() << " variables" << endl;
+  return 0;
+}
@@ -19,6 +19,7 @@
 
 #include <gtsam/base/timing.h>
 #include <gtsam/geometry/Pose3.h>
+#include <gtsam/geometry/LieBatch.h>
 
 using namespace std;
 using namespace gtsam;
@@ -48,6 +49,19 @@ int main()
   TEST(between_derivatives, T.between(T2,H1,H2))
   TEST(Logmap, Pose3::Logmap(T.between(T2)))
 
+  // Batch versions, on arrays of m poses: same total number of poses
+  typedef LieBatch<Pose3> Batch;
+  const int m = 1000;
+  n /= m;
+  Batch::Tangents xi = v.replicate(1, m);
+  Batch::Elements Ts(m, T), T2s = Batch::Compose(Ts, Batch::Expmap(xi));
+  Batch::Jacobians Hs1, Hs2;
+
+  TEST(batch_Expmap, Batch::Expmap(xi))
+  TEST(batch_between, Batch::Between(Ts, T2s))
+  TEST(batch_between_derivatives, Batch::Between(Ts, T2s, &Hs1, &Hs2))
+  TEST(batch_Logmap, Batch::Logmap(Batch::Between(Ts, T2s)))
+
   // Print timings
   tictoc_print_();
 
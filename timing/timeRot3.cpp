@@ -19,6 +19,7 @@
 #include <iostream>
 
 #include <gtsam/geometry/Rot3.h>
+#include <gtsam/geometry/LieBatch.h>
 
 using namespace std;
 using namespace gtsam;
@@ -51,5 +52,16 @@ int main()
   TEST("Slow rotation matrix",Rot3::Rz(z)*Rot3::Ry(y)*Rot3::Rx(x))
   TEST("Fast Rotation matrix", Rot3::RzRyRx(x,y,z))
 
+  // Batch versions, on arrays of m rotations: calls/second counts batches
+  typedef LieBatch<Rot3> Batch;
+  const int m = 1000;
+  n /= m;
+  Batch::Tangents omegas = v.replicate(1, m);
+  Batch::Elements Rs(m, R), R2s(m, R2);
+  Batch::Jacobians Hs;
+  TEST("Batch Expmap", Batch::Expmap(omegas))
+  TEST("Batch Expmap with derivatives", Batch::Expmap(omegas, &Hs))
+  TEST("Batch Logmap", Batch::Logmap(Batch::Between(Rs, R2s)))
+
   return 0;
 }
@@ -0,0 +1,69 @@
+/* ----------------------------------------------------------------------------
+
+ * GTSAM Copyright 2010, Georgia Tech Research Corporation,
+ * Atlanta, Georgia 30332-0415
+ * All Rights Reserved
+ * Authors: Frank Dellaert, et al. (see THANKS for the full author list)
+
+ * See LICENSE for the license information
+
+ * -------------------------------------------------------------------------- */
+
+/**
+ * @file    timeUnit3.cpp
+ * @brief   time Unit3 basis access, single-threaded and from many threads
+ *          sharing the same directions, as in parallel linearization
+ */
+
+#include <gtsam/geometry/Unit3.h>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace gtsam;
+
+// Call basis, with derivatives, on every direction, a number of times
+static double sweep(const vector<Unit3>& directions, size_t reps) {
+  double sum = 0;
+  Matrix62 H;
+  for (size_t r = 0; r < reps; r++)
+    for (const Unit3& d : directions)
+      sum += d.basis(H)(0, 0) + H(0, 0);
+  return sum;
+}
+
+int main() {
+  boost::mt19937 rng(42);
+  vector<Unit3> directions;
+  for (size_t i = 0; i < 1000; i++)
+    directions.push_back(Unit3::Random(rng));
+
+  const size_t reps = 2000;
+  const size_t maxThreads = max(1u, thread::hardware_concurrency());
+  for (size_t nThreads = 1; nThreads <= maxThreads; nThreads *= 2) {
+    vector<thread> threads;
+    vector<double> sums(nThreads);
+    auto start = chrono::steady_clock::now();
+    for (size_t t = 0; t < nThreads; t++)
+      threads.emplace_back([&, t]() { sums[t] = sweep(directions, reps); });
+    for (thread& t : threads) t.join();
+    const double seconds =
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    const double calls = double(nThreads * reps * directions.size());
+    cout << nThreads << " threads: " << calls / seconds << " basis calls/second"
+         << endl;
+  }
+
+  // Copying is a plain member-wise copy
+  auto start = chrono::steady_clock::now();
+  vector<Unit3> copies;
+  for (size_t r = 0; r < reps; r++) copies = directions;
+  const double seconds =
+      chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  cout << "copy: " << (reps * directions.size()) / seconds << " copies/second"
+       << endl;
+  return 0;
+}